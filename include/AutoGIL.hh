@@ -0,0 +1,86 @@
+/**
+ * @file AutoGIL.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief RAII guards releasing the Python GIL while JavaScript runs, and re-acquiring it when JavaScript calls back into Python
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_AutoGIL_
+#define PythonMonkey_AutoGIL_
+
+#include <Python.h>
+
+#include <atomic>
+
+/**
+ * @brief Release the GIL for the lifetime of the guard, if enabled by pythonmonkey.set_release_gil(True) on every thread or on this one.
+ * Wraps calls that execute JavaScript, so that other Python threads keep running meanwhile.
+ *
+ * While the GIL is released, the thread must not touch any Python object: every native, proxy handler trap,
+ * hook and callback through which JavaScript reaches Python holds an AutoAcquireGIL.
+ */
+struct AutoReleaseGIL {
+public:
+  AutoReleaseGIL() {
+    if (isEnabled() && !savedThreadState) {
+      savedThreadState = PyEval_SaveThread();
+      released = true;
+    }
+  }
+
+  ~AutoReleaseGIL() {
+    if (released) {
+      PyThreadState *threadState = savedThreadState;
+      savedThreadState = nullptr;
+      PyEval_RestoreThread(threadState);
+    }
+  }
+
+  AutoReleaseGIL(const AutoReleaseGIL &) = delete;
+  AutoReleaseGIL &operator=(const AutoReleaseGIL &) = delete;
+
+  /**
+   * @return whether JavaScript runs without the GIL on this thread
+   */
+  static bool isEnabled() {
+    return enabledOnThread || enabled.load(std::memory_order_relaxed);
+  }
+
+  static inline std::atomic<bool> enabled = false; /**< whether JavaScript runs without the GIL on every thread, off by default */
+  static inline thread_local bool enabledOnThread = false; /**< whether JavaScript runs without the GIL on this thread, as in workers */
+  static inline thread_local PyThreadState *savedThreadState = nullptr; /**< set while this thread runs JavaScript without the GIL */
+
+private:
+  bool released = false;
+};
+
+/**
+ * @brief Re-acquire the GIL for the lifetime of the guard, if this thread released it to run JavaScript.
+ * A no-op when the GIL is already held, so it nests freely, also around calls that release it again.
+ */
+struct AutoAcquireGIL {
+public:
+  AutoAcquireGIL() : threadState(AutoReleaseGIL::savedThreadState) {
+    if (threadState) {
+      AutoReleaseGIL::savedThreadState = nullptr;
+      PyEval_RestoreThread(threadState);
+    }
+  }
+
+  ~AutoAcquireGIL() {
+    if (threadState) {
+      AutoReleaseGIL::savedThreadState = PyEval_SaveThread();
+    }
+  }
+
+  AutoAcquireGIL(const AutoAcquireGIL &) = delete;
+  AutoAcquireGIL &operator=(const AutoAcquireGIL &) = delete;
+
+private:
+  PyThreadState *threadState;
+};
+
+#endif
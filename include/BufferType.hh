@@ -19,7 +19,8 @@
 struct BufferType {
 public:
   /**
-   * @brief Construct a new BufferType object from a JS TypedArray or ArrayBuffer, as a Python [memoryview](https://docs.python.org/3.9/c-api/memoryview.html) object
+   * @brief Construct a new BufferType object from a JS TypedArray, DataView, ArrayBuffer or SharedArrayBuffer, as a Python [memoryview](https://docs.python.org/3.9/c-api/memoryview.html) object.
+   * DataViews and ArrayBuffers become memoryviews of unsigned bytes
    *
    * @param cx - javascript context pointer
    * @param bufObj - JS object to be coerced
@@ -31,26 +32,70 @@ public:
   /**
    * @brief Convert a Python object that [provides the buffer interface](https://docs.python.org/3.9/c-api/typeobj.html#buffer-object-structures) to JS TypedArray.
    * The subtype (Uint8Array, Float64Array, ...) is automatically determined by the Python buffer's [format](https://docs.python.org/3.9/c-api/buffer.html#c.Py_buffer.format)
+   * A memoryview of a whole JS buffer converts back to that JS object.
+   * The TypedArray shares the buffer's memory unless its strides leave gaps between elements, in which case the elements are copied once.
+   * A read-only buffer (e.g. `bytes`) is copied once into a private ArrayBuffer, which JS writes go to. While JS leaves the copy unmodified,
+   * the TypedArray converts back to the original object.
+   * Multidimensional buffers become flat TypedArrays with `shape` and `strides` properties.
    *
    * @param cx - javascript context pointer
    * @param pyObject - the object to be converted
+   * @return the TypedArray, or nullptr with a Python exception set, the Python buffer then being released
    */
   static JSObject *toJsTypedArray(JSContext *cx, PyObject *pyObject);
 
   /**
-   * @returns Is the given JS object either a TypedArray or an ArrayBuffer?
+   * @brief Release the Python buffers of ArrayBuffers that were finalized off the main thread. Must be called with the GIL held,
+   * and only releases the buffers of the interpreter running on the current thread.
+   * This is what lets a `bytearray` be resized, or an `mmap` be closed, once no JS ArrayBuffer uses it anymore.
+   */
+  static void releasePendingPyBuffers();
+
+  /**
+   * @returns Is the given JS object a TypedArray, a DataView, an ArrayBuffer or a SharedArrayBuffer?
    */
   static bool isSupportedJsTypes(JSObject *obj);
 
 protected:
   static PyObject *fromJsTypedArray(JSContext *cx, JS::HandleObject typedArray);
-  static PyObject *fromJsArrayBuffer(JSContext *cx, JS::HandleObject arrayBuffer);
+  static PyObject *fromJsArrayBuffer(JSContext *cx, JS::HandleObject arrayBuffer); // also used for SharedArrayBuffers and DataViews
 
 private:
   static void _releasePyBuffer(Py_buffer *bufView);
   static void _releasePyBuffer(void *, void *bufView); // JS::BufferContentsFreeFunc callback for JS::NewExternalArrayBuffer
 
   static JS::Scalar::Type _getPyBufferType(Py_buffer *bufView);
+
+  /**
+   * @returns Can a TypedArray share the memory of the Python buffer? True if the elements are aligned and densely packed in C order,
+   * or in Fortran order for multidimensional buffers
+   */
+  static bool _isZeroCopyable(Py_buffer *bufView);
+
+  /**
+   * @brief Create a new ArrayBuffer holding a C-ordered copy of a Python buffer's elements
+   */
+  static JSObject *_newArrayBufferFromPyBuffer(JSContext *cx, Py_buffer *bufView);
+
+  /**
+   * @brief Create a new ArrayBuffer holding a C-ordered copy of an immutable Python buffer, remembered so that it converts back to `pyObject`.
+   * Releases the view, even on failure
+   */
+  static JSObject *_newPrivateCopy(JSContext *cx, PyObject *pyObject, Py_buffer *bufView);
+
+  /**
+   * @returns A new reference to the Python object a TypedArray was copied from, or nullptr if it is not a whole private copy,
+   * or if its contents no longer match those of the object
+   */
+  static PyObject *_getUnmodifiedCopySource(JS::HandleObject typedArray);
+
+  /**
+   * @brief Create the JS arrays describing the layout of a Python buffer, exposed as the `shape` and `strides` properties of its TypedArray.
+   * Strides are counted in elements of the flat TypedArray rather than in bytes.
+   *
+   * @param cOrder - the elements have been copied in C order, so the strides of the Python buffer no longer apply
+   */
+  static bool _newShapeAndStrides(JSContext *cx, Py_buffer *bufView, bool cOrder, JS::MutableHandleObject shape, JS::MutableHandleObject strides);
   static const char *_toPyBufferFormatCode(JS::Scalar::Type subtype);
 
   /**
@@ -0,0 +1,127 @@
+/**
+ * @file CycleCollector.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Collection of the reference cycles going through both the Python and the JavaScript heaps
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_CycleCollector_
+#define PythonMonkey_CycleCollector_
+
+#include "include/ProxyRoots.hh"
+
+#include <Python.h>
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Lets Python's garbage collector see the references that JS objects held by Python proxies have on Python objects.
+ *
+ * A Python object referencing a JS closure that captures that Python object forms a cycle that neither collector can free
+ * alone: the proxy of the closure roots it in the JS heap, and the JS proxy of the Python object holds a reference to it.
+ * When a full Python collection starts while proxies of JS objects exist, the gray bits of the last full JS collection are
+ * used. Since the proxies are gray roots, the JS objects it left gray were only kept alive by Python. Walking the gray graph
+ * reachable from each proxy finds the JS proxies of Python objects and the JS functions wrapping Python functions it holds,
+ * whose Python objects the proxy's tp_traverse then reports as if the proxy referenced them itself. The JS proxies of the
+ * Python objects in the cycles that the Python collection breaks are finalized by the next JS collection.
+ *
+ * A full JS collection is only forced first once the heap has doubled since the last one, and by MIN_FORCED_GC_GROWTH at least,
+ * so that Python collections do not keep stopping the program for full JS collections. Otherwise the cycles are those the
+ * last JS collection saw: JS objects made unreachable from JavaScript since, or created since, are only part of the cycles
+ * found after the next JS collection, be it triggered by allocations, run while idle, or by pythonmonkey.collect.
+ *
+ * A Python object held by a JS thing reachable from several proxies is not reported by any of them, as the Python collector
+ * would otherwise count the same reference more than once: cycles going through a JS object shared by several proxies
+ * are not collected, nor are any cycles when the gray graph is too large to walk, in which case no full JS collection is
+ * forced again until the heap is smaller than it was then.
+ */
+struct CycleCollector {
+public:
+  /**
+   * @brief Append the callback starting and ending the work of each collection to gc.callbacks, called by each interpreter importing pythonmonkey
+   *
+   * @return false with a Python exception set on failure
+   */
+  static bool install();
+
+  /**
+   * @brief Report to `visit` the Python objects that the JS object of `root` holds, for the tp_traverse of the proxies
+   */
+  static int traverse(ProxyRoot *root, visitproc visit, void *arg) {
+    if (edges.empty() || !root) {
+      return 0;
+    }
+    auto found = edges.find(root);
+    if (found != edges.end()) {
+      for (PyObject *held: found->second) {
+        Py_VISIT(held);
+      }
+    }
+    return 0;
+  }
+
+  /**
+   * @brief Drop the references found from `root`, which is being released
+   */
+  static void forget(ProxyRoot *root) {
+    if (!edges.empty()) {
+      edges.erase(root);
+    }
+  }
+
+  /**
+   * @brief Implementation of pythonmonkey.set_cycle_collection
+   */
+  static PyObject *configure(PyObject *enabled);
+
+  static bool isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return how many references from JS to Python objects were reported to Python's garbage collector, on any thread
+   */
+  static size_t edgeCount() {
+    return edgesFound.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return how many full JS collections Python collections forced, on any thread
+   */
+  static size_t forcedGCCount() {
+    return forcedGCs.load(std::memory_order_relaxed);
+  }
+
+private:
+  /**
+   * @brief The gc.callbacks callback, called with the phase of the collection and its info dict
+   */
+  static PyObject *gcCallback(PyObject *self, PyObject *args);
+
+  /**
+   * @brief Find the references that the proxies of the current thread's JSContext report, when a full collection starts
+   */
+  static void begin();
+
+  /**
+   * @brief Forget them when the collection ends
+   */
+  static void end();
+
+  static constexpr size_t MIN_FORCED_GC_GROWTH = 32 * 1024 * 1024;
+
+  static inline std::atomic<bool> enabled = true;
+  static inline std::atomic<size_t> edgesFound = 0;
+  static inline std::atomic<size_t> forcedGCs = 0;
+
+  static inline thread_local std::unordered_map<ProxyRoot *, std::vector<PyObject *>> edges; /**< the Python objects each proxy's JS object holds, during a collection */
+  static inline thread_local bool collecting = false;
+  static inline thread_local size_t overBudgetHeapBytes = 0; /**< the size of the heap when the last walk went over its budget, or 0 */
+};
+
+#endif
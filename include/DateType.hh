@@ -33,6 +33,11 @@ public:
    * @param pyObject - the python datetime object to be converted
    */
   static JSObject *toJsDate(JSContext *cx, PyObject *pyObject);
+
+  /**
+   * @return whether `pyObject` is a datetime of the current interpreter's datetime module. An interpreter that cannot import datetime has none.
+   */
+  static bool isPyDateTime(PyObject *pyObject);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,78 @@
+/**
+ * @file GCParameters.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief The garbage collector parameters set by pythonmonkey.set_gc_params, and MemoryError on JavaScript running out of memory
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_GCParameters_
+#define PythonMonkey_GCParameters_
+
+#include <jsapi.h>
+
+#include <Python.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+
+/**
+ * @brief GC parameters apply to the runtime of a JSContext and can only be set on its own thread, so the parameters
+ * set by pythonmonkey.set_gc_params are kept here, applied to the calling thread's context right away and to the other
+ * threads' contexts the next time they run JavaScript (see GCScheduler::applySettings), including contexts created later.
+ * A parameter given a value overrides the settings of idle collection, a parameter set to None gives control back to them.
+ */
+struct GCParameters {
+public:
+  /**
+   * @brief Implementation of pythonmonkey.set_gc_params, taking the parameters as keyword arguments
+   */
+  static PyObject *set(PyObject *args, PyObject *kwargs);
+
+  /**
+   * @return PyObject* - a new dict with the parameters in effect for the JSContext of the current thread, as read back from SpiderMonkey
+   */
+  static PyObject *get(JSContext *cx);
+
+  /**
+   * @brief Set the requested parameters on `cx`
+   */
+  static void apply(JSContext *cx);
+
+  /**
+   * @return whether `key` was given a value by pythonmonkey.set_gc_params, rather than left to its default
+   */
+  static bool isSet(JSGCParamKey key);
+
+  /**
+   * @brief The OOM callback of every JSContext, called when an allocation fails for good
+   */
+  static void onOutOfMemory(JSContext *cx, void *data);
+
+  /**
+   * @brief If `cx` failed for lack of memory, clear its pending exception and raise MemoryError, unless a Python exception is already set
+   *
+   * @return whether `cx` ran out of memory
+   */
+  static bool raiseOutOfMemory(JSContext *cx);
+
+  /**
+   * @return how many times JavaScript ran out of memory, on any thread
+   */
+  static size_t outOfMemoryCount() {
+    return outOfMemoryEvents.load(std::memory_order_relaxed);
+  }
+
+private:
+  static inline std::mutex mutex; /**< guards `requested` */
+  static inline std::map<JSGCParamKey, std::optional<uint32_t>> requested; /**< nullopt to reset a parameter to its default */
+  static inline std::atomic<size_t> outOfMemoryEvents = 0;
+  static inline thread_local bool outOfMemory = false; /**< set by the OOM callback until the failure reaches Python */
+};
+
+#endif
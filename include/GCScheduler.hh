@@ -0,0 +1,135 @@
+/**
+ * @file GCScheduler.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Garbage collection requested by pythonmonkey.collect, and incremental collection while the asyncio event-loop is idle
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_GCScheduler_
+#define PythonMonkey_GCScheduler_
+
+#include <jsapi.h>
+
+#include <Python.h>
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Runs the garbage collector of the JSContext of the current thread when the program has time for it.
+ *
+ * With idle collection enabled by pythonmonkey.set_idle_gc(True), JavaScript running on a thread with a running asyncio
+ * event-loop arms a callback on that loop. When the callback finds no other callback ready to run, it spends at most
+ * `sliceBudgetMs` on a slice of an incremental collection, started once the heap has grown by `thresholdBytes` since the
+ * last collection, and arms itself again until the collection is done. Collections triggered by allocations are then
+ * incremental too, with slices of the same budget, so that no full collection stops the program in the middle of a request.
+ */
+struct GCScheduler {
+public:
+  enum class Kind {
+    full, /**< a non-incremental collection of the whole heap, the default of pythonmonkey.collect */
+    minor, /**< a collection of the nursery, where new objects are allocated */
+    incremental, /**< a slice of an incremental collection, started if none is in progress */
+    shrinking, /**< a full collection that also compacts the heap and releases unused memory to the system */
+  };
+
+  /**
+   * @brief Parse the `kind` argument of pythonmonkey.collect
+   *
+   * @return false with a ValueError set if `name` is not a kind of collection
+   */
+  static bool parseKind(const char *name, Kind *kind);
+
+  /**
+   * @brief Collect garbage in the heap of `cx`
+   *
+   * @param budgetMs - the time budget of an incremental slice, or 0 for the configured one
+   * @return whether no incremental collection is left in progress
+   */
+  static bool collect(JSContext *cx, Kind kind, int64_t budgetMs);
+
+  /**
+   * @brief Set the GC parameters of a new JSContext, called by initJSContext
+   */
+  static void initContext(JSContext *cx);
+
+  /**
+   * @brief Arm the idle callback on the running event-loop of the current thread, if idle collection is enabled and it is not armed yet.
+   * Called whenever JavaScript runs from Python or from the event-loop.
+   */
+  static void schedule();
+
+  /**
+   * @brief Record the size of the heap of `cx` after a collection, called by the GC callback
+   */
+  static void onGCEnd(JSContext *cx);
+
+  /**
+   * @return how much the heap of `cx`, the context of the current thread, has grown since its last collection ended
+   */
+  static size_t bytesSinceGC(JSContext *cx);
+
+  /**
+   * @return the size of the heap of the current thread's context when its last collection ended, or 0 if none has run
+   */
+  static size_t heapBytesAfterLastGC() {
+    return heapBytesAfterGC;
+  }
+
+  /**
+   * @brief Implementation of pythonmonkey.set_idle_gc
+   */
+  static PyObject *configure(PyObject *args, PyObject *kwargs);
+
+  /**
+   * @return PyObject* - a new dict with the settings of idle collection, its statistics and the state of the heap of the current thread
+   */
+  static PyObject *info();
+
+  /**
+   * @brief Apply the latency settings and the GCParameters to the context of the current thread if they changed since they were last applied to it
+   */
+  static void applySettings(JSContext *cx);
+
+  /**
+   * @brief Make every thread apply the settings again, the next time it runs JavaScript
+   */
+  static void settingsChanged() {
+    settingsGeneration.fetch_add(1, std::memory_order_release);
+  }
+
+private:
+  /**
+   * @brief Call the idle callback on `loop` after `delaySeconds`, storing a new reference to `loop` in armedLoop
+   */
+  static void arm(PyObject *loop, double delaySeconds);
+
+  /**
+   * @brief The idle callback, run by the event-loop
+   */
+  static PyObject *idleCallback(PyObject *self, PyObject *args);
+
+  /**
+   * @brief Run a slice of garbage collection, starting an incremental collection if the heap has grown enough
+   *
+   * @return whether a collection is left in progress, to be continued by the next idle callback
+   */
+  static bool idleSlice(JSContext *cx);
+
+  static inline std::atomic<bool> idleEnabled = false;
+  static inline std::atomic<int64_t> sliceBudgetMs = 5;
+  static inline std::atomic<double> delaySeconds = 0.1; /**< how long the idle callback waits, when armed or when the event-loop is busy */
+  static inline std::atomic<size_t> thresholdBytes = 1024 * 1024;
+  static inline std::atomic<uint32_t> settingsGeneration = 1; /**< incremented by settingsChanged, so that each thread applies the new settings */
+  static inline std::atomic<size_t> idleSlices = 0;
+  static inline std::atomic<size_t> idleCollections = 0;
+
+  static inline thread_local uint32_t appliedGeneration = 0;
+  static inline thread_local PyObject *armedLoop = nullptr; /**< strong reference to the event-loop the idle callback is armed on */
+  static inline thread_local size_t heapBytesAfterGC = 0;
+};
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file HelperThreads.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief The threads running SpiderMonkey's helper tasks, stopped around fork() so that forked processes can keep using SpiderMonkey
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_HelperThreads_
+#define PythonMonkey_HelperThreads_
+
+#include <js/HelperThreadAPI.h>
+
+/**
+ * @brief SpiderMonkey runs its helper tasks (off-thread JIT compilation, parallel marking, background sweeping, ...)
+ * on this pool instead of its own threads. fork() only copies the forking thread, so a child forked while a helper thread
+ * runs a task, or holds a lock, inherits SpiderMonkey's state half-updated. beforeFork() lets the running tasks finish
+ * and stops the threads, afterFork() starts them again, in the parent and in the child, for the tasks queued meanwhile.
+ * The pythonmonkey package calls both through os.register_at_fork.
+ * Threads are started on demand, up to the number SpiderMonkey asks for, and exit once idle for IDLE_SECONDS.
+ */
+struct HelperThreads {
+public:
+  /**
+   * @brief Hand SpiderMonkey's helper tasks to this pool. Must be called after JS_Init and before the first JSContext is created
+   */
+  static void init();
+
+  /**
+   * @brief Wait for the running helper tasks to finish, then stop the helper threads and the eval_async compilation threads.
+   * Tasks queued until afterFork() wait for it
+   */
+  static void beforeFork();
+
+  /**
+   * @brief Start helper threads for the tasks queued since beforeFork(), in the parent and in the forked child alike,
+   * since no helper thread was running when forking
+   */
+  static void afterFork();
+
+private:
+  /**
+   * @brief JS::HelperThreadTaskCallback, queuing a task for a helper thread. Called on any thread
+   */
+  static void dispatch(JS::HelperThreadTask *task, JS::DispatchReason reason);
+
+  /**
+   * @brief Start a helper thread if there are fewer idle threads than queued tasks, and fewer threads than maxThreads.
+   * Must be called with the pool's mutex locked
+   */
+  static void startThreadIfNeeded();
+
+  /**
+   * @brief Entry point of the helper threads, running the queued tasks until none is queued for IDLE_SECONDS, or until beforeFork()
+   */
+  static void helperThread(void *unused);
+
+  static constexpr int IDLE_SECONDS = 30;
+};
+
+#endif
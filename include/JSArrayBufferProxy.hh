@@ -0,0 +1,101 @@
+/**
+ * @file JSArrayBufferProxy.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief JSArrayBufferProxy is a custom C-implemented python type that exports the memory of a JS ArrayBuffer, SharedArrayBuffer, TypedArray or DataView through the Python buffer protocol
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_JSArrayBufferProxy_
+#define PythonMonkey_JSArrayBufferProxy_
+
+#include "include/ModuleState.hh"
+
+#include "include/ProxyRoots.hh"
+
+#include <jsapi.h>
+
+#include <Python.h>
+
+/**
+ * @brief The typedef for the backing store that will be used by JSArrayBufferProxy objects.
+ * The memoryviews returned for JS ArrayBuffers, SharedArrayBuffers, TypedArrays and DataViews use a JSArrayBufferProxy as their exporter (`memoryview.obj`),
+ * so the JS object is kept alive for as long as any Python buffer points into its memory.
+ *
+ */
+typedef struct {
+  PyObject_HEAD
+  ProxyRoot *jsBuffer; /**< the ArrayBuffer, SharedArrayBuffer, TypedArray or DataView being exported, unrooted if its context is destroyed */
+  const char *format; /**< struct module format code of one element */
+  Py_ssize_t itemsize; /**< byte size of one element */
+  Py_ssize_t shape; /**< number of elements, computed when the first export is taken */
+  void *data; /**< pointer to the first byte, valid while there are exports */
+  Py_ssize_t exports; /**< number of live Py_buffer exports */
+  bool shared; /**< whether the memory is a SharedArrayBuffer's, which can be neither detached nor moved */
+  bool pinned; /**< whether we are the ones who pinned the length of the JS buffer */
+} JSArrayBufferProxy;
+
+/**
+ * @brief This struct is a bundle of methods used by the JSArrayBufferProxy type
+ *
+ */
+struct JSArrayBufferProxyMethodDefinitions {
+public:
+  /**
+   * @brief Create a new JSArrayBufferProxy for a JS ArrayBuffer, SharedArrayBuffer, TypedArray or DataView.
+   * The data of the JS object is moved out of line first, so that a moving GC cannot invalidate exported pointers.
+   *
+   * @param cx - javascript context pointer
+   * @param bufObj - the object to export
+   * @param format - struct module format code of one element
+   * @param itemsize - byte size of one element
+   * @return PyObject* - the new JSArrayBufferProxy, or NULL with an exception set
+   */
+  static PyObject *JSArrayBufferProxy_new(JSContext *cx, JS::HandleObject bufObj, const char *format, Py_ssize_t itemsize);
+
+  /**
+   * @brief Deallocation method (.tp_dealloc), removes the reference to the underlying JS buffer before freeing the JSArrayBufferProxy
+   *
+   * @param self - The JSArrayBufferProxy to be free'd
+   */
+  static void JSArrayBufferProxy_dealloc(JSArrayBufferProxy *self);
+
+  /**
+   * @brief .bf_getbuffer method, exports the memory of the JS buffer.
+   * The length of the JS buffer is pinned while there are exports, so that it can be neither detached nor resized from JS.
+   *
+   * @param self - The JSArrayBufferProxy
+   * @param view - The Py_buffer to fill in
+   * @param flags - The kind of buffer requested by the consumer
+   * @return 0 on success, -1 with a BufferError set otherwise
+   */
+  static int JSArrayBufferProxy_getbuffer(JSArrayBufferProxy *self, Py_buffer *view, int flags);
+
+  /**
+   * @brief .bf_releasebuffer method, unpins the length of the JS buffer once the last export is released
+   *
+   * @param self - The JSArrayBufferProxy
+   * @param view - The Py_buffer being released
+   */
+  static void JSArrayBufferProxy_releasebuffer(JSArrayBufferProxy *self, Py_buffer *view);
+
+  /**
+   * @brief Get the JS object a Python buffer was exported from, if it covers the whole of it.
+   * This lets JS buffers that went through Python come back to JS as themselves (a DataView stays a DataView, a SharedArrayBuffer stays shared).
+   *
+   * @param pyObject - a JSArrayBufferProxy, or a memoryview of one
+   * @return JSObject* - the exported JS object, or nullptr if pyObject is anything else, only covers part of it, or belongs to the JSContext of another thread
+   */
+  static JSObject *getExportedJsObject(PyObject *pyObject);
+};
+
+/**
+ * @brief The JSArrayBufferProxyType of the interpreter running on the current thread, used by all JSArrayBufferProxy objects
+ */
+inline PyTypeObject *JSArrayBufferProxyType() {
+  return ModuleState::current()->JSArrayBufferProxyType;
+}
+
+#endif
@@ -12,6 +12,7 @@
 #ifndef PythonMonkey_JSArrayIterProxy_
 #define PythonMonkey_JSArrayIterProxy_
 
+#include "include/ModuleState.hh"
 
 #include <jsapi.h>
 
@@ -103,8 +104,10 @@ static PyMethodDef JSArrayIterProxy_methods[] = {
 };
 
 /**
- * @brief Struct for the JSArrayProxyType, used by all JSArrayProxy objects
+ * @brief The JSArrayIterProxyType of the interpreter running on the current thread, used by all JSArrayIterProxy objects
  */
-extern PyTypeObject JSArrayIterProxyType;
+inline PyTypeObject *JSArrayIterProxyType() {
+  return ModuleState::current()->JSArrayIterProxyType;
+}
 
 #endif
\ No newline at end of file
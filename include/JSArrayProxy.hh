@@ -13,6 +13,9 @@
 #define PythonMonkey_JSArrayProxy_
 
 
+#include "include/ModuleState.hh"
+#include "include/ProxyRoots.hh"
+
 #include <jsapi.h>
 
 #include <Python.h>
@@ -24,7 +27,7 @@
  */
 typedef struct {
   PyListObject list;
-  JS::PersistentRootedObject *jsArray;
+  ProxyRoot *jsArray;
 } JSArrayProxy;
 
 /**
@@ -33,6 +36,14 @@ typedef struct {
  */
 struct JSArrayProxyMethodDefinitions {
 public:
+  /**
+   * @brief Raise a RuntimeError unless the JSArray belongs to the JSContext of the current thread, checked on entry by every method
+   *
+   * @param self - The JSArrayProxy
+   * @return whether the JSArray can be used on the current thread
+   */
+  static bool checkOwner(JSArrayProxy *self);
+
   /**
    * @brief Deallocation method (.tp_dealloc), removes the reference to the underlying JSObject before freeing the JSArrayProxy
    *
@@ -256,6 +267,14 @@ public:
    */
   static PyObject *JSArrayProxy_sort(JSArrayProxy *self, PyObject *args, PyObject *kwargs);
 
+  /**
+   * @brief __reduce__ method, pickles the array as its structured clone
+   *
+   * @param self - The JSArrayProxy
+   * @return PyObject* (pythonmonkey.deserialize, (bytes,)), NULL on exception
+   */
+  static PyObject *JSArrayProxy_reduce(JSArrayProxy *self);
+
   /**
    * @brief tp_traverse
    *
@@ -276,29 +295,6 @@ public:
 };
 
 
-/**
- * @brief Struct for the methods that define the Mapping protocol
- *
- */
-static PyMappingMethods JSArrayProxy_mapping_methods = {
-  .mp_length = (lenfunc)JSArrayProxyMethodDefinitions::JSArrayProxy_length,
-  .mp_subscript = (binaryfunc)JSArrayProxyMethodDefinitions::JSArrayProxy_get_subscript,
-  .mp_ass_subscript = (objobjargproc)JSArrayProxyMethodDefinitions::JSArrayProxy_assign_key
-};
-
-/**
- * @brief Struct for the methods that define the Sequence protocol
- *
- */
-static PySequenceMethods JSArrayProxy_sequence_methods = {
-  .sq_length = (lenfunc)JSArrayProxyMethodDefinitions::JSArrayProxy_length,
-  .sq_concat = (binaryfunc)JSArrayProxyMethodDefinitions::JSArrayProxy_concat,
-  .sq_repeat = (ssizeargfunc)JSArrayProxyMethodDefinitions::JSArrayProxy_repeat,
-  .sq_contains = (objobjproc)JSArrayProxyMethodDefinitions::JSArrayProxy_contains,
-  .sq_inplace_concat = (binaryfunc)JSArrayProxyMethodDefinitions::JSArrayProxy_inplace_concat,
-  .sq_inplace_repeat = (ssizeargfunc)JSArrayProxyMethodDefinitions::JSArrayProxy_inplace_repeat
-};
-
 
 PyDoc_STRVAR(py_list_clear__doc__,
   "clear($self, /)\n"
@@ -381,6 +377,12 @@ PyDoc_STRVAR(list_sort__doc__,
   "\n"
   "The reverse flag can be set to sort in descending order.");
 
+PyDoc_STRVAR(list___reduce____doc__,
+  "__reduce__($self, /)\n"
+  "--\n"
+  "\n"
+  "Pickle the array as a copy made with the structured clone algorithm.");
+
 PyDoc_STRVAR(list___reversed____doc__,
   "__reversed__($self, /)\n"
   "--\n"
@@ -404,12 +406,15 @@ static PyMethodDef JSArrayProxy_methods[] = {
   {"count", (PyCFunction)JSArrayProxyMethodDefinitions::JSArrayProxy_count, METH_O, list_count__doc__},
   {"reverse", (PyCFunction)JSArrayProxyMethodDefinitions::JSArrayProxy_reverse, METH_NOARGS, list_reverse__doc__},
   {"sort", (PyCFunction)JSArrayProxyMethodDefinitions::JSArrayProxy_sort, METH_VARARGS|METH_KEYWORDS, list_sort__doc__},
+  {"__reduce__", (PyCFunction)JSArrayProxyMethodDefinitions::JSArrayProxy_reduce, METH_NOARGS, list___reduce____doc__},
   {NULL, NULL}                       /* sentinel */
 };
 
 /**
- * @brief Struct for the JSArrayProxyType, used by all JSArrayProxy objects
+ * @brief The JSArrayProxyType of the interpreter running on the current thread, used by all JSArrayProxy objects
  */
-extern PyTypeObject JSArrayProxyType;
+inline PyTypeObject *JSArrayProxyType() {
+  return ModuleState::current()->JSArrayProxyType;
+}
 
 #endif
\ No newline at end of file
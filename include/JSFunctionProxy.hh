@@ -11,6 +11,9 @@
 #ifndef PythonMonkey_JSFunctionProxy_
 #define PythonMonkey_JSFunctionProxy_
 
+#include "include/ModuleState.hh"
+#include "include/ProxyRoots.hh"
+
 #include <jsapi.h>
 
 #include <Python.h>
@@ -20,7 +23,7 @@
  */
 typedef struct {
   PyObject_HEAD
-  JS::PersistentRootedObject *jsFunc;
+  ProxyRoot *jsFunc;
 } JSFunctionProxy;
 
 /**
@@ -36,6 +39,24 @@ public:
  */
   static void JSFunctionProxy_dealloc(JSFunctionProxy *self);
 
+  /**
+   * @brief Traverse method (.tp_traverse), reports the Python objects held by the JS function, see CycleCollector
+   *
+   * @param self - The JSFunctionProxy
+   * @param visit - The function to be applied on each element of the proxy
+   * @param arg - The argument to the visit function
+   * @return 0 on success
+   */
+  static int JSFunctionProxy_traverse(JSFunctionProxy *self, visitproc visit, void *arg);
+
+  /**
+   * @brief Clear method (.tp_clear)
+   *
+   * @param self - The JSFunctionProxy
+   * @return 0 on success
+   */
+  static int JSFunctionProxy_clear(JSFunctionProxy *self);
+
   /**
    * @brief New method (.tp_new), creates a new instance of the JSFunctionProxy type, exposed as the __new()__ method in python
    *
@@ -58,8 +79,10 @@ public:
 };
 
 /**
- * @brief Struct for the JSFunctionProxyType, used by all JSFunctionProxy objects
+ * @brief The JSFunctionProxyType of the interpreter running on the current thread, used by all JSFunctionProxy objects
  */
-extern PyTypeObject JSFunctionProxyType;
+inline PyTypeObject *JSFunctionProxyType() {
+  return ModuleState::current()->JSFunctionProxyType;
+}
 
 #endif
\ No newline at end of file
@@ -11,6 +11,8 @@
 #ifndef PythonMonkey_JSMethodProxy_
 #define PythonMonkey_JSMethodProxy_
 
+#include "include/ModuleState.hh"
+#include "include/ProxyRoots.hh"
 #include "include/JSFunctionProxy.hh"
 
 #include <jsapi.h>
@@ -23,7 +25,7 @@
 typedef struct {
   PyObject_HEAD
   PyObject *self;
-  JS::PersistentRootedObject *jsFunc;
+  ProxyRoot *jsFunc;
 } JSMethodProxy;
 
 /**
@@ -61,8 +63,10 @@ public:
 };
 
 /**
- * @brief Struct for the JSMethodProxyType, used by all JSMethodProxy objects
+ * @brief The JSMethodProxyType of the interpreter running on the current thread, used by all JSMethodProxy objects
  */
-extern PyTypeObject JSMethodProxyType;
+inline PyTypeObject *JSMethodProxyType() {
+  return ModuleState::current()->JSMethodProxyType;
+}
 
 #endif
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include <jsapi.h>
 
 #include <Python.h>
+#include "include/ModuleState.hh"
 #include "include/pyshim.hh"
 
 
@@ -98,15 +99,6 @@ public:
   static PyObject *JSObjectItemsProxy_mapping(PyObject *self, void *Py_UNUSED(ignored));
 };
 
-/**
- * @brief Struct for the methods that define the Sequence protocol
- *
- */
-static PySequenceMethods JSObjectItemsProxy_sequence_methods = {
-  .sq_length = (lenfunc)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_length,
-  // .sq_contains = TODO tuple support
-};
-
 PyDoc_STRVAR(items_reversed_keys_doc,
   "Return a reverse iterator over the dict keys.");
 
@@ -126,8 +118,10 @@ static PyGetSetDef JSObjectItemsProxy_getset[] = {
 };
 
 /**
- * @brief Struct for the JSObjectItemsProxyType, used by all JSObjectItemsProxy objects
+ * @brief The JSObjectItemsProxyType of the interpreter running on the current thread, used by all JSObjectItemsProxy objects
  */
-extern PyTypeObject JSObjectItemsProxyType;
+inline PyTypeObject *JSObjectItemsProxyType() {
+  return ModuleState::current()->JSObjectItemsProxyType;
+}
 
 #endif
\ No newline at end of file
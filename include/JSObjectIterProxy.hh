@@ -12,6 +12,8 @@
 #define PythonMonkey_JSObjectIterProxy_
 
 
+#include "include/ModuleState.hh"
+
 #include <jsapi.h>
 
 #include <Python.h>
@@ -109,8 +111,10 @@ static PyMethodDef JSObjectIterProxy_methods[] = {
 };
 
 /**
- * @brief Struct for the JSArrayProxyType, used by all JSArrayProxy objects
+ * @brief The JSObjectIterProxyType of the interpreter running on the current thread, used by all JSObjectIterProxy objects
  */
-extern PyTypeObject JSObjectIterProxyType;
+inline PyTypeObject *JSObjectIterProxyType() {
+  return ModuleState::current()->JSObjectIterProxyType;
+}
 
 #endif
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include <jsapi.h>
 
 #include <Python.h>
+#include "include/ModuleState.hh"
 #include "include/pyshim.hh"
 
 
@@ -135,22 +136,6 @@ public:
   static PyObject *JSObjectKeysProxy_mapping(PyObject *self, void *Py_UNUSED(ignored));
 };
 
-/**
- * @brief Struct for the methods that define the Sequence protocol
- *
- */
-static PySequenceMethods JSObjectKeysProxy_sequence_methods = {
-  .sq_length = (lenfunc)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_length,
-  .sq_contains = (objobjproc)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_contains
-};
-
-static PyNumberMethods JSObjectKeysProxy_number_methods = {
-  // .nb_subtract = default is fine
-  .nb_and =  (binaryfunc)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_intersect,
-  // .nb_xor = default is fine
-  // .nb_or = default is fine
-};
-
 PyDoc_STRVAR(isdisjoint_doc,
   "Return True if the view and the given iterable have a null intersection.");
 
@@ -173,8 +158,10 @@ static PyGetSetDef JSObjectKeysProxy_getset[] = {
 };
 
 /**
- * @brief Struct for the JSObjectKeysProxyType, used by all JSObjectKeysProxy objects
+ * @brief The JSObjectKeysProxyType of the interpreter running on the current thread, used by all JSObjectKeysProxy objects
  */
-extern PyTypeObject JSObjectKeysProxyType;
+inline PyTypeObject *JSObjectKeysProxyType() {
+  return ModuleState::current()->JSObjectKeysProxyType;
+}
 
 #endif
\ No newline at end of file
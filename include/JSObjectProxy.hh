@@ -11,6 +11,9 @@
 #ifndef PythonMonkey_JSObjectProxy_
 #define PythonMonkey_JSObjectProxy_
 
+#include "include/ModuleState.hh"
+#include "include/ProxyRoots.hh"
+
 #include <jsapi.h>
 
 #include <Python.h>
@@ -24,7 +27,7 @@
  */
 typedef struct {
   PyDictObject dict;
-  JS::PersistentRootedObject *jsObject;
+  ProxyRoot *jsObject;
 } JSObjectProxy;
 
 /**
@@ -33,6 +36,14 @@ typedef struct {
  */
 struct JSObjectProxyMethodDefinitions {
 public:
+  /**
+   * @brief Raise a RuntimeError unless the JSObject belongs to the JSContext of the current thread, checked on entry by every method
+   *
+   * @param self - The JSObjectProxy
+   * @return whether the JSObject can be used on the current thread
+   */
+  static bool checkOwner(JSObjectProxy *self);
+
   /**
    * @brief Deallocation method (.tp_dealloc), removes the reference to the underlying JSObject before freeing the JSObjectProxy
    *
@@ -220,6 +231,14 @@ public:
    */
   static PyObject *JSObjectProxy_values_method(JSObjectProxy *self);
 
+  /**
+   * @brief __reduce__ method, pickles the object as its structured clone
+   *
+   * @param self - The JSObjectProxy
+   * @return PyObject* (pythonmonkey.deserialize, (bytes,)), NULL on exception
+   */
+  static PyObject *JSObjectProxy_reduce_method(JSObjectProxy *self);
+
   /**
    * @brief items method
    *
@@ -300,29 +319,8 @@ PyDoc_STRVAR(dict_items__doc__,
   "D.items() -> a set-like object providing a view on D's items");
 PyDoc_STRVAR(dict_values__doc__,
   "D.values() -> an object providing a view on D's values");
-
-/**
- * @brief Struct for the methods that define the Mapping protocol
- *
- */
-static PyMappingMethods JSObjectProxy_mapping_methods = {
-  .mp_length = (lenfunc)JSObjectProxyMethodDefinitions::JSObjectProxy_length,
-  .mp_subscript = (binaryfunc)JSObjectProxyMethodDefinitions::JSObjectProxy_get_subscript,
-  .mp_ass_subscript = (objobjargproc)JSObjectProxyMethodDefinitions::JSObjectProxy_assign
-};
-
-/**
- * @brief Struct for the methods that define the Sequence protocol
- *
- */
-static PySequenceMethods JSObjectProxy_sequence_methods = {
-  .sq_contains = (objobjproc)JSObjectProxyMethodDefinitions::JSObjectProxy_contains
-};
-
-static PyNumberMethods JSObjectProxy_number_methods = {
-  .nb_or = (binaryfunc)JSObjectProxyMethodDefinitions::JSObjectProxy_or,
-  .nb_inplace_or = (binaryfunc)JSObjectProxyMethodDefinitions::JSObjectProxy_ior
-};
+PyDoc_STRVAR(reduce__doc__,
+  "Pickle the object as a copy made with the structured clone algorithm");
 
 /**
  * @brief Struct for the other methods
@@ -339,12 +337,15 @@ static PyMethodDef JSObjectProxy_methods[] = {
   {"keys", (PyCFunction)JSObjectProxyMethodDefinitions::JSObjectProxy_keys_method, METH_NOARGS, dict_keys__doc__},
   {"items", (PyCFunction)JSObjectProxyMethodDefinitions::JSObjectProxy_items_method, METH_NOARGS, dict_items__doc__},
   {"values", (PyCFunction)JSObjectProxyMethodDefinitions::JSObjectProxy_values_method, METH_NOARGS, dict_values__doc__},
+  {"__reduce__", (PyCFunction)JSObjectProxyMethodDefinitions::JSObjectProxy_reduce_method, METH_NOARGS, reduce__doc__},
   {NULL, NULL}                  /* sentinel */
 };
 
 /**
- * @brief Struct for the JSObjectProxyType, used by all JSObjectProxy objects
+ * @brief The JSObjectProxyType of the interpreter running on the current thread, used by all JSObjectProxy objects
  */
-extern PyTypeObject JSObjectProxyType;
+inline PyTypeObject *JSObjectProxyType() {
+  return ModuleState::current()->JSObjectProxyType;
+}
 
 #endif
\ No newline at end of file
@@ -14,6 +14,7 @@
 #include <jsapi.h>
 
 #include <Python.h>
+#include "include/ModuleState.hh"
 #include "include/pyshim.hh"
 
 
@@ -107,15 +108,6 @@ public:
   static PyObject *JSObjectValuesProxy_mapping(PyObject *self, void *Py_UNUSED(ignored));
 };
 
-/**
- * @brief Struct for the methods that define the Sequence protocol
- *
- */
-static PySequenceMethods JSObjectValuesProxy_sequence_methods = {
-  .sq_length = (lenfunc)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_length,
-  .sq_contains = (objobjproc)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_contains
-};
-
 PyDoc_STRVAR(reversed_values_doc,
   "Return a reverse iterator over the dict values.");
 
@@ -134,8 +126,10 @@ static PyGetSetDef JSObjectValuesProxy_getset[] = {
 };
 
 /**
- * @brief Struct for the JSObjectValuesProxyType, used by all JSObjectValuesProxy objects
+ * @brief The JSObjectValuesProxyType of the interpreter running on the current thread, used by all JSObjectValuesProxy objects
  */
-extern PyTypeObject JSObjectValuesProxyType;
+inline PyTypeObject *JSObjectValuesProxyType() {
+  return ModuleState::current()->JSObjectValuesProxyType;
+}
 
 #endif
\ No newline at end of file
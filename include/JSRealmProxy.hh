@@ -0,0 +1,115 @@
+/**
+ * @file JSRealmProxy.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief JSRealmProxy is a custom C-implemented python type, exposed as pythonmonkey.Realm, that holds the global object of a separate JS realm
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_JSRealmProxy_
+#define PythonMonkey_JSRealmProxy_
+
+#include "include/ModuleState.hh"
+
+#include <jsapi.h>
+
+#include <Python.h>
+
+/**
+ * @brief The typedef for the backing store that will be used by JSRealmProxy objects. All it contains is a pointer to the global of the realm,
+ * which is null once the realm is closed
+ *
+ */
+typedef struct {
+  PyObject_HEAD
+  JS::PersistentRootedObject *global;
+} JSRealmProxy;
+
+/**
+ * @brief This struct is a bundle of methods used by the JSRealmProxy type
+ *
+ */
+struct JSRealmProxyMethodDefinitions {
+public:
+  /**
+   * @brief New method (.tp_new), creates a realm with its own global object and standard classes
+   *
+   * @param subtype - The type of object to be created, will always be JSRealmProxyType or a derived type
+   * @param args - not used, realms take no arguments
+   * @param kwds - not used
+   * @return PyObject* - the new JSRealmProxy, or NULL with an exception set
+   */
+  static PyObject *JSRealmProxy_new(PyTypeObject *subtype, PyObject *args, PyObject *kwds);
+
+  /**
+   * @brief Deallocation method (.tp_dealloc), unroots the global of the realm, which is then reclaimed by the next GC
+   * unless JS values of the realm are still referenced
+   *
+   * @param self - The JSRealmProxy to be free'd
+   */
+  static void JSRealmProxy_dealloc(JSRealmProxy *self);
+
+  /**
+   * @brief Evaluate JS code in the realm, taking the same arguments as pythonmonkey.eval
+   *
+   * @param self - The JSRealmProxy
+   * @param args - the code and options, as for pythonmonkey.eval
+   * @return PyObject* - The result of evaluating the JS program, coerced to a Python type
+   */
+  static PyObject *JSRealmProxy_eval(JSRealmProxy *self, PyObject *args);
+
+  /**
+   * @brief Unroot the global of the realm now rather than when the JSRealmProxy is garbage collected. Further evaluation raises.
+   *
+   * @param self - The JSRealmProxy
+   * @return PyObject* - None
+   */
+  static PyObject *JSRealmProxy_close(JSRealmProxy *self, PyObject *Py_UNUSED(args));
+
+  /**
+   * @brief Context manager entry (__enter__), returns the realm itself
+   */
+  static PyObject *JSRealmProxy_enter(JSRealmProxy *self, PyObject *Py_UNUSED(args));
+
+  /**
+   * @brief Context manager exit (__exit__), closes the realm
+   */
+  static PyObject *JSRealmProxy_exit(JSRealmProxy *self, PyObject *args);
+
+  /**
+   * @brief Getter of the globalThis attribute, the global object of the realm
+   *
+   * @param self - The JSRealmProxy
+   * @return PyObject* - the global object, as a JSObjectProxy
+   */
+  static PyObject *JSRealmProxy_get_globalThis(JSRealmProxy *self, void *Py_UNUSED(closure));
+};
+
+PyDoc_STRVAR(realm_eval_doc,
+  "eval($self, code, evalOpts={}, /)\n--\n\nEvaluate JavaScript code in this realm, like pythonmonkey.eval");
+PyDoc_STRVAR(realm_close_doc,
+  "close($self, /)\n--\n\nRelease the realm, its global object is reclaimed by the garbage collector");
+
+static PyMethodDef JSRealmProxy_methods[] = {
+  {"eval", (PyCFunction)JSRealmProxyMethodDefinitions::JSRealmProxy_eval, METH_VARARGS, realm_eval_doc},
+  {"close", (PyCFunction)JSRealmProxyMethodDefinitions::JSRealmProxy_close, METH_NOARGS, realm_close_doc},
+  {"__enter__", (PyCFunction)JSRealmProxyMethodDefinitions::JSRealmProxy_enter, METH_NOARGS, NULL},
+  {"__exit__", (PyCFunction)JSRealmProxyMethodDefinitions::JSRealmProxy_exit, METH_VARARGS, NULL},
+  {NULL, NULL}                  /* sentinel */
+};
+
+static PyGetSetDef JSRealmProxy_getset[] = {
+  {"globalThis", (getter)JSRealmProxyMethodDefinitions::JSRealmProxy_get_globalThis, (setter)NULL, "the global object of the realm", NULL},
+  {0}
+};
+
+/**
+ * @brief The JSRealmProxyType of the interpreter running on the current thread, used by all JSRealmProxy objects
+ */
+inline PyTypeObject *JSRealmProxyType() {
+  return ModuleState::current()->JSRealmProxyType;
+}
+
+#endif
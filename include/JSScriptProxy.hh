@@ -0,0 +1,88 @@
+/**
+ * @file JSScriptProxy.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief JSScriptProxy is a custom C-implemented python type that holds a compiled JSScript, which can be executed many times
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_JSScriptProxy_
+#define PythonMonkey_JSScriptProxy_
+
+#include "include/ModuleState.hh"
+
+#include <jsapi.h>
+
+#include <Python.h>
+
+/**
+ * @brief The typedef for the backing store that will be used by JSScriptProxy objects. All it contains is a pointer to the JSScript
+ *
+ */
+typedef struct {
+  PyObject_HEAD
+  JS::PersistentRooted<JSScript *> *jsScript;
+  JSContext *cx; /**< the context that compiled the script, the only one that can execute it */
+} JSScriptProxy;
+
+/**
+ * @brief This struct is a bundle of methods used by the JSScriptProxy type
+ *
+ */
+struct JSScriptProxyMethodDefinitions {
+public:
+  /**
+   * @brief Create a new JSScriptProxy holding a compiled script
+   *
+   * @param cx - javascript context pointer
+   * @param script - the compiled script, which must not have been compiled as run-once
+   * @return PyObject* - the new JSScriptProxy, or NULL with an exception set
+   */
+  static PyObject *JSScriptProxy_new(JSContext *cx, JS::HandleScript script);
+
+  /**
+   * @brief Deallocation method (.tp_dealloc), removes the reference to the underlying JSScript before freeing the JSScriptProxy
+   *
+   * @param self - The JSScriptProxy to be free'd
+   */
+  static void JSScriptProxy_dealloc(JSScriptProxy *self);
+
+  /**
+   * @brief Call method (.tp_call), executes the script in the global scope
+   *
+   * @param self - The JSScriptProxy
+   * @param args - not used, the script takes no arguments
+   * @param kwargs - not used
+   * @return PyObject* - The value of the last expression statement of the script
+   */
+  static PyObject *JSScriptProxy_call(PyObject *self, PyObject *args, PyObject *kwargs);
+
+  /**
+   * @brief Raise a RuntimeError unless the script was compiled by the JSContext of the current thread
+   *
+   * @param self - The JSScriptProxy
+   * @return whether the script can be executed on the current thread
+   */
+  static bool checkOwner(JSScriptProxy *self);
+
+  /**
+   * @brief Execute a compiled script in the current global, and coerce the value of its last expression statement to Python.
+   * A script compiled in another realm is cloned into the current realm first.
+   *
+   * @param cx - javascript context pointer
+   * @param script - the script to execute
+   * @return PyObject* - the result, or NULL with an exception set
+   */
+  static PyObject *execute(JSContext *cx, JS::HandleScript script);
+};
+
+/**
+ * @brief The JSScriptProxyType of the interpreter running on the current thread, used by all JSScriptProxy objects
+ */
+inline PyTypeObject *JSScriptProxyType() {
+  return ModuleState::current()->JSScriptProxyType;
+}
+
+#endif
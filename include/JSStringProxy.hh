@@ -11,10 +11,14 @@
 #ifndef PythonMonkey_JSStringProxy_
 #define PythonMonkey_JSStringProxy_
 
+#include "include/ModuleState.hh"
+#include "include/ProxyRoots.hh"
+
 #include <jsapi.h>
 
 #include <Python.h>
 
+#include <mutex>
 #include <unordered_set>
 
 /**
@@ -23,10 +27,11 @@
  */
 typedef struct {
   PyUnicodeObject str;
-  JS::PersistentRootedValue *jsString;
+  ProxyStringRoot *jsString;
 } JSStringProxy;
 
 extern std::unordered_set<JSStringProxy *> jsStringProxies; // a collection of all JSStringProxy objects, used during a GCCallback to ensure they continue to point to the correct char buffer
+extern std::mutex jsStringProxiesMutex; // guards jsStringProxies, shared by interpreters that do not share a GIL
 
 /**
  * @brief This struct is a bundle of methods used by the JSStringProxy type
@@ -72,8 +77,10 @@ static PyMethodDef JSStringProxy_methods[] = {
 };
 
 /**
- * @brief Struct for the JSStringProxyType, used by all JSStringProxy objects
+ * @brief The JSStringProxyType of the interpreter running on the current thread, used by all JSStringProxy objects
  */
-extern PyTypeObject JSStringProxyType;
+inline PyTypeObject *JSStringProxyType() {
+  return ModuleState::current()->JSStringProxyType;
+}
 
 #endif
\ No newline at end of file
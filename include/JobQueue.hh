@@ -25,7 +25,7 @@ class JobQueue : public JS::JobQueue {
 
 public:
 explicit JobQueue(JSContext *cx);
-~JobQueue() = default;
+~JobQueue();
 
 /**
  * @brief Initialize PythonMonkey's event-loop job queue
@@ -107,6 +107,16 @@ void queueFinalizationRegistryCallback(JSFunction *callback);
  */
 bool runFinalizationRegistryCallbacks(JSContext *cx);
 
+/**
+ * @brief The callback for dispatching an off-thread promise to the event loop, also used by OffThreadCompileTask
+ *          see https://hg.mozilla.org/releases/mozilla-esr102/file/tip/js/public/Promise.h#l580
+ *              https://hg.mozilla.org/releases/mozilla-esr102/file/tip/js/src/vm/OffThreadPromiseRuntimeState.cpp#l160
+ * @param closure - closure, currently the javascript context
+ * @param dispatchable - Pointer to the Dispatchable to be called
+ * @return not shutting down
+ */
+static bool dispatchToEventLoop(void *closure, JS::Dispatchable *dispatchable);
+
 private:
 
 using FunctionVector = JS::GCVector<JSFunction *, 0, js::SystemAllocPolicy>;
@@ -123,16 +133,6 @@ JS::PersistentRooted<FunctionVector> *finalizationRegistryCallbacks;
  */
 js::UniquePtr<JS::JobQueue::SavedJobQueue> saveJobQueue(JSContext *) override;
 
-/**
- * @brief The callback for dispatching an off-thread promise to the event loop
- *          see https://hg.mozilla.org/releases/mozilla-esr102/file/tip/js/public/Promise.h#l580
- *              https://hg.mozilla.org/releases/mozilla-esr102/file/tip/js/src/vm/OffThreadPromiseRuntimeState.cpp#l160
- * @param closure - closure, currently the javascript context
- * @param dispatchable - Pointer to the Dispatchable to be called
- * @return not shutting down
- */
-static bool dispatchToEventLoop(void *closure, JS::Dispatchable *dispatchable);
-
 /**
  * @brief The callback that gets invoked whenever a Promise is rejected without a rejection handler (uncaught/unhandled exception)
  *          see https://hg.mozilla.org/releases/mozilla-esr102/file/tip/js/public/Promise.h#l268
@@ -150,7 +150,7 @@ static void promiseRejectionTracker(JSContext *cx, bool mutedErrors,
 }; // class
 
 /**
- * @brief Send job to the Python event-loop on main thread
+ * @brief Send job to the Python event-loop on the thread of the job's JSContext, the main thread for the main context
  * (Thread-Safe)
  * @param pyFunc - the Python job function
  * @return success
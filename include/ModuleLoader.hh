@@ -0,0 +1,142 @@
+/**
+ * @file ModuleLoader.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Native ES module loader: resolution, a per-realm module map, parallel compilation of module graphs, and dynamic import()
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_ModuleLoader_
+#define PythonMonkey_ModuleLoader_
+
+#include "include/ScriptCache.hh"
+
+#include <jsapi.h>
+#include <js/CompileOptions.h>
+#include <js/experimental/CompileScript.h>
+#include <js/experimental/JSStencil.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Loads ES modules from files, for pythonmonkey.eval with the `module` option and for import() and import declarations.
+ * Specifiers are resolved as Node.js does for files: relative to the importing module (or the current directory for
+ * classic scripts), trying the `.mjs` and `.js` extensions and directory entry points, and bare specifiers are searched
+ * in the node_modules directories above the importing module, then in those of sys.path and the pythonmonkey package.
+ * Each realm keeps its modules in a Map stored in a reserved slot of its global, keyed by absolute path.
+ * A module graph is loaded one level at a time, with the new modules of a level read and compiled in parallel on helper
+ * threads (through the StencilCache when it is enabled), then instantiated on the JSContext's thread.
+ */
+struct ModuleLoader {
+public:
+  /**
+   * @brief The reserved slot of global objects holding their module map.
+   * The global JSClass must be created with JSCLASS_GLOBAL_FLAGS_WITH_SLOTS(1).
+   */
+  static constexpr uint32_t MODULE_MAP_SLOT = JSCLASS_GLOBAL_APPLICATION_SLOTS;
+
+  /**
+   * @brief Install the module resolve, metadata and dynamic import hooks on the runtime of `cx`
+   */
+  static void init(JSContext *cx);
+
+  /**
+   * @brief Compile `source` as a module at the path `options.filename`, then load, link and evaluate its graph in the current realm
+   *
+   * @param cx - pointer to the JSContext
+   * @param source - the UTF-8 source of the module
+   * @param options - the resolved compilation options, relative filenames are made absolute
+   * @return JSObject* - the namespace of the module, or nullptr with a pending JS exception
+   */
+  static JSObject *evaluate(JSContext *cx, const std::string &source, const ScriptOptions &options);
+
+  /**
+   * @brief Resolve and load (without linking or evaluating) the module requested by `moduleRequest`, with its graph.
+   * Already loaded modules are taken from the module map of the current realm.
+   *
+   * @param cx - pointer to the JSContext
+   * @param referencingPrivate - the private value of the importing module (its path), or of the importing script
+   * @param moduleRequest - the module request, holding the specifier
+   * @return JSObject* - the module, or nullptr with a pending JS exception
+   */
+  static JSObject *loadImportedModule(JSContext *cx, JS::HandleValue referencingPrivate, JS::HandleObject moduleRequest);
+
+private:
+  /**
+   * @brief A module file to read and compile on a helper thread
+   */
+  struct ModuleJob {
+    ModuleJob(std::string path) : path(std::move(path)), options(JS::OwningCompileOptions::ForFrontendContext()) {}
+    ~ModuleJob();
+
+    std::string path;
+    std::string source;
+    bool read = false;
+    bool readFailed = false;
+    bool compiled = false; /**< compiled rather than decoded from the StencilCache */
+    JS::FrontendContext *fc = nullptr;
+    JS::OwningCompileOptions options;
+    RefPtr<JS::Stencil> stencil;
+  };
+
+  using ModuleJobs = std::vector<std::unique_ptr<ModuleJob>>;
+
+  static constexpr size_t STACK_QUOTA = 256 * 1024; // below the smallest default stack size of a secondary thread (512kB on macOS)
+
+  static JSObject *resolveHook(JSContext *cx, JS::HandleValue referencingPrivate, JS::HandleObject moduleRequest);
+  static bool metadataHook(JSContext *cx, JS::HandleValue privateValue, JS::HandleObject metaObject);
+  static bool dynamicImportHook(JSContext *cx, JS::HandleValue referencingPrivate, JS::HandleObject moduleRequest, JS::HandleObject promise);
+
+  /**
+   * @brief Resolve `specifier` imported by the module at `referrer` (empty for classic scripts) to the absolute path of a module file
+   *
+   * @return false if the module can't be found, with a pending JS exception
+   */
+  static bool resolve(JSContext *cx, const std::string &specifier, const std::string &referrer, std::string &path);
+
+  /**
+   * @brief Find the module file at `candidate`, trying the module extensions, then as a directory with a package.json or an index file
+   */
+  static bool resolveFile(JSContext *cx, const std::filesystem::path &candidate, std::string &path);
+
+  /**
+   * @brief Read the entry point of an ES module package from its package.json: "exports", then "module", then "main"
+   */
+  static bool readPackageEntry(JSContext *cx, const std::filesystem::path &packageJson, std::string &entry);
+
+  /**
+   * @brief Load the modules requested by the modules of `frontier`, level by level, until the whole graph is loaded
+   */
+  static bool loadGraph(JSContext *cx, JS::MutableHandleObjectVector frontier);
+
+  /**
+   * @brief Read and compile `jobs` in parallel, then instantiate and register them in the module map, appending them to `loaded`
+   */
+  static bool loadAll(JSContext *cx, ModuleJobs &jobs, JS::MutableHandleObjectVector loaded);
+
+  /**
+   * @brief Read, and if `compile` compile, the sources of `jobs` on up to one thread per core, the calling thread included
+   */
+  static void runInParallel(ModuleJobs &jobs, bool compile);
+
+  /**
+   * @brief Instantiate a module stencil compiled from the file at `path`, and register it in the module map
+   */
+  static JSObject *instantiate(JSContext *cx, const JS::ReadOnlyCompileOptions &options, JS::Stencil *stencil, const std::string &path);
+
+  static JSObject *getModuleMap(JSContext *cx);
+  static bool getModule(JSContext *cx, const std::string &path, JS::MutableHandleObject module);
+  static bool setModule(JSContext *cx, const std::string &path, JS::HandleObject module);
+
+  /**
+   * @return the path of a module from its private value, or an empty string for classic scripts
+   */
+  static std::string getModulePath(JSContext *cx, JS::HandleValue privateValue);
+};
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * @file ModuleState.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief The state of the pythonmonkey module in each Python interpreter: its heap types, exception type and event-loop bookkeeping
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_ModuleState_
+#define PythonMonkey_ModuleState_
+
+#include "include/PyEventLoop.hh"
+#include "include/ProxyFreeList.hh"
+
+#include <Python.h>
+#include "include/pyshim.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+struct ThreadContext;
+
+/**
+ * @brief The non-dunder attribute names of a type and its bases, cached by PyObjectProxyHandler
+ */
+struct TypeAttributeNames {
+  PyObject *names; /**< sorted list of the names */
+  PyObject *nameSet; /**< the same names as a frozenset, for merging in the instance's own attributes */
+  PyObject *typeRef; /**< weak reference to a heap type, whose callback drops the entry once the type is freed, or NULL for a static type */
+  std::list<PyTypeObject *>::iterator lruPosition; /**< the type's position in ModuleState::typeAttributeNamesLRU */
+#if PY_VERSION_HEX >= 0x030c0000
+  bool modified = false; /**< set by the type watcher once the type or one of its bases changed, the names being computed again on next use */
+#else
+  unsigned int versionTag = 0; /**< the type's tp_version_tag when the names were computed, which changing the type or one of its bases invalidates */
+#endif
+};
+
+/**
+ * @brief Python objects cannot be shared between interpreters, so each interpreter importing pythonmonkey gets its own
+ * types, SpiderMonkeyError and timers. The state is created by the exec slot of the module and destroyed with the module object,
+ * which holds a pointer to it as its per-module state. An interpreter loads the module once.
+ *
+ * The state of the interpreter running on the current thread is found through ModuleState::current(), and is cached per thread.
+ */
+struct ModuleState {
+public:
+  /**
+   * @brief Create the state of the interpreter running on the current thread
+   *
+   * @return the state, or nullptr with a Python exception set if the interpreter already has one
+   */
+  static ModuleState *create();
+
+  /**
+   * @brief Destroy the state along with the JSContexts of the interpreter's threads, once its module object is freed
+   */
+  static void destroy(ModuleState *state);
+
+  /**
+   * @return the state of the interpreter running on the current thread. The GIL must be held, and pythonmonkey imported in that interpreter.
+   */
+  static ModuleState *current() {
+    PyInterpreterState *interpreter = PyThreadState_GetInterpreter(PyThreadState_Get());
+    if (interpreter == cachedInterpreter && cachedGeneration == generation.load(std::memory_order_acquire)) {
+      return cachedState;
+    }
+    return lookup(interpreter);
+  }
+
+  int traverse(visitproc visit, void *arg);
+  void clear();
+
+  PyInterpreterState *interpreter;
+  bool mainInterpreter; /**< whether this is the state of the main interpreter, which owns the main JSContext */
+
+  PyTypeObject *NullType = nullptr;
+  PyTypeObject *BigIntType = nullptr;
+  PyTypeObject *JSObjectProxyType = nullptr;
+  PyTypeObject *JSStringProxyType = nullptr;
+  PyTypeObject *JSFunctionProxyType = nullptr;
+  PyTypeObject *JSMethodProxyType = nullptr;
+  PyTypeObject *JSArrayProxyType = nullptr;
+  PyTypeObject *JSArrayBufferProxyType = nullptr;
+  PyTypeObject *JSScriptProxyType = nullptr;
+  PyTypeObject *JSRealmProxyType = nullptr;
+  PyTypeObject *JSArrayIterProxyType = nullptr;
+  PyTypeObject *JSObjectIterProxyType = nullptr;
+  PyTypeObject *JSObjectKeysProxyType = nullptr;
+  PyTypeObject *JSObjectValuesProxyType = nullptr;
+  PyTypeObject *JSObjectItemsProxyType = nullptr;
+  PyObject *SpiderMonkeyError = nullptr;
+  void *dateTimeAPI = nullptr; /**< the PyDateTime_CAPI of the interpreter's datetime module, imported on first use by DateType */
+
+  ProxyFreeList JSObjectProxyFreeList;
+  ProxyFreeList JSStringProxyFreeList;
+  ProxyFreeList JSFunctionProxyFreeList;
+  ProxyFreeList JSArrayProxyFreeList;
+
+  PyEventLoop::Lock *locker = nullptr; /**< the event-loop shield of pythonmonkey.wait */
+  std::vector<PyEventLoop::AsyncHandle> timers; /**< timeoutID => AsyncHandle, see PyEventLoop::AsyncHandle::getUniqueId */
+  std::vector<ThreadContext *> threadContexts; /**< the JSContexts of a subinterpreter, one per thread that used JavaScript in it */
+
+  std::unordered_map<PyTypeObject *, TypeAttributeNames> typeAttributeNames; /**< the types are not kept alive, see TypeAttributeNames::typeRef */
+  std::list<PyTypeObject *> typeAttributeNamesLRU; /**< the types of typeAttributeNames, the most recently used first */
+  PyObject *typeAttributeNamesEvictor = nullptr; /**< the callback of the weak references of typeAttributeNames */
+#if PY_VERSION_HEX >= 0x030c0000 // type watchers are new in Python 3.12
+  int typeWatcher = -1; /**< the PyType_AddWatcher id invalidating typeAttributeNames, or -1 until it is first used */
+#endif
+
+  /**
+   * @brief Drop the entry of `type` from typeAttributeNames, if any
+   */
+  void evictTypeAttributeNames(PyTypeObject *type);
+
+  /**
+   * @brief Drop all the entries of typeAttributeNames
+   */
+  void clearTypeAttributeNames();
+
+private:
+  explicit ModuleState(PyInterpreterState *interpreter);
+  ~ModuleState();
+
+  static ModuleState *lookup(PyInterpreterState *interpreter);
+
+  static inline std::atomic<uint64_t> generation = 0; /**< incremented whenever a state is destroyed, invalidating the caches of all threads */
+  static inline thread_local PyInterpreterState *cachedInterpreter = nullptr;
+  static inline thread_local ModuleState *cachedState = nullptr;
+  static inline thread_local uint64_t cachedGeneration = 0;
+};
+
+#endif
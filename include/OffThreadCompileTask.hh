@@ -0,0 +1,108 @@
+/**
+ * @file OffThreadCompileTask.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Compile a script to a stencil on a helper thread, then execute it on the thread running the Python event-loop
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_OffThreadCompileTask_
+#define PythonMonkey_OffThreadCompileTask_
+
+#include "include/PyEventLoop.hh"
+
+#include <jsapi.h>
+#include <js/CompileOptions.h>
+#include <js/experimental/CompileScript.h>
+#include <js/experimental/JSStencil.h>
+#include <js/Promise.h>
+
+#include <Python.h>
+
+#include <cstdio>
+#include <string>
+
+/**
+ * @brief The work of one pythonmonkey.eval_async call.
+ * The source is parsed and compiled to a stencil on a helper thread, which touches neither the JSContext nor Python.
+ * Helper threads are shared by all calls: they are started on demand, up to one per core, take the queued tasks in order,
+ * and exit once idle for IDLE_SECONDS.
+ * The task is then handed back through JobQueue::dispatchToEventLoop, and run() instantiates and executes the script
+ * on the thread owning the JSContext, settling the asyncio.Future returned to Python with its result.
+ */
+struct OffThreadCompileTask : public JS::Dispatchable {
+public:
+  /**
+   * @brief Queue `code`, or the contents of `file`, for compilation on a helper thread
+   *
+   * @param cx - pointer to the JSContext, whose current global the script will run in
+   * @param options - the compile options, copied for use off-thread
+   * @param code - the UTF-8 source, or empty if it is read from `file`
+   * @param file - an open stream that the helper thread reads and closes, or NULL
+   * @param future - the asyncio.Future to settle with the result of the script
+   * @return true - the task has started, and owns itself until run() is called
+   * @return false - the task could not be started, an exception has been raised and the file is closed
+   */
+  static bool start(JSContext *cx, const JS::ReadOnlyCompileOptions &options, std::string &&code, FILE *file,
+    PyEventLoop::Future &&future);
+
+  /**
+   * @brief Instantiate and execute the compiled script, settle the future, and delete the task. Called on the event-loop thread.
+   */
+  void run(JSContext *cx, JS::Dispatchable::MaybeShuttingDown maybeShuttingDown) override;
+
+  /**
+   * @brief Wait for the compilations in progress, then stop the helper threads, see HelperThreads::beforeFork()
+   */
+  static void beforeFork();
+
+  /**
+   * @brief Start helper threads for the tasks queued since beforeFork()
+   */
+  static void afterFork();
+
+private:
+  OffThreadCompileTask(JSContext *cx, std::string &&code, FILE *file, PyEventLoop::Future &&future);
+  ~OffThreadCompileTask();
+
+  /**
+   * @brief Read the source if needed and compile it, then dispatch the task back to its JSContext. Called on a helper thread.
+   */
+  void compile();
+
+  /**
+   * @brief Hand `task` to an idle helper thread, or to a new one if none is idle and there are fewer than one per core
+   *
+   * @return false if no helper thread is running and none could be started
+   */
+  static bool enqueue(OffThreadCompileTask *task);
+
+  /**
+   * @brief Start a helper thread if there are fewer idle threads than queued tasks, and fewer threads than cores.
+   * Must be called with the queue's mutex locked
+   *
+   * @return false if no helper thread is running and none could be started
+   */
+  static bool startThreadIfNeeded();
+
+  /**
+   * @brief Entry point of the helper threads, compiling the queued tasks until none is queued for IDLE_SECONDS
+   */
+  static void helperThread(void *unused);
+
+  static constexpr size_t STACK_QUOTA = 1024 * 1024; // the parser recurses, leave it most of a default thread stack
+  static constexpr int IDLE_SECONDS = 30;
+
+  JSContext *cx;
+  JS::PersistentRootedObject global;
+  JS::FrontendContext *fc;
+  JS::OwningCompileOptions options;
+  std::string code;
+  FILE *file;
+  RefPtr<JS::Stencil> stencil;
+  PyEventLoop::Future future;
+};
+
+#endif
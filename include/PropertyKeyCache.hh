@@ -0,0 +1,73 @@
+/**
+ * @file PropertyKeyCache.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Cache of atomized JS property keys for Python str objects, used when enumerating proxied dicts and objects
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_PropertyKeyCache_
+#define PythonMonkey_PropertyKeyCache_
+
+#include <jsapi.h>
+#include <js/GCVector.h>
+
+#include <Python.h>
+
+/**
+ * @brief Direct-mapped cache from Python str keys to atomized jsids.
+ * Enumerating the same dict (or dicts sharing keys, as JSON-like records do) repeatedly hits the cache instead of
+ * creating and atomizing a fresh JS string per key. The cache holds a strong reference to each cached str, so a slot can
+ * be matched by pointer identity alone, and roots the ids so the atoms stay alive for as long as they are cached.
+ *
+ * Atoms belong to the runtime of the JSContext that created them, and the str keys to the interpreter of that context,
+ * so each JSContext has a cache of its own, created on first use on its thread.
+ */
+struct PropertyKeyCache {
+public:
+  /**
+   * @brief Convert a Python dict key to a jsid, going through the cache for exact str keys
+   *
+   * @param cx - pointer to the JSContext
+   * @param key - the Python key, either a str or an int
+   * @param idp - out-param, the resulting jsid
+   * @return true - the conversion succeeded
+   * @return false - the key is neither a str nor an int, or an exception has been raised
+   */
+  static bool keyToId(JSContext *cx, PyObject *key, JS::MutableHandleId idp);
+
+  /**
+   * @brief Convert a Python str directly to an atomized jsid from its Latin-1 or UCS-2 storage, without the UTF-8 round trip.
+   * Index-like strings such as "7" become int ids, as they would for any other JS property key.
+   *
+   * @param cx - pointer to the JSContext
+   * @param key - the Python str
+   * @param idp - out-param, the resulting jsid
+   * @return true - the conversion succeeded
+   * @return false - an exception has been raised
+   */
+  static bool strToId(JSContext *cx, PyObject *key, JS::MutableHandleId idp);
+
+  /**
+   * @brief Drop the cache of the JSContext of the current thread. Must be called before that context is destroyed.
+   */
+  static void clear();
+
+private:
+  using IdVector = JS::GCVector<JS::PropertyKey, 0, js::SystemAllocPolicy>;
+
+  static constexpr size_t CACHE_SIZE = 4096; // must be a power of 2
+
+  struct Entries {
+    explicit Entries(JSContext *cx) : ids(cx) {}
+
+    PyObject *keys[CACHE_SIZE] = {};
+    JS::PersistentRooted<IdVector> ids;
+  };
+
+  static inline thread_local Entries *current = nullptr; /**< the cache of the JSContext of this thread */
+};
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * @file ProxyFreeList.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Free lists of the Python proxies of JS objects, arrays, functions and strings
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_ProxyFreeList_
+#define PythonMonkey_ProxyFreeList_
+
+#include <Python.h>
+
+#include <cstddef>
+
+/**
+ * @brief The deallocated instances of a proxy type of an interpreter, kept for reuse like CPython keeps those of floats and tuples.
+ *
+ * A JS value crossing into Python creates its proxy directly instead of calling the type, which would look up and call
+ * tp_new and tp_init. A kept instance was untracked and had its JS thing released by its tp_dealloc, but still has the part
+ * of its base type (dict, list or str) initialized, so reusing it only initializes its header again.
+ *
+ * Each interpreter has its own lists in its ModuleState, used with its GIL held.
+ */
+struct ProxyFreeList {
+public:
+  static const size_t MAX_SIZE = 256;
+
+  /**
+   * @return a new reference to an instance of `type` reused from the list, tracked by Python's garbage collector if `type` is a GC type,
+   * or nullptr without an exception set if the list is empty
+   */
+  PyObject *reuse(PyTypeObject *type);
+
+  /**
+   * @return a new reference to an instance of `type` reused from the list, or else created by tp_new,
+   * or nullptr with a Python exception set on failure
+   */
+  PyObject *allocate(PyTypeObject *type);
+
+  /**
+   * @brief Keep `self`, an instance of the list's type untracked by its tp_dealloc, whose reference to its type tp_dealloc then drops
+   *
+   * @return false if the list is full, tp_dealloc then freeing `self`
+   */
+  bool recycle(PyObject *self) {
+    if (size == MAX_SIZE) {
+      return false;
+    }
+    items[size++] = self;
+    return true;
+  }
+
+  /**
+   * @brief Free the kept instances, before their type is released
+   */
+  void clear();
+
+private:
+  PyObject *items[MAX_SIZE];
+  size_t size = 0;
+};
+
+#endif
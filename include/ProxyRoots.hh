@@ -0,0 +1,170 @@
+/**
+ * @file ProxyRoots.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief The roots of the JS things held by the Python proxies JSObjectProxy, JSArrayProxy, JSFunctionProxy, JSMethodProxy and JSStringProxy
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_ProxyRoots_
+#define PythonMonkey_ProxyRoots_
+
+#include <jsapi.h>
+#include <js/GCAPI.h>
+#include <js/RootingAPI.h>
+#include <js/SliceBudget.h>
+#include <js/TracingAPI.h>
+
+#include <cstddef>
+
+template <typename Root> struct RootTable;
+struct ContextRoots;
+
+/**
+ * @brief A slot of the root table of a JSContext, holding a T
+ */
+template <typename T>
+class ProxyRootSlot {
+protected:
+  friend struct ProxyRoots;
+
+  JS::Heap<T> value;
+  ProxyRootSlot<T> *nextFree = nullptr; /**< the next free slot of its slab, while the slot is free */
+};
+
+/**
+ * @brief The JS object held by a Python proxy. It is used like the JS::PersistentRootedObject it replaces:
+ * as a JS::HandleObject, as a JSObject *, or through get() and set().
+ *
+ * Unlike a JS::PersistentRootedObject, which is a black root, it is traced as a gray root, so that after a full collection
+ * the JS objects only kept alive by Python are told apart from the ones that JavaScript itself can reach (see CycleCollector).
+ * Reading the object exposes it to JavaScript again, as SpiderMonkey requires of gray things.
+ */
+class ProxyRoot : public ProxyRootSlot<JSObject *> {
+public:
+  JSObject *get() const {
+    return value.get(); // JS::Heap::get unmarks gray things
+  }
+
+  operator JSObject *() const {
+    return get();
+  }
+
+  JSObject &operator*() const {
+    return *get();
+  }
+
+  operator JS::HandleObject() const {
+    get();
+    return JS::HandleObject::fromMarkedLocation(value.address());
+  }
+
+  void set(JSObject *obj) {
+    value = obj;
+  }
+
+  /**
+   * @return the JS object without exposing it, leaving it gray for CycleCollector
+   */
+  JSObject *unbarrieredGet() const {
+    return value.unbarrieredGet();
+  }
+};
+
+/**
+ * @brief The JS string whose characters a JSStringProxy shares
+ */
+class ProxyStringRoot : public ProxyRootSlot<JSString *> {
+public:
+  JSString *toString() const {
+    return value.get();
+  }
+
+  void set(JSString *str) {
+    value = str;
+  }
+
+  /**
+   * @return the JS string without exposing it, for reading its characters during a GC callback
+   */
+  JSString *unbarrieredGet() const {
+    return value.unbarrieredGet();
+  }
+};
+
+/**
+ * @brief The root tables of each JSContext: slabs of slots with free lists, one table of objects and one of strings,
+ * traced by a single gray roots tracer. Creating a root pops a free slot and releasing it pushes the slot back, without
+ * allocating, and the tracer scans contiguous slots instead of following SpiderMonkey's list of persistent roots.
+ * A root released on another thread than its context's is queued, and freed by that context's thread the next time it creates one.
+ */
+struct ProxyRoots {
+public:
+  /**
+   * @brief Root `obj` in the JSContext of the current thread
+   */
+  static ProxyRoot *create(JSObject *obj = nullptr);
+
+  /**
+   * @brief Root `str` in the JSContext of the current thread
+   */
+  static ProxyStringRoot *create(JSString *str);
+
+  /**
+   * @brief Unroot `root` and free its slot, from any thread. Does nothing if `root` is nullptr
+   */
+  static void release(ProxyRoot *root);
+  static void release(ProxyStringRoot *root);
+
+  /**
+   * @brief Create the root tables of a new JSContext and set its gray roots tracer, called by initJSContext on the context's thread
+   */
+  static void initContext(JSContext *cx);
+
+  /**
+   * @brief Unroot all the roots of `cx` before it is destroyed, on its own thread.
+   * The Python proxies still holding them raise when used, like the proxies of a destroyed context did with persistent roots.
+   */
+  static void destroyContext(JSContext *cx);
+
+  /**
+   * @brief Call `callback` with each object root of the JSContext of the current thread
+   */
+  static void forEach(void (*callback)(ProxyRoot *root, void *data), void *data);
+
+  /**
+   * @return the number of roots and the number of slots of the JSContext of the current thread
+   */
+  static size_t rootCount();
+  static size_t slotCount();
+
+private:
+  template <typename Root>
+  static Root *allocate(RootTable<Root> *table);
+
+  template <typename Root>
+  static void freeSlot(RootTable<Root> *table, Root *root);
+
+  template <typename Root>
+  static void releaseSlot(Root *root);
+
+  template <typename Root>
+  static void freeReleased(RootTable<Root> *table);
+
+  template <typename Root>
+  static void detach(RootTable<Root> *table);
+
+  template <typename Root>
+  static void trace(JSTracer *trc, RootTable<Root> *table, const char *name);
+
+  /**
+   * @brief The gray roots tracer of every JSContext, `data` being its ContextRoots
+   */
+  static bool traceGray(JSTracer *trc, JS::SliceBudget &budget, void *data);
+
+  static inline thread_local ContextRoots *current = nullptr;
+};
+
+#endif
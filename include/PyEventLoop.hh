@@ -38,7 +38,7 @@ public:
     AsyncHandle(const AsyncHandle &old) = delete; // forbid copy-initialization
     AsyncHandle(AsyncHandle &&old) : _handle(std::exchange(old._handle, nullptr)), _refed(old._refed.exchange(false)), _debugInfo(std::exchange(old._debugInfo, nullptr)) {}; // clear the moved-from object
     ~AsyncHandle() {
-      if (Py_IsInitialized()) { // the Python runtime has already been finalized when `_timeoutIdMap` is cleared at exit
+      if (Py_IsInitialized()) { // the Python runtime has already been finalized when the timers are cleared at exit
         Py_XDECREF(_handle);
       }
     }
@@ -72,12 +72,13 @@ public:
      */
     static inline id_t getUniqueId(AsyncHandle &&handle) {
       // TODO (Tom Tang): mutex lock
-      _timeoutIdMap.push_back(std::move(handle));
-      return _timeoutIdMap.size() - 1; // the index in `_timeoutIdMap`
+      std::vector<AsyncHandle> &timers = getAllTimers();
+      timers.push_back(std::move(handle));
+      return timers.size() - 1; // the index in `timers`
     }
     static inline AsyncHandle *fromId(id_t timeoutID) {
       try {
-        return &_timeoutIdMap.at(timeoutID);
+        return &getAllTimers().at(timeoutID);
       } catch (...) { // std::out_of_range&
         return nullptr; // invalid timeoutID
       }
@@ -119,7 +120,7 @@ public:
       if (!_refed) {
         _refed = true;
         if (!_finishedOrCancelled()) { // noop if the timer is finished or canceled
-          PyEventLoop::_locker->incCounter();
+          PyEventLoop::getLocker()->incCounter();
         }
       }
     }
@@ -130,7 +131,7 @@ public:
     inline void removeRef() {
       if (_refed) {
         _refed = false;
-        PyEventLoop::_locker->decCounter();
+        PyEventLoop::getLocker()->decCounter();
       }
     }
 
@@ -145,11 +146,9 @@ public:
     }
 
     /**
-     * @brief Get an iterator for the `AsyncHandle`s of all timers
+     * @brief Get the `AsyncHandle`s of all timers of the interpreter running on the current thread, indexed by timeoutID
      */
-    static inline auto &getAllTimers() {
-      return _timeoutIdMap;
-    }
+    static std::vector<AsyncHandle> &getAllTimers();
   protected:
     PyObject *_handle;
     std::atomic_bool _refed = false;
@@ -261,6 +260,13 @@ public:
    */
   static PyEventLoop getMainLoop();
 
+  /**
+   * @brief Get the running Python event-loop on the thread of `tstate`, or
+   *        raise a Python RuntimeError if no event-loop running on that thread
+   * @return an instance of `PyEventLoop`
+   */
+  static PyEventLoop getLoopOnThread(PyThreadState *tstate);
+
   struct Lock {
   public:
     explicit Lock() {
@@ -305,7 +311,10 @@ public:
     std::atomic_int _counter = 0;
   };
 
-  static inline PyEventLoop::Lock *_locker;
+  /**
+   * @brief Get the event-loop shield of the interpreter running on the current thread
+   */
+  static PyEventLoop::Lock *getLocker();
 
   PyObject *_loop;
 protected:
@@ -326,9 +335,6 @@ private:
 
   static PyThreadState *_getMainThread();
   static inline PyThreadState *_getCurrentThread();
-
-  // TODO (Tom Tang): use separate pools of IDs for different global objects
-  static inline std::vector<AsyncHandle> _timeoutIdMap;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,144 @@
+/**
+ * @file ScriptCache.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief LRU cache of compiled scripts and functions, consulted by pythonmonkey.eval, pythonmonkey.compile and pythonmonkey.compile_function
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_ScriptCache_
+#define PythonMonkey_ScriptCache_
+
+#include <jsapi.h>
+#include <js/CompilationAndEvaluation.h>
+
+#include <Python.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief The options of pythonmonkey.eval and pythonmonkey.compile that affect compilation, once resolved
+ * (e.g. `fromPythonFrame` resolved to a filename and line number)
+ */
+struct ScriptOptions {
+public:
+  std::string filename = "evaluate";
+  unsigned long lineno = 1;
+  unsigned long column = 0; /**< 0 if unset */
+  bool mutedErrors = false;
+  bool noScriptRval = false;
+  bool selfHosting = false;
+  bool strict = false;
+  bool module = false;
+
+  /**
+   * @brief Set these options on JS::CompileOptions. Whether the script runs once is left to the caller.
+   */
+  void apply(JS::CompileOptions &options) const;
+
+  /**
+   * @returns A string that is equal for two ScriptOptions if and only if they compile the same source to the same script
+   */
+  std::string key() const;
+};
+
+/**
+ * @brief LRU cache of compiled scripts keyed by source and options.
+ * Code evaluated repeatedly from Python (event handlers, templated snippets, the same `pm.eval` in a loop) is parsed and
+ * compiled once. Scripts in the cache are compiled as reusable (not run-once) scripts, and are rooted while cached.
+ * Misses go through the on-disk StencilCache when it is enabled.
+ * Functions compiled by pythonmonkey.compile_function share the cache, keyed by their body, name, parameters and options,
+ * and are cloned for each caller.
+ */
+struct ScriptCache {
+public:
+  /**
+   * @brief Get the script compiled from `code` with `options`, compiling and caching it on a miss
+   *
+   * @param cx - pointer to the JSContext
+   * @param code - the source, an exact Python str
+   * @param options - the resolved compilation options
+   * @return JSScript* - the compiled script, or nullptr if compilation failed and a JS exception is pending
+   */
+  static JSScript *getOrCompile(JSContext *cx, PyObject *code, const ScriptOptions &options);
+
+  /**
+   * @brief Get a new function compiled from `body` with `name`, `params` and `options` in the global scope of the current realm,
+   * compiling and caching it on a miss. Each call returns a new function object, cloned from the cached one and sharing its script,
+   * so that the properties callers set on their functions are not seen by other callers.
+   *
+   * @param cx - pointer to the JSContext
+   * @param name - the name of the function, or nullptr for an anonymous function
+   * @param params - the names of the parameters
+   * @param body - the body of the function, an exact Python str
+   * @param options - the resolved compilation options, `module` and `noScriptRval` are ignored
+   * @return JSObject* - the new function, or nullptr if compilation failed and a JS exception is pending
+   */
+  static JSObject *getOrCompileFunction(JSContext *cx, const char *name, const std::vector<std::string> &params,
+    PyObject *body, const ScriptOptions &options);
+
+  /**
+   * @return PyObject* - a new dict with the `hits`, `misses`, `maxsize` and `currsize` of the cache
+   */
+  static PyObject *info();
+
+  /**
+   * @brief Drop all cached scripts and reset the counters. Must be called before the JSContext is destroyed.
+   */
+  static void clear();
+
+private:
+  static constexpr size_t MAX_SIZE = 256;
+
+  struct Key {
+    Py_hash_t codeHash;
+    std::string options;
+
+    bool operator==(const Key &other) const {
+      return codeHash == other.codeHash && options == other.options;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const {
+      return std::hash<std::string>{}(key.options) ^ (size_t)key.codeHash;
+    }
+  };
+
+  struct Entry {
+    Entry(JSContext *cx, PyObject *code, Key key, JSScript *script) : code(code), key(std::move(key)), script(cx, script), function(cx) {}
+    Entry(JSContext *cx, PyObject *code, Key key, JSFunction *function) : code(code), key(std::move(key)), script(cx), function(cx, function) {}
+
+    PyObject *code; /**< strong reference, to tell apart sources whose hashes collide */
+    Key key;
+    JS::PersistentRooted<JSScript *> script; /**< set for scripts */
+    JS::PersistentRooted<JSFunction *> function; /**< set for functions, the template of their clones */
+  };
+
+  /**
+   * @brief Find the entry for `key` and `code`, counting a hit and making it the most recently used, or count a miss
+   *
+   * @return Entry* - the cached entry, or nullptr on a miss
+   */
+  static Entry *lookup(const Key &key, PyObject *code);
+
+  /**
+   * @brief Cache a newly compiled script or function as the most recently used entry, evicting the least recently used one if full
+   */
+  template<typename T>
+  static void insert(JSContext *cx, PyObject *code, const Key &key, T compiled);
+
+  static void evict(std::list<Entry>::iterator entry);
+
+  static inline std::list<Entry> entries; /**< most recently used first */
+  static inline std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+  static inline size_t hits = 0;
+  static inline size_t misses = 0;
+};
+
+#endif
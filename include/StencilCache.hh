@@ -0,0 +1,105 @@
+/**
+ * @file StencilCache.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief On-disk cache of compiled scripts (XDR-encoded stencils), keyed by a hash of their source and compile options
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_StencilCache_
+#define PythonMonkey_StencilCache_
+
+#include <jsapi.h>
+#include <js/CompilationAndEvaluation.h>
+#include <js/SourceText.h>
+#include <js/experimental/JSStencil.h>
+
+#include <Python.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Directory of XDR-encoded stencils, shared by processes running the same PythonMonkey build.
+ * When enabled, scripts missing from the in-memory ScriptCache are decoded from the directory instead of being parsed,
+ * and newly compiled scripts are written to it. Stencils encoded by another SpiderMonkey build fail to decode and are replaced.
+ * The least recently used files are deleted when the directory grows over its size limit: the size of the directory is
+ * measured when the cache is configured, then tracked as stencils are written, and the directory is only scanned again
+ * when the tracked size goes over the limit.
+ */
+struct StencilCache {
+public:
+  /**
+   * @brief Enable the cache in a directory, creating it if necessary, or disable the cache
+   *
+   * @param directory - the cache directory, or nullptr to disable the cache
+   * @param maxBytes - the size limit of the directory
+   * @return false if the directory could not be created, with an OSError set
+   */
+  static bool configure(const char *directory, size_t maxBytes);
+
+  /**
+   * @returns Whether a cache directory has been configured
+   */
+  static bool enabled();
+
+  /**
+   * @brief Decode the script compiled from `code` with `options` from the cache, or compile it and add it to the cache.
+   * Failing to read or write the cache is never an error, the script is compiled as if the cache was disabled.
+   *
+   * @param cx - pointer to the JSContext
+   * @param options - the compile options, which must not be run-once
+   * @param code - the source as a Python str, hashed along with `optionsKey`
+   * @param source - the same source, ready for compilation
+   * @param optionsKey - the ScriptOptions key of `options`
+   * @return JSScript* - the instantiated script, or nullptr if compilation failed and a JS exception is pending
+   */
+  static JSScript *getOrCompile(JSContext *cx, const JS::CompileOptions &options, PyObject *code,
+    JS::SourceText<mozilla::Utf8Unit> &source, const std::string &optionsKey);
+
+  /**
+   * @brief Decode the stencil compiled from `code` with `options` from the cache, for callers compiling by other means (e.g. modules)
+   *
+   * @param cx - pointer to the JSContext
+   * @param options - the compile options
+   * @param code - the UTF-8 source, hashed along with `optionsKey`
+   * @param optionsKey - the ScriptOptions key of `options`
+   * @return the stencil, or nullptr on a miss
+   */
+  static already_AddRefed<JS::Stencil> lookup(JSContext *cx, const JS::ReadOnlyCompileOptions &options,
+    const std::string &code, const std::string &optionsKey);
+
+  /**
+   * @brief Add a stencil compiled from `code` with the options of `optionsKey` to the cache, ignoring failures
+   */
+  static void store(JSContext *cx, JS::Stencil *stencil, const std::string &code, const std::string &optionsKey);
+
+  /**
+   * @return PyObject* - a new dict with the `directory`, `maxsize` (in bytes), `hits`, `misses` and `writes` of the cache
+   */
+  static PyObject *info();
+
+private:
+  static bool getPath(const char *code, size_t length, const std::string &optionsKey, std::filesystem::path &path);
+  static already_AddRefed<JS::Stencil> read(JSContext *cx, const JS::ReadOnlyCompileOptions &options, const std::filesystem::path &path);
+  static void write(JSContext *cx, JS::Stencil *stencil, const std::filesystem::path &path);
+  /**
+   * @brief Delete the least recently used files until the directory fits in maxBytes, and measure its size again. Called with `mutex` held.
+   */
+  static void trim();
+
+  static inline std::mutex mutex; /**< guards the configuration and trackedBytes, as the contexts of all threads use the cache */
+  static inline std::filesystem::path directory;
+  static inline size_t maxBytes = 0;
+  static inline uintmax_t trackedBytes = 0; /**< the size of the directory when last measured, plus the stencils written since */
+  static inline std::atomic<size_t> hits = 0; // the modules of subinterpreters go through the cache without the GIL of the main interpreter
+  static inline std::atomic<size_t> misses = 0;
+  static inline std::atomic<size_t> writes = 0;
+};
+
+#endif
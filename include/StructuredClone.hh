@@ -0,0 +1,64 @@
+/**
+ * @file StructuredClone.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Copies of JS value graphs with the structured clone algorithm: pythonmonkey.serialize/deserialize, pickling of proxies, and the structuredClone global
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_StructuredClone_
+#define PythonMonkey_StructuredClone_
+
+#include <jsapi.h>
+
+#include <Python.h>
+
+/**
+ * @brief The structured clone algorithm copies Dates, RegExps, typed arrays, Maps, Sets, Errors and cycles, which JSON loses.
+ * Bytes are written in the DifferentProcess scope, so that any process running the same PythonMonkey version can read them.
+ * Neither direction is zero-copy: typed-array contents are copied into the clone data when writing, and once more into the
+ * bytes, and reading copies the data given into clone data, and typed-array contents once more into new ArrayBuffers.
+ */
+struct StructuredClone {
+public:
+  /**
+   * @brief Serialize a value into bytes
+   *
+   * @param cx - javascript context pointer
+   * @param value - the value to serialize
+   * @return PyObject* - a new bytes object, or NULL with a Python exception set
+   */
+  static PyObject *serialize(JSContext *cx, JS::HandleValue value);
+
+  /**
+   * @brief Create a copy of the value serialized into an object supporting the buffer protocol
+   *
+   * @param cx - javascript context pointer
+   * @param data - the bytes returned by serialize
+   * @param rval - the copy
+   * @return true on success, false with a Python exception set
+   */
+  static bool deserialize(JSContext *cx, PyObject *data, JS::MutableHandleValue rval);
+
+  /**
+   * @brief Implement pickling (__reduce__) of JS values, as a call of pythonmonkey.deserialize with their serialized bytes
+   *
+   * @param cx - javascript context pointer
+   * @param value - the value to pickle
+   * @return PyObject* - a new (callable, args) tuple, or NULL with a Python exception set
+   */
+  static PyObject *reduce(JSContext *cx, JS::HandleValue value);
+
+  /**
+   * @brief Define the `structuredClone(value, { transfer })` function on a new global object
+   *
+   * @param cx - javascript context pointer
+   * @param global - the global object, in the current realm
+   * @return true on success, false with a JS exception pending
+   */
+  static bool defineGlobal(JSContext *cx, JS::HandleObject global);
+};
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file ThreadContext.hh
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief The JSContexts of Python threads other than the one that imported pythonmonkey
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#ifndef PythonMonkey_ThreadContext_
+#define PythonMonkey_ThreadContext_
+
+#include "include/JobQueue.hh"
+#include "include/modules/pythonmonkey/pythonmonkey.hh"
+
+#include <jsapi.h>
+#include <jsfriendapi.h>
+#include <js/HeapAPI.h>
+#include <js/shadow/Zone.h>
+
+#include <Python.h>
+#include "include/pyshim.hh"
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief A JSContext belongs to the thread that created it, so each Python thread using JavaScript gets its own.
+ * The thread that imported pythonmonkey uses the main context; any other thread gets a ThreadContext on first use,
+ * in a child runtime of the main one, with its own global, job queue (promise jobs run on the asyncio event-loop of
+ * that thread) and FinalizationRegistry for Python functions. GLOBAL_CX is thread-local and always refers to the
+ * JSContext of the current thread. The context is destroyed when its Python thread ends.
+ *
+ * JS values belong to the context that created them, and their proxies raise RuntimeError when used on any other thread.
+ * Values are passed between threads as Python values: strings, numbers, or copies of JS objects made on their thread.
+ *
+ * Subinterpreters get ThreadContexts too, owned by their ModuleState rather than by a thread state, since they may run on a
+ * new thread state each time. A thread runs the JavaScript of a single interpreter, the first one using JavaScript on it.
+ */
+struct ThreadContext {
+public:
+  /**
+   * @brief Record the runtime of the main JSContext, the parent runtime of the contexts of other threads
+   */
+  static void init(JSContext *mainContext);
+
+  /**
+   * @brief Make sure GLOBAL_CX is set for the current thread, creating a ThreadContext if the thread has no JSContext yet
+   *
+   * @return false with a Python exception set if the context could not be created, or the thread runs the JavaScript of another interpreter
+   */
+  static bool ensure();
+
+  /**
+   * @brief Destroy a context of a subinterpreter if it belongs to the current thread, or leave it behind otherwise
+   */
+  static void destroyOnOwnThread(ThreadContext *context);
+
+  /**
+   * @return the ThreadContext of the current thread, or nullptr on the thread using the main context (or no context yet)
+   */
+  static ThreadContext *current() {
+    return currentContext;
+  }
+
+  /**
+   * @return the ThreadContext that owns `cx`, or nullptr for the main context
+   */
+  static ThreadContext *of(JSContext *cx) {
+    return (ThreadContext *)JS_GetContextPrivate(cx);
+  }
+
+  /**
+   * @return whether `obj` can be used with the JSContext of the current thread.
+   * As long as only the main context exists, true on the thread using it. False for objects of a destroyed context, which have been unrooted.
+   */
+  static bool owns(JSObject *obj) {
+    if (!created.load(std::memory_order_relaxed)) {
+      return GLOBAL_CX;
+    }
+    return obj && GLOBAL_CX &&
+           JS::shadow::Zone::from(js::GetObjectZoneFromAnyThread(obj))->runtimeFromAnyThread() == JS_GetRuntime(GLOBAL_CX);
+  }
+
+  /**
+   * @return whether `str` can be used with the JSContext of the current thread
+   */
+  static bool owns(JSString *str) {
+    if (!created.load(std::memory_order_relaxed)) {
+      return GLOBAL_CX;
+    }
+    return str && GLOBAL_CX &&
+           JS::shadow::Zone::from(JS::GetGCThingZone(JS::GCCellPtr(str)))->runtimeFromAnyThread() == JS_GetRuntime(GLOBAL_CX);
+  }
+
+  /**
+   * @brief Raise a RuntimeError unless `obj` can be used with the JSContext of the current thread
+   *
+   * @return whether `obj` can be used
+   */
+  static bool checkOwner(JSObject *obj) {
+    if (owns(obj)) {
+      return true;
+    }
+    PyErr_SetString(PyExc_RuntimeError, "this JavaScript value belongs to the JSContext of another thread, only Python values can be passed between threads");
+    return false;
+  }
+
+  /**
+   * @return the global object of this context
+   */
+  JSObject *getGlobal() const {
+    return *global;
+  }
+
+  PyThreadState *threadState; /**< the Python thread state last using this context, whose event-loop runs its jobs */
+  PyInterpreterState *interpreter; /**< the interpreter whose Python objects this context references */
+
+private:
+  ThreadContext(JSContext *cx, PyThreadState *threadState) : threadState(threadState), interpreter(PyThreadState_GetInterpreter(threadState)), cx(cx) {}
+  ~ThreadContext();
+
+  /**
+   * @brief Destructor of the capsule stored in the thread state dict, called when the Python thread ends
+   */
+  static void destroy(PyObject *capsule);
+
+  JSContext *cx;
+  JobQueue *jobQueue = nullptr;
+  JS::PersistentRootedObject *global = nullptr;
+  JSAutoRealm *autoRealm = nullptr;
+
+  static inline JSRuntime *mainRuntime = nullptr;
+  static inline thread_local ThreadContext *currentContext = nullptr;
+  static inline thread_local int64_t boundInterpreter = -1; /**< the ID of the interpreter whose JavaScript runs on this thread */
+  static inline std::atomic<bool> created = false; /**< whether any ThreadContext has ever been created */
+};
+
+#endif
@@ -14,10 +14,10 @@
 namespace InternalBinding {
   extern JSFunctionSpec utils[];
   extern JSFunctionSpec timers[];
+  extern JSFunctionSpec fs[];
+  extern JSFunctionSpec structuredClone[];
 }
 
 JSObject *createInternalBindingsForNamespace(JSContext *cx, JSFunctionSpec *methodSpecs);
 JSObject *getInternalBindingsByNamespace(JSContext *cx, JSLinearString *namespaceStr);
 
-JSFunction *createInternalBinding(JSContext *cx);
-PyObject *getInternalBindingPyFn(JSContext *cx);
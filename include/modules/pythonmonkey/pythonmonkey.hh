@@ -19,8 +19,8 @@
 #include <Python.h>
 
 
-extern JSContext *GLOBAL_CX; /**< pointer to PythonMonkey's JSContext */
-extern JS::PersistentRootedObject jsFunctionRegistry; /**<// this is a FinalizationRegistry for JSFunctions that depend on Python functions. It is used to handle reference counts when the JSFunction is finalized */
+extern thread_local JSContext *GLOBAL_CX; /**< pointer to the JSContext of the current thread, see ThreadContext */
+extern thread_local JS::PersistentRootedObject *jsFunctionRegistry; /**<// this is a FinalizationRegistry for JSFunctions that depend on Python functions, one per JSContext. It is used to handle reference counts when the JSFunction is finalized */
 static JS::Rooted<JSObject *> *global; /**< pointer to the global object of PythonMonkey's JSContext */
 static JSAutoRealm *autoRealm; /**< pointer to PythonMonkey's AutoRealm */
 static JobQueue *JOB_QUEUE; /**< pointer to PythonMonkey's event-loop job queue */
@@ -39,10 +39,11 @@ static void cleanup();
  * @brief Function exposed by the python module that calls the spidermonkey garbage collector
  *
  * @param self - Pointer to the module object
- * @param args - Pointer to the python tuple of arguments (not used)
- * @return PyObject* - returns python None
+ * @param args - Pointer to the python tuple of arguments (optionally the kind of collection, see GCScheduler::Kind)
+ * @param kwargs - Pointer to the python dict of keyword arguments (optionally `budget_ms`, the time budget of an incremental slice)
+ * @return PyObject* - returns python True, or False if an incremental collection is left in progress
  */
-static PyObject *collect(PyObject *self, PyObject *args);
+static PyObject *collect(PyObject *self, PyObject *args, PyObject *kwargs);
 
 /**
  * @brief Function exposed by the python module for evaluating arbitrary JS code
@@ -53,6 +54,77 @@ static PyObject *collect(PyObject *self, PyObject *args);
  */
 static PyObject *eval(PyObject *self, PyObject *args);
 
+/**
+ * @brief Function exposed by the python module for compiling JS code once, to be executed many times
+ *
+ * @param self - Pointer to the module object
+ * @param args - Pointer to the python tuple of arguments (same as for eval)
+ * @return PyObject* - A JSScriptProxy which executes the compiled code when called
+ */
+static PyObject *compile(PyObject *self, PyObject *args);
+
+/**
+ * @brief Evaluate JS code in the realm of `evalGlobal`, taking the same arguments as pythonmonkey.eval
+ *
+ * @param evalGlobal - the global object of the realm to evaluate in
+ * @param fname - the name of the Python function, for error messages
+ * @param args - Pointer to the python tuple of arguments (same as for eval)
+ * @return PyObject* - The result of evaluating the JS program, coerced to a Python type, or NULL with an exception set
+ */
+PyObject *evalInGlobal(JS::HandleObject evalGlobal, const char *fname, PyObject *args);
+
+/**
+ * @brief Set up a new JSContext as PythonMonkey uses it: options, job queue, module loader, self-hosted code and GC callbacks
+ *
+ * @param cx - the new JSContext
+ * @param jobQueue - the job queue of the context
+ * @return false with a Python exception set on failure
+ */
+bool initJSContext(JSContext *cx, JobQueue *jobQueue);
+
+/**
+ * @brief Create the global object of a new JSContext, in a new compartment
+ *
+ * @param cx - javascript context pointer
+ * @return JSObject* - the new global, or nullptr with a Python exception set
+ */
+JSObject *newContextGlobal(JSContext *cx);
+
+/**
+ * @brief Create the FinalizationRegistry releasing the Python functions passed to a JSContext, see jsFunctionRegistry
+ *
+ * @param cx - javascript context pointer, in the realm of its global
+ * @return JSObject* - the new FinalizationRegistry, or nullptr with a Python exception set
+ */
+JSObject *newFunctionRegistry(JSContext *cx);
+
+/**
+ * @brief Create the global object of a new realm, with its own standard classes.
+ * The realm shares the compartment of PythonMonkey's global, so that JS values pass freely between realms.
+ *
+ * @param cx - javascript context pointer
+ * @return JSObject* - the new global, or nullptr with a pending JS exception
+ */
+JSObject *newRealmGlobal(JSContext *cx);
+
+/**
+ * @brief Function exposed by the python module for evaluating JS code compiled on a helper thread
+ *
+ * @param self - Pointer to the module object
+ * @param args - Pointer to the python tuple of arguments (same as for eval)
+ * @return PyObject* - An asyncio.Future of the result of evaluating the JS program
+ */
+static PyObject *evalAsync(PyObject *self, PyObject *args);
+
+/**
+ * @brief Function exposed by the python module for compiling a JS function from its name, parameter names and body
+ *
+ * @param self - Pointer to the module object
+ * @param args - Pointer to the python tuple of arguments (name, parameter names, body, and optionally the options of eval)
+ * @return PyObject* - A JSFunctionProxy of the compiled function
+ */
+static PyObject *compileFunction(PyObject *self, PyObject *args);
+
 /**
  * @brief Initialization function for the module. Starts the JSContext, creates the global object, and sets cleanup functions
  *
@@ -73,8 +145,8 @@ extern PyMethodDef PythonMonkeyMethods[];
 extern struct PyModuleDef pythonmonkey;
 
 /**
- * @brief PyObject for spidermonkey error type
+ * @brief PyObject for spidermonkey error type, of the interpreter running on the current thread
  *
  */
-extern PyObject *SpiderMonkeyError;
+PyObject *SpiderMonkeyError();
 #endif
\ No newline at end of file
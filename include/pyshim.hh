@@ -128,6 +128,38 @@ inline PyObject *PyObject_CallOneArg(PyObject *func, PyObject *arg) {
 }
 #endif
 
+/**
+ * @brief Shim for `PyThreadState_GetInterpreter`.
+ *        `PyThreadState_GetInterpreter` is not available in Python < 3.9
+ */
+#if PY_VERSION_HEX < 0x03090000 // Python version is less than 3.9
+inline PyInterpreterState *PyThreadState_GetInterpreter(PyThreadState *tstate) {
+  return tstate->interp;
+}
+#endif
+
+/**
+ * @brief Shim for `PyThreadState_GetUnchecked`.
+ *        Python 3.13 made the private `_PyThreadState_UncheckedGet` public as `PyThreadState_GetUnchecked`.
+ *        Unlike `PyThreadState_Get`, it returns NULL rather than aborting when the thread does not hold the GIL.
+ */
+#if PY_VERSION_HEX < 0x030d0000 // Python version is less than 3.13
+inline PyThreadState *PyThreadState_GetUnchecked() {
+  return _PyThreadState_UncheckedGet();
+}
+#endif
+
+/**
+ * @brief `Py_TPFLAGS_IMMUTABLETYPE` and `Py_TPFLAGS_DISALLOW_INSTANTIATION` are available since Python 3.10.
+ *        Heap types are mutable before that, and get instantiable through `object.__new__` unless their `tp_new` is reset.
+ */
+#ifndef Py_TPFLAGS_IMMUTABLETYPE
+#define Py_TPFLAGS_IMMUTABLETYPE 0
+#endif
+#ifndef Py_TPFLAGS_DISALLOW_INSTANTIATION
+#define Py_TPFLAGS_DISALLOW_INSTANTIATION 0
+#endif
+
 /**
  * @brief Shim for `_PyLong_AsByteArray`.
  *        Python 3.13.0a4 added a new public API `PyLong_AsNativeBytes()` to replace the private `_PyLong_AsByteArray()`.
@@ -1,17 +1,121 @@
 # Export public PythonMonkey APIs
 from .pythonmonkey import *
-from .helpers import *
-from .require import *
+from . import pythonmonkey as _pm
+import collections.abc as _abc
+import os as _os
+import time as _time
+
+# The views of JSObjectProxy cannot subclass the final dict view types, they are registered as the same kinds of views instead
+_abc.KeysView.register(JSObjectKeysProxy)
+_abc.ValuesView.register(JSObjectValuesProxy)
+_abc.ItemsView.register(JSObjectItemsProxy)
+
+# SpiderMonkey's helper threads do not survive fork(), they are stopped around it so that forked processes,
+# such as the workers of ProcessPool, inherit a consistent runtime
+if hasattr(_os, 'register_at_fork'):
+  _os.register_at_fork(before=_pm._before_fork, after_in_parent=_pm._after_fork, after_in_child=_pm._after_fork)
+
+# Cache compiled scripts on disk. Unless a cache is configured for all scripts, the bootstrap below
+# (ctx-module, require and the builtin modules) gets its own per-user cache, so that every import after
+# the first one decodes the compiled bootstrap instead of parsing it again. PYTHONMONKEY_BOOTSTRAP_CACHE
+# overrides its directory, or disables it when empty.
+if _os.environ.get('PYTHONMONKEY_STENCIL_CACHE'):
+  stencil_cache_configure(_os.environ['PYTHONMONKEY_STENCIL_CACHE'],
+                          int(_os.environ.get('PYTHONMONKEY_STENCIL_CACHE_SIZE', 256 * 1024 * 1024)))
+  _bootstrapCache = None
+else:
+  _bootstrapCache = _os.environ.get('PYTHONMONKEY_BOOTSTRAP_CACHE', _os.path.join(
+    _os.environ.get('XDG_CACHE_HOME') or _os.environ.get('LOCALAPPDATA') or _os.path.join(_os.path.expanduser('~'), '.cache'),
+    'pythonmonkey', 'bootstrap'))
+  try:
+    if _bootstrapCache:
+      stencil_cache_configure(_bootstrapCache, 32 * 1024 * 1024)
+  except OSError:  # e.g. read-only home directory, compile the bootstrap every time
+    _bootstrapCache = None
+
+_phaseStart = _time.perf_counter()
+
+
+def _endBootstrapPhase(phase: str):
+  global _phaseStart
+  now = _time.perf_counter()
+  bootstrap_timings[phase] = now - _phaseStart
+  _phaseStart = now
+
+
+from .helpers import *  # noqa: E402
+_endBootstrapPhase('helpers')
+from .require import *  # noqa: E402
+_endBootstrapPhase('require')
+from .worker import Worker  # noqa: E402
+from .process_pool import ProcessPool  # noqa: E402
 
 # Expose the package version
-import importlib.metadata
+import importlib.metadata  # noqa: E402
 __version__ = importlib.metadata.version(__name__)
 del importlib
 
 # Load the module by default to expose global APIs
 # builtin_modules
 require("console")
+_endBootstrapPhase('console')
 require("base64")
-require("timers")
+_endBootstrapPhase('base64')
 require("url")
+_endBootstrapPhase('url')
 require("XMLHttpRequest")
+_endBootstrapPhase('XMLHttpRequest')
+
+
+def _requireTimers():
+  start = _time.perf_counter()
+  require("timers")
+  bootstrap_timings['timers'] = _time.perf_counter() - start
+
+
+# Timers and Worker are loaded on first use of any of their globals. The lazy globals are only
+# removed for good once the module is loaded, a failed load leaves them in place to be retried.
+_lazyGlobals = _pm.eval("""'use strict'; (
+function lazyGlobals(names, requireModule)
+{
+  function load()
+  {
+    const descriptors = names.map((name) => Object.getOwnPropertyDescriptor(globalThis, name));
+    for (const name of names)
+      delete globalThis[name];
+    try
+    {
+      requireModule();
+    }
+    catch (error)
+    {
+      names.forEach((name, i) => {
+        if (!Object.prototype.hasOwnProperty.call(globalThis, name))
+          Object.defineProperty(globalThis, name, descriptors[i]);
+      });
+      throw error;
+    }
+  }
+
+  for (const name of names)
+    Object.defineProperty(globalThis, name, {
+      get: function getLazyGlobal() { load(); return globalThis[name]; },
+      set: function setLazyGlobal(value) { load(); globalThis[name] = value; },
+      enumerable: true,
+      configurable: true,
+    });
+})""", {'filename': __file__})
+_lazyGlobals(['setTimeout', 'clearTimeout', 'setImmediate', 'clearImmediate', 'setInterval', 'clearInterval'], _requireTimers)
+_lazyGlobals(['Worker', 'MessageEvent'], lambda: require("worker"))
+
+
+def __getattr__(name: str):
+  # the debugger global is an accessor on globalThis until first used, so helpers does not export it
+  if name == 'debuggerGlobal':
+    return _pm.eval("debuggerGlobal")
+  raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
+
+
+if _bootstrapCache:
+  stencil_cache_configure(None)
+del _os, _bootstrapCache
@@ -76,4 +76,43 @@ declare function internalBinding(namespace: "timers"): {
   getAllRefedTimersDebugInfo(): TimerDebugInfo[];
 };
 
+declare function internalBinding(namespace: "fs"): {
+  /**
+   * stat() a path, for the module loader. The results are cached by each thread: for existing files until `clearStatCache()`,
+   * for missing ones until `clearMissingPaths()`
+   * @return the `st_mode` of the file, or -1 if it doesn't exist
+   */
+  statMode(filename: string): number;
+
+  /**
+   * Forget the results of `statMode` on this thread
+   */
+  clearStatCache(): void;
+
+  /**
+   * Forget the paths `statMode` found missing on this thread, called when the outermost require() returns
+   */
+  clearMissingPaths(): void;
+
+  /**
+   * Read a whole UTF-8 file as a string. Large files are memory-mapped rather than read.
+   * Throws an Error with a `code` such as 'ENOENT' on failure
+   */
+  readFileUtf8(filename: string): string;
+};
+
+declare function internalBinding(namespace: "structuredClone"): {
+  /**
+   * Serialize a value with the structured clone algorithm, into a message that the JSContext of any thread can read.
+   * ArrayBuffers in `transfer` are moved into the message and detached; SharedArrayBuffers are shared, not copied
+   * @return an opaque message, a Python object
+   */
+  serialize(value: any, transfer?: ArrayBuffer[]): object;
+
+  /**
+   * Create a copy of the value serialized into `message`, in the current JSContext
+   */
+  deserialize(message: object): any;
+};
+
 export = internalBinding;
@@ -0,0 +1,102 @@
+/**
+ * @file     worker.js
+ *           Implement browser-style Worker, running a script in parallel in the JS context of another thread
+ * @see      https://html.spec.whatwg.org/multipage/workers.html#dedicated-workers-and-the-worker-interface
+ * @author   Philippe Laporte <philippe@distributive.network>
+ * @date     October 2026
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ */
+'use strict';
+
+const { EventTarget, Event } = require('event-target');
+const internalBinding = require('internal-binding');
+const { readFileUtf8 } = internalBinding('fs');
+const PyWorker = globalThis.python.eval('__import__("pythonmonkey").Worker');
+
+/**
+ * The event of a message received from a worker
+ * @see https://developer.mozilla.org/en-US/docs/Web/API/MessageEvent
+ */
+class MessageEvent extends Event
+{
+  /**
+   * @param {string} type
+   * @param {{ data?: any }} [eventInitDict]
+   */
+  constructor(type, eventInitDict = {})
+  {
+    super(type);
+    this.data = eventInitDict.data ?? null;
+    this.debugTag = 'worker:';
+  }
+}
+
+/**
+ * The event of an exception raised by the script of a worker or by its `onmessage`
+ */
+class ErrorEvent extends Event
+{
+  /**
+   * @param {string} type
+   * @param {{ error?: any }} [eventInitDict]
+   */
+  constructor(type, eventInitDict = {})
+  {
+    super(type);
+    this.error = eventInitDict.error ?? null;
+    this.message = String(this.error);
+    this.debugTag = 'worker:';
+  }
+}
+
+class Worker extends EventTarget
+{
+  /** @type {import('event-target').EventListenerFn} */
+  onmessage;
+  /** @type {import('event-target').EventListenerFn} */
+  onerror;
+
+  #worker;
+
+  /**
+   * Messages are copied with the structured clone algorithm. The global object of the worker holds the standard
+   * JavaScript library plus `self`, `postMessage`, `onmessage` and `close`.
+   * @param {string} filename the script of the worker
+   */
+  constructor(filename)
+  {
+    super();
+    this.#worker = PyWorker(readFileUtf8(String(filename)), String(filename));
+    this.#worker.onmessage = (data) => this.dispatchEvent(new MessageEvent('message', { data }));
+    this.#worker.onerror = (error) => this.dispatchEvent(new ErrorEvent('error', { error }));
+  }
+
+  /**
+   * Send a copy of `message` to the `onmessage` of the worker
+   * @param {any} message
+   * @param {ArrayBuffer[] | { transfer: ArrayBuffer[] }} [transfer] ArrayBuffers to move to the worker rather than copy
+   */
+  postMessage(message, transfer)
+  {
+    const completion = this.#worker.post_message(message, Array.isArray(transfer) ? transfer : transfer?.transfer);
+    completion.catch(() => {}); // reported through the error event
+  }
+
+  /**
+   * Stop the worker once the JavaScript it is running returns to its event-loop
+   */
+  terminate()
+  {
+    this.#worker.terminate();
+  }
+}
+
+if (!globalThis.MessageEvent)
+  globalThis.MessageEvent = MessageEvent;
+if (!globalThis.Worker)
+  globalThis.Worker = Worker;
+
+exports.MessageEvent = MessageEvent;
+exports.ErrorEvent = ErrorEvent;
+exports.Worker = Worker;
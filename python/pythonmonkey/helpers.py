@@ -15,12 +15,7 @@ def typeof(jsval):
   """
   typeof function - wraps JS typeof operator
   """
-  return pm.eval("""'use strict'; (
-function pmTypeof(jsval)
-{
-  return typeof jsval;
-}
-    )""", evalOpts)(jsval)
+  return pm.compile_function("pmTypeof", ["jsval"], "'use strict'; return typeof jsval;", evalOpts)(jsval)
 
 
 def new(ctor):
@@ -31,15 +26,12 @@ def new(ctor):
   if (typeof(ctor) == 'string'):
     ctor = pm.eval(ctor)
 
-  newCtor = pm.eval("""'use strict'; (
-function pmNewFactory(ctor)
-{
+  newCtor = pm.compile_function("pmNewFactory", ["ctor"], """'use strict';
   return function newCtor(args) {
     args = Array.from(args || []);
     return new ctor(...args);
   };
-}
-    )""", evalOpts)(ctor)
+""", evalOpts)(ctor)
   return (lambda *args: newCtor(list(args)))
 
 
@@ -61,9 +53,12 @@ __all__ = ["new", "typeof", "simpleUncaughtExceptionHandler"]
 globalThis = pm.eval('globalThis')
 pmGlobals = vars(pm)
 
+# Accessors (e.g. debuggerGlobal) are lazily initialized on first use, so they are not exported here;
+# the package exports debuggerGlobal through its module __getattr__
 exports = pm.eval("""
-Object.getOwnPropertyNames(globalThis)
-.filter(prop => Object.keys(globalThis).indexOf(prop) === -1);
+Object.entries(Object.getOwnPropertyDescriptors(globalThis))
+.filter(([prop, desc]) => !desc.enumerable && !desc.get)
+.map(([prop]) => prop);
 """, evalOpts)
 
 for index in range(0, len(exports)):
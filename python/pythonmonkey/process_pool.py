@@ -0,0 +1,257 @@
+# @file     process_pool.py - Run calls of JavaScript exports in a pool of worker processes
+#           Workers are forked once the pool has loaded the preloaded modules, sharing its heap copy-on-write, or
+#           spawned where fork() is not available. Arguments and results are structured clones.
+# @author   Philippe Laporte <philippe@distributive.network>
+# @date     October 2026
+# @copyright Copyright (c) 2026 Distributive Corp.
+
+import asyncio
+import collections
+import gc
+import inspect
+import multiprocessing
+import os
+import threading
+import typing
+import pythonmonkey as pm
+
+__all__ = ['ProcessPool']
+
+
+def _workerMain(connection, filename: str, preload: typing.List[str], require=None):
+  """
+  The loop of a worker process: requests are (id, module, export, serialized args), or None to exit.
+  Responses are (id, serialized result, None) or (id, None, exception); (None, None, exception) if the
+  preloaded modules fail to load, the worker then exiting.
+  Forked workers get the `require` of the pool, which has loaded the preloaded modules already.
+  """
+  if require is not None:
+    asyncio._set_running_loop(None)  # forked from a coroutine running on the event-loop of the pool, which is not running here
+  else:
+    try:
+      require = pm.createRequire(filename)
+      for moduleIdentifier in preload:
+        require(moduleIdentifier)
+    except Exception as error:
+      _sendError(connection, None, error)
+      return
+
+  async def serve():
+    while True:
+      request = connection.recv()
+      if request is None:
+        return
+      callId, moduleIdentifier, export, args = request
+      try:
+        result = require(moduleIdentifier)[export](*pm.deserialize(args))
+        if inspect.isawaitable(result):
+          result = await result
+        response = (callId, pm.serialize(result), None)
+      except Exception as error:
+        response = (callId, None, error)
+      try:
+        connection.send(response)
+      except Exception:  # the exception cannot be pickled
+        _sendError(connection, callId, response[2])
+
+  try:
+    asyncio.run(serve())
+  except (EOFError, KeyboardInterrupt):  # the pool has gone
+    pass
+
+
+def _sendError(connection, callId: typing.Optional[int], error: BaseException):
+  try:
+    connection.send((callId, None, error))
+  except Exception:  # the exception cannot be pickled
+    connection.send((callId, None, RuntimeError(f'{type(error).__name__}: {error}')))
+
+
+class _Worker:
+  def __init__(self, context, args: tuple):
+    self.connection, childConnection = context.Pipe()
+    self.process = context.Process(target=_workerMain, args=(childConnection, *args), daemon=True)
+    self.process.start()
+    childConnection.close()
+    self.calls: typing.Dict[int, asyncio.Future] = {}
+    self.exited = False
+    self.error: typing.Optional[BaseException] = None  # why it exited, if it reported it
+
+
+class ProcessPool:
+  """
+  A pool of `processes` worker processes calling the exports of CommonJS modules. Module identifiers are resolved
+  relative to the file creating the pool.
+  Where fork() is available, the pool loads the `preload` modules itself, collects garbage, then forks the workers,
+  which share the bootstrapped runtime and the loaded modules copy-on-write. SpiderMonkey's helper threads are
+  stopped around fork() for that, but JavaScript must not be running on other threads, e.g. in a Worker, meanwhile.
+  Elsewhere the workers are spawned, and each loads PythonMonkey and the `preload` modules when it starts. Like any
+  spawned process, they import the main module, whose top-level code must then be guarded by
+  `if __name__ == '__main__':`.
+  """
+
+  def __init__(self, processes: typing.Optional[int] = None, preload: typing.Iterable[str] = ()):
+    self._processes = processes or os.cpu_count() or 1
+    self._preload = list(preload)
+    self._filename = inspect.stack()[1].filename
+    if not os.path.exists(self._filename):
+      self._filename = os.path.join(os.getcwd(), "__main_virtual__")
+
+    if 'fork' in multiprocessing.get_all_start_methods():
+      context = multiprocessing.get_context('fork')
+      require = pm.createRequire(self._filename)
+      for moduleIdentifier in self._preload:
+        require(moduleIdentifier)
+      gc.collect()
+      pm.collect()  # the garbage would otherwise be copied by every worker that ends up collecting it
+      workerArgs = (self._filename, self._preload, require)
+    else:
+      context = multiprocessing.get_context('spawn')
+      workerArgs = (self._filename, self._preload)
+
+    self._loop: typing.Optional[asyncio.AbstractEventLoop] = None
+    self._nextId = 0
+    self._pending: typing.Deque[typing.Tuple[int, str, str, bytes, asyncio.Future]] = collections.deque()
+    self._idle: typing.List[_Worker] = []
+    self._workers: typing.List[_Worker] = []
+    self._closed = False
+    for i in range(self._processes):
+      worker = _Worker(context, workerArgs)
+      self._workers.append(worker)
+      self._idle.append(worker)
+
+  def call(self, moduleIdentifier: str, export: str, *args) -> asyncio.Future:
+    """
+    Call the function `export` of the module `moduleIdentifier` in a worker process, with copies of `args`.
+    Must be called while an asyncio event-loop runs, always the same one.
+    @return a Future resolving to a copy of the value the function returns or resolves to
+    """
+    if self._closed:
+      raise RuntimeError('the process pool is closed')
+    loop = asyncio.get_running_loop()
+    if self._loop is None:
+      self._loop = loop
+      # the responses, and the exits of workers that died since the pool started, are forwarded to this event-loop
+      for worker in self._workers:
+        threading.Thread(target=self._receive, args=(worker,), name='pythonmonkey ProcessPool receiver', daemon=True).start()
+    elif self._loop is not loop:
+      raise RuntimeError('the process pool is used by another event-loop')
+    future = loop.create_future()
+    self._nextId += 1
+    self._pending.append((self._nextId, moduleIdentifier, export, pm.serialize(list(args)), future))
+    self._dispatch()
+    return future
+
+  def _dispatch(self):
+    while self._pending and self._idle:
+      callId, moduleIdentifier, export, args, future = self._pending.popleft()
+      if future.cancelled():
+        continue
+      worker = self._idle.pop()
+      worker.calls[callId] = future
+      try:
+        worker.connection.send((callId, moduleIdentifier, export, args))
+      except OSError:  # the worker process died, its receiver settles the call
+        pass
+
+  def _receive(self, worker: _Worker):
+    """
+    Forward the responses of a worker to the event-loop of the pool, runs on a thread of its own
+    """
+    while True:
+      try:
+        response = worker.connection.recv()
+      except (EOFError, OSError):
+        response = None
+        worker.process.join(1)  # for its exit code
+      try:
+        self._loop.call_soon_threadsafe(self._settle, worker, response)
+      except RuntimeError:  # the event-loop is closed
+        return
+      if response is None:
+        return
+
+  def _settle(self, worker: _Worker, response):
+    if response is None:  # the worker process died
+      self._exited(worker)
+      return
+    callId, result, error = response
+    if callId is None:  # the worker could not load the preloaded modules, and exits
+      worker.error = error
+      self._exited(worker)
+      return
+    future = worker.calls.pop(callId)
+    if not self._closed:
+      self._idle.append(worker)
+    if not future.done():
+      if error is None:
+        try:
+          result = pm.deserialize(result)
+        except Exception as e:
+          error = e
+      if error is not None:
+        future.set_exception(error)
+      else:
+        future.set_result(result)
+    self._dispatch()
+
+  def _exited(self, worker: _Worker):
+    if worker.exited:
+      return
+    worker.exited = True
+    if worker in self._idle:
+      self._idle.remove(worker)
+    for future in worker.calls.values():
+      if not future.done():
+        future.set_exception(self._exitError(worker))
+    worker.calls.clear()
+    if not self._closed and all(w.exited for w in self._workers):  # nothing will run the queued calls
+      for callId, moduleIdentifier, export, args, future in self._pending:
+        if not future.done():
+          future.set_exception(self._exitError(worker))
+      self._pending.clear()
+
+  @staticmethod
+  def _exitError(worker: _Worker) -> BaseException:
+    if worker.error is not None:
+      return worker.error
+    if worker.process.exitcode is None:
+      return RuntimeError('a worker process of the pool exited')
+    return RuntimeError(f'a worker process of the pool exited with code {worker.process.exitcode}')
+
+  def close(self) -> None:
+    """
+    Stop the workers once they have finished their current call, and wait for them to exit. Pending calls are cancelled.
+    """
+    self._shutdown(kill=False)
+
+  def terminate(self) -> None:
+    """
+    Kill the worker processes immediately. Pending calls are cancelled.
+    """
+    self._shutdown(kill=True)
+
+  def _shutdown(self, kill: bool):
+    if self._closed:
+      return
+    self._closed = True
+    self._idle.clear()
+    for callId, moduleIdentifier, export, args, future in self._pending:
+      future.cancel()
+    self._pending.clear()
+    for worker in self._workers:
+      if kill:
+        worker.process.terminate()
+      else:
+        try:
+          worker.connection.send(None)
+        except OSError:  # the worker process died
+          pass
+    for worker in self._workers:
+      worker.process.join()
+
+  def __enter__(self) -> 'ProcessPool':
+    return self
+
+  def __exit__(self, *args) -> None:
+    self.close()
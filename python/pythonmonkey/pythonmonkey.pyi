@@ -20,9 +20,118 @@ class EvalOptions(_typing.TypedDict, total=False):
 # pylint: disable=redefined-builtin
 
 
-def eval(code: str, evalOpts: EvalOptions = {}, /) -> _typing.Any:
+def eval(code: str | JSScriptProxy, evalOpts: EvalOptions = {}, /) -> _typing.Any:
   """
   JavaScript evaluator in Python
+
+  Compiled code strings are cached, see `eval_cache_info()`
+
+  Each Python thread evaluates code in its own JavaScript context, created on first use: JS values can't be
+  passed between threads, only Python values can
+
+  With the `module` option, the code is evaluated as an ES module, with its imports loaded from files,
+  and the namespace object of the module is returned
+  """
+
+
+def eval_async(code: str | _typing.IO, evalOpts: EvalOptions = {}, /) -> _typing.Awaitable[_typing.Any]:
+  """
+  JavaScript evaluator in Python, compiling the code on a helper thread so that the event-loop keeps running meanwhile.
+  The script is then executed on the event-loop. Must be called from a coroutine running on the main thread.
+
+  ```py
+  result = await pm.eval_async(open("large-script.js"))
+  ```
+  """
+
+
+def compile(code: str, evalOpts: EvalOptions = {}, /) -> JSScriptProxy:
+  """
+  Compile JavaScript code once, returning a script that evaluates it each time it is called.
+  The script can only be run by the thread that compiled it
+
+  ```py
+  script = pm.compile("counter++")
+  for i in range(10):
+    script()
+  ```
+  """
+
+
+def compile_function(name: str | None, params: _typing.Sequence[str], body: str, evalOpts: EvalOptions = {}, /) -> JSFunctionProxy:
+  """
+  Compile a JavaScript function in the global scope, without evaluating any wrapper script.
+  Compiled functions are cached, each call with the same arguments returns a new function sharing the compiled code.
+
+  ```py
+  add = pm.compile_function("add", ["a", "b"], "return a + b")
+  add(1, 2) # 3.0
+  ```
+  """
+
+
+class EvalCacheInfo(_typing.TypedDict):
+  hits: int
+  misses: int
+  maxsize: int
+  currsize: int
+
+
+def eval_cache_info() -> EvalCacheInfo:
+  """
+  Statistics of the LRU cache of scripts compiled by `eval` and `compile`, keyed by source and options
+  """
+
+
+def eval_cache_clear() -> None:
+  """
+  Empty the cache of scripts compiled by `eval` and `compile`, and reset its statistics
+  """
+
+
+def stencil_cache_configure(directory: str | None, maxsize: int = 256 * 1024 * 1024, /) -> None:
+  """
+  Cache the scripts compiled by `eval`, `compile` and `require` on disk, in `directory`, keyed by a hash of their source and options.
+  The least recently used files are deleted when the directory grows over `maxsize` bytes. Passing `None` disables the cache.
+  The cache is configured at import from the `PYTHONMONKEY_STENCIL_CACHE` and `PYTHONMONKEY_STENCIL_CACHE_SIZE` environment variables.
+  """
+
+
+class StencilCacheInfo(_typing.TypedDict):
+  directory: str | None
+  maxsize: int
+  hits: int
+  misses: int
+  writes: int
+
+
+def stencil_cache_info() -> StencilCacheInfo:
+  """
+  Configuration and statistics of the on-disk cache of compiled scripts
+  """
+
+
+def serialize(value: _typing.Any, /) -> bytes:
+  """
+  Serialize a value into bytes with the structured clone algorithm, which keeps Dates, RegExps, typed arrays,
+  Maps, Sets and cycles. The bytes can be read by `deserialize` in any thread or process running the same
+  version of PythonMonkey. JS objects and arrays are pickled this way. Typed-array contents are copied into the bytes
+  """
+
+
+def deserialize(data: bytes | bytearray | memoryview, /) -> _typing.Any:
+  """
+  Create a copy of the value serialized by `serialize`, in the JS context of the calling thread. `data` is copied,
+  so it can be changed once this returns
+  """
+
+
+def set_release_gil(enabled: bool, /, *, thread: bool = False) -> None:
+  """
+  Set whether the GIL is released while JavaScript runs (`eval`, compiled scripts and calls to JS functions),
+  so that other Python threads keep running meanwhile. Off by default.
+  With `thread=True` the setting only applies to the calling thread, as in the threads of `Worker`s.
+  The GIL is taken back whenever JavaScript calls into Python, and strings returned by JavaScript are then copied
   """
 
 
@@ -75,16 +184,122 @@ def isCompilableUnit(code: str) -> bool:
   """
 
 
-def collect() -> None:
+def collect(kind: _typing.Literal['full', 'minor', 'incremental', 'shrinking'] = 'full', *, budget_ms: int = 0) -> bool:
+  """
+  Calls the spidermonkey garbage collector of the calling thread's JS context.
+  - `full`: collect the whole heap at once, finishing any incremental collection in progress
+  - `minor`: collect only the nursery, where new objects are allocated
+  - `incremental`: run one slice of at most `budget_ms` milliseconds (by default the `slice_budget_ms` of `set_idle_gc`)
+    of an incremental collection, starting one if none is in progress
+  - `shrinking`: a full collection that also compacts the heap and releases unused memory to the system
+
+  Returns False if an incremental collection is left in progress
+  """
+
+
+def set_idle_gc(enabled: bool, /, *, slice_budget_ms: int = 5, delay: float = 0.1, threshold: int = 1024 * 1024) -> None:
+  """
+  Set whether garbage is collected while the asyncio event-loop running JavaScript has no ready callbacks. Off by default.
+  Once the heap has grown by `threshold` bytes since the last collection, an incremental collection runs in slices of
+  at most `slice_budget_ms` milliseconds whenever the loop is idle; otherwise only the nursery is collected.
+  The idle check runs `delay` seconds after JavaScript ran or after the loop was found busy.
+  While enabled, collections triggered by allocations are incremental too, with slices of `slice_budget_ms`.
+  Settings not passed keep their current value
+  """
+
+
+class GCParams(_typing.TypedDict):
+  max_bytes: int | None
+  min_nursery_bytes: int
+  max_nursery_bytes: int
+  slice_time_budget_ms: int
+  incremental: bool
+  per_zone: bool
+  compacting: bool
+  parallel_marking: bool
+  marking_threads: int
+  helper_thread_ratio: int
+  max_helper_threads: int
+
+
+def set_gc_params(
+  *,
+  max_bytes: int | None = ...,
+  min_nursery_bytes: int | None = ...,
+  max_nursery_bytes: int | None = ...,
+  slice_time_budget_ms: int | None = ...,
+  incremental: bool | None = ...,
+  per_zone: bool | None = ...,
+  compacting: bool | None = ...,
+  parallel_marking: bool | None = ...,
+  marking_threads: int | None = ...,
+  helper_thread_ratio: int | None = ...,
+  max_helper_threads: int | None = ...,
+) -> None:
+  """
+  Set parameters of the garbage collector of every JS context: the heap limit `max_bytes` (None for no limit, the default),
+  the nursery size, the time budget of incremental slices (0 for no limit), whether collections are incremental,
+  per zone and compacting, parallel marking and its thread count, and the number of GC helper threads of the process.
+  The calling thread's context gets them right away, other threads' contexts the next time they run JavaScript.
+  Passing None restores a parameter's default. A parameter set here overrides `set_idle_gc`.
+
+  Once the heap reaches `max_bytes`, JavaScript raises a `MemoryError`, which can be caught
+  """
+
+
+def get_gc_params() -> GCParams:
+  """
+  The parameters of the garbage collector in effect for the calling thread's JS context.
+  SpiderMonkey rounds sizes and ignores inconsistent values, such as a minimum nursery size above the maximum
+  """
+
+
+class GCInfo(_typing.TypedDict):
+  idle: bool
+  slice_budget_ms: int
+  delay: float
+  threshold: int
+  idle_slices: int
+  idle_collections: int
+  in_progress: bool
+  heap_bytes: int
+  out_of_memory: int
+  cycle_collection: bool
+  cycle_edges: int
+  cycle_forced_gcs: int
+  proxy_roots: int
+  proxy_root_slots: int
+
+
+def gc_info() -> GCInfo:
   """
-  Calls the spidermonkey garbage collector
+  Settings and statistics of idle garbage collection (see `set_idle_gc`), whether an incremental collection is in progress,
+  the size of the heap of the calling thread's JS context, how many times JavaScript ran out of memory,
+  whether cycle collection is enabled (see `set_cycle_collection`), how many references from JavaScript to Python objects it reported,
+  and how many JS objects and strings the Python proxies of the calling thread's JS context hold, in how many pooled slots
   """
 
 
+def set_cycle_collection(enabled: bool, /) -> None:
+  """
+  Set whether full Python garbage collections (generation 2, such as `gc.collect()`) also collect the reference cycles
+  going through JavaScript objects, such as a Python object holding a JS closure that captures it. On by default.
+  Each full Python collection then runs a full collection of the calling thread's JS heap first
+  """
+
+
+bootstrap_timings: dict[str, float]
+"""
+Seconds spent in each phase of `import pythonmonkey`, in the order they ran.
+Lazily initialized parts of the bootstrap (e.g. `timers`) are added on first use.
+"""
+
+
 def internalBinding(namespace: str) -> JSObjectProxy:
   """
   INTERNAL USE ONLY
 
+  The bindings of the JS context of the calling thread.
   See function declarations in ./builtin_modules/internal-binding.d.ts
   """
 
@@ -134,6 +349,59 @@ class JSArrayProxy(list):
   def __init__(self) -> None: "deleted"
 
 
+class JSScriptProxy():
+  """
+  JavaScript compiled script, returned by `compile`
+  """
+
+  def __init__(self) -> None: "deleted"
+
+  def __call__(self) -> _typing.Any:
+    """
+    Execute the script in the global scope, returning the value of its last expression statement
+    """
+
+
+class Realm():
+  """
+  A separate JavaScript realm, with its own global object, standard classes and module map.
+  Values pass freely between realms. Creating a realm is cheap, so one can be used per request, and dropped
+  or closed afterwards. Only the standard JavaScript library is defined in a new realm; copy what else is
+  needed (e.g. `console`) onto its `globalThis`.
+
+  ```py
+  with pm.Realm() as realm:
+    realm.globalThis.console = pm.globalThis.console
+    realm.eval("console.log(Array === globalThis.Array)")
+  ```
+  """
+
+  globalThis: JSObjectProxy
+
+  def eval(self, code: str | JSScriptProxy, evalOpts: EvalOptions = {}, /) -> _typing.Any:
+    """
+    Evaluate JavaScript code in this realm, like `pythonmonkey.eval`
+    """
+
+  def close(self) -> None:
+    """
+    Release the realm, its global object is reclaimed by the garbage collector once no value of the realm is in use
+    """
+
+  def __enter__(self) -> Realm: ...
+  def __exit__(self, *args) -> None: ...
+
+
+class JSArrayBufferProxy():
+  """
+  Exporter of the memory of a JavaScript ArrayBuffer, SharedArrayBuffer, TypedArray or DataView,
+  found as `memoryview.obj` of the memoryviews PythonMonkey creates for them.
+  The JS object stays alive, and cannot be detached or resized from JavaScript, while a buffer is exported.
+  """
+
+  def __init__(self) -> None: "deleted"
+
+
 class JSArrayIterProxy(_typing.Iterator):
   """
   JavaScript Array Iterator proxy
@@ -222,25 +222,81 @@ return bootstrap;
 })(globalThis.python)""", evalOpts)
 
 
-def statSync_inner(filename: str) -> Union[Dict[str, int], bool]:
-  """
-  Inner function for statSync.
+# The file system calls of ctx-module go straight to native code: every require() probes many candidate
+# paths, and the probes are cached so that resolving from deep node_modules trees doesn't stat the same
+# paths over and over. Missing paths are only remembered until the outermost require() returns, see
+# memoizeRequire. Sources are decoded from UTF-8 without a detour through Python str.
+# pm.internalBinding('fs').clearStatCache() forgets files removed since.
+pm.eval("""'use strict'; (
+function installFs(bootstrap, fsBinding)
+{
+  const fs = bootstrap.modules.fs;
+
+  fs.statSync_inner = function statSync_inner(filename) {
+    const mode = fsBinding.statMode(filename);
+    return mode === -1 ? false : { mode };
+  };
+  fs.existsSync = function existsSync(filename) {
+    return fsBinding.statMode(filename) !== -1;
+  };
+  fs.readFileSync = function readFileSync(filename, charset) {
+    if (charset && !/^utf-?8$/i.test(charset))
+      return python.readFileSync(filename, charset);
+    return fsBinding.readFileUtf8(filename);
+  };
+})""", evalOpts)(bootstrap, pm.internalBinding('fs'))
+
+
+# Like Node's relativeResolveCache, the filenames that require() resolved are memoized by (directory, specifier),
+# so that requiring a module loaded already skips resolution. The outermost require() forgets the missing paths
+# when it returns, as the files may be created before the next one.
+pm.eval("""'use strict'; (
+function installMemoizeRequire(bootstrap, fsBinding)
+{
+  const resolved = new Map(); /* directory NUL specifier => filename */
+  let depth = 0;
 
-  Returns:
-      Union[Dict[str, int], False]: The mode of the file or False if the file doesn't exist.
-  """
-  from os import stat
-  filename = os.path.normpath(filename)
-  if (os.path.exists(filename)):
-    sb = stat(filename)
-    return {'mode': sb.st_mode}
-  else:
-    return False
+  bootstrap.memoizeRequire = function memoizeRequire(ctxRequire, directory, moduleCache)
+  {
+    return new Proxy(ctxRequire, {
+      apply: function memoizedRequire(target, thisArg, args)
+      {
+        const key = directory + '\\0' + args[0];
+        const filename = resolved.get(key);
+        if (filename !== undefined && moduleCache[filename])
+          return moduleCache[filename].exports;
+
+        depth++;
+        try
+        {
+          const exports = Reflect.apply(target, thisArg, args);
+          if (typeof target.resolve === 'function')
+          {
+            try
+            {
+              resolved.set(key, target.resolve(args[0])); /* cheap, the probes are cached */
+            }
+            catch (error)
+            {
+              /* not resolvable again, e.g. a virtual module: leave it unmemoized */
+            }
+          }
+          return exports;
+        }
+        finally
+        {
+          if (--depth === 0)
+            fsBinding.clearMissingPaths();
+        }
+      },
+    });
+  };
+})""", evalOpts)(bootstrap, pm.internalBinding('fs'))
 
 
 def readFileSync(filename, charset) -> str:
   """
-  Utility function for reading files.
+  Read files in encodings other than UTF-8.
   Returns:
       str: The contents of the file
   """
@@ -249,14 +305,7 @@ def readFileSync(filename, charset) -> str:
     return fileHnd.read()
 
 
-def existsSync(filename: str) -> bool:
-  filename = os.path.normpath(filename)
-  return os.path.exists(filename)
-
-
-bootstrap.modules.fs.statSync_inner = statSync_inner
-bootstrap.modules.fs.readFileSync = readFileSync
-bootstrap.modules.fs.existsSync = existsSync
+globalThis.python.readFileSync = readFileSync
 
 # Read ctx-module module from disk and invoke so that this file is the "main module" and ctx-module has
 # require and exports symbols injected from the bootstrap object above. Current PythonMonkey bugs
@@ -354,6 +403,8 @@ function createRequireInner(filename, bootstrap, extraPaths, isMain)
   module.require.extensions['.py'] = loadPythonModule;
   Object.assign(module.require.extensions, extCopy);
 
+  module.require = bootstrap.memoizeRequire(module.require, filename ? filename.slice(0, filename.lastIndexOf('/')) : '', moduleCache);
+
   if (isMain)
   {
     globalThis.module = module;
@@ -393,7 +444,21 @@ def createRequire(filename, extraPaths: Union[List[str], Literal[False]] = False
 
 
 bootstrap.requireFromDisk = createRequireInner(None, bootstrap, '', False)
-bootstrap.inspect = bootstrap.requireFromDisk('util').inspect
+
+# util is only loaded once bootstrap.inspect is used, i.e. when a DEBUG selector matches
+pm.eval("""'use strict'; (
+function lazyInspect(bootstrap)
+{
+  Object.defineProperty(bootstrap, 'inspect', {
+    get: function getInspect() {
+      const inspect = bootstrap.requireFromDisk('util').inspect;
+      Object.defineProperty(bootstrap, 'inspect', { value: inspect, writable: true, enumerable: true, configurable: true });
+      return inspect;
+    },
+    enumerable: true,
+    configurable: true,
+  });
+})""", evalOpts)(bootstrap)
 
 # API: pm.runProgramModule
 
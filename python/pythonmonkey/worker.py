@@ -0,0 +1,209 @@
+# @file     worker.py - Run JavaScript in parallel, in the JS context of a background thread
+#           Messages are copied between contexts with the structured clone algorithm.
+# @author   Philippe Laporte <philippe@distributive.network>
+# @date     October 2026
+# @copyright Copyright (c) 2026 Distributive Corp.
+
+import asyncio
+import threading
+import typing
+import pythonmonkey as pm
+
+__all__ = ['Worker']
+
+# Runs in the context of the worker thread, defines the globals of workers and returns the function that
+# delivers a message from the parent to `onmessage`
+_workerGlobals = """'use strict'; (
+function workerGlobals(structuredClone, send, closeWorker)
+{
+  globalThis.self = globalThis;
+  globalThis.onmessage = null;
+  globalThis.close = function close() { closeWorker(); };
+
+  /**
+   * @param {any} message
+   * @param {ArrayBuffer[] | { transfer: ArrayBuffer[] }} [transfer] ArrayBuffers to move to the parent rather than copy
+   */
+  globalThis.postMessage = function postMessage(message, transfer)
+  {
+    send(structuredClone.serialize(message, Array.isArray(transfer) ? transfer : transfer?.transfer));
+  };
+
+  return function receive(message)
+  {
+    const event = { type: 'message', data: structuredClone.deserialize(message) };
+    if (typeof globalThis.onmessage === 'function')
+      return globalThis.onmessage(event);
+  };
+})"""
+
+
+def _structuredClone():
+  return pm.internalBinding('structuredClone')
+
+
+def _transferList(transfer):
+  if transfer is None:
+    return None
+  return pm.eval('(transfer) => Array.from(transfer)')(transfer)
+
+
+class Worker:
+  """
+  A JavaScript context running `script` on a background thread, with the message passing of Web Workers.
+  The worker context holds the standard JavaScript library plus `self`, `postMessage`, `onmessage` and `close`.
+  Must be created while an asyncio event-loop runs; callbacks and Futures complete on that event-loop.
+  """
+
+  def __init__(self, script: str, filename: typing.Optional[str] = None):
+    self.onmessage: typing.Optional[typing.Callable[[typing.Any], None]] = None
+    """Called on the parent event-loop with a copy of each message posted by the worker"""
+    self.onerror: typing.Optional[typing.Callable[[BaseException], None]] = None
+    """Called on the parent event-loop with the exceptions the worker script and its `onmessage` raise"""
+    self._parentLoop = asyncio.get_running_loop()
+    self.exited: asyncio.Future = self._parentLoop.create_future()
+    """Resolves once the worker thread ends, after `close()` or `terminate()`"""
+    self._completions: typing.Set[asyncio.Future] = set()
+    self._script = script
+    self._filename = filename or '<worker>'
+    self._loop = asyncio.new_event_loop()
+    self._closing = False
+    self._stopped = self._loop.create_future()
+    # The first step of the task evaluates the script, before the messages posted meanwhile reach the event-loop
+    self._started = self._loop.create_task(self._main())
+    self._thread = threading.Thread(target=self._run, name=f'pythonmonkey Worker {self._filename}', daemon=True)
+    self._thread.start()
+
+  def post_message(self, message: typing.Any, transfer: typing.Optional[typing.Iterable[typing.Any]] = None) -> asyncio.Future:
+    """
+    Send a copy of `message` to the `onmessage` of the worker. The JS ArrayBuffers in `transfer` are moved
+    rather than copied, and become detached here.
+    @return a Future resolving to a copy of the value `onmessage` returns or resolves to, once it completes
+    """
+    serialized = _structuredClone().serialize(message, _transferList(transfer))
+    completion = self._parentLoop.create_future()
+    if self._callInWorker(self._receive, serialized, completion):
+      self._completions.add(completion)
+    else:
+      completion.set_exception(RuntimeError('the worker has exited'))
+    return completion
+
+  def terminate(self) -> None:
+    """
+    Stop the worker. Takes effect once the JavaScript it is running returns to its event-loop.
+    """
+    self._callInWorker(self._stop)
+
+  def _callInWorker(self, callback, *args) -> bool:
+    try:
+      self._loop.call_soon_threadsafe(callback, *args)
+      return True
+    except RuntimeError:  # the worker event-loop is closed
+      return False
+
+  def _callInParent(self, callback, *args) -> None:
+    try:
+      self._parentLoop.call_soon_threadsafe(callback, *args)
+    except RuntimeError:  # the parent event-loop is closed, nobody is listening anymore
+      pass
+
+  #
+  # Worker thread
+  #
+  def _run(self):
+    asyncio.set_event_loop(self._loop)
+    error = None
+    try:
+      self._loop.run_until_complete(self._started)
+    except BaseException as e:
+      error = e
+    finally:
+      self._cancelTasks()
+      self._loop.close()
+    self._callInParent(self._exit, error)
+
+  async def _main(self):
+    pm.set_release_gil(True, thread=True)  # workers run in parallel with the other Python threads
+    self._deliver = pm.eval(_workerGlobals, {'filename': __file__})(_structuredClone(), self._send, self._stop)
+    pm.eval(self._script, {'filename': self._filename})
+    await self._stopped
+    self._deliver = None
+
+  def _cancelTasks(self):
+    tasks = asyncio.all_tasks(self._loop)
+    for task in tasks:
+      task.cancel()
+    self._loop.run_until_complete(asyncio.gather(*tasks, return_exceptions=True))
+
+  def _stop(self):
+    self._closing = True
+    if not self._stopped.done():
+      self._stopped.set_result(None)
+
+  def _send(self, message):
+    self._callInParent(self._dispatch, message)
+
+  def _receive(self, message, completion: asyncio.Future):
+    if self._closing:
+      return  # rejected by _exit
+    try:
+      result = self._deliver(message)
+    except BaseException as error:
+      self._callInParent(self._settle, completion, None, error)
+      return
+    if asyncio.isfuture(result) or asyncio.iscoroutine(result):
+      self._loop.create_task(self._complete(result, completion))
+    else:
+      self._complete_with(result, completion)
+
+  async def _complete(self, pending, completion: asyncio.Future):
+    try:
+      result = await pending
+    except BaseException as error:
+      self._callInParent(self._settle, completion, None, error)
+      return
+    self._complete_with(result, completion)
+
+  def _complete_with(self, result, completion: asyncio.Future):
+    try:
+      serialized = _structuredClone().serialize(result)
+    except BaseException as error:
+      self._callInParent(self._settle, completion, None, error)
+      return
+    self._callInParent(self._settle, completion, serialized, None)
+
+  #
+  # Parent thread
+  #
+  def _dispatch(self, message):
+    data = _structuredClone().deserialize(message)
+    try:
+      if self.onmessage:
+        self.onmessage(data)
+    except BaseException as error:
+      self._parentLoop.call_exception_handler({'message': 'Exception in Worker.onmessage', 'exception': error})
+
+  def _settle(self, completion: asyncio.Future, result, error):
+    self._completions.discard(completion)
+    if error is not None:
+      self._reportError(error)
+    if completion.done():
+      return
+    if error is not None:
+      completion.set_exception(error)
+    else:
+      completion.set_result(_structuredClone().deserialize(result))
+
+  def _exit(self, error):
+    if error is not None:
+      self._reportError(error)
+    for completion in self._completions:
+      if not completion.done():
+        completion.set_exception(RuntimeError('the worker has exited'))
+    self._completions.clear()
+    if not self.exited.done():
+      self.exited.set_result(None)
+
+  def _reportError(self, error: BaseException):
+    if self.onerror:
+      self.onerror(error)
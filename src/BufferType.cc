@@ -9,14 +9,39 @@
  */
 
 #include "include/BufferType.hh"
-#include "include/PyBytesProxyHandler.hh"
+#include "include/JSArrayBufferProxy.hh"
+#include "include/setSpiderMonkeyException.hh"
 
 #include <jsapi.h>
+#include <js/Array.h>
 #include <js/ArrayBuffer.h>
+#include <js/GCVector.h>
+#include <js/SharedArrayBuffer.h>
+#include <js/Utility.h>
 #include <js/experimental/TypedData.h>
 #include <js/ScalarType.h>
 
+#include "include/pyshim.hh"
+
+#include <algorithm>
+#include <cstring>
 #include <limits.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief A Python buffer exported to JS, along with the interpreter of its object, which must be the one releasing it
+ */
+struct ExportedBuffer {
+  Py_buffer view; // first member, so that the view and its ExportedBuffer have the same address
+  PyInterpreterState *interpreter;
+  PyObject *copiedFrom = nullptr; /**< for the private copy of an immutable buffer, the object it was copied from. `view` then only holds the copy */
+};
+
+static std::mutex pendingReleasesMutex;
+static std::vector<ExportedBuffer *> pendingReleases; /**< Python buffers of finalized ArrayBuffers, waiting for the GIL of their interpreter */
+static std::unordered_map<void *, ExportedBuffer *> privateCopies; /**< private copies of immutable buffers, by contents. Guarded by pendingReleasesMutex too */
 
 // JS to Python
 
@@ -57,18 +82,17 @@ const char *BufferType::_toPyBufferFormatCode(JS::Scalar::Type subtype) {
 
 /* static */
 bool BufferType::isSupportedJsTypes(JSObject *obj) {
-  return JS::IsArrayBufferObject(obj) || JS_IsTypedArrayObject(obj);
+  return JS::IsArrayBufferObject(obj) || JS::IsSharedArrayBufferObject(obj) || JS_IsTypedArrayObject(obj) || JS_IsDataViewObject(obj);
 }
 
 PyObject *BufferType::getPyObject(JSContext *cx, JS::HandleObject bufObj) {
   PyObject *pyObject;
   if (JS_IsTypedArrayObject(bufObj)) {
     pyObject = fromJsTypedArray(cx, bufObj);
-  } else if (JS::IsArrayBufferObject(bufObj)) {
+  } else if (JS::IsArrayBufferObject(bufObj) || JS::IsSharedArrayBufferObject(bufObj) || JS_IsDataViewObject(bufObj)) {
     pyObject = fromJsArrayBuffer(cx, bufObj);
   } else {
-    // TODO (Tom Tang): Add support for JS [DataView](https://developer.mozilla.org/en-US/docs/Web/JavaScript/Reference/Global_Objects/DataView)
-    PyErr_SetString(PyExc_TypeError, "`bufObj` is neither a TypedArray object nor an ArraryBuffer object.");
+    PyErr_SetString(PyExc_TypeError, "`bufObj` is neither a TypedArray, a DataView, nor an ArrayBuffer or SharedArrayBuffer object.");
     pyObject = nullptr;
   }
 
@@ -77,91 +101,85 @@ PyObject *BufferType::getPyObject(JSContext *cx, JS::HandleObject bufObj) {
 
 /* static */
 PyObject *BufferType::fromJsTypedArray(JSContext *cx, JS::HandleObject typedArray) {
+  // immutable Python buffers come back as themselves, unless JS modified its copy
+  PyObject *copiedFrom = _getUnmodifiedCopySource(typedArray);
+  if (copiedFrom) {
+    return copiedFrom;
+  }
+
   JS::Scalar::Type subtype = JS_GetArrayBufferViewType(typedArray);
-  auto byteLength = JS_GetTypedArrayByteLength(typedArray);
-
-  // Retrieve/Create the underlying ArrayBuffer object for side-effect.
-  //
-  // If byte length is less than `JS_MaxMovableTypedArraySize()`,
-  // the ArrayBuffer object would be created lazily and the data is stored inline in the TypedArray.
-  // We don't want inline data because the data pointer would be invalidated during a GC as the TypedArray object is moved.
-  bool isSharedMemory;
-  if (!JS_GetArrayBufferViewBuffer(cx, typedArray, &isSharedMemory)) return nullptr;
-
-  uint8_t __destBuf[0] = {}; // we don't care about its value as it's used only if the TypedArray still having inline data
-  uint8_t *data = JS_GetArrayBufferViewFixedData(typedArray, __destBuf, 0 /* making sure we don't copy inline data */);
-  if (data == nullptr) { // shared memory or still having inline data
-    PyErr_SetString(PyExc_TypeError, "PythonMonkey cannot coerce TypedArrays backed by shared memory.");
+  PyObject *exporter = JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_new(cx, typedArray,
+    _toPyBufferFormatCode(subtype), JS::Scalar::byteSize(subtype));
+  if (!exporter) {
     return nullptr;
   }
 
-  Py_buffer bufInfo = {
-    .buf = data,
-    .obj = NULL /* the exporter PyObject */,
-    .len = (Py_ssize_t)byteLength,
-    .itemsize = (uint8_t)JS::Scalar::byteSize(subtype),
-    .readonly = false,
-    .ndim = 1 /* 1-dimensional array */,
-    .format = (char *)_toPyBufferFormatCode(subtype),
-  };
-  return PyMemoryView_FromBuffer(&bufInfo);
+  // the memoryview holds a reference to the exporter, which roots the TypedArray
+  PyObject *memoryView = PyMemoryView_FromObject(exporter);
+  Py_DECREF(exporter);
+  return memoryView;
 }
 
 /* static */
 PyObject *BufferType::fromJsArrayBuffer(JSContext *cx, JS::HandleObject arrayBuffer) {
-  auto byteLength = JS::GetArrayBufferByteLength(arrayBuffer);
-
-  // TODO (Tom Tang): handle SharedArrayBuffers or disallow them completely
-  bool isSharedMemory; // `JS::GetArrayBufferData` always sets this to `false`
-  JS::AutoCheckCannotGC autoNoGC(cx); // we don't really care about this
-  uint8_t *data = JS::GetArrayBufferData(arrayBuffer, &isSharedMemory, autoNoGC);
-
-  Py_buffer bufInfo = {
-    .buf = data,
-    .obj = NULL /* the exporter PyObject */,
-    .len = (Py_ssize_t)byteLength,
-    .itemsize = 1 /* each element is 1 byte */,
-    .readonly = false,
-    .ndim = 1 /* 1-dimensional array */,
-    .format = (char *)"B" /* uint8 array */,
-  };
-  return PyMemoryView_FromBuffer(&bufInfo);
+  PyObject *exporter = JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_new(cx, arrayBuffer,
+    "B" /* uint8 array */, 1 /* each element is 1 byte */);
+  if (!exporter) {
+    return nullptr;
+  }
+
+  PyObject *memoryView = PyMemoryView_FromObject(exporter);
+  Py_DECREF(exporter);
+  return memoryView;
 }
 
 
 // Python to JS
 
-static PyBytesProxyHandler pyBytesProxyHandler;
-
-
 JSObject *BufferType::toJsTypedArray(JSContext *cx, PyObject *pyObject) {
-  Py_INCREF(pyObject);
+  // JS buffers that went through Python come back as themselves
+  JSObject *exported = JSArrayBufferProxyMethodDefinitions::getExportedJsObject(pyObject);
+  if (exported) {
+    return exported;
+  }
 
-  // Get the pyObject's underlying buffer pointer and size
-  Py_buffer *view = new Py_buffer{};
+  releasePendingPyBuffers();
+
+  // Get the pyObject's underlying buffer pointer, size and layout
+  ExportedBuffer *exportedBuffer = new ExportedBuffer{{}, PyThreadState_GetInterpreter(PyThreadState_Get())};
+  Py_buffer *view = &exportedBuffer->view;
   bool immutable = false;
-  if (PyObject_GetBuffer(pyObject, view, PyBUF_ND | PyBUF_WRITABLE /* C-contiguous and writable */ | PyBUF_FORMAT) < 0) {
+  if (PyObject_GetBuffer(pyObject, view, PyBUF_RECORDS /* strided, writable, with format */) < 0) {
     // the buffer is immutable (e.g., Python `bytes` type is read-only)
     PyErr_Clear();     // a PyExc_BufferError was raised
 
-    if (PyObject_GetBuffer(pyObject, view, PyBUF_ND /* C-contiguous */ | PyBUF_FORMAT) < 0) {
+    if (PyObject_GetBuffer(pyObject, view, PyBUF_RECORDS_RO /* strided, with format */) < 0) {
+      delete exportedBuffer; // no view was filled in, there is nothing to release
       return nullptr;  // a PyExc_BufferError was raised again
     }
 
     immutable = true;
   }
-  
-  if (view->ndim != 1) {
-    PyErr_SetString(PyExc_BufferError, "multidimensional arrays are not allowed");
-    BufferType::_releasePyBuffer(view);
-    return nullptr;
-  }
 
   // Determine the TypedArray's subtype (Uint8Array, Float64Array, ...)
   JS::Scalar::Type subtype = _getPyBufferType(view);
 
+  // SpiderMonkey has no read-only ArrayBuffers, so sharing the memory of an immutable buffer would let JS write into it
+  bool copy = immutable || !_isZeroCopyable(view);
+
+  // The flat TypedArray holds the elements in memory order, so multidimensional arrays get their layout alongside
+  JS::RootedObject shape(cx);
+  JS::RootedObject strides(cx);
+  if (view->ndim != 1 && !_newShapeAndStrides(cx, view, copy, &shape, &strides)) {
+    BufferType::_releasePyBuffer(view);
+    setSpiderMonkeyException(cx);
+    return nullptr;
+  }
+
   JSObject *arrayBuffer;
-  if (view->len > 0) {
+  if (view->len > 0 && immutable) {
+    arrayBuffer = _newPrivateCopy(cx, pyObject, view); // releases the view
+  } else if (view->len > 0 && !copy) {
     // Create a new ExternalArrayBuffer object
     // Note: data will be copied instead of transferring the ownership when this external ArrayBuffer is "transferred" to a worker thread.
     //    see https://hg.mozilla.org/releases/mozilla-esr102/file/a03fde6/js/public/ArrayBuffer.h#l86
@@ -170,39 +188,202 @@ JSObject *BufferType::toJsTypedArray(JSContext *cx, PyObject *pyObject) {
       {BufferType::_releasePyBuffer, view /* the `bufView` argument to `_releasePyBuffer` */}
     );
 
+    // on failure, `dataPtr` is destroyed without having been released, its deleter then releases the view and frees exportedBuffer
     arrayBuffer = JS::NewExternalArrayBuffer(cx,
       view->len /* byteLength */, std::move(dataPtr)
     );
+  } else if (view->len > 0) { // strides with gaps, or misaligned data
+    arrayBuffer = _newArrayBufferFromPyBuffer(cx, view);
+    BufferType::_releasePyBuffer(view); // the data has been copied into the new ArrayBuffer
   } else { // empty buffer
     arrayBuffer = JS::NewArrayBuffer(cx, 0);
     BufferType::_releasePyBuffer(view); // the buffer is no longer needed since we are creating a brand new empty ArrayBuffer
   }
+  if (!arrayBuffer) {
+    setSpiderMonkeyException(cx); // unless _newArrayBufferFromPyBuffer already raised a Python exception
+    return nullptr;
+  }
+  // from here on the ArrayBuffer owns the view, which is released when it is finalized
 
-  if (!immutable) {
-    JS::RootedObject arrayBufferRooted(cx, arrayBuffer);
-    return _newTypedArrayWithBuffer(cx, subtype, arrayBufferRooted);
-  } else {
-    JS::RootedValue v(cx);
-    JS::RootedObject uint8ArrayPrototype(cx);
-    JS_GetClassPrototype(cx, JSProto_Uint8Array, &uint8ArrayPrototype); // so that instanceof will work, not that prototype methods will
-    JSObject *proxy = js::NewProxyObject(cx, &pyBytesProxyHandler, v, uint8ArrayPrototype.get());
-    JS::SetReservedSlot(proxy, PyObjectSlot, JS::PrivateValue(pyObject));
-    JS::PersistentRootedObject *arrayBufferPointer = new JS::PersistentRootedObject(cx);
-    arrayBufferPointer->set(arrayBuffer);
-    JS::SetReservedSlot(proxy, OtherSlot, JS::PrivateValue(arrayBufferPointer));
-    return proxy;
+  JS::RootedObject arrayBufferRooted(cx, arrayBuffer);
+  JS::RootedObject typedArray(cx, _newTypedArrayWithBuffer(cx, subtype, arrayBufferRooted));
+  if (!typedArray) {
+    setSpiderMonkeyException(cx); // unless the type of the buffer was already reported as invalid
+    return nullptr;
+  }
+  if (shape) {
+    if (!JS_DefineProperty(cx, typedArray, "shape", shape, JSPROP_READONLY) ||
+        !JS_DefineProperty(cx, typedArray, "strides", strides, JSPROP_READONLY)) {
+      setSpiderMonkeyException(cx);
+      return nullptr;
+    }
   }
+  return typedArray;
 }
 
 /* static */
-void BufferType::_releasePyBuffer(Py_buffer *bufView) {
+bool BufferType::_isZeroCopyable(Py_buffer *bufView) {
+  if (bufView->itemsize > 0 && (uintptr_t)bufView->buf % bufView->itemsize != 0) {
+    return false; // the elements of a TypedArray must be aligned
+  }
+  // Fortran order is fine once the strides are known, but 1-D consumers expect the elements in index order
+  return PyBuffer_IsContiguous(bufView, 'C') || (bufView->ndim > 1 && PyBuffer_IsContiguous(bufView, 'F'));
+}
+
+/* static */
+JSObject *BufferType::_newArrayBufferFromPyBuffer(JSContext *cx, Py_buffer *bufView) {
+  // copy straight into memory the ArrayBuffer takes ownership of, rather than into a zero-filled new ArrayBuffer
+  mozilla::UniquePtr<void, JS::FreePolicy> contents(js_pod_arena_malloc<uint8_t>(js::ArrayBufferContentsArena, bufView->len));
+  if (!contents) {
+    PyErr_NoMemory();
+    return nullptr;
+  }
+  if (PyBuffer_ToContiguous(contents.get(), bufView, bufView->len, 'C') < 0) {
+    return nullptr;
+  }
+  return JS::NewArrayBufferWithContents(cx, bufView->len, std::move(contents));
+}
+
+/* static */
+JSObject *BufferType::_newPrivateCopy(JSContext *cx, PyObject *pyObject, Py_buffer *bufView) {
+  Py_ssize_t byteLength = bufView->len;
+  mozilla::UniquePtr<void, JS::FreePolicy> contents(js_pod_arena_malloc<uint8_t>(js::ArrayBufferContentsArena, byteLength));
+  if (!contents) {
+    _releasePyBuffer(bufView);
+    PyErr_NoMemory();
+    return nullptr;
+  }
+  if (PyBuffer_ToContiguous(contents.get(), bufView, byteLength, 'C') < 0) {
+    _releasePyBuffer(bufView);
+    return nullptr;
+  }
+
+  // the export of the original buffer is not kept, only a reference to its object to convert back to
+  ExportedBuffer *privateCopy = reinterpret_cast<ExportedBuffer *>(bufView);
   PyBuffer_Release(bufView);
-  delete bufView;
+  privateCopy->view.buf = contents.get();
+  privateCopy->view.len = byteLength;
+  Py_INCREF(pyObject);
+  privateCopy->copiedFrom = pyObject;
+  {
+    std::lock_guard<std::mutex> lock(pendingReleasesMutex);
+    privateCopies[contents.get()] = privateCopy;
+  }
+
+  // on failure, `dataPtr` is destroyed without having been released, its deleter then frees the copy and privateCopy
+  mozilla::UniquePtr<void, JS::BufferContentsDeleter> dataPtr(
+    contents.release(),
+    {BufferType::_releasePyBuffer, privateCopy}
+  );
+  return JS::NewExternalArrayBuffer(cx, byteLength, std::move(dataPtr));
+}
+
+/* static */
+PyObject *BufferType::_getUnmodifiedCopySource(JS::HandleObject typedArray) {
+  bool isShared;
+  void *data;
+  {
+    JS::AutoCheckCannotGC nogc;
+    data = JS_GetArrayBufferViewData(typedArray, &isShared, nogc); // the contents of external ArrayBuffers never move
+  }
+
+  PyObject *copiedFrom;
+  {
+    std::lock_guard<std::mutex> lock(pendingReleasesMutex);
+    auto privateCopy = privateCopies.find(data);
+    if (privateCopy == privateCopies.end() || (size_t)privateCopy->second->view.len != JS_GetTypedArrayByteLength(typedArray)) {
+      return nullptr; // not a copy, or a view of part of one
+    }
+    copiedFrom = privateCopy->second->copiedFrom;
+  }
+
+  Py_buffer view;
+  if (PyObject_GetBuffer(copiedFrom, &view, PyBUF_RECORDS_RO) < 0) {
+    PyErr_Clear();
+    return nullptr;
+  }
+  // a read-only view of a mutable object may have changed on the Python side as well
+  bool unmodified = _getPyBufferType(&view) == JS_GetArrayBufferViewType(typedArray) &&
+                    (size_t)view.len == JS_GetTypedArrayByteLength(typedArray) &&
+                    PyBuffer_IsContiguous(&view, 'C') &&
+                    memcmp(view.buf, data, view.len) == 0;
+  PyBuffer_Release(&view);
+  if (!unmodified) {
+    return nullptr;
+  }
+  Py_INCREF(copiedFrom);
+  return copiedFrom;
 }
 
 /* static */
-void BufferType::_releasePyBuffer(void *, void *bufView) {
-  return _releasePyBuffer((Py_buffer *)bufView);
+bool BufferType::_newShapeAndStrides(JSContext *cx, Py_buffer *bufView, bool cOrder, JS::MutableHandleObject shape, JS::MutableHandleObject strides) {
+  JS::RootedValueVector shapeItems(cx);
+  JS::RootedValueVector strideItems(cx);
+  if (!shapeItems.resize(bufView->ndim) || !strideItems.resize(bufView->ndim)) {
+    PyErr_NoMemory();
+    return false;
+  }
+
+  // strides are counted in elements, so that they can be used to index the flat TypedArray
+  Py_ssize_t stride = 1;
+  for (int dim = bufView->ndim - 1; dim >= 0; dim--) {
+    shapeItems[dim].setNumber((double)bufView->shape[dim]);
+    if (cOrder || !bufView->strides) {
+      strideItems[dim].setNumber((double)stride);
+      stride *= bufView->shape[dim];
+    } else {
+      strideItems[dim].setNumber((double)(bufView->strides[dim] / bufView->itemsize));
+    }
+  }
+
+  shape.set(JS::NewArrayObject(cx, shapeItems));
+  strides.set(JS::NewArrayObject(cx, strideItems));
+  return shape && strides;
+}
+
+/* static */
+void BufferType::_releasePyBuffer(Py_buffer *bufView) {
+  ExportedBuffer *exportedBuffer = reinterpret_cast<ExportedBuffer *>(bufView);
+  PyBuffer_Release(bufView); // a no-op for private copies, whose view was released when copying
+  Py_XDECREF(exportedBuffer->copiedFrom);
+  delete exportedBuffer;
+}
+
+/* static */
+void BufferType::_releasePyBuffer(void *contents, void *bufView) {
+  // ArrayBuffers may be finalized on a GC helper thread, which must not touch Python objects,
+  // or by the JSContext of a thread running another interpreter than the one of the buffer
+  ExportedBuffer *exportedBuffer = (ExportedBuffer *)bufView;
+  PyThreadState *threadState = PyThreadState_GetUnchecked();
+  bool pending = !threadState || PyThreadState_GetInterpreter(threadState) != exportedBuffer->interpreter;
+  if (pending || exportedBuffer->copiedFrom) {
+    std::lock_guard<std::mutex> lock(pendingReleasesMutex);
+    if (exportedBuffer->copiedFrom) {
+      privateCopies.erase(contents);
+      js_free(contents);
+    }
+    if (pending) {
+      pendingReleases.push_back(exportedBuffer);
+      return;
+    }
+  }
+  return _releasePyBuffer(&exportedBuffer->view);
+}
+
+/* static */
+void BufferType::releasePendingPyBuffers() {
+  PyInterpreterState *interpreter = PyThreadState_GetInterpreter(PyThreadState_Get());
+  std::vector<ExportedBuffer *> exportedBuffers;
+  {
+    std::lock_guard<std::mutex> lock(pendingReleasesMutex);
+    auto ofInterpreter = std::partition(pendingReleases.begin(), pendingReleases.end(),
+      [interpreter](ExportedBuffer *exportedBuffer) { return exportedBuffer->interpreter != interpreter; });
+    exportedBuffers.assign(ofInterpreter, pendingReleases.end());
+    pendingReleases.erase(ofInterpreter, pendingReleases.end());
+  }
+  for (ExportedBuffer *exportedBuffer: exportedBuffers) {
+    _releasePyBuffer(&exportedBuffer->view);
+  }
 }
 
 /* static */
@@ -0,0 +1,244 @@
+/**
+ * @file CycleCollector.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Collection of the reference cycles going through both the Python and the JavaScript heaps
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/CycleCollector.hh"
+
+#include "include/GCScheduler.hh"
+#include "include/jsTypeFactory.hh"
+#include "include/PyBaseProxyHandler.hh"
+#include "include/PyDictProxyHandler.hh"
+#include "include/PyIterableProxyHandler.hh"
+#include "include/PyListProxyHandler.hh"
+#include "include/PyObjectProxyHandler.hh"
+#include "include/modules/pythonmonkey/pythonmonkey.hh"
+
+#include <jsapi.h>
+#include <jsfriendapi.h>
+#include <js/GCAPI.h>
+#include <js/HeapAPI.h>
+#include <js/Object.h>
+#include <js/Proxy.h>
+#include <js/TracingAPI.h>
+
+#include <Python.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @return the Python object that `obj` holds a reference to, if it is one of our JS proxies of Python objects or a JS function wrapping a Python function
+ */
+static PyObject *heldPyObject(JSObject *obj) {
+  if (js::IsProxy(obj)) {
+    const void *family = js::GetProxyHandler(obj)->family();
+    if (family == &PyDictProxyHandler::family ||
+        family == &PyListProxyHandler::family ||
+        family == &PyIterableProxyHandler::family ||
+        family == &PyObjectProxyHandler::family) {
+      return JS::GetMaybePtrFromReservedSlot<PyObject>(obj, PyObjectSlot);
+    }
+    return nullptr;
+  }
+  if (JS_ObjectIsFunction(obj) && JS_IsNativeFunction(obj, callPyFunc)) { // its reference is dropped by jsFunctionRegistry
+    return (PyObject *)js::GetFunctionNativeReserved(obj, 0).toPrivate();
+  }
+  return nullptr;
+}
+
+static const size_t MAX_VISITS = 1 << 22; /**< over this many gray things visited, a collection reports no references at all */
+
+/**
+ * @brief Walks the gray things reachable from the gray proxy roots, tagging each with the index of the first root reaching it.
+ * A thing reached again from a later root is tagged as shared and walked once more, so that the things it reaches are tagged
+ * as shared too: each thing is walked at most twice, however many roots reach it.
+ */
+class GrayGraphWalker : public JS::CallbackTracer {
+public:
+  static const size_t SHARED = SIZE_MAX; /**< the tag of the things reachable from several roots */
+
+  explicit GrayGraphWalker(JSContext *cx) : JS::CallbackTracer(cx) {}
+
+  /**
+   * @brief Walk the gray graph from `obj`, the JS object of the root at `index`, called with increasing indices from 0
+   *
+   * @return false if the walks went over MAX_VISITS
+   */
+  bool walk(size_t index, JSObject *obj) {
+    tag = index;
+    reach(JS::GCCellPtr(obj));
+    while (!stack.empty()) {
+      if (++visits > MAX_VISITS) {
+        return false;
+      }
+      JS::GCCellPtr thing = stack.back();
+      stack.pop_back();
+      tag = tags[thing.unsafeAsUIntPtr()]; // shared if a later root reached it since it was pushed
+      if (thing.is<JSObject>()) {
+        PyObject *pyObject = heldPyObject(&thing.as<JSObject>());
+        if (pyObject) {
+          holders.try_emplace(thing.unsafeAsUIntPtr(), pyObject);
+        }
+      }
+      JS::TraceChildren(this, thing);
+    }
+    return true;
+  }
+
+  /**
+   * @return the index of the only root reaching `thing`, a walked thing, or SHARED
+   */
+  size_t rootOf(uintptr_t thing) const {
+    return tags.at(thing);
+  }
+
+  std::unordered_map<uintptr_t, PyObject *> holders; /**< the walked JS things holding a Python object */
+
+private:
+  void onChild(JS::GCCellPtr thing, const char *name [[maybe_unused]]) override {
+    reach(thing);
+  }
+
+  void reach(JS::GCCellPtr thing) {
+    switch (thing.kind()) {
+    case JS::TraceKind::String:
+    case JS::TraceKind::Symbol:
+    case JS::TraceKind::BigInt:
+    case JS::TraceKind::JitCode:
+    case JS::TraceKind::RegExpShared:
+      return; // cannot lead to an object
+    default:
+      break;
+    }
+    if (!JS::GCThingIsMarkedGray(thing)) {
+      return; // black, JavaScript keeps it alive anyway
+    }
+    auto [entry, firstVisit] = tags.try_emplace(thing.unsafeAsUIntPtr(), tag);
+    if (!firstVisit) {
+      if (entry->second == tag || entry->second == SHARED) {
+        return;
+      }
+      entry->second = SHARED; // reached from two roots
+    }
+    stack.push_back(thing);
+  }
+
+  size_t tag = 0; /**< the tag of the thing being walked, given to the things it reaches */
+  size_t visits = 0;
+  std::vector<JS::GCCellPtr> stack;
+  std::unordered_map<uintptr_t, size_t> tags; /**< gray thing => index of the first root reaching it, or SHARED */
+};
+
+bool CycleCollector::install() {
+  static PyMethodDef callbackDef = {"pythonmonkey_cycle_collector", gcCallback, METH_VARARGS, NULL};
+  PyObject *gc = PyImport_ImportModule("gc");
+  if (!gc) {
+    return false;
+  }
+  PyObject *callbacks = PyObject_GetAttrString(gc, "callbacks");
+  Py_DECREF(gc);
+  if (!callbacks) {
+    return false;
+  }
+  PyObject *callback = PyCFunction_New(&callbackDef, NULL);
+  bool appended = callback && PyList_Append(callbacks, callback) == 0;
+  Py_XDECREF(callback);
+  Py_DECREF(callbacks);
+  return appended;
+}
+
+PyObject *CycleCollector::gcCallback(PyObject *Py_UNUSED(self), PyObject *args) {
+  const char *phase;
+  PyObject *info;
+  if (!PyArg_ParseTuple(args, "sO", &phase, &info)) {
+    return NULL;
+  }
+  if (strcmp(phase, "start") == 0) {
+    PyObject *generation = PyDict_Check(info) ? PyDict_GetItemString(info, "generation") : NULL; // borrowed reference
+    if (generation && PyLong_Check(generation) && PyLong_AsLong(generation) == 2) {
+      begin();
+    }
+  } else if (strcmp(phase, "stop") == 0) {
+    end();
+  }
+  Py_RETURN_NONE;
+}
+
+static void addRoot(ProxyRoot *root, void *roots) {
+  JSObject *obj = root->unbarrieredGet();
+  if (obj && JS::ObjectIsMarkedGray(obj)) {
+    ((std::vector<ProxyRoot *> *)roots)->push_back(root);
+  }
+}
+
+void CycleCollector::begin() {
+  JSContext *cx = GLOBAL_CX;
+  if (!cx || collecting || !enabled.load(std::memory_order_relaxed) || JS::RuntimeHeapIsBusy()) {
+    return;
+  }
+  if (ProxyRoots::rootCount() == 0) {
+    return; // no gray roots, no JS thing is kept alive by Python alone
+  }
+  if (overBudgetHeapBytes > 0 && JS_GetGCParameter(cx, JSGC_BYTES) >= overBudgetHeapBytes) {
+    return; // the last walk went over MAX_VISITS, and the heap has not shrunk since
+  }
+
+  // the walk needs the gray bits of a full collection: those of the last one are reused until the heap has doubled since
+  if (GCScheduler::bytesSinceGC(cx) >= std::max(GCScheduler::heapBytesAfterLastGC(), MIN_FORCED_GC_GROWTH)) {
+    JS_GC(cx, JS::GCReason::API);
+    forcedGCs.fetch_add(1, std::memory_order_relaxed);
+  } else if (JS::IsIncrementalGCInProgress(cx) || !js::AreGCGrayBitsValid(JS_GetRuntime(cx))) {
+    return; // the next collection to finish makes them valid again
+  }
+
+  std::vector<ProxyRoot *> roots;
+  ProxyRoots::forEach(addRoot, &roots);
+  if (roots.empty()) {
+    return;
+  }
+
+  GrayGraphWalker walker(cx);
+  for (size_t index = 0; index < roots.size(); index++) {
+    if (!walker.walk(index, roots[index]->unbarrieredGet())) {
+      overBudgetHeapBytes = JS_GetGCParameter(cx, JSGC_BYTES);
+      return; // reporting no reference is always safe
+    }
+  }
+  overBudgetHeapBytes = 0;
+  size_t found = 0;
+  for (const auto &[thing, pyObject]: walker.holders) {
+    size_t root = walker.rootOf(thing);
+    if (root != GrayGraphWalker::SHARED) {
+      edges[roots[root]].push_back(pyObject);
+      found++;
+    }
+  }
+  edgesFound.fetch_add(found, std::memory_order_relaxed);
+  collecting = true;
+}
+
+void CycleCollector::end() {
+  if (!collecting) {
+    return;
+  }
+  // the JS proxies of the Python objects in the cycles the Python collection broke hold them until the next JS collection
+  // finalizes them, which is left to the allocation and idle triggers of SpiderMonkey and GCScheduler
+  collecting = false;
+  edges.clear();
+}
+
+PyObject *CycleCollector::configure(PyObject *enabledArg) {
+  int truth = PyObject_IsTrue(enabledArg);
+  if (truth < 0) {
+    return NULL;
+  }
+  enabled.store(truth, std::memory_order_relaxed);
+  Py_RETURN_NONE;
+}
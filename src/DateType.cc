@@ -10,13 +10,32 @@
 
 #include "include/DateType.hh"
 
+#include "include/ModuleState.hh"
+
 #include <jsapi.h>
 #include <js/Date.h>
 
 #include <datetime.h>
 
+/**
+ * @brief The PyDateTimeAPI macro of datetime.h is a single static pointer, which interpreters with their own GIL would race to
+ * import into, and which would point to the types of whichever interpreter imported it first. Each interpreter keeps its own instead.
+ *
+ * @return the datetime C API of the current interpreter, or nullptr with a Python exception set if datetime cannot be imported
+ */
+static PyDateTime_CAPI *getDateTimeAPI() {
+  ModuleState *state = ModuleState::current();
+  if (!state->dateTimeAPI) {
+    state->dateTimeAPI = PyCapsule_Import(PyDateTime_CAPSULE_NAME, 0);
+  }
+  return (PyDateTime_CAPI *)state->dateTimeAPI;
+}
+
 PyObject *DateType::getPyObject(JSContext *cx, JS::HandleObject dateObj) {
-  if (!PyDateTimeAPI) { PyDateTime_IMPORT; } // for PyDateTime_FromTimestamp
+  PyDateTime_CAPI *dateTimeAPI = getDateTimeAPI();
+  if (!dateTimeAPI) {
+    return NULL;
+  }
 
   JS::Rooted<JS::ValueArray<0>> args(cx);
   JS::Rooted<JS::Value> year(cx);
@@ -34,19 +53,28 @@ PyObject *DateType::getPyObject(JSContext *cx, JS::HandleObject dateObj) {
   JS_CallFunctionName(cx, dateObj, "getUTCSeconds", args, &second);
   JS_CallFunctionName(cx, dateObj, "getUTCMilliseconds", args, &usecond);
 
-  PyObject *pyObject = PyDateTimeAPI->DateTime_FromDateAndTime(
+  PyObject *pyObject = dateTimeAPI->DateTime_FromDateAndTime(
     year.toNumber(), month.toNumber() + 1, day.toNumber(),
     hour.toNumber(), minute.toNumber(), second.toNumber(),
     usecond.toNumber() * 1000,
-    PyDateTime_TimeZone_UTC, // Make the resulting Python datetime object timezone-aware
-                             // See https://docs.python.org/3/library/datetime.html#aware-and-naive-objects
-    PyDateTimeAPI->DateTimeType
+    dateTimeAPI->TimeZone_UTC, // Make the resulting Python datetime object timezone-aware
+                               // See https://docs.python.org/3/library/datetime.html#aware-and-naive-objects
+    dateTimeAPI->DateTimeType
   );
-  Py_INCREF(PyDateTime_TimeZone_UTC);
+  Py_INCREF(dateTimeAPI->TimeZone_UTC);
 
   return pyObject;
 }
 
+bool DateType::isPyDateTime(PyObject *pyObject) {
+  PyDateTime_CAPI *dateTimeAPI = getDateTimeAPI();
+  if (!dateTimeAPI) {
+    PyErr_Clear();
+    return false;
+  }
+  return PyObject_TypeCheck(pyObject, dateTimeAPI->DateTimeType);
+}
+
 JSObject *DateType::toJsDate(JSContext *cx, PyObject *pyObject) {
   // See https://docs.python.org/3/library/datetime.html#datetime.datetime.timestamp
   PyObject *timestamp = PyObject_CallMethod(pyObject, "timestamp", NULL); // the result is in seconds
@@ -17,12 +17,12 @@
 
 
 PyObject *DictType::getPyObject(JSContext *cx, JS::Handle<JS::Value> jsObject) {
-  JSObjectProxy *proxy = (JSObjectProxy *)PyObject_CallObject((PyObject *)&JSObjectProxyType, NULL);
+  ModuleState *state = ModuleState::current();
+  JSObjectProxy *proxy = (JSObjectProxy *)state->JSObjectProxyFreeList.allocate(state->JSObjectProxyType);
   if (proxy != NULL) {
     JS::RootedObject obj(cx);
     JS_ValueToObject(cx, jsObject, &obj);
-    proxy->jsObject = new JS::PersistentRootedObject(cx);
-    proxy->jsObject->set(obj);
+    proxy->jsObject = ProxyRoots::create(obj);
     return (PyObject *)proxy;
   }
   return NULL;
@@ -15,7 +15,15 @@
 
 
 PyObject *FuncType::getPyObject(JSContext *cx, JS::HandleValue fval) {
-  JSFunctionProxy *proxy = (JSFunctionProxy *)PyObject_CallObject((PyObject *)&JSFunctionProxyType, NULL);
-  proxy->jsFunc->set(&fval.toObject());
+  ModuleState *state = ModuleState::current();
+  JSFunctionProxy *proxy = (JSFunctionProxy *)state->JSFunctionProxyFreeList.allocate(state->JSFunctionProxyType);
+  if (!proxy) {
+    return NULL;
+  }
+  if (proxy->jsFunc) { // created by JSFunctionProxy_new
+    proxy->jsFunc->set(&fval.toObject());
+  } else { // reused from the free list
+    proxy->jsFunc = ProxyRoots::create(&fval.toObject());
+  }
   return (PyObject *)proxy;
 }
\ No newline at end of file
@@ -0,0 +1,205 @@
+/**
+ * @file GCParameters.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief The garbage collector parameters set by pythonmonkey.set_gc_params, and MemoryError on JavaScript running out of memory
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/GCParameters.hh"
+
+#include "include/GCScheduler.hh"
+#include "include/ThreadContext.hh"
+#include "include/modules/pythonmonkey/pythonmonkey.hh"
+
+#include <jsapi.h>
+#include <js/GCAPI.h>
+
+#include <Python.h>
+
+#include <cstring>
+#include <optional>
+
+static const uint32_t UNLIMITED = UINT32_MAX; /**< the value of JSGC_MAX_BYTES for no limit, reported as None */
+
+struct GCParameter {
+  const char *name;
+  JSGCParamKey key;
+  bool isBool;
+  bool mainRuntimeOnly; /**< shared by all runtimes of the process, SpiderMonkey refuses it from the runtimes of other threads */
+};
+
+static const GCParameter gcParameters[] = {
+  {"max_bytes", JSGC_MAX_BYTES, false, false},
+  {"min_nursery_bytes", JSGC_MIN_NURSERY_BYTES, false, false},
+  {"max_nursery_bytes", JSGC_MAX_NURSERY_BYTES, false, false},
+  {"slice_time_budget_ms", JSGC_SLICE_TIME_BUDGET_MS, false, false},
+  {"incremental", JSGC_INCREMENTAL_GC_ENABLED, true, false},
+  {"per_zone", JSGC_PER_ZONE_GC_ENABLED, true, false},
+  {"compacting", JSGC_COMPACTING_ENABLED, true, false},
+  {"parallel_marking", JSGC_PARALLEL_MARKING_ENABLED, true, false},
+  {"marking_threads", JSGC_MARKING_THREAD_COUNT, false, false},
+  {"helper_thread_ratio", JSGC_HELPER_THREAD_RATIO, false, true},
+  {"max_helper_threads", JSGC_MAX_HELPER_THREADS, false, true},
+};
+
+static const GCParameter *findParameter(const char *name) {
+  for (const GCParameter &parameter: gcParameters) {
+    if (strcmp(parameter.name, name) == 0) {
+      return &parameter;
+    }
+  }
+  return nullptr;
+}
+
+static const GCParameter *findParameter(JSGCParamKey key) {
+  for (const GCParameter &parameter: gcParameters) {
+    if (parameter.key == key) {
+      return &parameter;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Convert the Python value of a parameter, None standing for its default: unlimited max_bytes, incremental collections,
+ * and SpiderMonkey's defaults for the others
+ *
+ * @return false with a Python exception set if the value is out of range
+ */
+static bool toParameterValue(const GCParameter &parameter, PyObject *value, std::optional<uint32_t> *result) {
+  if (value == Py_None) { // back to the default, see initJSContext and GCScheduler::initContext
+    if (parameter.key == JSGC_MAX_BYTES) {
+      *result = UNLIMITED;
+    } else if (parameter.key == JSGC_INCREMENTAL_GC_ENABLED) {
+      *result = 1;
+    } else {
+      *result = std::nullopt;
+    }
+    return true;
+  }
+  if (parameter.isBool) {
+    int truth = PyObject_IsTrue(value);
+    if (truth < 0) {
+      return false;
+    }
+    *result = truth;
+    return true;
+  }
+  if (!PyLong_Check(value)) {
+    PyErr_Format(PyExc_TypeError, "the GC parameter %s must be an int, not %s", parameter.name, Py_TYPE(value)->tp_name);
+    return false;
+  }
+  unsigned long long number = PyLong_AsUnsignedLongLong(value);
+  if ((number == (unsigned long long)-1 && PyErr_Occurred()) || number > UINT32_MAX) {
+    PyErr_Clear();
+    PyErr_Format(PyExc_ValueError, "the GC parameter %s must be between 0 and %u", parameter.name, UINT32_MAX);
+    return false;
+  }
+  *result = (uint32_t)number;
+  return true;
+}
+
+PyObject *GCParameters::set(PyObject *args, PyObject *kwargs) {
+  if (PyTuple_GET_SIZE(args) != 0) {
+    PyErr_SetString(PyExc_TypeError, "set_gc_params() takes keyword arguments only");
+    return NULL;
+  }
+
+  std::map<JSGCParamKey, std::optional<uint32_t>> values;
+  PyObject *name, *value;
+  Py_ssize_t pos = 0;
+  while (kwargs && PyDict_Next(kwargs, &pos, &name, &value)) {
+    const GCParameter *parameter = findParameter(PyUnicode_AsUTF8(name));
+    if (!parameter) {
+      PyErr_Format(PyExc_TypeError, "set_gc_params() got an unexpected keyword argument '%U'", name);
+      return NULL;
+    }
+    std::optional<uint32_t> converted;
+    if (!toParameterValue(*parameter, value, &converted)) {
+      return NULL;
+    }
+    values[parameter->key] = converted;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &[key, converted]: values) {
+      requested[key] = converted;
+    }
+  }
+  GCScheduler::settingsChanged();
+  if (GLOBAL_CX) {
+    GCScheduler::applySettings(GLOBAL_CX);
+  }
+  Py_RETURN_NONE;
+}
+
+PyObject *GCParameters::get(JSContext *cx) {
+  PyObject *result = PyDict_New();
+  if (!result) {
+    return NULL;
+  }
+  for (const GCParameter &parameter: gcParameters) {
+    uint32_t number = JS_GetGCParameter(cx, parameter.key);
+    PyObject *value;
+    if (parameter.isBool) {
+      value = PyBool_FromLong(number);
+    } else if (parameter.key == JSGC_MAX_BYTES && number == UNLIMITED) {
+      Py_INCREF(Py_None);
+      value = Py_None;
+    } else {
+      value = PyLong_FromUnsignedLong(number);
+    }
+    if (!value || PyDict_SetItemString(result, parameter.name, value) < 0) {
+      Py_XDECREF(value);
+      Py_DECREF(result);
+      return NULL;
+    }
+    Py_DECREF(value);
+  }
+  return result;
+}
+
+void GCParameters::apply(JSContext *cx) {
+  bool mainRuntime = !ThreadContext::current();
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const auto &[key, value]: requested) {
+    if (!mainRuntime && findParameter(key)->mainRuntimeOnly) {
+      continue;
+    }
+    if (value) {
+      JS_SetGCParameter(cx, key, *value); // SpiderMonkey rounds sizes and ignores inconsistent values, see GCParameters::get
+    } else {
+      JS_ResetGCParameter(cx, key);
+    }
+  }
+}
+
+bool GCParameters::isSet(JSGCParamKey key) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = requested.find(key);
+  return found != requested.end() && found->second.has_value();
+}
+
+void GCParameters::onOutOfMemory(JSContext *cx [[maybe_unused]], void *data [[maybe_unused]]) {
+  outOfMemory = true;
+  outOfMemoryEvents.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool GCParameters::raiseOutOfMemory(JSContext *cx) {
+  // SpiderMonkey may fail for lack of memory without an exception pending. The flag left by a failure that JavaScript
+  // caught and recovered from is dropped here, with the next exception.
+  bool ranOut = JS_IsThrowingOutOfMemory(cx) || (outOfMemory && !JS_IsExceptionPending(cx));
+  outOfMemory = false;
+  if (!ranOut) {
+    return false;
+  }
+  JS_ClearPendingException(cx);
+  if (!PyErr_Occurred()) {
+    PyErr_SetString(PyExc_MemoryError, "JavaScript ran out of memory, see pythonmonkey.set_gc_params(max_bytes=...)");
+  }
+  return true;
+}
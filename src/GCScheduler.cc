@@ -0,0 +1,259 @@
+/**
+ * @file GCScheduler.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Garbage collection requested by pythonmonkey.collect, and incremental collection while the asyncio event-loop is idle
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/GCScheduler.hh"
+
+#include "include/AutoGIL.hh"
+#include "include/CycleCollector.hh"
+#include "include/GCParameters.hh"
+#include "include/PyEventLoop.hh"
+#include "include/modules/pythonmonkey/pythonmonkey.hh"
+
+#include <jsapi.h>
+#include <js/GCAPI.h>
+#include <js/SliceBudget.h>
+#include <mozilla/TimeStamp.h>
+
+#include <Python.h>
+
+#include <cstring>
+
+static JS::SliceBudget sliceBudget(int64_t budgetMs) {
+  return JS::SliceBudget(JS::TimeBudget(budgetMs));
+}
+
+static size_t heapBytes(JSContext *cx) {
+  return JS_GetGCParameter(cx, JSGC_BYTES);
+}
+
+bool GCScheduler::parseKind(const char *name, Kind *kind) {
+  if (strcmp(name, "full") == 0) {
+    *kind = Kind::full;
+  } else if (strcmp(name, "minor") == 0) {
+    *kind = Kind::minor;
+  } else if (strcmp(name, "incremental") == 0) {
+    *kind = Kind::incremental;
+  } else if (strcmp(name, "shrinking") == 0) {
+    *kind = Kind::shrinking;
+  } else {
+    PyErr_Format(PyExc_ValueError, "unknown kind of collection '%s', expected 'full', 'minor', 'incremental' or 'shrinking'", name);
+    return false;
+  }
+  return true;
+}
+
+bool GCScheduler::collect(JSContext *cx, Kind kind, int64_t budgetMs) {
+  if (budgetMs <= 0) {
+    budgetMs = sliceBudgetMs.load(std::memory_order_relaxed);
+  }
+  AutoReleaseGIL releaseGIL; // the GC callbacks take the GIL back for finalizers
+  switch (kind) {
+  case Kind::full:
+    JS_GC(cx); // also finishes an incremental collection in progress
+    break;
+  case Kind::minor:
+    JS::RunNurseryCollection(JS_GetRuntime(cx), JS::GCReason::API, mozilla::TimeDuration());
+    break;
+  case Kind::incremental:
+    if (JS::IsIncrementalGCInProgress(cx)) {
+      JS::PrepareForIncrementalGC(cx);
+      JS::IncrementalGCSlice(cx, JS::GCReason::API, sliceBudget(budgetMs));
+    } else {
+      JS::PrepareForFullGC(cx);
+      JS::StartIncrementalGC(cx, JS::GCOptions::Normal, JS::GCReason::API, sliceBudget(budgetMs));
+    }
+    break;
+  case Kind::shrinking:
+    JS::PrepareForFullGC(cx);
+    JS::NonIncrementalGC(cx, JS::GCOptions::Shrink, JS::GCReason::API);
+    break;
+  }
+  return !JS::IsIncrementalGCInProgress(cx);
+}
+
+void GCScheduler::initContext(JSContext *cx) {
+  // collections triggered by allocations only run in slices once a slice budget is set, see applySettings
+  JS_SetGCParameter(cx, JSGC_INCREMENTAL_GC_ENABLED, 1);
+  appliedGeneration = 0;
+  applySettings(cx);
+}
+
+void GCScheduler::applySettings(JSContext *cx) {
+  uint32_t generation = settingsGeneration.load(std::memory_order_acquire);
+  if (appliedGeneration == generation) {
+    return;
+  }
+  appliedGeneration = generation;
+  GCParameters::apply(cx);
+  if (GCParameters::isSet(JSGC_SLICE_TIME_BUDGET_MS)) {
+    return;
+  }
+  if (idleEnabled.load(std::memory_order_relaxed)) {
+    JS_SetGCParameter(cx, JSGC_SLICE_TIME_BUDGET_MS, (uint32_t)sliceBudgetMs.load(std::memory_order_relaxed));
+  } else {
+    JS_SetGCParameter(cx, JSGC_SLICE_TIME_BUDGET_MS, 0); // no limit, allocation-triggered collections run to completion
+  }
+}
+
+void GCScheduler::schedule() {
+  if (!GLOBAL_CX || PyErr_Occurred()) {
+    return;
+  }
+  applySettings(GLOBAL_CX);
+  if (!idleEnabled.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  PyEventLoop loop = PyEventLoop::getRunningLoop();
+  if (!loop.initialized()) {
+    PyErr_Clear(); // JavaScript run outside of an event-loop is collected when it allocates
+    return;
+  }
+  if (loop._loop != armedLoop) { // a loop run by asyncio.run() after the one the callback was armed on has closed
+    arm(loop._loop, delaySeconds.load(std::memory_order_relaxed));
+  }
+}
+
+void GCScheduler::arm(PyObject *loop, double delay) {
+  static PyMethodDef idleCallbackDef = {"pythonmonkeyIdleGC", idleCallback, METH_NOARGS, NULL};
+  PyObject *callback = PyCFunction_New(&idleCallbackDef, NULL);
+  PyObject *handle = callback ? PyObject_CallMethod(loop, "call_later", "dO", delay, callback) : NULL;
+  Py_XDECREF(callback);
+  if (!handle) {
+    PyErr_Clear(); // the loop is closed
+    return;
+  }
+  Py_DECREF(handle);
+  Py_INCREF(loop);
+  Py_XSETREF(armedLoop, loop);
+}
+
+PyObject *GCScheduler::idleCallback(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(args)) {
+  PyObject *loop = armedLoop; // owned reference
+  armedLoop = nullptr;
+  if (!loop) {
+    Py_RETURN_NONE;
+  }
+  if (!GLOBAL_CX || !idleEnabled.load(std::memory_order_relaxed)) {
+    Py_DECREF(loop);
+    Py_RETURN_NONE;
+  }
+
+  // callbacks due in this iteration of the event-loop, asyncio's own loops keep them in `_ready`
+  bool idle = true;
+  PyObject *ready = PyObject_GetAttrString(loop, "_ready");
+  if (ready) {
+    idle = PyObject_Size(ready) == 0;
+    Py_DECREF(ready);
+  }
+  PyErr_Clear(); // other event-loop implementations are treated as idle whenever the callback runs
+
+  if (!idle) {
+    arm(loop, delaySeconds.load(std::memory_order_relaxed));
+  } else if (idleSlice(GLOBAL_CX)) {
+    arm(loop, 0); // continue the collection as soon as the event-loop is idle again
+  }
+  Py_DECREF(loop);
+  Py_RETURN_NONE;
+}
+
+bool GCScheduler::idleSlice(JSContext *cx) {
+  applySettings(cx);
+  int64_t budgetMs = sliceBudgetMs.load(std::memory_order_relaxed);
+  bool inProgress = JS::IsIncrementalGCInProgress(cx);
+  if (!inProgress && heapBytes(cx) < heapBytesAfterGC + thresholdBytes.load(std::memory_order_relaxed)) {
+    // not worth a major collection yet, but emptying the nursery now saves a minor collection in the next request
+    AutoReleaseGIL releaseGIL;
+    JS::RunNurseryCollection(JS_GetRuntime(cx), JS::GCReason::API,
+      mozilla::TimeDuration::FromSeconds(delaySeconds.load(std::memory_order_relaxed)));
+    return false;
+  }
+
+  {
+    AutoReleaseGIL releaseGIL;
+    if (inProgress) {
+      JS::PrepareForIncrementalGC(cx);
+      JS::IncrementalGCSlice(cx, JS::GCReason::API, sliceBudget(budgetMs));
+    } else {
+      JS::PrepareForFullGC(cx);
+      JS::StartIncrementalGC(cx, JS::GCOptions::Normal, JS::GCReason::API, sliceBudget(budgetMs));
+    }
+  }
+  idleSlices.fetch_add(1, std::memory_order_relaxed);
+  if (JS::IsIncrementalGCInProgress(cx)) {
+    return true;
+  }
+  idleCollections.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void GCScheduler::onGCEnd(JSContext *cx) {
+  heapBytesAfterGC = heapBytes(cx);
+}
+
+size_t GCScheduler::bytesSinceGC(JSContext *cx) {
+  size_t bytes = heapBytes(cx);
+  return bytes > heapBytesAfterGC ? bytes - heapBytesAfterGC : 0;
+}
+
+PyObject *GCScheduler::configure(PyObject *args, PyObject *kwargs) {
+  static const char *keywords[] = {"", "slice_budget_ms", "delay", "threshold", NULL};
+  int enabled;
+  long long budgetMs = sliceBudgetMs.load(std::memory_order_relaxed);
+  double delay = delaySeconds.load(std::memory_order_relaxed);
+  Py_ssize_t threshold = (Py_ssize_t)thresholdBytes.load(std::memory_order_relaxed);
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "p|$Ldn:set_idle_gc", (char **)keywords, &enabled, &budgetMs, &delay, &threshold)) {
+    return NULL;
+  }
+  if (budgetMs <= 0 || budgetMs > UINT32_MAX) {
+    PyErr_SetString(PyExc_ValueError, "slice_budget_ms must be a positive number of milliseconds");
+    return NULL;
+  }
+  if (!(delay >= 0)) {
+    PyErr_SetString(PyExc_ValueError, "delay must not be negative");
+    return NULL;
+  }
+  if (threshold < 0) {
+    PyErr_SetString(PyExc_ValueError, "threshold must not be negative");
+    return NULL;
+  }
+
+  idleEnabled.store(enabled, std::memory_order_relaxed);
+  sliceBudgetMs.store(budgetMs, std::memory_order_relaxed);
+  delaySeconds.store(delay, std::memory_order_relaxed);
+  thresholdBytes.store((size_t)threshold, std::memory_order_relaxed);
+  settingsChanged();
+  schedule(); // applies the settings to the context of this thread right away
+  Py_RETURN_NONE;
+}
+
+PyObject *GCScheduler::info() {
+  bool inProgress = false;
+  size_t bytes = 0;
+  if (GLOBAL_CX) {
+    inProgress = JS::IsIncrementalGCInProgress(GLOBAL_CX);
+    bytes = heapBytes(GLOBAL_CX);
+  }
+  return Py_BuildValue("{s:O,s:L,s:d,s:n,s:n,s:n,s:O,s:n,s:n,s:O,s:n,s:n,s:n,s:n}",
+    "idle", idleEnabled.load(std::memory_order_relaxed) ? Py_True : Py_False,
+    "slice_budget_ms", (long long)sliceBudgetMs.load(std::memory_order_relaxed),
+    "delay", delaySeconds.load(std::memory_order_relaxed),
+    "threshold", (Py_ssize_t)thresholdBytes.load(std::memory_order_relaxed),
+    "idle_slices", (Py_ssize_t)idleSlices.load(std::memory_order_relaxed),
+    "idle_collections", (Py_ssize_t)idleCollections.load(std::memory_order_relaxed),
+    "in_progress", inProgress ? Py_True : Py_False,
+    "heap_bytes", (Py_ssize_t)bytes,
+    "out_of_memory", (Py_ssize_t)GCParameters::outOfMemoryCount(),
+    "cycle_collection", CycleCollector::isEnabled() ? Py_True : Py_False,
+    "cycle_edges", (Py_ssize_t)CycleCollector::edgeCount(),
+    "cycle_forced_gcs", (Py_ssize_t)CycleCollector::forcedGCCount(),
+    "proxy_roots", (Py_ssize_t)ProxyRoots::rootCount(),
+    "proxy_root_slots", (Py_ssize_t)ProxyRoots::slotCount());
+}
@@ -0,0 +1,106 @@
+/**
+ * @file HelperThreads.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief The threads running SpiderMonkey's helper tasks, stopped around fork() so that forked processes can keep using SpiderMonkey
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/HelperThreads.hh"
+
+#include "include/OffThreadCompileTask.hh"
+
+#include <Python.h>
+#include <pythread.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief The helper tasks waiting for a thread. Never destroyed, as idle helper threads may still wait on it at exit.
+ */
+struct HelperTaskQueue {
+  std::mutex mutex;
+  std::condition_variable queued;
+  std::condition_variable stopped; /**< notified when a helper thread exits */
+  std::deque<JS::HelperThreadTask *> tasks;
+  size_t maxThreads = 1; /**< the number of threads SpiderMonkey asked for */
+  size_t threads = 0; /**< helper threads running */
+  size_t idleThreads = 0; /**< helper threads waiting for a task */
+  bool forking = false; /**< between beforeFork() and afterFork(), no helper thread runs */
+};
+
+static HelperTaskQueue *helperTaskQueue = new HelperTaskQueue();
+
+void HelperThreads::init() {
+  helperTaskQueue->maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  // the stack size is the one of Python threads, which is at least the 2MB SpiderMonkey asks for on the platforms it supports
+  JS::SetHelperThreadTaskCallback(dispatch, helperTaskQueue->maxThreads, 2 * 1024 * 1024);
+}
+
+void HelperThreads::dispatch(JS::HelperThreadTask *task, JS::DispatchReason reason [[maybe_unused]]) {
+  std::lock_guard<std::mutex> lock(helperTaskQueue->mutex);
+  helperTaskQueue->tasks.push_back(task);
+  if (!helperTaskQueue->forking) {
+    startThreadIfNeeded();
+  }
+}
+
+void HelperThreads::startThreadIfNeeded() {
+  if (helperTaskQueue->idleThreads >= helperTaskQueue->tasks.size() || helperTaskQueue->threads >= helperTaskQueue->maxThreads) {
+    helperTaskQueue->queued.notify_one();
+    return;
+  }
+  if (PyThread_start_new_thread(helperThread, NULL) != PYTHREAD_INVALID_THREAD_ID) {
+    helperTaskQueue->threads++;
+  } else { // the running helper threads get to it
+    helperTaskQueue->queued.notify_one();
+  }
+}
+
+void HelperThreads::helperThread(void *unused [[maybe_unused]]) {
+  std::unique_lock<std::mutex> lock(helperTaskQueue->mutex);
+  for (;;) {
+    helperTaskQueue->idleThreads++;
+    bool queued = helperTaskQueue->queued.wait_for(lock, std::chrono::seconds(IDLE_SECONDS), []() {
+      return !helperTaskQueue->tasks.empty() || helperTaskQueue->forking;
+    });
+    helperTaskQueue->idleThreads--;
+    if (!queued || helperTaskQueue->forking) {
+      helperTaskQueue->threads--;
+      helperTaskQueue->stopped.notify_all();
+      return;
+    }
+    JS::HelperThreadTask *task = helperTaskQueue->tasks.front();
+    helperTaskQueue->tasks.pop_front();
+    lock.unlock();
+    JS::RunHelperThreadTask(task);
+    lock.lock();
+  }
+}
+
+void HelperThreads::beforeFork() {
+  OffThreadCompileTask::beforeFork();
+
+  std::unique_lock<std::mutex> lock(helperTaskQueue->mutex);
+  helperTaskQueue->forking = true;
+  helperTaskQueue->queued.notify_all();
+  helperTaskQueue->stopped.wait(lock, []() { return helperTaskQueue->threads == 0; });
+  lock.release(); // kept locked across fork(), so that the child does not inherit it locked by a thread it does not have
+}
+
+void HelperThreads::afterFork() {
+  helperTaskQueue->forking = false;
+  for (size_t task = 0; task < helperTaskQueue->tasks.size() && helperTaskQueue->threads < helperTaskQueue->maxThreads; task++) {
+    startThreadIfNeeded();
+  }
+  helperTaskQueue->mutex.unlock();
+
+  OffThreadCompileTask::afterFork();
+}
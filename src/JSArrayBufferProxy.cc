@@ -0,0 +1,167 @@
+/**
+ * @file JSArrayBufferProxy.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief JSArrayBufferProxy is a custom C-implemented python type that exports the memory of a JS ArrayBuffer, SharedArrayBuffer, TypedArray or DataView through the Python buffer protocol
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/JSArrayBufferProxy.hh"
+
+#include "include/modules/pythonmonkey/pythonmonkey.hh"
+#include "include/ThreadContext.hh"
+
+#include <jsapi.h>
+#include <js/ArrayBuffer.h>
+#include <js/SharedArrayBuffer.h>
+#include <js/experimental/TypedData.h>
+
+#include <Python.h>
+
+#include <cstring>
+
+PyObject *JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_new(JSContext *cx, JS::HandleObject bufObj, const char *format, Py_ssize_t itemsize) {
+  bool isSharedMemory = JS::IsSharedArrayBufferObject(bufObj);
+  if (!isSharedMemory && !JS::IsArrayBufferObject(bufObj)) { // a TypedArray or a DataView
+    if (!JS_GetArrayBufferViewBuffer(cx, bufObj, &isSharedMemory)) {
+      PyErr_SetString(PyExc_BufferError, "cannot get the ArrayBuffer of the view");
+      return nullptr;
+    }
+  }
+
+  // Small TypedArrays store their data inline in the object, and the data moves along with the object during a compacting GC.
+  // Move it to a malloc'ed ArrayBuffer so that the pointers we hand out remain valid. Shared memory is never inline.
+  if (!isSharedMemory && !JS::EnsureNonInlineArrayBufferOrView(cx, bufObj)) {
+    PyErr_SetString(PyExc_BufferError, "cannot move the data of the TypedArray out of line");
+    return nullptr;
+  }
+
+  JSArrayBufferProxy *self = PyObject_New(JSArrayBufferProxy, JSArrayBufferProxyType());
+  if (!self) {
+    return nullptr;
+  }
+  self->jsBuffer = ProxyRoots::create(bufObj);
+  self->format = format;
+  self->itemsize = itemsize;
+  self->shape = 0;
+  self->data = nullptr;
+  self->exports = 0;
+  self->shared = isSharedMemory;
+  self->pinned = false;
+  return (PyObject *)self;
+}
+
+void JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_dealloc(JSArrayBufferProxy *self)
+{
+  PyTypeObject *type = Py_TYPE(self);
+  ProxyRoots::release(self->jsBuffer);
+  PyObject_Del(self);
+  Py_DECREF(type);
+}
+
+int JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_getbuffer(JSArrayBufferProxy *self, Py_buffer *view, int flags) {
+  // the memory of a buffer whose context is destroyed is freed, and a buffer of another thread can be detached by it at any time
+  if (!ThreadContext::owns(*(self->jsBuffer))) {
+    PyErr_SetString(PyExc_BufferError, "this JavaScript buffer belongs to the JSContext of another thread, only Python values can be passed between threads");
+    return -1;
+  }
+  JS::RootedObject bufObj(GLOBAL_CX, *(self->jsBuffer));
+  bool isArrayBuffer = JS::IsArrayBufferObject(bufObj);
+  bool isSharedArrayBuffer = JS::IsSharedArrayBufferObject(bufObj);
+
+  if (self->exports == 0) {
+    if (!self->shared) { // SharedArrayBuffers can't be detached, and can only grow
+      bool isDetached;
+      if (isArrayBuffer) {
+        isDetached = JS::IsDetachedArrayBufferObject(bufObj);
+      } else {
+        bool isSharedMemory;
+        JS::RootedObject arrayBuffer(GLOBAL_CX, JS_GetArrayBufferViewBuffer(GLOBAL_CX, bufObj, &isSharedMemory));
+        if (!arrayBuffer) {
+          PyErr_SetString(PyExc_BufferError, "cannot get the ArrayBuffer of the view");
+          return -1;
+        }
+        isDetached = JS::IsArrayBufferObject(arrayBuffer) && JS::IsDetachedArrayBufferObject(arrayBuffer);
+      }
+      if (isDetached) {
+        PyErr_SetString(PyExc_BufferError, "the JS ArrayBuffer has been detached");
+        return -1;
+      }
+
+      // The buffer can't be detached, transferred or resized while its length is pinned.
+      // If it was already pinned by somebody else, leave it to them to unpin.
+      self->pinned = JS::PinArrayBufferOrViewLength(bufObj, true);
+    }
+
+    size_t byteLength;
+    if (isArrayBuffer) {
+      byteLength = JS::GetArrayBufferByteLength(bufObj);
+    } else if (isSharedArrayBuffer) {
+      byteLength = JS::GetSharedArrayBufferByteLength(bufObj);
+    } else {
+      byteLength = JS_GetArrayBufferViewByteLength(bufObj);
+    }
+    self->shape = (Py_ssize_t)byteLength / self->itemsize;
+
+    static uint8_t emptyData[1] = {}; // a Py_buffer must not point to NULL, even when empty
+
+    bool isSharedMemory;
+    JS::AutoCheckCannotGC autoNoGC(GLOBAL_CX);
+    void *data;
+    if (isArrayBuffer) {
+      data = JS::GetArrayBufferData(bufObj, &isSharedMemory, autoNoGC);
+    } else if (isSharedArrayBuffer) {
+      data = JS::GetSharedArrayBufferData(bufObj, &isSharedMemory, autoNoGC);
+    } else {
+      data = JS_GetArrayBufferViewData(bufObj, &isSharedMemory, autoNoGC);
+    }
+    self->data = (data && self->shape > 0) ? data : emptyData;
+  }
+
+  Py_INCREF(self);
+  view->obj = (PyObject *)self;
+  view->buf = self->data;
+  view->len = self->shape * self->itemsize;
+  view->itemsize = self->itemsize;
+  view->readonly = false;
+  view->ndim = 1;
+  view->format = (flags & PyBUF_FORMAT) ? (char *)self->format : NULL;
+  view->shape = (flags & PyBUF_ND) ? &self->shape : NULL;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &view->itemsize : NULL;
+  view->suboffsets = NULL;
+  view->internal = NULL;
+
+  self->exports++;
+  return 0;
+}
+
+void JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_releasebuffer(JSArrayBufferProxy *self, Py_buffer *view) {
+  self->exports--;
+  if (self->exports == 0 && self->pinned && ThreadContext::owns(*(self->jsBuffer))) { // left pinned if released on another thread
+    JS::PinArrayBufferOrViewLength(*(self->jsBuffer), false);
+    self->pinned = false;
+  }
+}
+
+JSObject *JSArrayBufferProxyMethodDefinitions::getExportedJsObject(PyObject *pyObject) {
+  if (PyObject_TypeCheck(pyObject, JSArrayBufferProxyType())) {
+    JSObject *obj = *(((JSArrayBufferProxy *)pyObject)->jsBuffer);
+    return ThreadContext::owns(obj) ? obj : nullptr;
+  }
+  if (!PyMemoryView_Check(pyObject) || ((PyMemoryViewObject *)pyObject)->flags & _Py_MEMORYVIEW_RELEASED) {
+    return nullptr; // a released memoryview no longer holds a reference to its exporter
+  }
+
+  Py_buffer *view = PyMemoryView_GET_BUFFER(pyObject);
+  if (!view->obj || !PyObject_TypeCheck(view->obj, JSArrayBufferProxyType())) {
+    return nullptr;
+  }
+  JSArrayBufferProxy *exporter = (JSArrayBufferProxy *)view->obj;
+  bool isWhole = view->buf == exporter->data && view->len == exporter->shape * exporter->itemsize && view->ndim == 1 &&
+                 (!view->strides || view->strides[0] == exporter->itemsize) &&
+                 view->format && strcmp(view->format, exporter->format) == 0;
+  JSObject *obj = *(exporter->jsBuffer);
+  return isWhole && ThreadContext::owns(obj) ? obj : nullptr;
+}
@@ -24,12 +24,17 @@
 
 void JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_dealloc(JSArrayIterProxy *self)
 {
+  PyTypeObject *type = Py_TYPE(self);
   PyObject_GC_UnTrack(self);
   Py_XDECREF(self->it.it_seq);
   PyObject_GC_Del(self);
+  Py_DECREF(type);
 }
 
 int JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_traverse(JSArrayIterProxy *self, visitproc visit, void *arg) {
+#if PY_VERSION_HEX >= 0x03090000
+  Py_VISIT(Py_TYPE(self));
+#endif
   Py_VISIT(self->it.it_seq);
   return 0;
 }
@@ -49,6 +54,9 @@ PyObject *JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_next(JSArrayIterPr
   if (seq == NULL) {
     return NULL;
   }
+  if (!JSArrayProxyMethodDefinitions::checkOwner((JSArrayProxy *)seq)) {
+    return NULL;
+  }
 
   if (self->it.reversed) {
     if (self->it.it_index >= 0) {
@@ -14,6 +14,10 @@
 #include "include/JSArrayIterProxy.hh"
 
 #include "include/modules/pythonmonkey/pythonmonkey.hh"
+#include "include/ThreadContext.hh"
+#include "include/CycleCollector.hh"
+#include "include/StructuredClone.hh"
+#include "include/AutoGIL.hh"
 #include "include/jsTypeFactory.hh"
 #include "include/pyTypeFactory.hh"
 #include "include/PyBaseProxyHandler.hh"
@@ -28,26 +32,41 @@
 
 void JSArrayProxyMethodDefinitions::JSArrayProxy_dealloc(JSArrayProxy *self)
 {
-  self->jsArray->set(nullptr);
-  delete self->jsArray;
+  PyTypeObject *type = Py_TYPE(self);
   PyObject_GC_UnTrack(self);
-  PyObject_GC_Del(self);
+  ProxyRoots::release(self->jsArray);
+  self->jsArray = nullptr;
+  ModuleState *state = ModuleState::current();
+  if (!state || type != state->JSArrayProxyType || !state->JSArrayProxyFreeList.recycle((PyObject *)self)) {
+    PyObject_GC_Del(self);
+  }
+  Py_DECREF(type);
 }
 
 int JSArrayProxyMethodDefinitions::JSArrayProxy_traverse(JSArrayProxy *self, visitproc visit, void *arg)
 {
-  // Nothing to be done
-  return 0;
+#if PY_VERSION_HEX >= 0x03090000
+  Py_VISIT(Py_TYPE(self));
+#endif
+  return CycleCollector::traverse(self->jsArray, visit, arg);
 }
 
 int JSArrayProxyMethodDefinitions::JSArrayProxy_clear(JSArrayProxy *self)
 {
-  // Nothing to be done
+  // The JS object is released by dealloc, as a proxy cleared of it could not be used anymore.
+  // The cycles CycleCollector reports through it are broken by clearing the Python objects in them.
   return 0;
 }
 
+bool JSArrayProxyMethodDefinitions::checkOwner(JSArrayProxy *self) {
+  return ThreadContext::checkOwner(*(self->jsArray));
+}
+
 Py_ssize_t JSArrayProxyMethodDefinitions::JSArrayProxy_length(JSArrayProxy *self)
 {
+  if (!checkOwner(self)) {
+    return -1;
+  }
   uint32_t length;
   JS::GetArrayLength(GLOBAL_CX, *(self->jsArray), &length);
   return (Py_ssize_t)length;
@@ -55,6 +74,9 @@ Py_ssize_t JSArrayProxyMethodDefinitions::JSArrayProxy_length(JSArrayProxy *self
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_get(JSArrayProxy *self, PyObject *key)
 {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   JS::RootedId id(GLOBAL_CX);
   if (!keyToId(key, &id)) {
     PyErr_SetString(PyExc_AttributeError, "JSArrayProxy property name must be of type str or int");
@@ -63,7 +85,7 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_get(JSArrayProxy *self, Py
 
   // look through the methods for dispatch and return key if no method found
   for (size_t index = 0;; index++) {
-    const char *methodName = JSArrayProxyType.tp_methods[index].ml_name;
+    const char *methodName = JSArrayProxyType()->tp_methods[index].ml_name;
     if (methodName == NULL || !PyUnicode_Check(key)) {   // reached end of list
       JS::RootedValue value(GLOBAL_CX);
       JS_GetPropertyById(GLOBAL_CX, *(self->jsArray), id, &value);
@@ -90,7 +112,7 @@ static PyObject *list_slice(JSArrayProxy *self, Py_ssize_t ilow, Py_ssize_t ihig
   jArgs[1].setInt32(ihigh);
   JS::RootedValue jReturnedArray(GLOBAL_CX);
   if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "slice", jArgs, &jReturnedArray)) {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
     return NULL;
   }
   return pyTypeFactory(GLOBAL_CX, jReturnedArray);
@@ -98,6 +120,9 @@ static PyObject *list_slice(JSArrayProxy *self, Py_ssize_t ilow, Py_ssize_t ihig
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_get_subscript(JSArrayProxy *self, PyObject *key)
 {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   if (PyIndex_Check(key)) {
     Py_ssize_t index = PyNumber_AsSsize_t(key, PyExc_IndexError);
     if (index == -1 && PyErr_Occurred()) {
@@ -265,6 +290,9 @@ static int list_ass_slice(JSArrayProxy *self, Py_ssize_t ilow, Py_ssize_t ihigh,
 
 int JSArrayProxyMethodDefinitions::JSArrayProxy_assign_key(JSArrayProxy *self, PyObject *key, PyObject *value)
 {
+  if (!checkOwner(self)) {
+    return -1;
+  }
   if (PyIndex_Check(key)) {
     Py_ssize_t index = PyNumber_AsSsize_t(key, PyExc_IndexError);
     if (index == -1 && PyErr_Occurred()) {
@@ -419,6 +447,9 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_richcompare(JSArrayProxy *
   if (!PyList_Check(self) || !PyList_Check(other)) {
     Py_RETURN_NOTIMPLEMENTED;
   }
+  if (!checkOwner(self) || (PyObject_TypeCheck(other, JSArrayProxyType()) && !checkOwner((JSArrayProxy *)other))) {
+    return NULL;
+  }
 
   if (self == (JSArrayProxy *)other && (op == Py_EQ || op == Py_NE)) {
     if (op == Py_EQ) {
@@ -432,7 +463,7 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_richcompare(JSArrayProxy *
   Py_ssize_t selfLength = JSArrayProxy_length(self);
   Py_ssize_t otherLength;
 
-  if (PyObject_TypeCheck(other, &JSArrayProxyType)) {
+  if (PyObject_TypeCheck(other, JSArrayProxyType())) {
     otherLength = JSArrayProxy_length((JSArrayProxy *)other);
   } else {
     otherLength = Py_SIZE(other);
@@ -459,7 +490,7 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_richcompare(JSArrayProxy *
     PyObject *rightItem;
 
     bool needToDecRefRightItem;
-    if (PyObject_TypeCheck(other, &JSArrayProxyType)) {
+    if (PyObject_TypeCheck(other, JSArrayProxyType())) {
       JS_GetElement(GLOBAL_CX, *(((JSArrayProxy *)other)->jsArray), index, &elementVal);
       rightItem = pyTypeFactory(GLOBAL_CX, elementVal);
       needToDecRefRightItem = true;
@@ -512,6 +543,9 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_richcompare(JSArrayProxy *
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_repr(JSArrayProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   Py_ssize_t selfLength = JSArrayProxy_length(self);
 
   if (selfLength == 0) {
@@ -580,7 +614,10 @@ error:
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_iter(JSArrayProxy *self) {
-  JSArrayIterProxy *iterator = PyObject_GC_New(JSArrayIterProxy, &JSArrayIterProxyType);
+  if (!checkOwner(self)) {
+    return NULL;
+  }
+  JSArrayIterProxy *iterator = PyObject_GC_New(JSArrayIterProxy, JSArrayIterProxyType());
   if (iterator == NULL) {
     return NULL;
   }
@@ -593,7 +630,10 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_iter(JSArrayProxy *self) {
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_iter_reverse(JSArrayProxy *self) {
-  JSArrayIterProxy *iterator = PyObject_GC_New(JSArrayIterProxy, &JSArrayIterProxyType);
+  if (!checkOwner(self)) {
+    return NULL;
+  }
+  JSArrayIterProxy *iterator = PyObject_GC_New(JSArrayIterProxy, JSArrayIterProxyType());
   if (iterator == NULL) {
     return NULL;
   }
@@ -611,10 +651,13 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_concat(JSArrayProxy *self,
     PyErr_Format(PyExc_TypeError, "can only concatenate list (not \"%.200s\") to list", Py_TYPE(value)->tp_name);
     return NULL;
   }
+  if (!checkOwner(self) || (PyObject_TypeCheck(value, JSArrayProxyType()) && !checkOwner((JSArrayProxy *)value))) {
+    return NULL;
+  }
 
   Py_ssize_t sizeSelf = JSArrayProxy_length(self);
   Py_ssize_t sizeValue;
-  if (PyObject_TypeCheck(value, &JSArrayProxyType)) {
+  if (PyObject_TypeCheck(value, JSArrayProxyType())) {
     sizeValue = JSArrayProxyMethodDefinitions::JSArrayProxy_length((JSArrayProxy *)value);
   } else {
     sizeValue = Py_SIZE(value);
@@ -641,7 +684,7 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_concat(JSArrayProxy *self,
     JS_SetElement(GLOBAL_CX, jCombinedArray, inputIdx, elementVal);
   }
 
-  if (PyObject_TypeCheck(value, &JSArrayProxyType)) {
+  if (PyObject_TypeCheck(value, JSArrayProxyType())) {
     for (Py_ssize_t inputIdx = 0; inputIdx < sizeValue; inputIdx++) {
       JS_GetElement(GLOBAL_CX, *(((JSArrayProxy *)value)->jsArray), inputIdx, &elementVal);
       JS_SetElement(GLOBAL_CX, jCombinedArray, sizeSelf + inputIdx, elementVal);
@@ -661,6 +704,9 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_concat(JSArrayProxy *self,
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_repeat(JSArrayProxy *self, Py_ssize_t n) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   const Py_ssize_t input_size = JSArrayProxy_length(self);
   if (input_size == 0 || n <= 0) {
     return PyList_New(0);
@@ -688,6 +734,9 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_repeat(JSArrayProxy *self,
 }
 
 int JSArrayProxyMethodDefinitions::JSArrayProxy_contains(JSArrayProxy *self, PyObject *element) {
+  if (!checkOwner(self)) {
+    return -1;
+  }
   Py_ssize_t index;
   int cmp;
 
@@ -706,6 +755,9 @@ int JSArrayProxyMethodDefinitions::JSArrayProxy_contains(JSArrayProxy *self, PyO
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_inplace_concat(JSArrayProxy *self, PyObject *value) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   Py_ssize_t selfLength = JSArrayProxy_length(self);
   Py_ssize_t valueLength = Py_SIZE(value);
 
@@ -726,6 +778,9 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_inplace_concat(JSArrayProx
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_inplace_repeat(JSArrayProxy *self, Py_ssize_t n) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   Py_ssize_t input_size = JSArrayProxy_length(self);
   if (input_size == 0 || n == 1) {
     Py_INCREF(self);
@@ -759,23 +814,32 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_inplace_repeat(JSArrayProx
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_clear_method(JSArrayProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   JS::SetArrayLength(GLOBAL_CX, *(self->jsArray), 0);
   Py_RETURN_NONE;
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_copy(JSArrayProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   JS::Rooted<JS::ValueArray<2>> jArgs(GLOBAL_CX);
   jArgs[0].setInt32(0);
   jArgs[1].setInt32(JSArrayProxy_length(self));
   JS::RootedValue jReturnedArray(GLOBAL_CX);
   if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "slice", jArgs, &jReturnedArray)) {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
     return NULL;
   }
   return pyTypeFactory(GLOBAL_CX, jReturnedArray);
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_append(JSArrayProxy *self, PyObject *value) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   Py_ssize_t len = JSArrayProxy_length(self);
 
   JS::SetArrayLength(GLOBAL_CX, *(self->jsArray), len + 1);
@@ -786,6 +850,9 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_append(JSArrayProxy *self,
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_insert(JSArrayProxy *self, PyObject *const *args, Py_ssize_t nargs) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   PyObject *return_value = NULL;
   Py_ssize_t index;
   PyObject *value;
@@ -828,13 +895,16 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_insert(JSArrayProxy *self,
 
   JS::RootedValue jReturnedArray(GLOBAL_CX);
   if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "splice", jArgs, &jReturnedArray)) {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
     return NULL;
   }
   Py_RETURN_NONE;
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_extend(JSArrayProxy *self, PyObject *iterable) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   if (PyList_CheckExact(iterable) || PyTuple_CheckExact(iterable) || (PyObject *)self == iterable) {
     iterable = PySequence_Fast(iterable, "argument must be iterable");
     if (!iterable) {
@@ -898,6 +968,9 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_extend(JSArrayProxy *self,
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_pop(JSArrayProxy *self, PyObject *const *args, Py_ssize_t nargs) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   Py_ssize_t index = -1;
 
   if (!_PyArg_CheckPositional("pop", nargs, 0, 1)) {
@@ -940,7 +1013,7 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_pop(JSArrayProxy *self, Py
 
   JS::RootedValue jReturnedArray(GLOBAL_CX);
   if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "splice", jArgs, &jReturnedArray)) {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
     return NULL;
   }
 
@@ -953,6 +1026,9 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_pop(JSArrayProxy *self, Py
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_remove(JSArrayProxy *self, PyObject *value) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   Py_ssize_t selfSize = JSArrayProxy_length(self);
 
   JS::RootedValue elementVal(GLOBAL_CX);
@@ -969,7 +1045,7 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_remove(JSArrayProxy *self,
       jArgs[1].setInt32(1);
       JS::RootedValue jReturnedArray(GLOBAL_CX);
       if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "splice", jArgs, &jReturnedArray)) {
-        PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+        PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
         return NULL;
       }
       Py_RETURN_NONE;
@@ -984,6 +1060,9 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_remove(JSArrayProxy *self,
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_index(JSArrayProxy *self, PyObject *const *args, Py_ssize_t nargs) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   PyObject *value;
   Py_ssize_t start = 0;
   Py_ssize_t stop = PY_SSIZE_T_MAX;
@@ -1042,6 +1121,9 @@ skip_optional:
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_count(JSArrayProxy *self, PyObject *value) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   Py_ssize_t count = 0;
 
   Py_ssize_t length = JSArrayProxy_length(self);
@@ -1064,10 +1146,13 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_count(JSArrayProxy *self,
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_reverse(JSArrayProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   if (JSArrayProxy_length(self) > 1) {
     JS::RootedValue jReturnedArray(GLOBAL_CX);
     if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "reverse", JS::HandleValueArray::empty(), &jReturnedArray)) {
-      PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+      PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
       return NULL;
     }
   }
@@ -1077,20 +1162,21 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_reverse(JSArrayProxy *self
 
 // private
 static bool sort_compare_key_func(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject callee(cx, &args.callee());
 
   JS::RootedValue keyFunc(cx);
   if (!JS_GetProperty(cx, callee, "_key_func_param", &keyFunc)) {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
     return false;
   }
   PyObject *keyfunc = (PyObject *)keyFunc.toPrivate();
 
   JS::RootedValue reverseValue(cx);
   if (!JS_GetProperty(cx, callee, "_reverse_param", &reverseValue)) {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
     return false;
   }
   bool reverse = reverseValue.toBoolean();
@@ -1135,12 +1221,13 @@ static bool sort_compare_key_func(JSContext *cx, unsigned argc, JS::Value *vp) {
 
 // private
 static bool sort_compare_default(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject callee(cx, &args.callee());
   JS::RootedValue reverseValue(cx);
   if (!JS_GetProperty(cx, callee, "_reverse_param", &reverseValue)) {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
     return false;
   }
   bool reverse = reverseValue.toBoolean();
@@ -1181,6 +1268,9 @@ static bool sort_compare_default(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_sort(JSArrayProxy *self, PyObject *args, PyObject *kwargs) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   static const char *const _keywords[] = {"key", "reverse", NULL};
 
   PyObject *keyfunc = Py_None;
@@ -1201,14 +1291,14 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_sort(JSArrayProxy *self, P
 
           JS::RootedValue privateValue(GLOBAL_CX, JS::PrivateValue(keyfunc));
           if (!JS_SetProperty(GLOBAL_CX, funObj, "_key_func_param", privateValue)) {  // JS::SetReservedSlot(functionObj, KeyFuncSlot, JS::PrivateValue(keyfunc)); does not work
-            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
             return NULL;
           }
 
           JS::RootedValue reverseValue(GLOBAL_CX);
           reverseValue.setBoolean(reverse);
           if (!JS_SetProperty(GLOBAL_CX, funObj, "_reverse_param", reverseValue)) {
-            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
             return NULL;
           }
 
@@ -1216,19 +1306,19 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_sort(JSArrayProxy *self, P
           jArgs[0].setObject(*funObj);
           if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "sort", jArgs, &jReturnedArray)) {
             if (!PyErr_Occurred()) {
-              PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+              PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
             }
             return NULL;
           }
 
           // cleanup
           if (!JS_DeleteProperty(GLOBAL_CX, funObj, "_key_func_param")) {
-            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
             return NULL;
           }
 
           if (!JS_DeleteProperty(GLOBAL_CX, funObj, "_reverse_param")) {
-            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
             return NULL;
           }
         }
@@ -1237,7 +1327,7 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_sort(JSArrayProxy *self, P
           JS::Rooted<JS::ValueArray<1>> jArgs(GLOBAL_CX);
           jArgs[0].set(jsTypeFactory(GLOBAL_CX, keyfunc));
           if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "sort", jArgs, &jReturnedArray)) {
-            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
             return NULL;
           }
 
@@ -1246,11 +1336,11 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_sort(JSArrayProxy *self, P
           }
         }
       }
-      else if (PyObject_TypeCheck(keyfunc, &JSFunctionProxyType)) {
+      else if (PyObject_TypeCheck(keyfunc, JSFunctionProxyType())) {
         JS::Rooted<JS::ValueArray<1>> jArgs(GLOBAL_CX);
         jArgs[0].setObject(**((JSFunctionProxy *)keyfunc)->jsFunc);
         if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "sort", jArgs, &jReturnedArray)) {
-          PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+          PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
           return NULL;
         }
 
@@ -1263,14 +1353,14 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_sort(JSArrayProxy *self, P
 
         JS::RootedValue privateValue(GLOBAL_CX, JS::PrivateValue(keyfunc));
         if (!JS_SetProperty(GLOBAL_CX, funObj, "_key_func_param", privateValue)) {  // JS::SetReservedSlot(functionObj, KeyFuncSlot, JS::PrivateValue(keyfunc)); does not work
-          PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+          PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
           return NULL;
         }
 
         JS::RootedValue reverseValue(GLOBAL_CX);
         reverseValue.setBoolean(reverse);
         if (!JS_SetProperty(GLOBAL_CX, funObj, "_reverse_param", reverseValue)) {
-          PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+          PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
           return NULL;
         }
 
@@ -1278,7 +1368,7 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_sort(JSArrayProxy *self, P
         jArgs[0].setObject(*funObj);
         if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "sort", jArgs, &jReturnedArray)) {
           if (!PyErr_Occurred()) {
-            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
           }
           return NULL;
         }
@@ -1296,17 +1386,24 @@ PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_sort(JSArrayProxy *self, P
       JS::RootedValue reverseValue(GLOBAL_CX);
       reverseValue.setBoolean(reverse);
       if (!JS_SetProperty(GLOBAL_CX, funObj, "_reverse_param", reverseValue)) {
-        PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+        PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
         return NULL;
       }
 
       JS::Rooted<JS::ValueArray<1>> jArgs(GLOBAL_CX);
       jArgs[0].setObject(*funObj);
       if (!JS_CallFunctionName(GLOBAL_CX, *(self->jsArray), "sort", jArgs, &jReturnedArray)) {
-        PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType.tp_name);
+        PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSArrayProxyType()->tp_name);
         return NULL;
       }
     }
   }
   Py_RETURN_NONE;
-}
\ No newline at end of file
+}
+PyObject *JSArrayProxyMethodDefinitions::JSArrayProxy_reduce(JSArrayProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
+  JS::RootedValue value(GLOBAL_CX, JS::ObjectValue(**(self->jsArray)));
+  return StructuredClone::reduce(GLOBAL_CX, value);
+}
@@ -11,6 +11,9 @@
 #include "include/JSFunctionProxy.hh"
 
 #include "include/modules/pythonmonkey/pythonmonkey.hh"
+#include "include/ThreadContext.hh"
+#include "include/CycleCollector.hh"
+#include "include/AutoGIL.hh"
 #include "include/jsTypeFactory.hh"
 #include "include/pyTypeFactory.hh"
 #include "include/setSpiderMonkeyException.hh"
@@ -21,18 +24,43 @@
 
 void JSFunctionProxyMethodDefinitions::JSFunctionProxy_dealloc(JSFunctionProxy *self)
 {
-  delete self->jsFunc;
+  PyTypeObject *type = Py_TYPE(self);
+  PyObject_GC_UnTrack(self);
+  ProxyRoots::release(self->jsFunc);
+  self->jsFunc = nullptr;
+  ModuleState *state = ModuleState::current();
+  if (!state || type != state->JSFunctionProxyType || !state->JSFunctionProxyFreeList.recycle((PyObject *)self)) {
+    type->tp_free((PyObject *)self);
+  }
+  Py_DECREF(type);
+}
+
+int JSFunctionProxyMethodDefinitions::JSFunctionProxy_traverse(JSFunctionProxy *self, visitproc visit, void *arg)
+{
+#if PY_VERSION_HEX >= 0x03090000
+  Py_VISIT(Py_TYPE(self));
+#endif
+  return CycleCollector::traverse(self->jsFunc, visit, arg);
+}
+
+int JSFunctionProxyMethodDefinitions::JSFunctionProxy_clear(JSFunctionProxy *self)
+{
+  // The JS function is released by dealloc, see JSObjectProxy_clear
+  return 0;
 }
 
 PyObject *JSFunctionProxyMethodDefinitions::JSFunctionProxy_new(PyTypeObject *subtype, PyObject *args, PyObject *kwds) {
   JSFunctionProxy *self = (JSFunctionProxy *)subtype->tp_alloc(subtype, 0);
   if (self) {
-    self->jsFunc = new JS::PersistentRootedObject(GLOBAL_CX);
+    self->jsFunc = ProxyRoots::create();
   }
   return (PyObject *)self;
 }
 
 PyObject *JSFunctionProxyMethodDefinitions::JSFunctionProxy_call(PyObject *self, PyObject *args, PyObject *kwargs) {
+  if (!ThreadContext::checkOwner(**((JSFunctionProxy *)self)->jsFunc)) {
+    return NULL;
+  }
   JSContext *cx = GLOBAL_CX;
   JS::RootedValue jsFunc(GLOBAL_CX, JS::ObjectValue(**((JSFunctionProxy *)self)->jsFunc));
   JSObject *jsFuncObj = jsFunc.toObjectOrNull();
@@ -54,7 +82,12 @@ PyObject *JSFunctionProxyMethodDefinitions::JSFunctionProxy_call(PyObject *self,
 
   JS::HandleValueArray jsArgs(jsArgsVector);
   JS::RootedValue jsReturnVal(cx);
-  if (!JS_CallFunctionValue(cx, thisObj, jsFunc, jsArgs, &jsReturnVal)) {
+  bool called;
+  {
+    AutoReleaseGIL releaseGIL;
+    called = JS_CallFunctionValue(cx, thisObj, jsFunc, jsArgs, &jsReturnVal);
+  }
+  if (!called) {
     setSpiderMonkeyException(cx);
     return NULL;
   }
@@ -11,6 +11,8 @@
 #include "include/JSMethodProxy.hh"
 
 #include "include/modules/pythonmonkey/pythonmonkey.hh"
+#include "include/ThreadContext.hh"
+#include "include/AutoGIL.hh"
 #include "include/jsTypeFactory.hh"
 #include "include/pyTypeFactory.hh"
 #include "include/setSpiderMonkeyException.hh"
@@ -21,7 +23,7 @@
 
 void JSMethodProxyMethodDefinitions::JSMethodProxy_dealloc(JSMethodProxy *self)
 {
-  delete self->jsFunc;
+  ProxyRoots::release(self->jsFunc);
   return;
 }
 
@@ -29,21 +31,27 @@ PyObject *JSMethodProxyMethodDefinitions::JSMethodProxy_new(PyTypeObject *subtyp
   JSFunctionProxy *jsFunctionProxy;
   PyObject *im_self;
 
-  if (!PyArg_ParseTuple(args, "O!O", &JSFunctionProxyType, &jsFunctionProxy, &im_self)) {
+  if (!PyArg_ParseTuple(args, "O!O", JSFunctionProxyType(), &jsFunctionProxy, &im_self)) {
+    return NULL;
+  }
+
+  if (!ThreadContext::checkOwner(*(jsFunctionProxy->jsFunc))) { // rooted in the JSContext of the current thread
     return NULL;
   }
 
   JSMethodProxy *self = (JSMethodProxy *)subtype->tp_alloc(subtype, 0);
   if (self) {
     self->self = im_self;
-    self->jsFunc = new JS::PersistentRootedObject(GLOBAL_CX);
-    self->jsFunc->set(*(jsFunctionProxy->jsFunc));
+    self->jsFunc = ProxyRoots::create(*(jsFunctionProxy->jsFunc));
   }
 
   return (PyObject *)self;
 }
 
 PyObject *JSMethodProxyMethodDefinitions::JSMethodProxy_call(PyObject *self, PyObject *args, PyObject *kwargs) {
+  if (!ThreadContext::checkOwner(**((JSMethodProxy *)self)->jsFunc)) {
+    return NULL;
+  }
   JSContext *cx = GLOBAL_CX;
   JS::RootedValue jsFunc(GLOBAL_CX, JS::ObjectValue(**((JSMethodProxy *)self)->jsFunc));
   JS::RootedValue selfValue(cx, jsTypeFactory(cx, ((JSMethodProxy *)self)->self));
@@ -65,7 +73,12 @@ PyObject *JSMethodProxyMethodDefinitions::JSMethodProxy_call(PyObject *self, PyO
 
   JS::HandleValueArray jsArgs(jsArgsVector);
   JS::RootedValue jsReturnVal(cx);
-  if (!JS_CallFunctionValue(cx, selfObject, jsFunc, jsArgs, &jsReturnVal)) {
+  bool called;
+  {
+    AutoReleaseGIL releaseGIL;
+    called = JS_CallFunctionValue(cx, selfObject, jsFunc, jsArgs, &jsReturnVal);
+  }
+  if (!called) {
     setSpiderMonkeyException(cx);
     return NULL;
   }
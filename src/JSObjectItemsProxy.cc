@@ -27,9 +27,11 @@
 
 void JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_dealloc(JSObjectItemsProxy *self)
 {
+  PyTypeObject *type = Py_TYPE(self);
   PyObject_GC_UnTrack(self);
   Py_XDECREF(self->dv.dv_dict);
   PyObject_GC_Del(self);
+  Py_DECREF(type);
 }
 
 Py_ssize_t JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_length(JSObjectItemsProxy *self)
@@ -41,6 +43,9 @@ Py_ssize_t JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_length(JSObje
 }
 
 int JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_traverse(JSObjectItemsProxy *self, visitproc visit, void *arg) {
+#if PY_VERSION_HEX >= 0x03090000
+  Py_VISIT(Py_TYPE(self));
+#endif
   Py_VISIT(self->dv.dv_dict);
   return 0;
 }
@@ -51,7 +56,10 @@ int JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_clear(JSObjectItemsP
 }
 
 PyObject *JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_iter(JSObjectItemsProxy *self) {
-  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, &JSObjectIterProxyType);
+  if (!JSObjectProxyMethodDefinitions::checkOwner((JSObjectProxy *)self->dv.dv_dict)) {
+    return NULL;
+  }
+  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, JSObjectIterProxyType());
   if (iterator == NULL) {
     return NULL;
   }
@@ -70,7 +78,10 @@ PyObject *JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_iter(JSObjectI
 }
 
 PyObject *JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_iter_reverse(JSObjectItemsProxy *self) {
-  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, &JSObjectIterProxyType);
+  if (!JSObjectProxyMethodDefinitions::checkOwner((JSObjectProxy *)self->dv.dv_dict)) {
+    return NULL;
+  }
+  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, JSObjectIterProxyType());
   if (iterator == NULL) {
     return NULL;
   }
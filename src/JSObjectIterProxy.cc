@@ -28,13 +28,18 @@
 
 void JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_dealloc(JSObjectIterProxy *self)
 {
+  PyTypeObject *type = Py_TYPE(self);
   delete self->it.props;
   PyObject_GC_UnTrack(self);
   Py_XDECREF(self->it.di_dict);
   PyObject_GC_Del(self);
+  Py_DECREF(type);
 }
 
 int JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_traverse(JSObjectIterProxy *self, visitproc visit, void *arg) {
+#if PY_VERSION_HEX >= 0x03090000
+  Py_VISIT(Py_TYPE(self));
+#endif
   Py_VISIT(self->it.di_dict);
   return 0;
 }
@@ -54,6 +59,9 @@ PyObject *JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_nextkey(JSObject
   if (dict == NULL) {
     return NULL;
   }
+  if (!JSObjectProxyMethodDefinitions::checkOwner((JSObjectProxy *)dict)) {
+    return NULL;
+  }
 
   if (self->it.reversed) {
     if (self->it.it_index >= 0) {
@@ -11,6 +11,7 @@
 #include "include/JSObjectKeysProxy.hh"
 
 #include "include/JSObjectIterProxy.hh"
+#include "include/JSObjectItemsProxy.hh"
 #include "include/JSObjectProxy.hh"
 #include "include/JSArrayProxy.hh"
 
@@ -24,11 +25,20 @@
 #include <Python.h>
 #include "include/pyshim.hh"
 
+/**
+ * @return whether `op` is a set-like view of a dict, or of the keys or items of a JSObjectProxy
+ */
+static bool isDictViewSet(PyObject *op) {
+  return PyDictViewSet_Check(op) || PyObject_TypeCheck(op, JSObjectKeysProxyType()) || PyObject_TypeCheck(op, JSObjectItemsProxyType());
+}
+
 void JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_dealloc(JSObjectKeysProxy *self)
 {
+  PyTypeObject *type = Py_TYPE(self);
   PyObject_GC_UnTrack(self);
   Py_XDECREF(self->dv.dv_dict);
   PyObject_GC_Del(self);
+  Py_DECREF(type);
 }
 
 Py_ssize_t JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_length(JSObjectKeysProxy *self)
@@ -48,6 +58,9 @@ int JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_contains(JSObjectKeysP
 }
 
 int JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_traverse(JSObjectKeysProxy *self, visitproc visit, void *arg) {
+#if PY_VERSION_HEX >= 0x03090000
+  Py_VISIT(Py_TYPE(self));
+#endif
   Py_VISIT(self->dv.dv_dict);
   return 0;
 }
@@ -73,7 +86,7 @@ static int all_contained_in(PyObject *self, PyObject *other) {
         ok = -1;
       break;
     }
-    if (PyObject_TypeCheck(other, &JSObjectKeysProxyType)) {
+    if (PyObject_TypeCheck(other, JSObjectKeysProxyType())) {
       JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_contains((JSObjectKeysProxy *)other, next);
     }
     else {
@@ -93,7 +106,7 @@ PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_richcompare(JSOb
   int ok;
   PyObject *result;
 
-  if (!PyAnySet_Check(other) && !PyDictViewSet_Check(other)) {
+  if (!PyAnySet_Check(other) && !isDictViewSet(other)) {
     Py_RETURN_NOTIMPLEMENTED;
   }
 
@@ -102,7 +115,7 @@ PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_richcompare(JSOb
     return NULL;
   }
 
-  if (PyObject_TypeCheck(other, &JSObjectKeysProxyType)) {
+  if (PyObject_TypeCheck(other, JSObjectKeysProxyType())) {
     len_other = JSObjectProxyMethodDefinitions::JSObjectProxy_length((JSObjectProxy *)self->dv.dv_dict);
   }
   else {
@@ -161,7 +174,10 @@ PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_richcompare(JSOb
 }
 
 PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_iter(JSObjectKeysProxy *self) {
-  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, &JSObjectIterProxyType);
+  if (!JSObjectProxyMethodDefinitions::checkOwner((JSObjectProxy *)self->dv.dv_dict)) {
+    return NULL;
+  }
+  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, JSObjectIterProxyType());
   if (iterator == NULL) {
     return NULL;
   }
@@ -180,7 +196,10 @@ PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_iter(JSObjectKey
 }
 
 PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_iter_reverse(JSObjectKeysProxy *self) {
-  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, &JSObjectIterProxyType);
+  if (!JSObjectProxyMethodDefinitions::checkOwner((JSObjectProxy *)self->dv.dv_dict)) {
+    return NULL;
+  }
+  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, JSObjectIterProxyType());
   if (iterator == NULL) {
     return NULL;
   }
@@ -221,8 +240,12 @@ Done:
 }
 
 // private
-static Py_ssize_t dictview_len(_PyDictViewObject *dv) {
+static Py_ssize_t dictview_len(PyObject *view) {
+  if (!PyDictViewSet_Check(view)) { // the views of a JSObjectProxy, whose dict is empty
+    return PyObject_Size(view);
+  }
   Py_ssize_t len = 0;
+  _PyDictViewObject *dv = (_PyDictViewObject *)view;
   if (dv->dv_dict != NULL) {
     len = dv->dv_dict->ma_used;
   }
@@ -237,17 +260,17 @@ PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_intersect(JSObje
   int rv;
 
   // Python interpreter swaps parameters when dict view is on right side of &
-  if (!PyDictViewSet_Check(self)) {
+  if (!isDictViewSet((PyObject *)self)) {
     PyObject *tmp = other;
     other = (PyObject *)self;
     self = (JSObjectKeysProxy *)tmp;
   }
 
-  if (PyObject_TypeCheck(self, &JSObjectKeysProxyType)) {
+  if (PyObject_TypeCheck(self, JSObjectKeysProxyType())) {
     len_self = JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_length(self);
   }
   else {
-    len_self = dictview_len((_PyDictViewObject *)self);
+    len_self = dictview_len((PyObject *)self);
   }
 
   // if other is a set and self is smaller than other, reuse set intersection logic
@@ -256,8 +279,8 @@ PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_intersect(JSObje
   }
 
   // if other is another dict view, and it is bigger than self, swap them
-  if (PyDictViewSet_Check(other)) {
-    Py_ssize_t len_other = dictview_len((_PyDictViewObject *)other);
+  if (isDictViewSet(other)) {
+    Py_ssize_t len_other = dictview_len(other);
     if (len_other > len_self) {
       PyObject *tmp = other;
       other = (PyObject *)self;
@@ -280,7 +303,7 @@ PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_intersect(JSObje
   }
 
   while ((key = PyIter_Next(it)) != NULL) {
-    if (PyObject_TypeCheck(self, &JSObjectKeysProxyType)) {
+    if (PyObject_TypeCheck(self, JSObjectKeysProxyType())) {
       rv = JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_contains(self, key);
     }
     else {
@@ -332,7 +355,7 @@ PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_isDisjoint(JSObj
 
   /* Iterate over the shorter object (only if other is a set,
    * because PySequence_Contains may be expensive otherwise): */
-  if (PyAnySet_Check(other) || PyDictViewSet_Check(other)) {
+  if (PyAnySet_Check(other) || isDictViewSet(other)) {
     Py_ssize_t len_self = selfLen;
     Py_ssize_t len_other = PyObject_Size(other);
     if (len_other == -1) {
@@ -353,7 +376,7 @@ PyObject *JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_isDisjoint(JSObj
 
   while ((item = PyIter_Next(it)) != NULL) {
     int contains;
-    if (PyObject_TypeCheck(self, &JSObjectKeysProxyType)) {
+    if (PyObject_TypeCheck(self, JSObjectKeysProxyType())) {
       contains = JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_contains(self, item);
     }
     else {
@@ -17,6 +17,9 @@
 #include "include/JSObjectItemsProxy.hh"
 
 #include "include/modules/pythonmonkey/pythonmonkey.hh"
+#include "include/ThreadContext.hh"
+#include "include/CycleCollector.hh"
+#include "include/StructuredClone.hh"
 #include "include/jsTypeFactory.hh"
 #include "include/pyTypeFactory.hh"
 #include "include/PyBaseProxyHandler.hh"
@@ -31,7 +34,7 @@
 
 #include <object.h>
 
-JSContext *GLOBAL_CX; /**< pointer to PythonMonkey's JSContext */
+thread_local JSContext *GLOBAL_CX; /**< pointer to the JSContext of the current thread, see ThreadContext */
 
 bool keyToId(PyObject *key, JS::MutableHandleId idp) {
   if (PyUnicode_Check(key)) { // key is str type
@@ -51,30 +54,45 @@ bool keyToId(PyObject *key, JS::MutableHandleId idp) {
 
 void JSObjectProxyMethodDefinitions::JSObjectProxy_dealloc(JSObjectProxy *self)
 {
-  self->jsObject->set(nullptr);
-  delete self->jsObject;
+  PyTypeObject *type = Py_TYPE(self);
   PyObject_GC_UnTrack(self);
-  PyObject_GC_Del(self);
+  ProxyRoots::release(self->jsObject);
+  self->jsObject = nullptr;
+  ModuleState *state = ModuleState::current();
+  if (!state || type != state->JSObjectProxyType || !state->JSObjectProxyFreeList.recycle((PyObject *)self)) {
+    PyObject_GC_Del(self);
+  }
+  Py_DECREF(type);
 }
 
 int JSObjectProxyMethodDefinitions::JSObjectProxy_traverse(JSObjectProxy *self, visitproc visit, void *arg)
 {
-  // Nothing to be done
-  return 0;
+#if PY_VERSION_HEX >= 0x03090000
+  Py_VISIT(Py_TYPE(self));
+#endif
+  return CycleCollector::traverse(self->jsObject, visit, arg);
 }
 
 int JSObjectProxyMethodDefinitions::JSObjectProxy_clear(JSObjectProxy *self)
 {
-  // Nothing to be done
+  // The JS object is released by dealloc, as a proxy cleared of it could not be used anymore.
+  // The cycles CycleCollector reports through it are broken by clearing the Python objects in them.
   return 0;
 }
 
+bool JSObjectProxyMethodDefinitions::checkOwner(JSObjectProxy *self) {
+  return ThreadContext::checkOwner(*(self->jsObject));
+}
+
 Py_ssize_t JSObjectProxyMethodDefinitions::JSObjectProxy_length(JSObjectProxy *self)
 {
+  if (!checkOwner(self)) {
+    return -1;
+  }
   JS::RootedIdVector props(GLOBAL_CX);
   if (!js::GetPropertyKeys(GLOBAL_CX, *(self->jsObject), JSITER_OWNONLY, &props))
   {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType()->tp_name);
     return -1;
   }
   return props.length();
@@ -83,7 +101,7 @@ Py_ssize_t JSObjectProxyMethodDefinitions::JSObjectProxy_length(JSObjectProxy *s
 static inline PyObject *getKey(JSObjectProxy *self, PyObject *key, JS::HandleId id, bool checkPropertyShadowsMethod) {
   // look through the methods for dispatch
   for (size_t index = 0;; index++) {
-    const char *methodName = JSObjectProxyType.tp_methods[index].ml_name;
+    const char *methodName = JSObjectProxyType()->tp_methods[index].ml_name;
     if (methodName == NULL || !PyUnicode_Check(key)) {
       JS::RootedValue value(GLOBAL_CX);
       JS_GetPropertyById(GLOBAL_CX, *(self->jsObject), id, &value);
@@ -111,7 +129,7 @@ static inline PyObject *getKey(JSObjectProxy *self, PyObject *key, JS::HandleId
           args[0].setObject(*((*(self->jsObject)).get()));
           JS::RootedValue boundFunction(GLOBAL_CX);
           if (!JS_CallFunctionName(GLOBAL_CX, valueObject, "bind", args, &boundFunction)) {
-            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType.tp_name);
+            PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType()->tp_name);
             return NULL;
           }
           value.set(boundFunction);
@@ -144,6 +162,9 @@ static inline PyObject *getKey(JSObjectProxy *self, PyObject *key, JS::HandleId
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_get(JSObjectProxy *self, PyObject *key)
 {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   JS::RootedId id(GLOBAL_CX);
   if (!keyToId(key, &id)) {
     PyErr_SetString(PyExc_AttributeError, "JSObjectProxy property name must be of type str or int");
@@ -155,6 +176,9 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_get(JSObjectProxy *self,
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_get_subscript(JSObjectProxy *self, PyObject *key)
 {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   JS::RootedId id(GLOBAL_CX);
   if (!keyToId(key, &id)) {
     PyErr_SetString(PyExc_AttributeError, "JSObjectProxy property name must be of type str or int");
@@ -166,6 +190,9 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_get_subscript(JSObjectPr
 
 int JSObjectProxyMethodDefinitions::JSObjectProxy_contains(JSObjectProxy *self, PyObject *key)
 {
+  if (!checkOwner(self)) {
+    return -1;
+  }
   JS::RootedId id(GLOBAL_CX);
   if (!keyToId(key, &id)) {
     PyErr_SetString(PyExc_AttributeError, "JSObjectProxy property name must be of type str or int");
@@ -188,6 +215,9 @@ static inline void assignKeyValue(JSObjectProxy *self, PyObject *key, JS::Handle
 
 int JSObjectProxyMethodDefinitions::JSObjectProxy_assign(JSObjectProxy *self, PyObject *key, PyObject *value)
 {
+  if (!checkOwner(self)) {
+    return -1;
+  }
   JS::RootedId id(GLOBAL_CX);
   if (!keyToId(key, &id)) { // invalid key
     PyErr_SetString(PyExc_AttributeError, "JSObjectProxy property name must be of type str or int");
@@ -204,6 +234,9 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_richcompare(JSObjectProx
   if (op != Py_EQ && op != Py_NE) {
     Py_RETURN_NOTIMPLEMENTED;
   }
+  if (!checkOwner(self) || (PyObject_TypeCheck(other, JSObjectProxyType()) && !checkOwner((JSObjectProxy *)other))) {
+    return NULL;
+  }
 
   std::unordered_map<PyObject *, PyObject *> visited;
 
@@ -246,7 +279,7 @@ bool JSObjectProxyMethodDefinitions::JSObjectProxy_richcompare_helper(JSObjectPr
   JS::RootedIdVector props(GLOBAL_CX);
   if (!js::GetPropertyKeys(GLOBAL_CX, *(self->jsObject), JSITER_OWNONLY, &props))
   {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType()->tp_name);
     return false;
   }
 
@@ -265,13 +298,13 @@ bool JSObjectProxyMethodDefinitions::JSObjectProxy_richcompare_helper(JSObjectPr
     if (!pyVal2) { // if other.key is NULL then not equal
       return false;
     }
-    if (pyVal1 && Py_TYPE(pyVal1) == &JSObjectProxyType) { // if either subvalue is a JSObjectProxy, we need to pass around our visited map
+    if (pyVal1 && Py_TYPE(pyVal1) == JSObjectProxyType()) { // if either subvalue is a JSObjectProxy, we need to pass around our visited map
       if (!JSObjectProxy_richcompare_helper((JSObjectProxy *)pyVal1, pyVal2, visited))
       {
         return false;
       }
     }
-    else if (pyVal2 && Py_TYPE(pyVal2) == &JSObjectProxyType) {
+    else if (pyVal2 && Py_TYPE(pyVal2) == JSObjectProxyType()) {
       if (!JSObjectProxy_richcompare_helper((JSObjectProxy *)pyVal2, pyVal1, visited))
       {
         return false;
@@ -286,8 +319,11 @@ bool JSObjectProxyMethodDefinitions::JSObjectProxy_richcompare_helper(JSObjectPr
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_iter(JSObjectProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   // key iteration
-  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, &JSObjectIterProxyType);
+  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, JSObjectIterProxyType());
   if (iterator == NULL) {
     return NULL;
   }
@@ -306,6 +342,9 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_iter(JSObjectProxy *self
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_iter_next(JSObjectProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   PyObject *key = PyUnicode_FromString("next");
   JS::RootedId id(GLOBAL_CX);
   if (!keyToId(key, &id)) {
@@ -343,6 +382,9 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_iter_next(JSObjectProxy
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_repr(JSObjectProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   // Detect cyclic objects
   PyObject *objPtr = PyLong_FromVoidPtr(self->jsObject->get());
   // For `Py_ReprEnter`, we must get a same PyObject when visiting the same JSObject.
@@ -549,15 +591,20 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_or(JSObjectProxy *self,
   #if PY_VERSION_HEX < 0x03090000
   // | is not supported on dicts in python3.8 or less, so only allow if both
   // operands are JSObjectProxy
-  if (!PyObject_TypeCheck(self, &JSObjectProxyType) || !PyObject_TypeCheck(other, &JSObjectProxyType)) {
+  if (!PyObject_TypeCheck(self, JSObjectProxyType()) || !PyObject_TypeCheck(other, JSObjectProxyType())) {
     Py_RETURN_NOTIMPLEMENTED;
   }
   #endif
   if (!PyDict_Check(self) || !PyDict_Check(other)) {
     Py_RETURN_NOTIMPLEMENTED;
   }
+  // either operand may be the proxy
+  if ((PyObject_TypeCheck(self, JSObjectProxyType()) && !checkOwner(self)) ||
+      (PyObject_TypeCheck(other, JSObjectProxyType()) && !checkOwner((JSObjectProxy *)other))) {
+    return NULL;
+  }
 
-  if (!PyObject_TypeCheck(self, &JSObjectProxyType) && PyObject_TypeCheck(other, &JSObjectProxyType)) {
+  if (!PyObject_TypeCheck(self, JSObjectProxyType()) && PyObject_TypeCheck(other, JSObjectProxyType())) {
     return PyDict_Type.tp_as_number->nb_or((PyObject *)&(self->dict), other);
   }
   else {
@@ -572,7 +619,7 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_or(JSObjectProxy *self,
     // call Object.assign
     JS::RootedValue Object(GLOBAL_CX);
     if (!JS_GetProperty(GLOBAL_CX, global, "Object", &Object)) {
-      PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType.tp_name);
+      PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType()->tp_name);
       return NULL;
     }
 
@@ -580,7 +627,7 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_or(JSObjectProxy *self,
     JS::RootedValue ret(GLOBAL_CX);
 
     if (!JS_CallFunctionName(GLOBAL_CX, rootedObject, "assign", args, &ret)) {
-      PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType.tp_name);
+      PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType()->tp_name);
       return NULL;
     }
     return pyTypeFactory(GLOBAL_CX, ret);
@@ -588,6 +635,9 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_or(JSObjectProxy *self,
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_ior(JSObjectProxy *self, PyObject *other) {
+  if (!checkOwner(self) || (PyObject_TypeCheck(other, JSObjectProxyType()) && !checkOwner((JSObjectProxy *)other))) {
+    return NULL;
+  }
   if (PyDict_Check(other)) {
     JS::Rooted<JS::ValueArray<2>> args(GLOBAL_CX);
     args[0].setObjectOrNull(*(self->jsObject));
@@ -599,14 +649,14 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_ior(JSObjectProxy *self,
     // call Object.assign
     JS::RootedValue Object(GLOBAL_CX);
     if (!JS_GetProperty(GLOBAL_CX, global, "Object", &Object)) {
-      PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType.tp_name);
+      PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType()->tp_name);
       return NULL;
     }
 
     JS::RootedObject rootedObject(GLOBAL_CX, Object.toObjectOrNull());
     JS::RootedValue ret(GLOBAL_CX);
     if (!JS_CallFunctionName(GLOBAL_CX, rootedObject, "assign", args, &ret)) {
-      PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType.tp_name);
+      PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType()->tp_name);
       return NULL;
     }
   }
@@ -621,6 +671,9 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_ior(JSObjectProxy *self,
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_get_method(JSObjectProxy *self, PyObject *const *args, Py_ssize_t nargs) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   PyObject *key;
   PyObject *default_value = Py_None;
 
@@ -646,6 +699,9 @@ skip_optional:
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_setdefault_method(JSObjectProxy *self, PyObject *const *args, Py_ssize_t nargs) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   PyObject *key;
   PyObject *default_value = Py_None;
 
@@ -678,6 +734,9 @@ skip_optional:
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_pop_method(JSObjectProxy *self, PyObject *const *args, Py_ssize_t nargs) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   PyObject *key;
   PyObject *default_value = NULL;
 
@@ -716,10 +775,13 @@ skip_optional:
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_clear_method(JSObjectProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   JS::RootedIdVector props(GLOBAL_CX);
   if (!js::GetPropertyKeys(GLOBAL_CX, *(self->jsObject), JSITER_OWNONLY, &props))
   {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType()->tp_name);
     return NULL;
   }
 
@@ -733,6 +795,9 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_clear_method(JSObjectPro
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_copy_method(JSObjectProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   JS::Rooted<JS::ValueArray<2>> args(GLOBAL_CX);
   args[0].setObjectOrNull(JS_NewPlainObject(GLOBAL_CX));
   args[1].setObjectOrNull(*(self->jsObject));
@@ -742,20 +807,23 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_copy_method(JSObjectProx
   // call Object.assign
   JS::RootedValue Object(GLOBAL_CX);
   if (!JS_GetProperty(GLOBAL_CX, global, "Object", &Object)) {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType()->tp_name);
     return NULL;
   }
 
   JS::RootedObject rootedObject(GLOBAL_CX, Object.toObjectOrNull());
   JS::RootedValue ret(GLOBAL_CX);
   if (!JS_CallFunctionName(GLOBAL_CX, rootedObject, "assign", args, &ret)) {
-    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType.tp_name);
+    PyErr_Format(PyExc_SystemError, "%s JSAPI call failed", JSObjectProxyType()->tp_name);
     return NULL;
   }
   return pyTypeFactory(GLOBAL_CX, ret);
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_update_method(JSObjectProxy *self, PyObject *args, PyObject *kwds) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
   PyObject *arg = NULL;
   int result = 0;
 
@@ -763,7 +831,7 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_update_method(JSObjectPr
     return NULL;
   }
   else if (arg != NULL) {
-    if (PyDict_CheckExact(arg) || PyObject_TypeCheck(arg, &JSObjectProxyType)) {
+    if (PyDict_CheckExact(arg) || PyObject_TypeCheck(arg, JSObjectProxyType())) {
       JSObjectProxyMethodDefinitions::JSObjectProxy_ior((JSObjectProxy *)self, arg);
       result = 0;
     } else { // iterable
@@ -783,13 +851,29 @@ PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_update_method(JSObjectPr
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_keys_method(JSObjectProxy *self) {
-  return PyDictView_New((PyObject *)self, &JSObjectKeysProxyType);
+  if (!checkOwner(self)) {
+    return NULL;
+  }
+  return PyDictView_New((PyObject *)self, JSObjectKeysProxyType());
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_values_method(JSObjectProxy *self) {
-  return PyDictView_New((PyObject *)self, &JSObjectValuesProxyType);
+  if (!checkOwner(self)) {
+    return NULL;
+  }
+  return PyDictView_New((PyObject *)self, JSObjectValuesProxyType());
 }
 
 PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_items_method(JSObjectProxy *self) {
-  return PyDictView_New((PyObject *)self, &JSObjectItemsProxyType);
-}
\ No newline at end of file
+  if (!checkOwner(self)) {
+    return NULL;
+  }
+  return PyDictView_New((PyObject *)self, JSObjectItemsProxyType());
+}
+PyObject *JSObjectProxyMethodDefinitions::JSObjectProxy_reduce_method(JSObjectProxy *self) {
+  if (!checkOwner(self)) {
+    return NULL;
+  }
+  JS::RootedValue value(GLOBAL_CX, JS::ObjectValue(**(self->jsObject)));
+  return StructuredClone::reduce(GLOBAL_CX, value);
+}
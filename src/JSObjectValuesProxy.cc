@@ -26,9 +26,11 @@
 
 void JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_dealloc(JSObjectValuesProxy *self)
 {
+  PyTypeObject *type = Py_TYPE(self);
   PyObject_GC_UnTrack(self);
   Py_XDECREF(self->dv.dv_dict);
   PyObject_GC_Del(self);
+  Py_DECREF(type);
 }
 
 Py_ssize_t JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_length(JSObjectValuesProxy *self)
@@ -48,6 +50,9 @@ int JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_contains(JSObjectV
 }
 
 int JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_traverse(JSObjectValuesProxy *self, visitproc visit, void *arg) {
+#if PY_VERSION_HEX >= 0x03090000
+  Py_VISIT(Py_TYPE(self));
+#endif
   Py_VISIT(self->dv.dv_dict);
   return 0;
 }
@@ -73,7 +78,7 @@ static int all_contained_in(PyObject *self, PyObject *other) {
         ok = -1;
       break;
     }
-    if (PyObject_TypeCheck(other, &JSObjectValuesProxyType)) {
+    if (PyObject_TypeCheck(other, JSObjectValuesProxyType())) {
       JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_contains((JSObjectValuesProxy *)other, next);
     }
     else {
@@ -89,7 +94,10 @@ static int all_contained_in(PyObject *self, PyObject *other) {
 }
 
 PyObject *JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_iter(JSObjectValuesProxy *self) {
-  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, &JSObjectIterProxyType);
+  if (!JSObjectProxyMethodDefinitions::checkOwner((JSObjectProxy *)self->dv.dv_dict)) {
+    return NULL;
+  }
+  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, JSObjectIterProxyType());
   if (iterator == NULL) {
     return NULL;
   }
@@ -108,7 +116,10 @@ PyObject *JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_iter(JSObjec
 }
 
 PyObject *JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_iter_reverse(JSObjectValuesProxy *self) {
-  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, &JSObjectIterProxyType);
+  if (!JSObjectProxyMethodDefinitions::checkOwner((JSObjectProxy *)self->dv.dv_dict)) {
+    return NULL;
+  }
+  JSObjectIterProxy *iterator = PyObject_GC_New(JSObjectIterProxy, JSObjectIterProxyType());
   if (iterator == NULL) {
     return NULL;
   }
@@ -0,0 +1,97 @@
+/**
+ * @file JSRealmProxy.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief JSRealmProxy is a custom C-implemented python type, exposed as pythonmonkey.Realm, that holds the global object of a separate JS realm
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/JSRealmProxy.hh"
+
+#include "include/modules/pythonmonkey/pythonmonkey.hh"
+#include "include/pyTypeFactory.hh"
+#include "include/ThreadContext.hh"
+#include "include/setSpiderMonkeyException.hh"
+
+#include <jsapi.h>
+
+#include <Python.h>
+
+/**
+ * @return the global of the realm, or nullptr with a ValueError raised if the realm is closed
+ */
+static JSObject *getRealmGlobal(JSRealmProxy *self) {
+  if (!self->global) {
+    PyErr_SetString(PyExc_ValueError, "the realm is closed");
+    return nullptr;
+  }
+  if (!ThreadContext::checkOwner(*self->global)) {
+    return nullptr;
+  }
+  return *self->global;
+}
+
+PyObject *JSRealmProxyMethodDefinitions::JSRealmProxy_new(PyTypeObject *subtype, PyObject *args, PyObject *kwds) {
+  if (PyTuple_GET_SIZE(args) || (kwds && PyDict_GET_SIZE(kwds))) {
+    PyErr_SetString(PyExc_TypeError, "pythonmonkey.Realm() takes no arguments");
+    return NULL;
+  }
+  if (!ThreadContext::ensure()) {
+    return NULL;
+  }
+
+  JS::RootedObject realmGlobal(GLOBAL_CX, newRealmGlobal(GLOBAL_CX));
+  if (!realmGlobal) {
+    setSpiderMonkeyException(GLOBAL_CX);
+    return NULL;
+  }
+
+  JSRealmProxy *self = (JSRealmProxy *)subtype->tp_alloc(subtype, 0);
+  if (!self) {
+    return NULL;
+  }
+  self->global = new JS::PersistentRootedObject(GLOBAL_CX, realmGlobal);
+  return (PyObject *)self;
+}
+
+void JSRealmProxyMethodDefinitions::JSRealmProxy_dealloc(JSRealmProxy *self) {
+  PyTypeObject *type = Py_TYPE(self);
+  delete self->global;
+  type->tp_free((PyObject *)self);
+  Py_DECREF(type);
+}
+
+PyObject *JSRealmProxyMethodDefinitions::JSRealmProxy_eval(JSRealmProxy *self, PyObject *args) {
+  JS::RootedObject realmGlobal(GLOBAL_CX, getRealmGlobal(self));
+  if (!realmGlobal) {
+    return NULL;
+  }
+  return evalInGlobal(realmGlobal, "Realm.eval", args);
+}
+
+PyObject *JSRealmProxyMethodDefinitions::JSRealmProxy_close(JSRealmProxy *self, PyObject *Py_UNUSED(args)) {
+  delete self->global;
+  self->global = nullptr;
+  Py_RETURN_NONE;
+}
+
+PyObject *JSRealmProxyMethodDefinitions::JSRealmProxy_enter(JSRealmProxy *self, PyObject *Py_UNUSED(args)) {
+  Py_INCREF(self);
+  return (PyObject *)self;
+}
+
+PyObject *JSRealmProxyMethodDefinitions::JSRealmProxy_exit(JSRealmProxy *self, PyObject *args) {
+  return JSRealmProxy_close(self, NULL);
+}
+
+PyObject *JSRealmProxyMethodDefinitions::JSRealmProxy_get_globalThis(JSRealmProxy *self, void *Py_UNUSED(closure)) {
+  JS::RootedObject realmGlobal(GLOBAL_CX, getRealmGlobal(self));
+  if (!realmGlobal) {
+    return NULL;
+  }
+  JSAutoRealm ar(GLOBAL_CX, realmGlobal);
+  JS::RootedValue globalValue(GLOBAL_CX, JS::ObjectValue(*realmGlobal));
+  return pyTypeFactory(GLOBAL_CX, globalValue);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file JSScriptProxy.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief JSScriptProxy is a custom C-implemented python type that holds a compiled JSScript, which can be executed many times
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/JSScriptProxy.hh"
+
+#include "include/modules/pythonmonkey/pythonmonkey.hh"
+#include "include/pyTypeFactory.hh"
+#include "include/setSpiderMonkeyException.hh"
+#include "include/AutoGIL.hh"
+
+#include <jsapi.h>
+#include <js/CompilationAndEvaluation.h>
+
+#include <Python.h>
+
+PyObject *JSScriptProxyMethodDefinitions::JSScriptProxy_new(JSContext *cx, JS::HandleScript script) {
+  JSScriptProxy *self = PyObject_New(JSScriptProxy, JSScriptProxyType());
+  if (!self) {
+    return nullptr;
+  }
+  self->jsScript = new JS::PersistentRooted<JSScript *>(cx, script);
+  self->cx = cx;
+  return (PyObject *)self;
+}
+
+void JSScriptProxyMethodDefinitions::JSScriptProxy_dealloc(JSScriptProxy *self)
+{
+  PyTypeObject *type = Py_TYPE(self);
+  delete self->jsScript;
+  PyObject_Del(self);
+  Py_DECREF(type);
+}
+
+PyObject *JSScriptProxyMethodDefinitions::JSScriptProxy_call(PyObject *self, PyObject *args, PyObject *kwargs) {
+  if (PyTuple_GET_SIZE(args) > 0 || (kwargs && PyDict_GET_SIZE(kwargs) > 0)) {
+    PyErr_SetString(PyExc_TypeError, "compiled scripts take no arguments");
+    return NULL;
+  }
+  if (!checkOwner((JSScriptProxy *)self)) {
+    return NULL;
+  }
+  JS::RootedScript script(GLOBAL_CX, *((JSScriptProxy *)self)->jsScript);
+  return execute(GLOBAL_CX, script);
+}
+
+bool JSScriptProxyMethodDefinitions::checkOwner(JSScriptProxy *self) {
+  if (self->cx == GLOBAL_CX && *self->jsScript) { // unrooted if its context was destroyed, whose address may have been reused since
+    return true;
+  }
+  PyErr_SetString(PyExc_RuntimeError, "this compiled script belongs to the JSContext of another thread, compile it again on this thread");
+  return false;
+}
+
+PyObject *JSScriptProxyMethodDefinitions::execute(JSContext *cx, JS::HandleScript script) {
+  // execute the compiled code; last expr goes to rval.
+  // Scripts compiled in another realm (e.g. cached by pythonmonkey.eval, then evaluated by a pythonmonkey.Realm) are cloned into the current one
+  JS::RootedValue rval(cx);
+  bool executed;
+  {
+    AutoReleaseGIL releaseGIL;
+    executed = JS::CloneAndExecuteScript(cx, script, &rval);
+  }
+  if (!executed) {
+    setSpiderMonkeyException(cx);
+    return NULL;
+  }
+
+  // translate to the proper python type
+  PyObject *returnValue = pyTypeFactory(cx, rval);
+  if (PyErr_Occurred()) {
+    Py_XDECREF(returnValue);
+    return NULL;
+  }
+
+  if (returnValue) {
+    return returnValue;
+  }
+  else {
+    Py_RETURN_NONE;
+  }
+}
@@ -13,13 +13,24 @@
 #include "include/StrType.hh"
 
 std::unordered_set<JSStringProxy *> jsStringProxies;
-extern JSContext *GLOBAL_CX;
+std::mutex jsStringProxiesMutex;
+extern thread_local JSContext *GLOBAL_CX;
 
 
 void JSStringProxyMethodDefinitions::JSStringProxy_dealloc(JSStringProxy *self)
 {
-  jsStringProxies.erase(self);
-  delete self->jsString;
+  {
+    std::lock_guard<std::mutex> lock(jsStringProxiesMutex);
+    jsStringProxies.erase(self);
+  }
+  ProxyRoots::release(self->jsString);
+  self->jsString = nullptr;
+  PyTypeObject *type = Py_TYPE(self);
+  ModuleState *state = ModuleState::current();
+  if (!state || type != state->JSStringProxyType || !state->JSStringProxyFreeList.recycle((PyObject *)self)) {
+    type->tp_free((PyObject *)self);
+  }
+  Py_DECREF(type);
 }
 
 PyObject *JSStringProxyMethodDefinitions::JSStringProxy_copy_method(JSStringProxy *self) {
@@ -12,10 +12,13 @@
 #include "include/modules/pythonmonkey/pythonmonkey.hh"
 
 #include "include/PyEventLoop.hh"
+#include "include/ThreadContext.hh"
+#include "include/AutoGIL.hh"
 #include "include/pyTypeFactory.hh"
 #include "include/PromiseType.hh"
 
 #include <Python.h>
+#include "include/pyshim.hh"
 
 #include <jsfriendapi.h>
 #include <mozilla/Unused.h>
@@ -23,7 +26,11 @@
 #include <stdexcept>
 
 JobQueue::JobQueue(JSContext *cx) {
-  finalizationRegistryCallbacks = new JS::PersistentRooted<FunctionVector>(cx);   // Leaks but it's OK since freed at process exit
+  finalizationRegistryCallbacks = new JS::PersistentRooted<FunctionVector>(cx);
+}
+
+JobQueue::~JobQueue() {
+  delete finalizationRegistryCallbacks; // the job queue is deleted after its context, whose roots are gone by then
 }
 
 bool JobQueue::getHostDefinedData(JSContext *cx, JS::MutableHandle<JSObject *> data) const {
@@ -36,6 +43,7 @@ bool JobQueue::enqueuePromiseJob(JSContext *cx,
   JS::HandleObject job,
   [[maybe_unused]] JS::HandleObject allocationSite,
   JS::HandleObject incumbentGlobal) {
+  AutoAcquireGIL acquireGIL;
 
   // Convert the `job` JS function to a Python function for event-loop callback
   JS::RootedValue jobv(cx, JS::ObjectValue(*job));
@@ -93,37 +101,87 @@ static PyObject *callDispatchFunc(PyObject *dispatchFuncTuple, PyObject *Py_UNUS
 
 static PyMethodDef callDispatchFuncDef = {"JsDispatchCallable", callDispatchFunc, METH_NOARGS, NULL};
 
+/**
+ * @brief Attach a thread that Python did not create to the interpreter of a JSContext, for the lifetime of the object.
+ * The PyGILState API only knows the main interpreter, so a thread state of the subinterpreter is created and deleted instead.
+ *    see https://docs.python.org/3/c-api/init.html#non-python-created-threads
+ */
+struct AutoAttachInterpreter {
+public:
+  explicit AutoAttachInterpreter(JSContext *cx) {
+    ThreadContext *context = ThreadContext::of(cx);
+    PyInterpreterState *interpreter = context ? context->interpreter : PyInterpreterState_Main();
+    PyThreadState *current = PyThreadState_GetUnchecked();
+    if (interpreter == PyInterpreterState_Main()) {
+      gstate = PyGILState_Ensure();
+      ensured = true;
+    } else if (!current || PyThreadState_GetInterpreter(current) != interpreter) {
+      threadState = PyThreadState_New(interpreter);
+      PyEval_RestoreThread(threadState);
+    }
+  }
+
+  ~AutoAttachInterpreter() {
+    if (ensured) {
+      PyGILState_Release(gstate);
+    } else if (threadState) {
+      PyThreadState_Clear(threadState);
+      PyThreadState_DeleteCurrent();
+    }
+  }
+
+  AutoAttachInterpreter(const AutoAttachInterpreter &) = delete;
+  AutoAttachInterpreter &operator=(const AutoAttachInterpreter &) = delete;
+
+private:
+  PyGILState_STATE gstate;
+  bool ensured = false;
+  PyThreadState *threadState = nullptr;
+};
+
+/**
+ * @return whether `tstate` is still a thread state of `interpreter`, as the thread last using a JSContext may be gone
+ */
+static bool isThreadStateOf(PyInterpreterState *interpreter, PyThreadState *tstate) {
+  for (PyThreadState *other = PyInterpreterState_ThreadHead(interpreter); other; other = PyThreadState_Next(other)) {
+    if (other == tstate) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool JobQueue::dispatchToEventLoop(void *closure, JS::Dispatchable *dispatchable) {
   JSContext *cx = (JSContext *)closure;
 
   // The `dispatchToEventLoop` function is running in a helper thread, so
-  // we must acquire the Python GIL (global interpreter lock)
-  //    see https://docs.python.org/3/c-api/init.html#non-python-created-threads
-  PyGILState_STATE gstate = PyGILState_Ensure();
+  // we must acquire the Python GIL (global interpreter lock) of the interpreter of `cx`
+  AutoAttachInterpreter attach(cx);
 
   PyObject *dispatchFuncTuple = PyTuple_Pack(2, PyLong_FromVoidPtr(cx), PyLong_FromVoidPtr(dispatchable));
   PyObject *pyFunc = PyCFunction_New(&callDispatchFuncDef, dispatchFuncTuple);
 
   // Avoid using the current, JS helper thread to send jobs to event-loop as it may cause deadlock
   PyThread_start_new_thread((void (*)(void *)) &sendJobToMainLoop, pyFunc);
-
-  PyGILState_Release(gstate);
   return true;
 }
 
 bool sendJobToMainLoop(PyObject *pyFunc) {
-  PyGILState_STATE gstate = PyGILState_Ensure();
+  JSContext *cx = (JSContext *)PyLong_AsVoidPtr(PyTuple_GetItem(PyCFunction_GET_SELF(pyFunc), 0));
+  AutoAttachInterpreter attach(cx);
 
-  // Send job to the running Python event-loop on cx's thread (the main thread)
-  PyEventLoop loop = PyEventLoop::getMainLoop();
+  // Send job to the running Python event-loop on cx's thread
+  ThreadContext *context = ThreadContext::of(cx);
+  if (context && !isThreadStateOf(context->interpreter, context->threadState)) {
+    return false;
+  }
+  PyEventLoop loop = context ? PyEventLoop::getLoopOnThread(context->threadState) : PyEventLoop::getMainLoop();
   if (!loop.initialized()) {
-    PyGILState_Release(gstate);
     return false;
   }
   loop.enqueue(pyFunc);
 
-  loop._loop = nullptr; // the `Py_XDECREF` Python API call in `PyEventLoop`'s destructor will not be accessible once we hand over the GIL by `PyGILState_Release`
-  PyGILState_Release(gstate);
+  loop._loop = nullptr; // the `Py_XDECREF` Python API call in `PyEventLoop`'s destructor will not be accessible once we hand over the GIL
   return true;
 }
 
@@ -132,6 +190,7 @@ void JobQueue::promiseRejectionTracker(JSContext *cx,
   JS::HandleObject promise,
   JS::PromiseRejectionHandlingState state,
   [[maybe_unused]] void *privateData) {
+  AutoAcquireGIL acquireGIL;
 
   // We only care about unhandled Promises
   if (state != JS::PromiseRejectionHandlingState::Unhandled) {
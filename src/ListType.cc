@@ -15,10 +15,10 @@
 
 
 PyObject *ListType::getPyObject(JSContext *cx, JS::HandleObject jsArrayObj) {
-  JSArrayProxy *proxy = (JSArrayProxy *)PyObject_CallObject((PyObject *)&JSArrayProxyType, NULL);
+  ModuleState *state = ModuleState::current();
+  JSArrayProxy *proxy = (JSArrayProxy *)state->JSArrayProxyFreeList.allocate(state->JSArrayProxyType);
   if (proxy != NULL) {
-    proxy->jsArray = new JS::PersistentRootedObject(cx);
-    proxy->jsArray->set(jsArrayObj);
+    proxy->jsArray = ProxyRoots::create(jsArrayObj);
     return (PyObject *)proxy;
   }
   return NULL;
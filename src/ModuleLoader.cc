@@ -0,0 +1,510 @@
+/**
+ * @file ModuleLoader.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Native ES module loader: resolution, a per-realm module map, parallel compilation of module graphs, and dynamic import()
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/ModuleLoader.hh"
+
+#include "include/JobQueue.hh"
+#include "include/StencilCache.hh"
+#include "include/AutoGIL.hh"
+
+#include <jsapi.h>
+#include <js/CharacterEncoding.h>
+#include <js/JSON.h>
+#include <js/MapAndSet.h>
+#include <js/Modules.h>
+#include <js/Promise.h>
+#include <js/SourceText.h>
+
+#include <Python.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <unordered_set>
+
+static const char *MODULE_EXTENSIONS[] = {"", ".mjs", ".js"};
+static const char *INDEX_FILES[] = {"index.mjs", "index.js"};
+
+/**
+ * @brief A dynamic import(), loaded, linked and evaluated as a job of the Python event-loop rather than within the
+ * call to import(), which only returns a promise
+ */
+struct DynamicImportTask : public JS::Dispatchable {
+public:
+  DynamicImportTask(JSContext *cx, JS::HandleValue referencingPrivate, JS::HandleObject moduleRequest, JS::HandleObject promise) :
+    global(cx, JS::CurrentGlobalOrNull(cx)), referencingPrivate(cx, referencingPrivate), moduleRequest(cx, moduleRequest), promise(cx, promise) {}
+
+  void run(JSContext *cx, JS::Dispatchable::MaybeShuttingDown maybeShuttingDown) override {
+    if (maybeShuttingDown == JS::Dispatchable::NotShuttingDown) {
+      JSAutoRealm ar(cx, global);
+      JS::RootedObject module(cx, ModuleLoader::loadImportedModule(cx, referencingPrivate, moduleRequest));
+      JS::RootedValue rval(cx);
+      JS::RootedObject evaluationPromise(cx);
+      if (module && JS::ModuleLink(cx, module) && JS::ModuleEvaluate(cx, module, &rval) && rval.isObject()) {
+        evaluationPromise = &rval.toObject();
+      }
+      // rejects the promise of import() with the pending exception if there is no evaluation promise
+      if (!JS::FinishDynamicModuleImport(cx, evaluationPromise, referencingPrivate, moduleRequest, promise)) {
+        JS_ClearPendingException(cx);
+      }
+    }
+    delete this;
+  }
+
+private:
+  JS::PersistentRootedObject global;
+  JS::PersistentRootedValue referencingPrivate;
+  JS::PersistentRootedObject moduleRequest;
+  JS::PersistentRootedObject promise;
+};
+
+ModuleLoader::ModuleJob::~ModuleJob() {
+  if (fc) {
+    JS::DestroyFrontendContext(fc);
+  }
+}
+
+void ModuleLoader::init(JSContext *cx) {
+  JSRuntime *rt = JS_GetRuntime(cx);
+  JS::SetModuleResolveHook(rt, resolveHook);
+  JS::SetModuleMetadataHook(rt, metadataHook);
+  JS::SetModuleDynamicImportHook(rt, dynamicImportHook);
+}
+
+JSObject *ModuleLoader::resolveHook(JSContext *cx, JS::HandleValue referencingPrivate, JS::HandleObject moduleRequest) {
+  AutoAcquireGIL acquireGIL;
+  return loadImportedModule(cx, referencingPrivate, moduleRequest); // already loaded with its graph, unless imported by a classic script
+}
+
+bool ModuleLoader::metadataHook(JSContext *cx, JS::HandleValue privateValue, JS::HandleObject metaObject) {
+  AutoAcquireGIL acquireGIL;
+  std::string path = getModulePath(cx, privateValue);
+  std::string url = "file://" + std::filesystem::path(path).generic_string();
+  JS::RootedString urlString(cx, JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(url.data(), url.size())));
+  JS::RootedString filename(cx, JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(path.data(), path.size())));
+  std::string dir = std::filesystem::path(path).parent_path().string();
+  JS::RootedString dirname(cx, JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(dir.data(), dir.size())));
+  return urlString && filename && dirname &&
+         JS_DefineProperty(cx, metaObject, "url", urlString, JSPROP_ENUMERATE) &&
+         JS_DefineProperty(cx, metaObject, "filename", filename, JSPROP_ENUMERATE) &&
+         JS_DefineProperty(cx, metaObject, "dirname", dirname, JSPROP_ENUMERATE);
+}
+
+bool ModuleLoader::dynamicImportHook(JSContext *cx, JS::HandleValue referencingPrivate, JS::HandleObject moduleRequest, JS::HandleObject promise) {
+  AutoAcquireGIL acquireGIL;
+  JobQueue::dispatchToEventLoop(cx, new DynamicImportTask(cx, referencingPrivate, moduleRequest, promise));
+  return true;
+}
+
+JSObject *ModuleLoader::loadImportedModule(JSContext *cx, JS::HandleValue referencingPrivate, JS::HandleObject moduleRequest) {
+  JS::RootedString specifierString(cx, JS::GetModuleRequestSpecifier(cx, moduleRequest));
+  JS::UniqueChars specifier = specifierString ? JS_EncodeStringToUTF8(cx, specifierString) : nullptr;
+  std::string path;
+  if (!specifier || !resolve(cx, specifier.get(), getModulePath(cx, referencingPrivate), path)) {
+    return nullptr;
+  }
+
+  JS::RootedObject module(cx);
+  if (!getModule(cx, path, &module)) {
+    return nullptr;
+  }
+  if (module) {
+    return module;
+  }
+
+  ModuleJobs jobs;
+  jobs.push_back(std::make_unique<ModuleJob>(path));
+  JS::RootedObjectVector loaded(cx);
+  if (!loadAll(cx, jobs, &loaded)) {
+    return nullptr;
+  }
+  module = loaded[0];
+  if (!loadGraph(cx, &loaded)) {
+    return nullptr;
+  }
+  return module;
+}
+
+JSObject *ModuleLoader::evaluate(JSContext *cx, const std::string &source, const ScriptOptions &options) {
+  ScriptOptions moduleOptions = options;
+  std::error_code error;
+  std::filesystem::path path = std::filesystem::absolute(options.filename, error);
+  if (!error) {
+    moduleOptions.filename = path.lexically_normal().string();
+  }
+  moduleOptions.module = true;
+
+  JS::CompileOptions compileOptions(cx);
+  compileOptions.setIntroductionType("pythonmonkey eval");
+  moduleOptions.apply(compileOptions);
+
+  RefPtr<JS::Stencil> stencil = StencilCache::enabled() ? StencilCache::lookup(cx, compileOptions, source, moduleOptions.key()) : nullptr;
+  if (!stencil) {
+    JS::SourceText<mozilla::Utf8Unit> sourceText;
+    if (!sourceText.init(cx, source.data(), source.size(), JS::SourceOwnership::Borrowed)) {
+      return nullptr;
+    }
+    stencil = JS::CompileModuleScriptToStencil(cx, compileOptions, sourceText);
+    if (!stencil) {
+      return nullptr;
+    }
+    if (StencilCache::enabled()) {
+      StencilCache::store(cx, stencil, source, moduleOptions.key());
+    }
+  }
+
+  JS::RootedObject module(cx, instantiate(cx, compileOptions, stencil, moduleOptions.filename));
+  if (!module) {
+    return nullptr;
+  }
+  JS::RootedObjectVector frontier(cx);
+  if (!frontier.append(module) || !loadGraph(cx, &frontier) || !JS::ModuleLink(cx, module)) {
+    return nullptr;
+  }
+
+  JS::RootedValue rval(cx);
+  if (!JS::ModuleEvaluate(cx, module, &rval)) {
+    return nullptr;
+  }
+  if (rval.isObject()) { // a rejected evaluation promise throws here, a pending one (top-level await) settles on the event-loop
+    JS::RootedObject evaluationPromise(cx, &rval.toObject());
+    if (!JS::ThrowOnModuleEvaluationFailure(cx, evaluationPromise, JS::ThrowModuleErrorsSync)) {
+      return nullptr;
+    }
+  }
+  return JS::GetModuleNamespace(cx, module);
+}
+
+bool ModuleLoader::resolve(JSContext *cx, const std::string &specifier, const std::string &referrer, std::string &path) {
+  std::string spec = specifier.rfind("file://", 0) == 0 ? specifier.substr(7) : specifier;
+  std::error_code error;
+  std::filesystem::path base = referrer.empty() ? std::filesystem::current_path(error) : std::filesystem::path(referrer).parent_path();
+
+  bool isPath = spec.rfind("/", 0) == 0 || spec.rfind("./", 0) == 0 || spec.rfind("../", 0) == 0 || spec == "." || spec == ".." ||
+                std::filesystem::path(spec).is_absolute();
+  if (isPath) {
+    if (resolveFile(cx, base / spec, path)) {
+      return true;
+    }
+  } else {
+    for (std::filesystem::path dir = base;; dir = dir.parent_path()) {
+      if (resolveFile(cx, dir / "node_modules" / spec, path)) {
+        return true;
+      }
+      if (dir == dir.parent_path()) {
+        break;
+      }
+    }
+
+    // then the same global node_modules directories as pythonmonkey.require
+    std::vector<std::filesystem::path> searchPaths;
+    PyObject *sysPath = PySys_GetObject("path"); // borrowed
+    for (Py_ssize_t i = 0; sysPath && PyList_Check(sysPath) && i < PyList_GET_SIZE(sysPath); i++) {
+      PyObject *item = PyList_GET_ITEM(sysPath, i);
+      const char *itemPath = PyUnicode_Check(item) ? PyUnicode_AsUTF8(item) : NULL;
+      if (itemPath) {
+        searchPaths.push_back(std::filesystem::path(itemPath) / "node_modules");
+      }
+    }
+    PyObject *require = PyImport_ImportModule("pythonmonkey.require");
+    PyObject *nodeModules = require ? PyObject_GetAttrString(require, "node_modules") : NULL;
+    if (nodeModules && PyUnicode_Check(nodeModules)) {
+      searchPaths.push_back(PyUnicode_AsUTF8(nodeModules));
+    }
+    Py_XDECREF(nodeModules);
+    Py_XDECREF(require);
+    PyErr_Clear();
+
+    for (const std::filesystem::path &searchPath : searchPaths) {
+      if (resolveFile(cx, searchPath / spec, path)) {
+        return true;
+      }
+    }
+  }
+
+  if (!JS_IsExceptionPending(cx)) {
+    JS_ReportErrorUTF8(cx, "Cannot find module '%s' imported from %s", specifier.c_str(), referrer.empty() ? base.string().c_str() : referrer.c_str());
+  }
+  return false;
+}
+
+bool ModuleLoader::resolveFile(JSContext *cx, const std::filesystem::path &candidate, std::string &path) {
+  std::error_code error;
+  for (const char *extension : MODULE_EXTENSIONS) {
+    std::filesystem::path file = candidate;
+    file += extension;
+    if (std::filesystem::is_regular_file(file, error)) {
+      path = std::filesystem::absolute(file, error).lexically_normal().string();
+      return true;
+    }
+  }
+
+  if (std::filesystem::is_directory(candidate, error)) {
+    std::string entry;
+    if (readPackageEntry(cx, candidate / "package.json", entry) && resolveFile(cx, candidate / entry, path)) {
+      return true;
+    }
+    for (const char *index : INDEX_FILES) {
+      if (std::filesystem::is_regular_file(candidate / index, error)) {
+        path = std::filesystem::absolute(candidate / index, error).lexically_normal().string();
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Get a string property of an object as UTF-8
+ *
+ * @return false if the property isn't a string
+ */
+static bool getStringProperty(JSContext *cx, JS::HandleObject obj, const char *name, std::string &value) {
+  JS::RootedValue property(cx);
+  if (!JS_GetProperty(cx, obj, name, &property) || !property.isString()) {
+    return false;
+  }
+  JS::RootedString propertyString(cx, property.toString());
+  JS::UniqueChars chars = JS_EncodeStringToUTF8(cx, propertyString);
+  if (!chars) {
+    return false;
+  }
+  value = chars.get();
+  return true;
+}
+
+bool ModuleLoader::readPackageEntry(JSContext *cx, const std::filesystem::path &packageJson, std::string &entry) {
+  std::ifstream in(packageJson, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  JS::RootedString jsonString(cx, JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(json.data(), json.size())));
+  JS::RootedValue package(cx);
+  if (!jsonString || !JS_ParseJSON(cx, jsonString, &package) || !package.isObject()) {
+    JS_ClearPendingException(cx); // not a valid package.json, try the index files
+    return false;
+  }
+  JS::RootedObject packageObject(cx, &package.toObject());
+
+  // "exports": "./entry.js", or { ".": ... }, or { "import": ..., "default": ... }, with conditions nested at most once
+  JS::RootedValue exports(cx);
+  if (JS_GetProperty(cx, packageObject, "exports", &exports) && exports.isObject()) {
+    JS::RootedObject exportsObject(cx, &exports.toObject());
+    JS::RootedValue dot(cx);
+    if (JS_GetProperty(cx, exportsObject, ".", &dot) && dot.isObject()) {
+      exportsObject = &dot.toObject();
+    } else if (dot.isString()) {
+      return getStringProperty(cx, exportsObject, ".", entry);
+    }
+    if (getStringProperty(cx, exportsObject, "import", entry) || getStringProperty(cx, exportsObject, "default", entry)) {
+      return true;
+    }
+  } else if (getStringProperty(cx, packageObject, "exports", entry)) {
+    return true;
+  }
+  bool found = getStringProperty(cx, packageObject, "module", entry) || getStringProperty(cx, packageObject, "main", entry);
+  JS_ClearPendingException(cx);
+  return found;
+}
+
+bool ModuleLoader::loadGraph(JSContext *cx, JS::MutableHandleObjectVector frontier) {
+  while (!frontier.empty()) {
+    ModuleJobs jobs;
+    std::unordered_set<std::string> queued;
+    for (size_t i = 0; i < frontier.length(); i++) {
+      JS::RootedObject module(cx, frontier[i]);
+      JS::RootedValue modulePrivate(cx, JS::GetModulePrivate(module));
+      std::string referrer = getModulePath(cx, modulePrivate);
+
+      uint32_t count = JS::GetRequestedModulesCount(cx, module);
+      for (uint32_t request = 0; request < count; request++) {
+        JS::RootedString specifierString(cx, JS::GetRequestedModuleSpecifier(cx, module, request));
+        JS::UniqueChars specifier = specifierString ? JS_EncodeStringToUTF8(cx, specifierString) : nullptr;
+        std::string path;
+        if (!specifier || !resolve(cx, specifier.get(), referrer, path)) {
+          return false;
+        }
+        JS::RootedObject loadedModule(cx);
+        if (!getModule(cx, path, &loadedModule)) {
+          return false;
+        }
+        if (!loadedModule && queued.insert(path).second) {
+          jobs.push_back(std::make_unique<ModuleJob>(path));
+        }
+      }
+    }
+
+    frontier.clear();
+    if (!jobs.empty() && !loadAll(cx, jobs, frontier)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @return the StencilCache options key of a module file loaded by import
+ */
+static std::string moduleKey(const std::string &path) {
+  ScriptOptions moduleOptions;
+  moduleOptions.filename = path;
+  moduleOptions.module = true;
+  return moduleOptions.key();
+}
+
+bool ModuleLoader::loadAll(JSContext *cx, ModuleJobs &jobs, JS::MutableHandleObjectVector loaded) {
+  for (std::unique_ptr<ModuleJob> &job : jobs) {
+    ScriptOptions moduleOptions;
+    moduleOptions.filename = job->path;
+    moduleOptions.module = true;
+    JS::CompileOptions compileOptions(cx);
+    compileOptions.setIntroductionType("pythonmonkey import");
+    moduleOptions.apply(compileOptions); // the same options as moduleKey()
+    job->fc = JS::NewFrontendContext();
+    if (!job->fc || !job->options.copy(job->fc, compileOptions)) {
+      JS_ReportOutOfMemory(cx);
+      return false;
+    }
+  }
+
+  if (StencilCache::enabled()) {
+    runInParallel(jobs, false);
+    for (std::unique_ptr<ModuleJob> &job : jobs) {
+      if (!job->readFailed) {
+        job->stencil = StencilCache::lookup(cx, job->options, job->source, moduleKey(job->path));
+      }
+    }
+  }
+  runInParallel(jobs, true);
+
+  for (std::unique_ptr<ModuleJob> &job : jobs) {
+    if (job->readFailed) {
+      JS_ReportErrorUTF8(cx, "Cannot read module %s", job->path.c_str());
+      return false;
+    }
+    if (!job->stencil) {
+      JS::ConvertFrontendErrorsToRuntimeErrors(cx, job->fc, job->options);
+      if (!JS_IsExceptionPending(cx)) {
+        JS_ReportErrorUTF8(cx, "Cannot compile module %s", job->path.c_str());
+      }
+      return false;
+    }
+    if (job->compiled && StencilCache::enabled()) {
+      StencilCache::store(cx, job->stencil, job->source, moduleKey(job->path));
+    }
+    JS::RootedObject module(cx, instantiate(cx, job->options, job->stencil, job->path));
+    if (!module || !loaded.append(module)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ModuleLoader::runInParallel(ModuleJobs &jobs, bool compile) {
+  std::atomic<size_t> next = 0;
+  auto work = [&jobs, &next, compile]() {
+    for (size_t i = next++; i < jobs.size(); i = next++) {
+      ModuleJob &job = *jobs[i];
+      if (!job.read) {
+        std::ifstream in(job.path, std::ios::binary);
+        job.source.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        job.readFailed = !in && !in.eof();
+        job.read = true;
+      }
+      if (compile && !job.readFailed && !job.stencil) {
+        JS::SetNativeStackQuota(job.fc, STACK_QUOTA);
+        JS::SourceText<mozilla::Utf8Unit> source;
+        if (source.init(job.fc, job.source.data(), job.source.size(), JS::SourceOwnership::Borrowed)) {
+          job.stencil = JS::CompileModuleScriptToStencil(job.fc, job.options, source);
+          job.compiled = bool(job.stencil);
+        }
+      }
+    }
+  };
+
+  size_t threadCount = std::min<size_t>(jobs.size(), std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < threadCount; i++) {
+    threads.emplace_back(work);
+  }
+  work(); // the calling thread takes a share too
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+JSObject *ModuleLoader::instantiate(JSContext *cx, const JS::ReadOnlyCompileOptions &options, JS::Stencil *stencil, const std::string &path) {
+  JS::InstantiateOptions instantiateOptions(options);
+  JS::RootedObject module(cx, JS::InstantiateModuleStencil(cx, instantiateOptions, stencil));
+  if (!module) {
+    return nullptr;
+  }
+  JS::RootedString pathString(cx, JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(path.data(), path.size())));
+  if (!pathString) {
+    return nullptr;
+  }
+  JS::SetModulePrivate(module, JS::StringValue(pathString));
+  if (!setModule(cx, path, module)) {
+    return nullptr;
+  }
+  return module;
+}
+
+JSObject *ModuleLoader::getModuleMap(JSContext *cx) {
+  JS::RootedObject global(cx, JS::CurrentGlobalOrNull(cx));
+  JS::Value mapValue = JS::GetReservedSlot(global, MODULE_MAP_SLOT);
+  if (mapValue.isObject()) {
+    return &mapValue.toObject();
+  }
+  JSObject *map = JS::NewMapObject(cx);
+  if (map) {
+    JS::SetReservedSlot(global, MODULE_MAP_SLOT, JS::ObjectValue(*map));
+  }
+  return map;
+}
+
+bool ModuleLoader::getModule(JSContext *cx, const std::string &path, JS::MutableHandleObject module) {
+  JS::RootedObject map(cx, getModuleMap(cx));
+  JS::RootedString pathString(cx, JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(path.data(), path.size())));
+  if (!map || !pathString) {
+    return false;
+  }
+  JS::RootedValue key(cx, JS::StringValue(pathString));
+  JS::RootedValue value(cx);
+  if (!JS::MapGet(cx, map, key, &value)) {
+    return false;
+  }
+  module.set(value.isObject() ? &value.toObject() : nullptr);
+  return true;
+}
+
+bool ModuleLoader::setModule(JSContext *cx, const std::string &path, JS::HandleObject module) {
+  JS::RootedObject map(cx, getModuleMap(cx));
+  JS::RootedString pathString(cx, JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(path.data(), path.size())));
+  if (!map || !pathString) {
+    return false;
+  }
+  JS::RootedValue key(cx, JS::StringValue(pathString));
+  JS::RootedValue value(cx, JS::ObjectValue(*module));
+  return JS::MapSet(cx, map, key, value);
+}
+
+std::string ModuleLoader::getModulePath(JSContext *cx, JS::HandleValue privateValue) {
+  if (!privateValue.isString()) {
+    return std::string();
+  }
+  JS::RootedString pathString(cx, privateValue.toString());
+  JS::UniqueChars path = JS_EncodeStringToUTF8(cx, pathString);
+  return path ? std::string(path.get()) : std::string();
+}
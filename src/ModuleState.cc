@@ -0,0 +1,153 @@
+/**
+ * @file ModuleState.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief The state of the pythonmonkey module in each Python interpreter: its heap types, exception type and event-loop bookkeeping
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/ModuleState.hh"
+
+#include "include/ThreadContext.hh"
+
+#include <Python.h>
+#include "include/pyshim.hh"
+
+static const char CAPSULE_NAME[] = "pythonmonkey.ModuleState";
+
+ModuleState::ModuleState(PyInterpreterState *interpreter) : interpreter(interpreter), mainInterpreter(interpreter == PyInterpreterState_Main()) {}
+
+ModuleState *ModuleState::lookup(PyInterpreterState *interpreter) {
+  uint64_t currentGeneration = generation.load(std::memory_order_acquire);
+  PyObject *interpreterDict = PyInterpreterState_GetDict(interpreter);
+  PyObject *capsule = interpreterDict ? PyDict_GetItemString(interpreterDict, CAPSULE_NAME) : NULL; // borrowed reference
+  ModuleState *state = capsule ? (ModuleState *)PyCapsule_GetPointer(capsule, CAPSULE_NAME) : nullptr;
+  if (state) {
+    cachedInterpreter = interpreter;
+    cachedState = state;
+    cachedGeneration = currentGeneration;
+  }
+  return state;
+}
+
+ModuleState *ModuleState::create() {
+  PyInterpreterState *interpreter = PyThreadState_GetInterpreter(PyThreadState_Get());
+  if (lookup(interpreter)) {
+    PyErr_SetString(PyExc_ImportError, "pythonmonkey is already loaded in this interpreter");
+    return nullptr;
+  }
+  PyObject *interpreterDict = PyInterpreterState_GetDict(interpreter);
+  if (!interpreterDict) {
+    PyErr_SetString(PyExc_ImportError, "pythonmonkey cannot keep its state in this interpreter");
+    return nullptr;
+  }
+
+  ModuleState *state = new ModuleState(interpreter);
+  PyObject *capsule = PyCapsule_New(state, CAPSULE_NAME, NULL);
+  if (!capsule || PyDict_SetItemString(interpreterDict, CAPSULE_NAME, capsule) < 0) {
+    Py_XDECREF(capsule);
+    delete state;
+    return nullptr;
+  }
+  Py_DECREF(capsule);
+  return state;
+}
+
+void ModuleState::destroy(ModuleState *state) {
+  delete state;
+}
+
+ModuleState::~ModuleState() {
+  generation.fetch_add(1, std::memory_order_release);
+
+  // JSContexts of other threads cannot be destroyed from this one, and are left behind along with the Python objects they reference
+  for (ThreadContext *context: threadContexts) {
+    ThreadContext::destroyOnOwnThread(context);
+  }
+  timers.clear();
+  delete locker;
+  clear();
+
+  PyObject *interpreterDict = PyInterpreterState_GetDict(interpreter);
+  if (interpreterDict && PyDict_GetItemString(interpreterDict, CAPSULE_NAME) && PyDict_DelItemString(interpreterDict, CAPSULE_NAME) < 0) {
+    PyErr_Clear();
+  }
+}
+
+int ModuleState::traverse(visitproc visit, void *arg) {
+  Py_VISIT(NullType);
+  Py_VISIT(BigIntType);
+  Py_VISIT(JSObjectProxyType);
+  Py_VISIT(JSStringProxyType);
+  Py_VISIT(JSFunctionProxyType);
+  Py_VISIT(JSMethodProxyType);
+  Py_VISIT(JSArrayProxyType);
+  Py_VISIT(JSArrayBufferProxyType);
+  Py_VISIT(JSScriptProxyType);
+  Py_VISIT(JSRealmProxyType);
+  Py_VISIT(JSArrayIterProxyType);
+  Py_VISIT(JSObjectIterProxyType);
+  Py_VISIT(JSObjectKeysProxyType);
+  Py_VISIT(JSObjectValuesProxyType);
+  Py_VISIT(JSObjectItemsProxyType);
+  Py_VISIT(SpiderMonkeyError);
+  return 0;
+}
+
+void ModuleState::evictTypeAttributeNames(PyTypeObject *type) {
+  auto entry = typeAttributeNames.find(type);
+  if (entry == typeAttributeNames.end()) {
+    return;
+  }
+#if PY_VERSION_HEX >= 0x030c0000
+  // a type being freed is still valid while the callbacks of its weak references run
+  if (PyType_Unwatch(typeWatcher, (PyObject *)type) < 0) {
+    PyErr_Clear();
+  }
+#endif
+  TypeAttributeNames names = entry->second;
+  typeAttributeNamesLRU.erase(names.lruPosition);
+  typeAttributeNames.erase(entry);
+  Py_DECREF(names.names);
+  Py_DECREF(names.nameSet);
+  Py_XDECREF(names.typeRef); // a weak reference freed before its type never calls back
+}
+
+void ModuleState::clearTypeAttributeNames() {
+  while (!typeAttributeNamesLRU.empty()) {
+    evictTypeAttributeNames(typeAttributeNamesLRU.back());
+  }
+}
+
+void ModuleState::clear() {
+  JSObjectProxyFreeList.clear();
+  JSStringProxyFreeList.clear();
+  JSFunctionProxyFreeList.clear();
+  JSArrayProxyFreeList.clear();
+  Py_CLEAR(NullType);
+  Py_CLEAR(BigIntType);
+  Py_CLEAR(JSObjectProxyType);
+  Py_CLEAR(JSStringProxyType);
+  Py_CLEAR(JSFunctionProxyType);
+  Py_CLEAR(JSMethodProxyType);
+  Py_CLEAR(JSArrayProxyType);
+  Py_CLEAR(JSArrayBufferProxyType);
+  Py_CLEAR(JSScriptProxyType);
+  Py_CLEAR(JSRealmProxyType);
+  Py_CLEAR(JSArrayIterProxyType);
+  Py_CLEAR(JSObjectIterProxyType);
+  Py_CLEAR(JSObjectKeysProxyType);
+  Py_CLEAR(JSObjectValuesProxyType);
+  Py_CLEAR(JSObjectItemsProxyType);
+  Py_CLEAR(SpiderMonkeyError);
+  clearTypeAttributeNames();
+  Py_CLEAR(typeAttributeNamesEvictor);
+#if PY_VERSION_HEX >= 0x030c0000
+  if (typeWatcher >= 0 && PyType_ClearWatcher(typeWatcher) < 0) {
+    PyErr_Clear();
+  }
+  typeWatcher = -1;
+#endif
+}
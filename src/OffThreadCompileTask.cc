@@ -0,0 +1,200 @@
+/**
+ * @file OffThreadCompileTask.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Compile a script to a stencil on a helper thread, then execute it on the thread running the Python event-loop
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/OffThreadCompileTask.hh"
+
+#include "include/JobQueue.hh"
+#include "include/JSScriptProxy.hh"
+#include "include/setSpiderMonkeyException.hh"
+
+#include <jsapi.h>
+#include <js/CompilationAndEvaluation.h>
+#include <js/SourceText.h>
+
+#include <Python.h>
+#include <pythread.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief The tasks waiting for a helper thread. Never destroyed, as idle helper threads may still wait on it at exit.
+ */
+struct CompileQueue {
+  std::mutex mutex;
+  std::condition_variable queued;
+  std::condition_variable stopped; /**< notified when a helper thread exits */
+  std::deque<OffThreadCompileTask *> tasks;
+  size_t threads = 0; /**< helper threads running */
+  size_t idleThreads = 0; /**< helper threads waiting for a task */
+  bool forking = false; /**< between beforeFork() and afterFork(), no helper thread runs */
+};
+
+static CompileQueue *compileQueue = new CompileQueue();
+
+OffThreadCompileTask::OffThreadCompileTask(JSContext *cx, std::string &&code, FILE *file, PyEventLoop::Future &&future) :
+  cx(cx), global(cx, JS::CurrentGlobalOrNull(cx)), fc(JS::NewFrontendContext()),
+  options(JS::OwningCompileOptions::ForFrontendContext()), code(std::move(code)), file(file), future(std::move(future)) {}
+
+OffThreadCompileTask::~OffThreadCompileTask() {
+  if (fc) {
+    JS::DestroyFrontendContext(fc);
+  }
+}
+
+bool OffThreadCompileTask::start(JSContext *cx, const JS::ReadOnlyCompileOptions &options, std::string &&code, FILE *file,
+  PyEventLoop::Future &&future) {
+  OffThreadCompileTask *task = new OffThreadCompileTask(cx, std::move(code), file, std::move(future));
+  if (!task->fc || !task->options.copy(task->fc, options)) {
+    PyErr_NoMemory();
+  } else if (!enqueue(task)) {
+    PyErr_SetString(PyExc_RuntimeError, "pythonmonkey.eval_async could not start a compilation thread");
+  } else {
+    return true;
+  }
+
+  if (file) {
+    fclose(file);
+  }
+  delete task;
+  return false;
+}
+
+bool OffThreadCompileTask::enqueue(OffThreadCompileTask *task) {
+  std::lock_guard<std::mutex> lock(compileQueue->mutex);
+  compileQueue->tasks.push_back(task);
+  if (compileQueue->forking) { // afterFork() starts its thread
+    return true;
+  }
+  if (startThreadIfNeeded()) {
+    return true;
+  }
+  compileQueue->tasks.pop_back();
+  return false;
+}
+
+bool OffThreadCompileTask::startThreadIfNeeded() {
+  size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  if (compileQueue->idleThreads >= compileQueue->tasks.size() || compileQueue->threads >= maxThreads) {
+    compileQueue->queued.notify_one();
+    return true;
+  }
+  if (PyThread_start_new_thread(helperThread, NULL) != PYTHREAD_INVALID_THREAD_ID) {
+    compileQueue->threads++;
+    return true;
+  }
+  if (compileQueue->threads > 0) { // the running helper threads get to it
+    compileQueue->queued.notify_one();
+    return true;
+  }
+  return false;
+}
+
+void OffThreadCompileTask::helperThread(void *unused [[maybe_unused]]) {
+  std::unique_lock<std::mutex> lock(compileQueue->mutex);
+  for (;;) {
+    compileQueue->idleThreads++;
+    bool queued = compileQueue->queued.wait_for(lock, std::chrono::seconds(IDLE_SECONDS), []() {
+      return !compileQueue->tasks.empty() || compileQueue->forking;
+    });
+    compileQueue->idleThreads--;
+    if (!queued || compileQueue->forking) {
+      compileQueue->threads--;
+      compileQueue->stopped.notify_all();
+      return;
+    }
+    OffThreadCompileTask *task = compileQueue->tasks.front();
+    compileQueue->tasks.pop_front();
+    lock.unlock();
+    task->compile();
+    lock.lock();
+  }
+}
+
+void OffThreadCompileTask::beforeFork() {
+  std::unique_lock<std::mutex> lock(compileQueue->mutex);
+  compileQueue->forking = true;
+  compileQueue->queued.notify_all();
+  compileQueue->stopped.wait(lock, []() { return compileQueue->threads == 0; });
+  lock.release(); // kept locked across fork(), see HelperThreads::beforeFork()
+}
+
+void OffThreadCompileTask::afterFork() {
+  compileQueue->forking = false;
+  for (size_t task = 0; task < compileQueue->tasks.size(); task++) {
+    if (!startThreadIfNeeded()) {
+      break; // the tasks wait for the next call to start a thread
+    }
+  }
+  compileQueue->mutex.unlock();
+}
+
+void OffThreadCompileTask::compile() {
+  if (file) { // read the file here too, it may be slow
+    char buffer[64 * 1024];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      code.append(buffer, read);
+    }
+    fclose(file);
+    file = NULL;
+  }
+
+  JS::SetNativeStackQuota(fc, STACK_QUOTA);
+  JS::SourceText<mozilla::Utf8Unit> source;
+  if (source.init(fc, code.data(), code.size(), JS::SourceOwnership::Borrowed)) {
+    stencil = JS::CompileGlobalScriptToStencil(fc, options, source);
+  }
+
+  JobQueue::dispatchToEventLoop(cx, this); // errors, if any, are reported by run()
+}
+
+void OffThreadCompileTask::run(JSContext *cx, JS::Dispatchable::MaybeShuttingDown maybeShuttingDown) {
+  if (maybeShuttingDown == JS::Dispatchable::ShuttingDown || future.isCancelled()) {
+    delete this;
+    return;
+  }
+
+  JSAutoRealm ar(cx, global);
+  PyObject *result = NULL;
+  if (!stencil) {
+    JS::ConvertFrontendErrorsToRuntimeErrors(cx, fc, options);
+    setSpiderMonkeyException(cx);
+  } else {
+    JS::InstantiateOptions instantiateOptions(options);
+    JS::RootedScript script(cx, JS::InstantiateGlobalStencil(cx, instantiateOptions, stencil));
+    if (!script) {
+      setSpiderMonkeyException(cx);
+    } else {
+      result = JSScriptProxyMethodDefinitions::execute(cx, script);
+    }
+  }
+
+  if (result) {
+    future.setResult(result);
+    Py_DECREF(result);
+  } else {
+    PyObject *type, *value, *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+    PyErr_NormalizeException(&type, &value, &traceback);
+    if (traceback) {
+      PyException_SetTraceback(value, traceback);
+    }
+    future.setException(value);
+    Py_XDECREF(type);
+    Py_XDECREF(value);
+    Py_XDECREF(traceback);
+  }
+  delete this;
+}
@@ -14,6 +14,7 @@
 #include "include/PyEventLoop.hh"
 #include "include/pyTypeFactory.hh"
 #include "include/jsTypeFactory.hh"
+#include "include/AutoGIL.hh"
 
 #include <jsapi.h>
 #include <jsfriendapi.h>
@@ -27,6 +28,7 @@
 #define PROMISE_OBJ_SLOT 1
 
 static bool onResolvedCb(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   // Get the Promise state
@@ -41,7 +43,7 @@ static bool onResolvedCb(JSContext *cx, unsigned argc, JS::Value *vp) {
   if (state == JS::PromiseState::Rejected && !PyExceptionInstance_Check(result)) {
     // Wrap the result object into a SpiderMonkeyError object
     // because only *Exception objects can be thrown in Python `raise` statement and alike
-    PyObject *wrapped = PyObject_CallOneArg(SpiderMonkeyError, result); // wrapped = SpiderMonkeyError(result)
+    PyObject *wrapped = PyObject_CallOneArg(SpiderMonkeyError(), result); // wrapped = SpiderMonkeyError(result)
     // Preserve the original JS value as the `jsError` attribute for lossless conversion back
     PyObject *originalJsErrCapsule = DictType::getPyObject(cx, resultArg);
     PyObject_SetAttrString(wrapped, "jsError", originalJsErrCapsule);
@@ -92,7 +94,7 @@ static PyObject *futureOnDoneCallback(PyObject *futureCallbackTuple, PyObject *a
                                                   // see https://docs.python.org/3.9/library/asyncio-future.html#asyncio.Future.add_done_callback
   PyEventLoop::Future future = PyEventLoop::Future(futureObj);
 
-  PyEventLoop::_locker->decCounter();
+  PyEventLoop::getLocker()->decCounter();
 
   PyObject *exception = future.getException();
   if (exception == NULL || PyErr_Occurred()) { // awaitable is cancelled, `futureObj.exception()` raises a CancelledError
@@ -127,7 +129,7 @@ JSObject *PromiseType::toJsPromise(JSContext *cx, PyObject *pyObject) {
   if (!loop.initialized()) return nullptr;
   PyEventLoop::Future future = loop.ensureFuture(pyObject);
 
-  PyEventLoop::_locker->incCounter();
+  PyEventLoop::getLocker()->incCounter();
 
   // Resolve or Reject the JS Promise once the python awaitable is done
   JS::PersistentRooted<JSObject *> *rootedPtr = new JS::PersistentRooted<JSObject *>(cx, promise); // `promise` is required to be rooted from here to the end of onDoneCallback
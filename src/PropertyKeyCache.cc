@@ -0,0 +1,90 @@
+/**
+ * @file PropertyKeyCache.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Cache of atomized JS property keys for Python str objects, used when enumerating proxied dicts and objects
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/PropertyKeyCache.hh"
+
+#include "include/PyBaseProxyHandler.hh"
+
+#include <jsapi.h>
+#include <js/GCVector.h>
+
+#include <Python.h>
+#include "include/pyshim.hh"
+
+bool PropertyKeyCache::strToId(JSContext *cx, PyObject *key, JS::MutableHandleId idp) {
+  Py_ssize_t length = PyUnicode_GET_LENGTH(key);
+  JSString *atom;
+  switch (PyUnicode_KIND(key)) {
+  case PyUnicode_1BYTE_KIND:
+    atom = JS_AtomizeStringN(cx, (const char *)PyUnicode_1BYTE_DATA(key), length); // Python's 1-byte kind is Latin-1, same as JS
+    break;
+  case PyUnicode_2BYTE_KIND:
+    atom = JS_AtomizeUCStringN(cx, (const char16_t *)PyUnicode_2BYTE_DATA(key), length);
+    break;
+  default: // UCS4 needs surrogate pairs, let the generic path do the conversion
+    return ::keyToId(key, idp);
+  }
+
+  if (!atom) {
+    return false;
+  }
+  JS::RootedString atomRooted(cx, atom);
+  return JS_StringToId(cx, atomRooted, idp);
+}
+
+bool PropertyKeyCache::keyToId(JSContext *cx, PyObject *key, JS::MutableHandleId idp) {
+  if (PyLong_Check(key)) {
+    return ::keyToId(key, idp);
+  }
+  if (!PyUnicode_Check(key)) {
+    return false;
+  }
+  if (!PyUnicode_CheckExact(key)) { // str subclasses may not hash like their contents, don't cache them
+    return strToId(cx, key, idp);
+  }
+  if (!current) {
+    current = new Entries(cx);
+    if (!current->ids.get().resize(CACHE_SIZE)) { // filled with JS::PropertyKey::Void()
+      delete current;
+      current = nullptr;
+      return strToId(cx, key, idp);
+    }
+  }
+
+  PyObject **keys = current->keys;
+  size_t slot = (size_t)PyObject_Hash(key) & (CACHE_SIZE - 1); // the hash of a str is computed once and stored on the object
+  if (keys[slot] == key) {
+    idp.set(current->ids.get()[slot]);
+    return true;
+  }
+
+  if (!strToId(cx, key, idp)) {
+    return false;
+  }
+
+  Py_INCREF(key);
+  Py_XDECREF(keys[slot]);
+  keys[slot] = key;
+  current->ids.get()[slot] = idp.get();
+  return true;
+}
+
+void PropertyKeyCache::clear() {
+  if (!current) {
+    return;
+  }
+  if (!Py_IsFinalizing()) {
+    for (PyObject *key: current->keys) {
+      Py_XDECREF(key);
+    }
+  }
+  delete current;
+  current = nullptr;
+}
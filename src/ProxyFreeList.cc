@@ -0,0 +1,46 @@
+/**
+ * @file ProxyFreeList.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Free lists of the Python proxies of JS objects, arrays, functions and strings
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/ProxyFreeList.hh"
+
+#include <Python.h>
+
+PyObject *ProxyFreeList::reuse(PyTypeObject *type) {
+  if (size == 0) {
+    return nullptr;
+  }
+  PyObject *self = items[--size];
+  PyObject_Init(self, type); // sets its reference count to 1, and takes a reference to its heap type again
+  if (PyType_IS_GC(type)) {
+    PyObject_GC_Track(self);
+  }
+  return self;
+}
+
+PyObject *ProxyFreeList::allocate(PyTypeObject *type) {
+  PyObject *self = reuse(type);
+  if (self) {
+    return self;
+  }
+  PyObject *args = PyTuple_New(0);
+  if (!args) {
+    return NULL;
+  }
+  self = type->tp_new(type, args, NULL); // initializes the part of the base type, as dict_new does
+  Py_DECREF(args);
+  return self;
+}
+
+void ProxyFreeList::clear() {
+  while (size > 0) {
+    PyObject *self = items[--size];
+    Py_TYPE(self)->tp_free(self);
+  }
+}
@@ -0,0 +1,285 @@
+/**
+ * @file ProxyRoots.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief The roots of the JS things held by the Python proxies JSObjectProxy, JSArrayProxy, JSFunctionProxy, JSMethodProxy and JSStringProxy
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/ProxyRoots.hh"
+
+#include "include/CycleCollector.hh"
+
+#include <jsapi.h>
+#include <js/GCAPI.h>
+#include <js/TracingAPI.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+static const size_t SLAB_BYTES = 16384; /**< slabs are aligned to their size, so that the slab of a slot is found from its address */
+static const size_t SLAB_HEADER_BYTES = 64;
+
+static std::mutex releasedMutex; /**< guards RootTable::released, and the slabs detached from a destroyed context */
+
+template <typename Root>
+struct alignas(SLAB_BYTES) RootSlab {
+  static const size_t CAPACITY = (SLAB_BYTES - SLAB_HEADER_BYTES) / sizeof(Root);
+
+  RootSlab(RootTable<Root> *table, size_t index) : owner(table), index(index) {}
+
+  static RootSlab *of(Root *root) {
+    return (RootSlab *)((uintptr_t)root & ~(uintptr_t)(SLAB_BYTES - 1));
+  }
+
+  std::atomic<RootTable<Root> *> owner; /**< nullptr once its context is destroyed, the slab being freed with its last root */
+  typename Root::ProxyRootSlot *freeList = nullptr;
+  RootSlab *nextAvailable = nullptr; /**< the list of slabs with free slots */
+  RootSlab *prevAvailable = nullptr;
+  uint32_t live = 0; /**< slots in use */
+  uint32_t index; /**< position in RootTable::slabs */
+  Root slots[CAPACITY];
+};
+
+template <typename Root>
+struct RootTable {
+  std::vector<RootSlab<Root> *> slabs;
+  RootSlab<Root> *available = nullptr;
+  size_t emptySlabs = 0; /**< one empty slab is kept, so that a root created and released at a slab boundary does not allocate a slab each time */
+  std::vector<Root *> released; /**< released by other threads, to be freed by the context's thread */
+  std::atomic<bool> hasReleased = false;
+
+  void makeAvailable(RootSlab<Root> *slab) {
+    slab->prevAvailable = nullptr;
+    slab->nextAvailable = available;
+    if (available) {
+      available->prevAvailable = slab;
+    }
+    available = slab;
+  }
+
+  void makeUnavailable(RootSlab<Root> *slab) {
+    if (slab->prevAvailable) {
+      slab->prevAvailable->nextAvailable = slab->nextAvailable;
+    } else {
+      available = slab->nextAvailable;
+    }
+    if (slab->nextAvailable) {
+      slab->nextAvailable->prevAvailable = slab->prevAvailable;
+    }
+    slab->nextAvailable = slab->prevAvailable = nullptr;
+  }
+};
+
+static_assert(sizeof(RootSlab<ProxyRoot>) == SLAB_BYTES && sizeof(RootSlab<ProxyStringRoot>) == SLAB_BYTES);
+
+struct ContextRoots {
+  std::tuple<RootTable<ProxyRoot>, RootTable<ProxyStringRoot>> tables;
+
+  template <typename Root>
+  RootTable<Root> *table() {
+    return &std::get<RootTable<Root>>(tables);
+  }
+};
+
+template <typename Root>
+Root *ProxyRoots::allocate(RootTable<Root> *table) {
+  if (table->hasReleased.load(std::memory_order_relaxed)) {
+    freeReleased(table);
+  }
+  RootSlab<Root> *slab = table->available;
+  if (!slab) {
+    slab = new RootSlab<Root>(table, table->slabs.size());
+    for (size_t i = RootSlab<Root>::CAPACITY; i > 0; i--) { // allocated in address order
+      slab->slots[i - 1].nextFree = slab->freeList;
+      slab->freeList = &slab->slots[i - 1];
+    }
+    table->slabs.push_back(slab);
+    table->makeAvailable(slab);
+    table->emptySlabs++;
+  }
+  Root *root = static_cast<Root *>(slab->freeList);
+  slab->freeList = root->nextFree;
+  root->nextFree = nullptr;
+  if (slab->live++ == 0) {
+    table->emptySlabs--;
+  }
+  if (slab->live == RootSlab<Root>::CAPACITY) {
+    table->makeUnavailable(slab);
+  }
+  return root;
+}
+
+template <typename Root>
+void ProxyRoots::freeSlot(RootTable<Root> *table, Root *root) {
+  RootSlab<Root> *slab = RootSlab<Root>::of(root);
+  root->value = nullptr; // the barriers of JS::Heap run on the context's own thread
+  root->nextFree = slab->freeList;
+  slab->freeList = root;
+  if (slab->live-- == RootSlab<Root>::CAPACITY) {
+    table->makeAvailable(slab);
+  }
+  if (slab->live == 0 && table->emptySlabs++ > 0) {
+    table->emptySlabs--;
+    table->makeUnavailable(slab);
+    RootSlab<Root> *last = table->slabs.back();
+    table->slabs[slab->index] = last;
+    last->index = slab->index;
+    table->slabs.pop_back();
+    delete slab;
+  }
+}
+
+template <typename Root>
+void ProxyRoots::releaseSlot(Root *root) {
+  if (!root) {
+    return;
+  }
+  RootSlab<Root> *slab = RootSlab<Root>::of(root);
+  RootTable<Root> *table = current ? current->table<Root>() : nullptr;
+  if (table && slab->owner.load(std::memory_order_relaxed) == table) {
+    freeSlot(table, root);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(releasedMutex);
+  RootTable<Root> *owner = slab->owner.load(std::memory_order_relaxed);
+  if (owner) {
+    owner->released.push_back(root);
+    owner->hasReleased.store(true, std::memory_order_relaxed);
+  } else if (--slab->live == 0) { // its context is destroyed, its slots were cleared then
+    delete slab;
+  }
+}
+
+template <typename Root>
+void ProxyRoots::freeReleased(RootTable<Root> *table) {
+  std::vector<Root *> released;
+  {
+    std::lock_guard<std::mutex> lock(releasedMutex);
+    released.swap(table->released);
+    table->hasReleased.store(false, std::memory_order_relaxed);
+  }
+  for (Root *root: released) {
+    freeSlot(table, root);
+  }
+}
+
+template <typename Root>
+void ProxyRoots::detach(RootTable<Root> *table) {
+  freeReleased(table);
+  std::lock_guard<std::mutex> lock(releasedMutex);
+  for (Root *root: table->released) { // released since freeReleased
+    RootSlab<Root>::of(root)->live--;
+  }
+  for (RootSlab<Root> *slab: table->slabs) {
+    if (slab->live == 0) {
+      delete slab;
+      continue;
+    }
+    for (Root &root: slab->slots) {
+      root.value = nullptr;
+    }
+    slab->owner.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+template <typename Root>
+void ProxyRoots::trace(JSTracer *trc, RootTable<Root> *table, const char *name) {
+  for (RootSlab<Root> *slab: table->slabs) {
+    if (slab->live == 0) {
+      continue;
+    }
+    for (Root &root: slab->slots) {
+      if (root.value.unbarrieredGet()) {
+        JS::TraceEdge(trc, &root.value, name);
+      }
+    }
+  }
+}
+
+ProxyRoot *ProxyRoots::create(JSObject *obj) {
+  ProxyRoot *root = allocate(current->table<ProxyRoot>());
+  root->set(obj);
+  return root;
+}
+
+ProxyStringRoot *ProxyRoots::create(JSString *str) {
+  ProxyStringRoot *root = allocate(current->table<ProxyStringRoot>());
+  root->set(str);
+  return root;
+}
+
+void ProxyRoots::release(ProxyRoot *root) {
+  CycleCollector::forget(root);
+  releaseSlot(root);
+}
+
+void ProxyRoots::release(ProxyStringRoot *root) {
+  releaseSlot(root);
+}
+
+void ProxyRoots::initContext(JSContext *cx) {
+  current = new ContextRoots();
+  JS_SetGrayGCRootsTracer(cx, traceGray, current);
+}
+
+void ProxyRoots::destroyContext(JSContext *cx) {
+  if (!current) {
+    return;
+  }
+  JS_SetGrayGCRootsTracer(cx, nullptr, nullptr);
+  detach(current->table<ProxyRoot>());
+  detach(current->table<ProxyStringRoot>());
+  delete current;
+  current = nullptr;
+}
+
+void ProxyRoots::forEach(void (*callback)(ProxyRoot *root, void *data), void *data) {
+  if (!current) {
+    return;
+  }
+  for (RootSlab<ProxyRoot> *slab: current->table<ProxyRoot>()->slabs) {
+    if (slab->live == 0) {
+      continue;
+    }
+    for (ProxyRoot &root: slab->slots) {
+      if (root.unbarrieredGet()) {
+        callback(&root, data);
+      }
+    }
+  }
+}
+
+size_t ProxyRoots::rootCount() {
+  size_t count = 0;
+  if (current) {
+    for (RootSlab<ProxyRoot> *slab: current->table<ProxyRoot>()->slabs) {
+      count += slab->live;
+    }
+    for (RootSlab<ProxyStringRoot> *slab: current->table<ProxyStringRoot>()->slabs) {
+      count += slab->live;
+    }
+  }
+  return count;
+}
+
+size_t ProxyRoots::slotCount() {
+  if (!current) {
+    return 0;
+  }
+  return current->table<ProxyRoot>()->slabs.size() * RootSlab<ProxyRoot>::CAPACITY +
+         current->table<ProxyStringRoot>()->slabs.size() * RootSlab<ProxyStringRoot>::CAPACITY;
+}
+
+bool ProxyRoots::traceGray(JSTracer *trc, JS::SliceBudget &budget [[maybe_unused]], void *data) {
+  ContextRoots *roots = (ContextRoots *)data;
+  trace(trc, roots->table<ProxyRoot>(), "Python proxy");
+  trace(trc, roots->table<ProxyStringRoot>(), "Python string proxy");
+  return true;
+}
@@ -12,11 +12,29 @@
 #include "include/PyBaseProxyHandler.hh"
 
 #include <jsapi.h>
+#include <js/String.h>
+#include <mozilla/EndianUtils.h>
 
 #include <Python.h>
 
 
 PyObject *idToKey(JSContext *cx, JS::HandleId id) {
+  if (id.isString()) { // string ids are atoms, which are always linear, so build the Python str straight from their chars
+    JSLinearString *str = id.toLinearString();
+    size_t length = JS::GetLinearStringLength(str);
+    JS::AutoCheckCannotGC nogc;
+    if (JS::LinearStringHasLatin1Chars(str)) {
+      return PyUnicode_FromKindAndData(PyUnicode_1BYTE_KIND, JS::GetLatin1LinearStringChars(nogc, str), length);
+    }
+    // UTF-16 decoding joins surrogate pairs, and replaces lone surrogates like `JS_EncodeStringToUTF8` does
+  #if MOZ_LITTLE_ENDIAN()
+    int byteOrder = -1;
+  #else
+    int byteOrder = 1;
+  #endif
+    return PyUnicode_DecodeUTF16((const char *)JS::GetTwoByteLinearStringChars(nogc, str), length * sizeof(char16_t), "replace", &byteOrder);
+  }
+
   JS::RootedValue idv(cx, js::IdToValue(id));
   JS::RootedString idStr(cx);
   if (!id.isSymbol()) { // `JS::ToString` returns `nullptr` for JS symbols
@@ -26,9 +44,15 @@ PyObject *idToKey(JSContext *cx, JS::HandleId id) {
     // FIXME (Tom Tang): key collision for symbols without a description string, or pure strings look like "Symbol(xxx)"
     idStr = JS_ValueToSource(cx, idv);
   }
+  if (!idStr) {
+    return NULL; // JS exception pending
+  }
 
   // We convert all types of property keys to string
   auto chars = JS_EncodeStringToUTF8(cx, idStr);
+  if (!chars) {
+    return NULL;
+  }
   return PyUnicode_FromString(chars.get());
 }
 
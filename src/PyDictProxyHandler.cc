@@ -10,8 +10,10 @@
 
 #include "include/PyDictProxyHandler.hh"
 
+#include "include/PropertyKeyCache.hh"
 #include "include/jsTypeFactory.hh"
 #include "include/pyTypeFactory.hh"
+#include "include/AutoGIL.hh"
 
 #include <jsapi.h>
 #include <jsfriendapi.h>
@@ -27,19 +29,46 @@
 const char PyDictProxyHandler::family = 0;
 
 bool PyDictProxyHandler::ownPropertyKeys(JSContext *cx, JS::HandleObject proxy, JS::MutableHandleIdVector props) const {
+  AutoAcquireGIL acquireGIL;
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
-  PyObject *keys = PyDict_Keys(self);
 
-  size_t length = PyList_Size(keys);
+  if (!props.reserve(PyDict_Size(self))) {
+    return false; // out of memory
+  }
 
-  return handleOwnPropertyKeys(cx, keys, length, props);
+  // Walk the dict in place rather than materializing a list of its keys first
+  Py_ssize_t pos = 0;
+  PyObject *key;
+  PyObject *value;
+  JS::RootedId jsId(cx);
+  while (PyDict_Next(self, &pos, &key, &value)) {
+    Py_INCREF(key); // borrowed reference, keep it alive in case a GC callback runs Python code that mutates the dict
+    bool converted = PropertyKeyCache::keyToId(cx, key, &jsId);
+    Py_DECREF(key);
+    if (!converted) {
+      if (JS_IsExceptionPending(cx)) {
+        return false;
+      }
+      continue; // skip over keys that are not str or int
+    }
+    if (!props.append(jsId)) { // the dict may have grown since we reserved
+      return false; // out of memory
+    }
+  }
+  return true;
 }
 
 bool PyDictProxyHandler::delete_(JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   JS::ObjectOpResult &result) const {
+  AutoAcquireGIL acquireGIL;
   PyObject *attrName = idToKey(cx, id);
+  if (!attrName) {
+    return false;
+  }
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
-  if (PyDict_DelItem(self, attrName) < 0) {
+  int deleted = PyDict_DelItem(self, attrName);
+  Py_DECREF(attrName);
+  if (deleted < 0) {
     return result.failCantDelete(); // raises JS exception
   }
   return result.succeed();
@@ -54,9 +83,14 @@ bool PyDictProxyHandler::getOwnPropertyDescriptor(
   JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   JS::MutableHandle<mozilla::Maybe<JS::PropertyDescriptor>> desc
 ) const {
+  AutoAcquireGIL acquireGIL;
   PyObject *attrName = idToKey(cx, id);
+  if (!attrName) {
+    return false;
+  }
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
   PyObject *item = PyDict_GetItemWithError(self, attrName); // returns NULL without an exception set if the key wasn’t present.
+  Py_DECREF(attrName);
 
   return handleGetOwnPropertyDescriptor(cx, id, desc, item);
 }
@@ -64,16 +98,21 @@ bool PyDictProxyHandler::getOwnPropertyDescriptor(
 bool PyDictProxyHandler::set(JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   JS::HandleValue v, JS::HandleValue receiver,
   JS::ObjectOpResult &result) const {
+  AutoAcquireGIL acquireGIL;
   JS::RootedValue rootedV(cx, v);
   PyObject *attrName = idToKey(cx, id);
+  if (!attrName) {
+    return false;
+  }
 
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
   PyObject *value = pyTypeFactory(cx, rootedV);
-  if (PyDict_SetItem(self, attrName, value)) {
-    Py_DECREF(value);
+  int failed = PyDict_SetItem(self, attrName, value);
+  Py_DECREF(attrName);
+  Py_DECREF(value);
+  if (failed) {
     return result.failCantSetInterposed(); // raises JS exception
   }
-  Py_DECREF(value);
   return result.succeed();
 }
 
@@ -84,9 +123,14 @@ bool PyDictProxyHandler::enumerate(JSContext *cx, JS::HandleObject proxy,
 
 bool PyDictProxyHandler::hasOwn(JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   bool *bp) const {
+  AutoAcquireGIL acquireGIL;
   PyObject *attrName = idToKey(cx, id);
+  if (!attrName) {
+    return false;
+  }
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
   *bp = PyDict_Contains(self, attrName) == 1;
+  Py_DECREF(attrName);
   return true;
 }
 
@@ -11,6 +11,9 @@
 
 #include "include/PyEventLoop.hh"
 
+#include "include/GCScheduler.hh"
+#include "include/ModuleState.hh"
+
 #include <Python.h>
 
 /**
@@ -22,7 +25,8 @@ static PyObject *eventLoopJobWrapper(PyObject *jobFn, PyObject *Py_UNUSED(_)) {
 
   PyObject *type, *value, *traceback;
   PyErr_Fetch(&type, &value, &traceback); // Protects `decCounter()`. If the error indicator is set, Python cannot make further function calls.
-  PyEventLoop::_locker->decCounter();
+  GCScheduler::schedule(); // the job may have left garbage to collect once the event-loop is idle
+  PyEventLoop::getLocker()->decCounter();
   PyErr_Restore(type, value, traceback);
 
   if (PyErr_Occurred()) {
@@ -49,9 +53,10 @@ static PyObject *timerJobWrapper(PyObject *jobFn, PyObject *args) {
 
   PyObject *errType, *errValue, *traceback; // we can't call any Python code unless the error indicator is clear
   PyErr_Fetch(&errType, &errValue, &traceback);
+  GCScheduler::schedule();
   // Making sure a `AsyncHandle::fromId` call is close to its `handle`'s use.
   // We need to ensure the memory block doesn't move for reallocation before we can use the pointer,
-  // as we could have multiple new `setTimeout` calls to expand the `_timeoutIdMap` vector while running the job function in parallel.
+  // as we could have multiple new `setTimeout` calls to expand the timers vector while running the job function in parallel.
   auto handle = PyEventLoop::AsyncHandle::fromId(handleId);
   if (repeat && !handle->cancelled()) {
     _enqueueWithDelay(_loop, handleId, jobFn, delaySeconds, repeat);
@@ -69,7 +74,7 @@ static PyObject *timerJobWrapper(PyObject *jobFn, PyObject *args) {
 static PyMethodDef timerJobWrapperDef = {"timerJobWrapper", timerJobWrapper, METH_VARARGS, NULL};
 
 PyEventLoop::AsyncHandle PyEventLoop::enqueue(PyObject *jobFn) {
-  PyEventLoop::_locker->incCounter();
+  PyEventLoop::getLocker()->incCounter();
   PyObject *wrapper = PyCFunction_New(&loopJobWrapperDef, jobFn);
   // Enqueue job to the Python event-loop
   //    https://docs.python.org/3/library/asyncio-eventloop.html#asyncio.loop.call_soon
@@ -212,9 +217,9 @@ PyEventLoop PyEventLoop::_getLoopOnThread(PyThreadState *tstate) {
 
 /* static */
 PyThreadState *PyEventLoop::_getMainThread() {
-  // The last element in the linked-list of threads associated with the main interpreter should be the main thread
+  // The last element in the linked-list of threads associated with the current interpreter should be its main thread
   // (The first element is the current thread, see https://github.com/python/cpython/blob/7cb3a44/Python/pystate.c#L291-L293)
-  PyInterpreterState *interp = PyInterpreterState_Main();
+  PyInterpreterState *interp = PyThreadState_GetInterpreter(PyThreadState_Get());
   PyThreadState *tstate = PyInterpreterState_ThreadHead(interp);
   while (PyThreadState_Next(tstate) != nullptr) {
     tstate = PyThreadState_Next(tstate);
@@ -234,6 +239,11 @@ PyEventLoop PyEventLoop::getMainLoop() {
   return _getLoopOnThread(_getMainThread());
 }
 
+/* static */
+PyEventLoop PyEventLoop::getLoopOnThread(PyThreadState *tstate) {
+  return _getLoopOnThread(tstate);
+}
+
 /* static */
 PyEventLoop PyEventLoop::getRunningLoop() {
   return _getLoopOnThread(_getCurrentThread());
@@ -249,9 +259,19 @@ void PyEventLoop::AsyncHandle::cancel() {
   Py_XDECREF(ret);
 }
 
+/* static */
+std::vector<PyEventLoop::AsyncHandle> &PyEventLoop::AsyncHandle::getAllTimers() {
+  return ModuleState::current()->timers;
+}
+
+/* static */
+PyEventLoop::Lock *PyEventLoop::getLocker() {
+  return ModuleState::current()->locker;
+}
+
 /* static */
 bool PyEventLoop::AsyncHandle::cancelAll() {
-  for (AsyncHandle &handle: _timeoutIdMap) {
+  for (AsyncHandle &handle: getAllTimers()) {
     handle.cancel();
   }
   return true;
@@ -12,6 +12,7 @@
 #include "include/PyIterableProxyHandler.hh"
 
 #include "include/jsTypeFactory.hh"
+#include "include/AutoGIL.hh"
 
 #include <jsapi.h>
 
@@ -57,6 +58,7 @@ static bool iter_next(JSContext *cx, JS::CallArgs args, PyObject *it) {
 }
 
 static bool iterable_next(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject thisObj(cx);
   if (!args.computeThis(cx, &thisObj)) return false;
@@ -67,6 +69,7 @@ static bool iterable_next(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool toPrimitive(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -122,6 +125,7 @@ enum {
 static JSClass iterableIteratorClass = {"IterableIterator", JSCLASS_HAS_RESERVED_SLOTS(IterableIteratorSlotCount)};
 
 static bool iterator_next(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject thisObj(cx);
   if (!args.computeThis(cx, &thisObj)) return false;
@@ -172,6 +176,7 @@ static bool DefineIterableIterator(JSContext *cx, JS::HandleObject global) {
 }
 
 static bool iterable_values(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -212,6 +217,7 @@ bool PyIterableProxyHandler::getOwnPropertyDescriptor(
   JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   JS::MutableHandle<mozilla::Maybe<JS::PropertyDescriptor>> desc
 ) const {
+  AutoAcquireGIL acquireGIL;
   // see if we're calling a function
   if (id.isString()) {
     for (size_t index = 0;; index++) {
@@ -291,11 +297,17 @@ bool PyIterableProxyHandler::getOwnPropertyDescriptor(
   }
 
   PyObject *attrName = idToKey(cx, id);
+  if (!attrName) {
+    return false;
+  }
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
   PyObject *item = PyObject_GetAttr(self, attrName);
+  Py_DECREF(attrName);
   if (!item && PyErr_ExceptionMatches(PyExc_AttributeError)) {
     PyErr_Clear(); // clear error, we will be returning undefined in this case
   }
 
-  return handleGetOwnPropertyDescriptor(cx, id, desc, item);
+  bool success = handleGetOwnPropertyDescriptor(cx, id, desc, item);
+  Py_XDECREF(item); // the JS value holds its own reference where it needs one
+  return success;
 }
\ No newline at end of file
@@ -15,6 +15,7 @@
 #include "include/JSArrayProxy.hh"
 #include "include/JSFunctionProxy.hh"
 #include "include/pyTypeFactory.hh"
+#include "include/AutoGIL.hh"
 
 #include <jsapi.h>
 #include <jsfriendapi.h>
@@ -53,6 +54,7 @@ static bool makeNewPyMethod(JSContext *cx, JS::MutableHandleValue function, JS::
 }
 
 static bool array_reverse(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -73,6 +75,7 @@ static bool array_reverse(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_pop(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -100,6 +103,7 @@ static bool array_pop(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_push(JSContext *cx, unsigned argc, JS::Value *vp) { // surely the function name is in there...review JSAPI examples
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -125,6 +129,7 @@ static bool array_push(JSContext *cx, unsigned argc, JS::Value *vp) { // surely
 }
 
 static bool array_shift(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -153,6 +158,7 @@ static bool array_shift(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_unshift(JSContext *cx, unsigned argc, JS::Value *vp) { // surely the function name is in there...review JSAPI examples
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -191,6 +197,7 @@ static inline uint64_t normalizeSliceTerm(int64_t value, uint64_t length) {
 }
 
 static bool array_slice(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "slice", 1)) {
@@ -236,6 +243,7 @@ static bool array_slice(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_indexOf(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "indexOf", 1)) {
@@ -295,6 +303,7 @@ static bool array_indexOf(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_splice(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -378,6 +387,7 @@ static bool array_splice(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_fill(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "fill", 1)) {
@@ -445,6 +455,7 @@ static bool array_fill(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_copyWithin(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -540,6 +551,7 @@ static bool array_copyWithin(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_concat(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -557,7 +569,7 @@ static bool array_concat(JSContext *cx, unsigned argc, JS::Value *vp) {
     elementVal.set(args[index].get());
 
     PyObject *item = pyTypeFactory(cx, elementVal);
-    if (PyObject_TypeCheck(item, &JSArrayProxyType)) {
+    if (PyObject_TypeCheck(item, JSArrayProxyType())) {
       // flatten the array only a depth 1
       Py_ssize_t itemLength = JSArrayProxyMethodDefinitions::JSArrayProxy_length((JSArrayProxy *)item);
       for (Py_ssize_t flatIndex = 0; flatIndex < itemLength; flatIndex++) {
@@ -603,6 +615,7 @@ static bool array_concat(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_lastIndexOf(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "lastIndexOf", 1)) {
@@ -680,6 +693,7 @@ static bool array_includes(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_forEach(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "forEach", 1)) {
@@ -741,6 +755,7 @@ static bool array_forEach(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_map(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "map", 1)) {
@@ -808,6 +823,7 @@ static bool array_map(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_filter(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "filter", 1)) {
@@ -880,6 +896,7 @@ static bool array_filter(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_reduce(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "reduce", 1)) {
@@ -936,6 +953,7 @@ static bool array_reduce(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_reduceRight(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "reduceRight", 1)) {
@@ -990,6 +1008,7 @@ static bool array_reduceRight(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_some(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "some", 1)) {
@@ -1055,6 +1074,7 @@ static bool array_some(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_every(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "every", 1)) {
@@ -1120,6 +1140,7 @@ static bool array_every(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_find(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "find", 1)) {
@@ -1186,6 +1207,7 @@ static bool array_find(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_findIndex(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "findIndex", 1)) {
@@ -1260,7 +1282,7 @@ static uint32_t FlattenIntoArray(JSContext *cx,
   JS::RootedValue elementVal(cx);
 
   for (uint32_t sourceIndex = 0; sourceIndex < sourceLen; sourceIndex++) {
-    if (PyObject_TypeCheck(source, &JSArrayProxyType)) {
+    if (PyObject_TypeCheck(source, JSArrayProxyType())) {
       JS_GetElement(cx, *(((JSArrayProxy *)source)->jsArray), sourceIndex, &elementVal);
     }
     else if (PyObject_TypeCheck(source, &PyList_Type)) {
@@ -1271,14 +1293,14 @@ static uint32_t FlattenIntoArray(JSContext *cx,
 
     bool shouldFlatten;
     if (depth > 0) {
-      shouldFlatten = PyObject_TypeCheck(element, &JSArrayProxyType) || PyObject_TypeCheck(element, &PyList_Type);
+      shouldFlatten = PyObject_TypeCheck(element, JSArrayProxyType()) || PyObject_TypeCheck(element, &PyList_Type);
     } else {
       shouldFlatten = false;
     }
 
     if (shouldFlatten) {
       Py_ssize_t elementLen;
-      if (PyObject_TypeCheck(element, &JSArrayProxyType)) {
+      if (PyObject_TypeCheck(element, JSArrayProxyType())) {
         elementLen = JSArrayProxyMethodDefinitions::JSArrayProxy_length((JSArrayProxy *)element);
       }
       else if (PyObject_TypeCheck(element, &PyList_Type)) {
@@ -1327,7 +1349,7 @@ static uint32_t FlattenIntoArrayWithCallBack(JSContext *cx,
   JS::RootedValue retVal(cx);
 
   for (uint32_t sourceIndex = 0; sourceIndex < sourceLen; sourceIndex++) {
-    if (PyObject_TypeCheck(source, &JSArrayProxyType)) {
+    if (PyObject_TypeCheck(source, JSArrayProxyType())) {
       JS_GetElement(cx, *(((JSArrayProxy *)source)->jsArray), sourceIndex, &elementVal);
     }
     else if (PyObject_TypeCheck(source, &PyList_Type)) {
@@ -1345,13 +1367,13 @@ static uint32_t FlattenIntoArrayWithCallBack(JSContext *cx,
 
     bool shouldFlatten;
     if (depth > 0) {
-      shouldFlatten = PyObject_TypeCheck(element, &JSArrayProxyType) || PyObject_TypeCheck(element, &PyList_Type);
+      shouldFlatten = PyObject_TypeCheck(element, JSArrayProxyType()) || PyObject_TypeCheck(element, &PyList_Type);
     } else {
       shouldFlatten = false;
     }
 
     Py_ssize_t elementLen;
-    if (PyObject_TypeCheck(element, &JSArrayProxyType)) {
+    if (PyObject_TypeCheck(element, JSArrayProxyType())) {
       elementLen = JSArrayProxyMethodDefinitions::JSArrayProxy_length((JSArrayProxy *)element);
     }
     else if (PyObject_TypeCheck(element, &PyList_Type)) {
@@ -1375,11 +1397,11 @@ static uint32_t FlattenIntoArrayWithCallBack(JSContext *cx,
       uint32_t length;
       JS::GetArrayLength(cx, rootedRetArray, &length);
 
-      if (PyObject_TypeCheck(element, &JSArrayProxyType) || PyObject_TypeCheck(element, &PyList_Type)) {
+      if (PyObject_TypeCheck(element, JSArrayProxyType()) || PyObject_TypeCheck(element, &PyList_Type)) {
         // flatten array callBack result to depth 1
         JS::RootedValue elementIndexVal(cx);
         for (uint32_t elementIndex = 0; elementIndex < elementLen; elementIndex++, targetIndex++) {
-          if (PyObject_TypeCheck(element, &JSArrayProxyType)) {
+          if (PyObject_TypeCheck(element, JSArrayProxyType())) {
             JS_GetElement(cx, *(((JSArrayProxy *)element)->jsArray), elementIndex, &elementIndexVal);
           }
           else {
@@ -1413,6 +1435,7 @@ static uint32_t FlattenIntoArrayWithCallBack(JSContext *cx,
 }
 
 static bool array_flat(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -1440,6 +1463,7 @@ static bool array_flat(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_flatMap(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   if (!args.requireAtLeast(cx, "flatMap", 1)) {
@@ -1491,6 +1515,7 @@ static bool array_flatMap(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_join(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -1552,6 +1577,7 @@ static bool array_toString(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_toLocaleString(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -1605,6 +1631,7 @@ static bool array_toLocaleString(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool array_valueOf(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -1732,6 +1759,7 @@ static bool js_sort_compare_default(JSContext *cx, unsigned argc, JS::Value *vp)
 }
 
 static bool array_sort(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -1798,6 +1826,7 @@ enum {
 static JSClass listIteratorClass = {"ListIterator", JSCLASS_HAS_RESERVED_SLOTS(ListIteratorSlotCount)};
 
 static bool iterator_next(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   JS::RootedObject thisObj(cx);
   if (!args.computeThis(cx, &thisObj)) return false;
@@ -1905,6 +1934,7 @@ static bool DefineListIterator(JSContext *cx, JS::HandleObject global) {
 
 // private util
 static bool array_iterator_func(JSContext *cx, unsigned argc, JS::Value *vp, int itemKind) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedObject proxy(cx, JS::ToObject(cx, args.thisv()));
@@ -1996,6 +2026,7 @@ bool PyListProxyHandler::getOwnPropertyDescriptor(
   JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   JS::MutableHandle<mozilla::Maybe<JS::PropertyDescriptor>> desc
 ) const {
+  AutoAcquireGIL acquireGIL;
   // see if we're calling a function
   if (id.isString()) {
     for (size_t index = 0;; index++) {
@@ -2090,6 +2121,7 @@ bool PyListProxyHandler::getOwnPropertyDescriptor(
 }
 
 void PyListProxyHandler::finalize(JS::GCContext *gcx, JSObject *proxy) const {
+  AutoAcquireGIL acquireGIL;
   // We cannot call Py_DECREF here when shutting down as the thread state is gone.
   // Then, when shutting down, there is only on reference left, and we don't need
   // to free the object since the entire process memory is being released.
@@ -2103,6 +2135,7 @@ bool PyListProxyHandler::defineProperty(
   JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   JS::Handle<JS::PropertyDescriptor> desc, JS::ObjectOpResult &result
 ) const {
+  AutoAcquireGIL acquireGIL;
   Py_ssize_t index;
   if (!idToIndex(cx, id, &index)) { // not an int-like property key
     return result.failBadIndex();
@@ -2136,6 +2169,7 @@ bool PyListProxyHandler::defineProperty(
 }
 
 bool PyListProxyHandler::ownPropertyKeys(JSContext *cx, JS::HandleObject proxy, JS::MutableHandleIdVector props) const {
+  AutoAcquireGIL acquireGIL;
   // Modified from https://hg.mozilla.org/releases/mozilla-esr102/file/3b574e1/dom/base/RemoteOuterWindowProxy.cpp#l137
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
   int32_t length = PyList_Size(self);
@@ -2152,6 +2186,7 @@ bool PyListProxyHandler::ownPropertyKeys(JSContext *cx, JS::HandleObject proxy,
 }
 
 bool PyListProxyHandler::delete_(JSContext *cx, JS::HandleObject proxy, JS::HandleId id, JS::ObjectOpResult &result) const {
+  AutoAcquireGIL acquireGIL;
   Py_ssize_t index;
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
   if (!idToIndex(cx, id, &index)) {
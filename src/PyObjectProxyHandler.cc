@@ -10,8 +10,11 @@
 
 #include "include/PyObjectProxyHandler.hh"
 
+#include "include/ModuleState.hh"
+#include "include/PropertyKeyCache.hh"
 #include "include/jsTypeFactory.hh"
 #include "include/pyTypeFactory.hh"
+#include "include/AutoGIL.hh"
 
 #include <jsapi.h>
 #include <jsfriendapi.h>
@@ -33,7 +36,10 @@ bool PyObjectProxyHandler::handleOwnPropertyKeys(JSContext *cx, PyObject *keys,
   for (size_t i = 0; i < length; i++) {
     PyObject *key = PyList_GetItem(keys, i);
     JS::RootedId jsId(cx);
-    if (!keyToId(key, &jsId)) {
+    if (!PropertyKeyCache::keyToId(cx, key, &jsId)) {
+      if (JS_IsExceptionPending(cx)) {
+        return false;
+      }
       continue; // skip over keys that are not str or int
     }
     props.infallibleAppend(jsId);
@@ -41,21 +47,48 @@ bool PyObjectProxyHandler::handleOwnPropertyKeys(JSContext *cx, PyObject *keys,
   return true;
 }
 
+/**
+ * @brief Pinned atoms for the Object.prototype methods that proxied dicts and objects forward to. Pinned atoms are never
+ * collected, so ids can be compared against them by identity instead of encoding every property name and string comparing it.
+ * Atoms belong to the runtime of a context, so each thread's context pins its own.
+ */
+static thread_local JS::PropertyKey toStringId;
+static thread_local JS::PropertyKey toLocaleStringId;
+static thread_local JS::PropertyKey valueOfId;
+
+static bool isObjectPrototypeMethodId(JSContext *cx, JS::HandleId id, bool *isMethod) {
+  if (toStringId.isVoid()) {
+    JSString *toStringAtom = JS_AtomizeAndPinString(cx, "toString");
+    JSString *toLocaleStringAtom = JS_AtomizeAndPinString(cx, "toLocaleString");
+    JSString *valueOfAtom = JS_AtomizeAndPinString(cx, "valueOf");
+    if (!toStringAtom || !toLocaleStringAtom || !valueOfAtom) {
+      return false;
+    }
+    toStringId = JS::PropertyKey::fromPinnedString(toStringAtom);
+    toLocaleStringId = JS::PropertyKey::fromPinnedString(toLocaleStringAtom);
+    valueOfId = JS::PropertyKey::fromPinnedString(valueOfAtom);
+  }
+  *isMethod = id == toStringId || id == toLocaleStringId || id == valueOfId;
+  return true;
+}
+
 bool PyObjectProxyHandler::handleGetOwnPropertyDescriptor(JSContext *cx, JS::HandleId id,
   JS::MutableHandle<mozilla::Maybe<JS::PropertyDescriptor>> desc, PyObject *item) {
   // see if we're calling a function
   if (id.isString()) {
-    JS::UniqueChars idString = JS_EncodeStringToUTF8(cx, JS::RootedString(cx, id.toString()));
-    const char *methodName = idString.get();
+    bool isMethod;
+    if (!isObjectPrototypeMethodId(cx, id, &isMethod)) {
+      return false;
+    }
 
-    if (!strcmp(methodName, "toString") || !strcmp(methodName, "toLocaleString") || !strcmp(methodName, "valueOf")) {
+    if (isMethod) {
       JS::RootedObject objectPrototype(cx);
       if (!JS_GetClassPrototype(cx, JSProto_Object, &objectPrototype)) {
         return false;
       }
 
       JS::RootedValue Object_Prototype_Method(cx);
-      if (!JS_GetProperty(cx, objectPrototype, methodName, &Object_Prototype_Method)) {
+      if (!JS_GetPropertyById(cx, objectPrototype, id, &Object_Prototype_Method)) {
         return false;
       }
 
@@ -86,6 +119,7 @@ bool PyObjectProxyHandler::handleGetOwnPropertyDescriptor(JSContext *cx, JS::Han
 }
 
 void PyObjectProxyHandler::finalize(JS::GCContext *gcx, JSObject *proxy) const {
+  AutoAcquireGIL acquireGIL;
   // We cannot call Py_DECREF here when shutting down as the thread state is gone.
   // Then, when shutting down, there is only on reference left, and we don't need
   // to free the object since the entire process memory is being released.
@@ -95,37 +129,302 @@ void PyObjectProxyHandler::finalize(JS::GCContext *gcx, JSObject *proxy) const {
   }
 }
 
-bool PyObjectProxyHandler::ownPropertyKeys(JSContext *cx, JS::HandleObject proxy, JS::MutableHandleIdVector props) const {
-  PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
-  PyObject *keys = PyObject_Dir(self);
+/**
+ * @return true if `key` is a str starting with "__", which we don't expose to JS
+ */
+static bool isDunder(PyObject *key) {
+  return PyUnicode_Check(key) &&
+         PyUnicode_GET_LENGTH(key) >= 2 &&
+         PyUnicode_READ_CHAR(key, 0) == '_' &&
+         PyUnicode_READ_CHAR(key, 1) == '_';
+}
 
-  if (keys != nullptr) {
-    size_t keysLength = PyList_Size(keys);
+/**
+ * @brief Filter out the dunder names of a `dir()` result
+ *
+ * @return PyObject* - new reference to a list, or NULL with an exception set
+ */
+static PyObject *nonDunderNames(PyObject *names) {
+  Py_ssize_t length = PyList_GET_SIZE(names);
+  PyObject *filtered = PyList_New(0);
+  if (!filtered) {
+    return NULL;
+  }
+  for (Py_ssize_t i = 0; i < length; i++) {
+    PyObject *name = PyList_GET_ITEM(names, i);
+    if (!isDunder(name) && PyList_Append(filtered, name) < 0) {
+      Py_DECREF(filtered);
+      return NULL;
+    }
+  }
+  return filtered;
+}
+
+static const size_t MAX_CACHED_TYPES = 256; /**< past this many types, the least recently used one is dropped from the cache */
+
+#if PY_VERSION_HEX >= 0x030c0000
+/**
+ * @brief The type watcher of the cache, called by CPython when a watched type or one of its bases is modified.
+ * The type may be in the middle of being modified, so its entry is only marked, and computed again on next use.
+ */
+static int onTypeModified(PyTypeObject *type) {
+  ModuleState *state = ModuleState::current();
+  if (state) {
+    auto entry = state->typeAttributeNames.find(type);
+    if (entry != state->typeAttributeNames.end()) {
+      entry->second.modified = true;
+    }
+  }
+  return 0;
+}
+#endif
+
+/**
+ * @brief The callback of the weak references the cache holds to heap types, dropping the entry of a type being freed
+ */
+static PyObject *onCachedTypeFreed(PyObject *self [[maybe_unused]], PyObject *typeRef) {
+  ModuleState *state = ModuleState::current();
+  if (state) {
+    for (const auto &[type, names]: state->typeAttributeNames) {
+      if (names.typeRef == typeRef) {
+        state->evictTypeAttributeNames(type);
+        break;
+      }
+    }
+  }
+  Py_RETURN_NONE;
+}
+
+static PyMethodDef onCachedTypeFreedDef = {"pythonmonkeyCachedTypeFreed", onCachedTypeFreed, METH_O, NULL};
+
+/**
+ * @brief Get the cached non-dunder attribute names of `type`, computing them if needed.
+ * The cache of each interpreter is in its ModuleState. It holds heap types weakly, and drops the least recently used type
+ * once it holds MAX_CACHED_TYPES. Python 3.12 and later tell it of the changes to its types through a type watcher. Before,
+ * an entry is valid while the type keeps the version tag it had, which CPython invalidates along with its method cache
+ * whenever the type or one of its bases changes. Python 3.8 to 3.10 reuse version tags once all 2^32 of them have been
+ * handed out, so an entry could then outlive a change to its type, if the type happened to be given the same tag again.
+ *
+ * @return const TypeAttributeNames* - the cache entry, or nullptr if the type's names can't be cached (e.g. it defines `__dir__`)
+ */
+static const TypeAttributeNames *getTypeAttributeNames(PyTypeObject *type) {
+  static thread_local PyObject *dirName = PyUnicode_InternFromString("__dir__"); // interned, for the lookup to go through the method cache
+  static thread_local PyObject *defaultDir = PyObject_GetAttr((PyObject *)&PyBaseObject_Type, dirName);
+
+  // a metaclass or a class overriding `__dir__` can report anything, so only the default `object.__dir__` behaviour is cached
+  if (Py_TYPE(type) != &PyType_Type) {
+    return nullptr;
+  }
+  PyObject *typeDir = PyObject_GetAttr((PyObject *)type, dirName);
+  if (!typeDir) {
+    PyErr_Clear();
+    return nullptr;
+  }
+  Py_DECREF(typeDir);
+  if (typeDir != defaultDir) {
+    return nullptr;
+  }
+
+  ModuleState *state = ModuleState::current();
+  if (!state) {
+    return nullptr;
+  }
+  if (!state->typeAttributeNamesEvictor) {
+    state->typeAttributeNamesEvictor = PyCFunction_New(&onCachedTypeFreedDef, NULL);
+    if (!state->typeAttributeNamesEvictor) {
+      PyErr_Clear();
+      return nullptr;
+    }
+  }
+#if PY_VERSION_HEX >= 0x030c0000
+  if (state->typeWatcher < 0) {
+    state->typeWatcher = PyType_AddWatcher(onTypeModified);
+    if (state->typeWatcher < 0) {
+      PyErr_Clear();
+      return nullptr;
+    }
+  }
+#else
+  // looking `__dir__` up gave the type a version tag, unless its MRO cannot have one
+  if (!PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG)) {
+    return nullptr;
+  }
+  unsigned int versionTag = type->tp_version_tag;
+#endif
+  auto entry = state->typeAttributeNames.find(type);
+  if (entry != state->typeAttributeNames.end()) {
+#if PY_VERSION_HEX >= 0x030c0000
+    bool valid = !entry->second.modified;
+#else
+    bool valid = entry->second.versionTag == versionTag;
+#endif
+    if (valid) {
+      state->typeAttributeNamesLRU.splice(state->typeAttributeNamesLRU.begin(), state->typeAttributeNamesLRU, entry->second.lruPosition);
+      return &entry->second;
+    }
+  }
+
+  // `dir(type)` merges the `__dict__`s of the type and its bases, exactly what `object.__dir__` adds to the instance `__dict__`
+  PyObject *allNames = PyObject_Dir((PyObject *)type);
+  if (!allNames) {
+    PyErr_Clear();
+    return nullptr;
+  }
+  PyObject *names = nonDunderNames(allNames);
+  Py_DECREF(allNames);
+  PyObject *nameSet = names ? PyFrozenSet_New(names) : NULL;
+  if (!nameSet) {
+    Py_XDECREF(names);
+    PyErr_Clear();
+    return nullptr;
+  }
 
-    PyObject *nonDunderKeys = PyList_New(0);
-    for (size_t i = 0; i < keysLength; i++) {
-      PyObject *key = PyList_GetItem(keys, i);
-      if (PyObject_CallMethod(key, "startswith", "(s)", "__") == Py_False) { // if key starts with "__", ignore it
-        PyList_Append(nonDunderKeys, key);
+  entry = state->typeAttributeNames.find(type); // computing the names may have run code using the cache
+  if (entry == state->typeAttributeNames.end()) {
+    if (state->typeAttributeNames.size() >= MAX_CACHED_TYPES) {
+      state->evictTypeAttributeNames(state->typeAttributeNamesLRU.back());
+    }
+    PyObject *typeRef = NULL; // static types are never freed
+    if (PyType_HasFeature(type, Py_TPFLAGS_HEAPTYPE)) {
+      typeRef = PyWeakref_NewRef((PyObject *)type, state->typeAttributeNamesEvictor);
+      if (!typeRef) {
+        PyErr_Clear();
+        Py_DECREF(names);
+        Py_DECREF(nameSet);
+        return nullptr;
       }
     }
+#if PY_VERSION_HEX >= 0x030c0000
+    if (PyType_Watch(state->typeWatcher, (PyObject *)type) < 0) {
+      PyErr_Clear();
+      Py_XDECREF(typeRef);
+      Py_DECREF(names);
+      Py_DECREF(nameSet);
+      return nullptr;
+    }
+#endif
+    state->typeAttributeNamesLRU.push_front(type);
+    entry = state->typeAttributeNames.emplace(type, TypeAttributeNames{
+      .names = names, .nameSet = nameSet, .typeRef = typeRef, .lruPosition = state->typeAttributeNamesLRU.begin()
+    }).first;
+  } else {
+    Py_SETREF(entry->second.names, names);
+    Py_SETREF(entry->second.nameSet, nameSet);
+    state->typeAttributeNamesLRU.splice(state->typeAttributeNamesLRU.begin(), state->typeAttributeNamesLRU, entry->second.lruPosition);
+#if PY_VERSION_HEX >= 0x030c0000
+    entry->second.modified = false;
+#endif
+  }
+#if PY_VERSION_HEX < 0x030c0000
+  entry->second.versionTag = versionTag; // a change made while computing the names invalidated it already
+#endif
+  return &entry->second;
+}
+
+/**
+ * @brief Equivalent to the non-dunder names of `dir(self)`, using the per-type cache for the class attributes
+ *
+ * @return PyObject* - new reference to a sorted list of names, or NULL with an exception set
+ */
+static PyObject *getAttributeNames(PyObject *self) {
+  const TypeAttributeNames *typeNames = getTypeAttributeNames(Py_TYPE(self));
+  if (!typeNames) {
+    PyObject *allNames = PyObject_Dir(self);
+    if (!allNames) {
+      return NULL;
+    }
+    PyObject *names = nonDunderNames(allNames);
+    Py_DECREF(allNames);
+    return names;
+  }
+  // the entry may be dropped by code run from here on, e.g. by the `__eq__` of a `str` subclass key
+  PyObject *typeNameList = typeNames->names;
+  PyObject *typeNameSet = typeNames->nameSet;
+  Py_INCREF(typeNameList);
+  Py_INCREF(typeNameSet);
+
+  PyObject *instanceDict = PyObject_GenericGetDict(self, NULL);
+  if (!instanceDict) { // no `__dict__`, e.g. the type uses `__slots__`
+    PyErr_Clear();
+    Py_DECREF(typeNameSet);
+    return typeNameList;
+  }
+
+  // Only the instance's own attributes need to be looked at, and that is a plain walk over its `__dict__`
+  PyObject *names = NULL;
+  Py_ssize_t pos = 0;
+  PyObject *key;
+  PyObject *value;
+  while (PyDict_Next(instanceDict, &pos, &key, &value)) {
+    if (!PyUnicode_Check(key) || isDunder(key)) {
+      continue;
+    }
+    int isTypeName = PySet_Contains(typeNameSet, key);
+    if (isTypeName < 0) {
+      Py_XDECREF(names);
+      Py_DECREF(instanceDict);
+      Py_DECREF(typeNameList);
+      Py_DECREF(typeNameSet);
+      return NULL;
+    }
+    if (isTypeName) {
+      continue;
+    }
+    if (!names) {
+      names = PyList_GetSlice(typeNameList, 0, PyList_GET_SIZE(typeNameList)); // copy, the cached list is shared
+    }
+    if (!names || PyList_Append(names, key) < 0) {
+      Py_XDECREF(names);
+      Py_DECREF(instanceDict);
+      Py_DECREF(typeNameList);
+      Py_DECREF(typeNameSet);
+      return NULL;
+    }
+  }
+  Py_DECREF(instanceDict);
+  Py_DECREF(typeNameSet);
+
+  if (!names) { // nothing beyond the class attributes
+    return typeNameList;
+  }
+  Py_DECREF(typeNameList);
+  if (PyList_Sort(names) < 0) { // `dir()` returns its names sorted
+    Py_DECREF(names);
+    return NULL;
+  }
+  return names;
+}
+
+bool PyObjectProxyHandler::ownPropertyKeys(JSContext *cx, JS::HandleObject proxy, JS::MutableHandleIdVector props) const {
+  AutoAcquireGIL acquireGIL;
+  PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
+  PyObject *keys = getAttributeNames(self);
 
-    return handleOwnPropertyKeys(cx, nonDunderKeys, PyList_Size(nonDunderKeys), props);
+  if (keys != nullptr) {
+    bool success = handleOwnPropertyKeys(cx, keys, PyList_GET_SIZE(keys), props);
+    Py_DECREF(keys);
+    return success;
   }
   else {
     if (PyErr_Occurred()) {
       PyErr_Clear();
     }
 
-    return handleOwnPropertyKeys(cx, PyList_New(0), 0, props);
+    return true; // no keys
   }
 }
 
 bool PyObjectProxyHandler::delete_(JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   JS::ObjectOpResult &result) const {
+  AutoAcquireGIL acquireGIL;
   PyObject *attrName = idToKey(cx, id);
+  if (!attrName) {
+    return false;
+  }
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
-  if (PyObject_SetAttr(self, attrName, NULL) < 0) {
+  int deleted = PyObject_SetAttr(self, attrName, NULL);
+  Py_DECREF(attrName);
+  if (deleted < 0) {
     return result.failCantDelete(); // raises JS exception
   }
   return result.succeed();
@@ -140,29 +439,41 @@ bool PyObjectProxyHandler::getOwnPropertyDescriptor(
   JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   JS::MutableHandle<mozilla::Maybe<JS::PropertyDescriptor>> desc
 ) const {
+  AutoAcquireGIL acquireGIL;
   PyObject *attrName = idToKey(cx, id);
+  if (!attrName) {
+    return false;
+  }
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
   PyObject *item = PyObject_GetAttr(self, attrName);
+  Py_DECREF(attrName);
   if (!item && PyErr_ExceptionMatches(PyExc_AttributeError)) {
     PyErr_Clear(); // clear error, we will be returning undefined in this case
   }
 
-  return handleGetOwnPropertyDescriptor(cx, id, desc, item);
+  bool success = handleGetOwnPropertyDescriptor(cx, id, desc, item);
+  Py_XDECREF(item); // the JS value holds its own reference where it needs one
+  return success;
 }
 
 bool PyObjectProxyHandler::set(JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   JS::HandleValue v, JS::HandleValue receiver,
   JS::ObjectOpResult &result) const {
+  AutoAcquireGIL acquireGIL;
   JS::RootedValue rootedV(cx, v);
   PyObject *attrName = idToKey(cx, id);
+  if (!attrName) {
+    return false;
+  }
 
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
   PyObject *value = pyTypeFactory(cx, rootedV);
-  if (PyObject_SetAttr(self, attrName, value)) {
-    Py_DECREF(value);
+  int failed = PyObject_SetAttr(self, attrName, value);
+  Py_DECREF(attrName);
+  Py_DECREF(value);
+  if (failed) {
     return result.failCantSetInterposed(); // raises JS exception
   }
-  Py_DECREF(value);
   return result.succeed();
 }
 
@@ -173,9 +484,14 @@ bool PyObjectProxyHandler::enumerate(JSContext *cx, JS::HandleObject proxy,
 
 bool PyObjectProxyHandler::hasOwn(JSContext *cx, JS::HandleObject proxy, JS::HandleId id,
   bool *bp) const {
+  AutoAcquireGIL acquireGIL;
   PyObject *attrName = idToKey(cx, id);
+  if (!attrName) {
+    return false;
+  }
   PyObject *self = JS::GetMaybePtrFromReservedSlot<PyObject>(proxy, PyObjectSlot);
   *bp = PyObject_HasAttr(self, attrName) == 1;
+  Py_DECREF(attrName);
   return true;
 }
 
@@ -0,0 +1,177 @@
+/**
+ * @file ScriptCache.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief LRU cache of compiled scripts and functions, consulted by pythonmonkey.eval, pythonmonkey.compile and pythonmonkey.compile_function
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/ScriptCache.hh"
+#include "include/StencilCache.hh"
+#include "include/ThreadContext.hh"
+
+#include <jsapi.h>
+#include <js/CompilationAndEvaluation.h>
+#include <js/SourceText.h>
+
+#include <Python.h>
+#include "include/pyshim.hh"
+
+#include <cstring>
+
+void ScriptOptions::apply(JS::CompileOptions &options) const {
+  options.setFileAndLine(filename.c_str(), lineno)
+  .setNoScriptRval(noScriptRval)
+  .setMutedErrors(mutedErrors)
+  .setSelfHostingMode(selfHosting);
+  if (column) options.setColumn(JS::ColumnNumberOneOrigin(column));
+  if (strict) options.setForceStrictMode();
+  if (module) options.setModule();
+}
+
+std::string ScriptOptions::key() const {
+  std::string key = filename;
+  key += '\0';
+  key += std::to_string(lineno) + ':' + std::to_string(column) + ':';
+  key += mutedErrors ? 'm' : '-';
+  key += noScriptRval ? 'n' : '-';
+  key += selfHosting ? 'h' : '-';
+  key += strict ? 's' : '-';
+  key += module ? 'M' : '-';
+  return key;
+}
+
+ScriptCache::Entry *ScriptCache::lookup(const Key &key, PyObject *code) {
+  auto found = index.find(key);
+  if (found != index.end()) {
+    Entry &entry = *found->second;
+    if (entry.code == code || PyUnicode_Compare(entry.code, code) == 0) {
+      hits++;
+      entries.splice(entries.begin(), entries, found->second); // move to the front, iterators stay valid
+      return &entry;
+    }
+    evict(found->second); // hash collision, the newer source takes the slot
+  }
+  misses++;
+  return nullptr;
+}
+
+template<typename T>
+void ScriptCache::insert(JSContext *cx, PyObject *code, const Key &key, T compiled) {
+  if (entries.size() >= MAX_SIZE) {
+    evict(std::prev(entries.end()));
+  }
+  Py_INCREF(code);
+  entries.emplace_front(cx, code, key, compiled);
+  index[key] = entries.begin();
+}
+
+JSScript *ScriptCache::getOrCompile(JSContext *cx, PyObject *code, const ScriptOptions &options) {
+  Key key = {PyObject_Hash(code) /* the hash of a str is computed once and stored on the object */, options.key()};
+  if (Entry *entry = lookup(key, code)) {
+    return entry->script;
+  }
+
+  Py_ssize_t codeLength;
+  const char *codeChars = PyUnicode_AsUTF8AndSize(code, &codeLength);
+  if (!codeChars) {
+    return nullptr;
+  }
+  JS::SourceText<mozilla::Utf8Unit> source;
+  if (!source.init(cx, codeChars, codeLength, JS::SourceOwnership::Borrowed)) {
+    return nullptr;
+  }
+  JS::CompileOptions compileOptions(cx);
+  compileOptions.setIntroductionType("pythonmonkey eval");
+  options.apply(compileOptions);
+  compileOptions.setIsRunOnce(false); // cached scripts may be executed many times
+  JS::RootedScript script(cx, StencilCache::enabled()
+    ? StencilCache::getOrCompile(cx, compileOptions, code, source, key.options)
+    : JS::Compile(cx, compileOptions, source));
+  if (!script) {
+    return nullptr;
+  }
+
+  insert(cx, code, key, script.get());
+  return script;
+}
+
+JSObject *ScriptCache::getOrCompileFunction(JSContext *cx, const char *name, const std::vector<std::string> &params,
+  PyObject *body, const ScriptOptions &options) {
+  ScriptOptions functionOptions = options;
+  functionOptions.module = false;
+  functionOptions.noScriptRval = false;
+
+  // a function is told apart from a script with the same source by its signature, which can't be part of a script's options key.
+  // Each name is prefixed by its length, as names may contain any character
+  std::string signature = name ? "function " + std::to_string(strlen(name)) + ':' + name : "function -";
+  signature += '(';
+  for (const std::string &param : params) {
+    signature += std::to_string(param.size()) + ':' + param;
+  }
+  signature += ')';
+  Key key = {PyObject_Hash(body), functionOptions.key() + '\0' + signature};
+  bool cacheable = !ThreadContext::current(); // the cache roots its functions in the main context
+  if (Entry *entry = cacheable ? lookup(key, body) : nullptr) {
+    JS::RootedObject compiled(cx, JS_GetFunctionObject(entry->function));
+    return JS::CloneFunctionObject(cx, compiled);
+  }
+
+  Py_ssize_t bodyLength;
+  const char *bodyChars = PyUnicode_AsUTF8AndSize(body, &bodyLength);
+  if (!bodyChars) {
+    return nullptr;
+  }
+  JS::SourceText<mozilla::Utf8Unit> source;
+  if (!source.init(cx, bodyChars, bodyLength, JS::SourceOwnership::Borrowed)) {
+    return nullptr;
+  }
+  JS::CompileOptions compileOptions(cx);
+  compileOptions.setIntroductionType("pythonmonkey compile_function");
+  functionOptions.apply(compileOptions);
+
+  std::vector<const char *> argnames;
+  for (const std::string &param : params) {
+    argnames.push_back(param.c_str());
+  }
+  JS::RootedVector<JSObject *> emptyScopeChain(cx); // global scope, the function closes over nothing else
+  JS::RootedFunction function(cx, JS::CompileFunction(cx, emptyScopeChain, compileOptions, name, argnames.size(), argnames.data(), source));
+  if (!function) {
+    return nullptr;
+  }
+  JS::RootedObject compiled(cx, JS_GetFunctionObject(function));
+  if (!cacheable) {
+    return compiled;
+  }
+
+  // the cached function is never handed out, each caller gets its own clone sharing its compiled script
+  insert(cx, body, key, function.get());
+  return JS::CloneFunctionObject(cx, compiled);
+}
+
+void ScriptCache::evict(std::list<Entry>::iterator entry) {
+  index.erase(entry->key);
+  if (!Py_IsFinalizing()) {
+    Py_DECREF(entry->code);
+  }
+  entries.erase(entry);
+}
+
+PyObject *ScriptCache::info() {
+  return Py_BuildValue("{s:n,s:n,s:n,s:n}",
+    "hits", (Py_ssize_t)hits,
+    "misses", (Py_ssize_t)misses,
+    "maxsize", (Py_ssize_t)MAX_SIZE,
+    "currsize", (Py_ssize_t)entries.size()
+  );
+}
+
+void ScriptCache::clear() {
+  while (!entries.empty()) {
+    evict(entries.begin());
+  }
+  hits = 0;
+  misses = 0;
+}
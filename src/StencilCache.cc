@@ -0,0 +1,251 @@
+/**
+ * @file StencilCache.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief On-disk cache of compiled scripts (XDR-encoded stencils), keyed by a hash of their source and compile options
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/StencilCache.hh"
+
+#include <jsapi.h>
+#include <js/experimental/JSStencil.h>
+#include <js/Transcoding.h>
+
+#include <Python.h>
+
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+static const char *STENCIL_EXTENSION = ".stencil";
+
+bool StencilCache::configure(const char *dir, size_t max) {
+  if (!dir) {
+    std::lock_guard<std::mutex> lock(mutex);
+    directory.clear();
+    return true;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(dir, error);
+  if (error) {
+    PyErr_Format(PyExc_OSError, "cannot create the stencil cache directory %s: %s", dir, error.message().c_str());
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  directory = dir;
+  maxBytes = max;
+  trim();
+  return true;
+}
+
+bool StencilCache::enabled() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return !directory.empty();
+}
+
+bool StencilCache::getPath(const char *code, size_t length, const std::string &optionsKey, std::filesystem::path &path) {
+  // sha256(code + '\0' + options), hashing the code in place through a memoryview
+  PyObject *hashlib = PyImport_ImportModule("hashlib");
+  if (!hashlib) {
+    return false;
+  }
+  PyObject *codeView = PyMemoryView_FromMemory((char *)code, length, PyBUF_READ);
+  PyObject *hash = codeView ? PyObject_CallMethod(hashlib, "sha256", "O", codeView) : NULL;
+  Py_DECREF(hashlib);
+  Py_XDECREF(codeView);
+  if (!hash) {
+    return false;
+  }
+  std::string suffix = '\0' + optionsKey;
+  PyObject *suffixBytes = PyBytes_FromStringAndSize(suffix.data(), suffix.size());
+  PyObject *updated = suffixBytes ? PyObject_CallMethod(hash, "update", "O", suffixBytes) : NULL;
+  Py_XDECREF(suffixBytes);
+  Py_XDECREF(updated);
+  PyObject *digest = updated ? PyObject_CallMethod(hash, "hexdigest", NULL) : NULL;
+  Py_DECREF(hash);
+  if (!digest) {
+    return false;
+  }
+
+  std::filesystem::path cacheDirectory;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    cacheDirectory = directory;
+  }
+  bool cached = !cacheDirectory.empty(); // unless disabled meanwhile
+  if (cached) {
+    path = cacheDirectory / (std::string(PyUnicode_AsUTF8(digest)) + STENCIL_EXTENSION);
+  }
+  Py_DECREF(digest);
+  return cached;
+}
+
+already_AddRefed<JS::Stencil> StencilCache::read(JSContext *cx, const JS::ReadOnlyCompileOptions &options, const std::filesystem::path &path) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (in) {
+    JS::TranscodeBuffer buffer;
+    std::streamsize size = in.tellg();
+    in.seekg(0);
+    if (size > 0 && buffer.resize(size) && in.read((char *)buffer.begin(), size)) {
+      JS::Stencil *decoded = nullptr;
+      JS::TranscodeRange range(buffer.begin(), buffer.length());
+      JS::DecodeOptions decodeOptions(options);
+      if (JS::DecodeStencil(cx, decodeOptions, range, &decoded) == JS::TranscodeResult::Ok) {
+        hits++;
+        std::error_code error;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error); // for LRU trimming
+        return already_AddRefed<JS::Stencil>(decoded);
+      }
+      JS_ClearPendingException(cx); // from another SpiderMonkey build, or corrupted, compile and replace it
+    }
+  }
+  misses++;
+  return nullptr;
+}
+
+void StencilCache::write(JSContext *cx, JS::Stencil *stencil, const std::filesystem::path &path) {
+  JS::TranscodeBuffer buffer;
+  if (JS::EncodeStencil(cx, stencil, buffer) != JS::TranscodeResult::Ok) {
+    JS_ClearPendingException(cx); // e.g. asm.js can't be encoded, the script still runs
+    return;
+  }
+
+  // write to a temporary file first, so that other processes never read a partial stencil
+  std::filesystem::path temporary = path;
+  temporary += "." + std::to_string(getpid()) + ".tmp";
+  std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+  out.write((const char *)buffer.begin(), buffer.length());
+  out.close();
+  bool written = !out.fail();
+  std::error_code error;
+  if (written) {
+    std::filesystem::rename(temporary, path, error);
+  }
+  if (!written || error) {
+    std::filesystem::remove(temporary, error);
+  } else {
+    writes++;
+    std::lock_guard<std::mutex> lock(mutex);
+    trackedBytes += buffer.length();
+    if (trackedBytes > maxBytes) {
+      trim();
+    }
+  }
+}
+
+JSScript *StencilCache::getOrCompile(JSContext *cx, const JS::CompileOptions &options, PyObject *code,
+  JS::SourceText<mozilla::Utf8Unit> &source, const std::string &optionsKey) {
+  JS::InstantiateOptions instantiateOptions(options);
+
+  Py_ssize_t codeLength;
+  const char *codeChars = PyUnicode_AsUTF8AndSize(code, &codeLength);
+  std::filesystem::path path;
+  if (!codeChars || !getPath(codeChars, codeLength, optionsKey, path)) {
+    PyErr_Clear();
+    return JS::Compile(cx, options, source);
+  }
+
+  RefPtr<JS::Stencil> stencil = read(cx, options, path);
+  if (!stencil) {
+    stencil = JS::CompileGlobalScriptToStencil(cx, options, source);
+    if (!stencil) {
+      return nullptr;
+    }
+    write(cx, stencil, path);
+  }
+  return JS::InstantiateGlobalStencil(cx, instantiateOptions, stencil);
+}
+
+already_AddRefed<JS::Stencil> StencilCache::lookup(JSContext *cx, const JS::ReadOnlyCompileOptions &options,
+  const std::string &code, const std::string &optionsKey) {
+  std::filesystem::path path;
+  if (!getPath(code.data(), code.size(), optionsKey, path)) {
+    PyErr_Clear();
+    return nullptr;
+  }
+  return read(cx, options, path);
+}
+
+void StencilCache::store(JSContext *cx, JS::Stencil *stencil, const std::string &code, const std::string &optionsKey) {
+  std::filesystem::path path;
+  if (!getPath(code.data(), code.size(), optionsKey, path)) {
+    PyErr_Clear();
+    return;
+  }
+  write(cx, stencil, path);
+}
+
+void StencilCache::trim() {
+  struct CachedFile {
+    std::filesystem::path path;
+    std::filesystem::file_time_type lastUsed;
+    uintmax_t size;
+  };
+  std::vector<CachedFile> files;
+  uintmax_t totalSize = 0;
+  if (directory.empty()) {
+    return;
+  }
+
+  std::error_code error;
+  for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+    std::error_code entryError;
+    if (entry.path().extension() != STENCIL_EXTENSION || !entry.is_regular_file(entryError)) {
+      continue;
+    }
+    CachedFile file = {entry.path(), entry.last_write_time(entryError), entry.file_size(entryError)};
+    if (!entryError) {
+      totalSize += file.size;
+      files.push_back(std::move(file));
+    }
+  }
+  trackedBytes = totalSize;
+  if (totalSize <= maxBytes) {
+    return;
+  }
+
+  std::sort(files.begin(), files.end(), [](const CachedFile &a, const CachedFile &b) { return a.lastUsed < b.lastUsed; });
+  for (const CachedFile &file : files) {
+    if (totalSize <= maxBytes) {
+      break;
+    }
+    if (std::filesystem::remove(file.path, error)) {
+      totalSize -= file.size;
+    }
+  }
+  trackedBytes = totalSize;
+}
+
+PyObject *StencilCache::info() {
+  std::filesystem::path cacheDirectory;
+  size_t cacheMaxBytes;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    cacheDirectory = directory;
+    cacheMaxBytes = maxBytes;
+  }
+  PyObject *dir;
+  if (!cacheDirectory.empty()) {
+    dir = PyUnicode_FromString(cacheDirectory.c_str());
+    if (!dir) {
+      return NULL;
+    }
+  } else {
+    Py_INCREF(Py_None);
+    dir = Py_None;
+  }
+  return Py_BuildValue("{s:N,s:n,s:n,s:n,s:n}",
+    "directory", dir,
+    "maxsize", (Py_ssize_t)cacheMaxBytes,
+    "hits", (Py_ssize_t)hits,
+    "misses", (Py_ssize_t)misses,
+    "writes", (Py_ssize_t)writes
+  );
+}
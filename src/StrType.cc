@@ -11,6 +11,8 @@
 #include "include/StrType.hh"
 #include "include/JSStringProxy.hh"
 #include "include/jsTypeFactory.hh"
+#include "include/ThreadContext.hh"
+#include "include/AutoGIL.hh"
 
 #include <jsapi.h>
 #include <js/String.h>
@@ -113,16 +115,22 @@ PyObject *StrType::proxifyString(JSContext *cx, JS::HandleValue strVal) {
 
   size_t length = JS::GetLinearStringLength(lstr);
 
-  JSStringProxy *pyString = PyObject_New(JSStringProxy, &JSStringProxyType); // new reference
+  ModuleState *state = ModuleState::current();
+  JSStringProxy *pyString = (JSStringProxy *)state->JSStringProxyFreeList.reuse(state->JSStringProxyType); // new reference
+  if (pyString == NULL) {
+    pyString = PyObject_New(JSStringProxy, state->JSStringProxyType);
+  }
 
   if (pyString == NULL) {
     return NULL;
   }
 
   JS::RootedObject obj(cx);
-  pyString->jsString = new JS::PersistentRootedValue(cx);
-  pyString->jsString->setString((JSString *)lstr);
-  jsStringProxies.insert(pyString);
+  pyString->jsString = ProxyRoots::create((JSString *)lstr);
+  {
+    std::lock_guard<std::mutex> lock(jsStringProxiesMutex);
+    jsStringProxies.insert(pyString);
+  }
 
   // Initialize as legacy string (https://github.com/python/cpython/blob/v3.12.0b1/Include/cpython/unicodeobject.h#L78-L93)
   // see https://github.com/python/cpython/blob/v3.11.3/Objects/unicodeobject.c#L1230-L1245
@@ -223,5 +231,13 @@ PyObject *StrType::getPyObject(JSContext *cx, JS::HandleValue str) {
     }
   }
 
-  return proxifyString(cx, str);
+  PyObject *pyString = proxifyString(cx, str);
+  if (pyString && (ThreadContext::current() || AutoReleaseGIL::isEnabled()) && PyObject_TypeCheck(pyString, JSStringProxyType())) {
+    // the characters of a thread's JSContext are freed when the thread ends, while the Python string may outlive it.
+    // Without the GIL, a GC may move the characters while another Python thread reads them.
+    PyObject *copied = PyUnicode_FromObject(pyString);
+    Py_DECREF(pyString);
+    return copied;
+  }
+  return pyString;
 }
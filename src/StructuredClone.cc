@@ -0,0 +1,114 @@
+/**
+ * @file StructuredClone.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Copies of JS value graphs with the structured clone algorithm: pythonmonkey.serialize/deserialize, pickling of proxies, and the structuredClone global
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/StructuredClone.hh"
+
+#include "include/setSpiderMonkeyException.hh"
+
+#include <jsapi.h>
+#include <js/StructuredClone.h>
+
+#include <Python.h>
+
+#include <cstring>
+
+PyObject *StructuredClone::serialize(JSContext *cx, JS::HandleValue value) {
+  JSAutoStructuredCloneBuffer buffer(JS::StructuredCloneScope::DifferentProcess, nullptr, nullptr);
+  if (!buffer.write(cx, value)) {
+    setSpiderMonkeyException(cx);
+    return NULL;
+  }
+
+  // The clone data is a list of segments, typed-array contents included, which only a single copy makes contiguous
+  const JSStructuredCloneData &data = buffer.data();
+  PyObject *bytes = PyBytes_FromStringAndSize(NULL, data.Size());
+  if (!bytes) {
+    return NULL;
+  }
+  char *out = PyBytes_AS_STRING(bytes);
+  data.ForEachDataChunk([&out](const char *chunk, size_t size) {
+    memcpy(out, chunk, size);
+    out += size;
+    return true;
+  });
+  return bytes;
+}
+
+bool StructuredClone::deserialize(JSContext *cx, PyObject *data, JS::MutableHandleValue rval) {
+  Py_buffer view;
+  if (PyObject_GetBuffer(data, &view, PyBUF_SIMPLE) < 0) {
+    return false;
+  }
+
+  // copied, as the clone data frees its segments, and reading needs them 8-byte aligned, which any buffer need not be
+  JSStructuredCloneData cloneData(JS::StructuredCloneScope::DifferentProcess);
+  bool appended = cloneData.AppendBytes((const char *)view.buf, view.len);
+  PyBuffer_Release(&view);
+  if (!appended) {
+    PyErr_NoMemory();
+    return false;
+  }
+
+  if (!JS_ReadStructuredClone(cx, cloneData, JS_STRUCTURED_CLONE_VERSION, JS::StructuredCloneScope::DifferentProcess,
+    rval, JS::CloneDataPolicy(), nullptr, nullptr)) {
+    setSpiderMonkeyException(cx);
+    return false;
+  }
+  return true;
+}
+
+PyObject *StructuredClone::reduce(JSContext *cx, JS::HandleValue value) {
+  PyObject *bytes = serialize(cx, value);
+  if (!bytes) {
+    return NULL;
+  }
+  PyObject *module = PyImport_ImportModule("pythonmonkey");
+  PyObject *deserialize = module ? PyObject_GetAttrString(module, "deserialize") : NULL;
+  Py_XDECREF(module);
+  if (!deserialize) {
+    Py_DECREF(bytes);
+    return NULL;
+  }
+  PyObject *reduced = Py_BuildValue("(N(N))", deserialize, bytes);
+  return reduced;
+}
+
+/**
+ * @brief The structuredClone global: copy a value in the same context, moving the ArrayBuffers in `options.transfer`
+ * @see https://html.spec.whatwg.org/multipage/structured-data.html#dom-structuredclone
+ */
+static bool structuredClone(JSContext *cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  if (!args.requireAtLeast(cx, "structuredClone", 1)) {
+    return false;
+  }
+
+  JS::RootedValue transfer(cx);
+  if (args.get(1).isObject()) {
+    JS::RootedObject options(cx, &args[1].toObject());
+    if (!JS_GetProperty(cx, options, "transfer", &transfer)) {
+      return false;
+    }
+  }
+
+  JS::CloneDataPolicy policy;
+  policy.allowSharedMemoryObjects();
+  JSAutoStructuredCloneBuffer buffer(JS::StructuredCloneScope::SameProcess, nullptr, nullptr);
+  return buffer.write(cx, args[0], transfer, policy) && buffer.read(cx, args.rval(), policy);
+}
+
+static JSFunctionSpec globalFunctions[] = {
+  JS_FN("structuredClone", structuredClone, /* nargs */ 1, 0),
+  JS_FS_END
+};
+
+bool StructuredClone::defineGlobal(JSContext *cx, JS::HandleObject global) {
+  return JS_DefineFunctions(cx, global, globalFunctions);
+}
@@ -0,0 +1,138 @@
+/**
+ * @file ThreadContext.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief The JSContexts of Python threads other than the one that imported pythonmonkey
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ *
+ */
+
+#include "include/ThreadContext.hh"
+
+#include "include/modules/pythonmonkey/pythonmonkey.hh"
+#include "include/BufferType.hh"
+#include "include/ModuleState.hh"
+#include "include/PropertyKeyCache.hh"
+#include "include/ProxyRoots.hh"
+
+#include <jsapi.h>
+
+#include <Python.h>
+
+static const char CAPSULE_NAME[] = "pythonmonkey.ThreadContext";
+
+void ThreadContext::init(JSContext *mainContext) {
+  mainRuntime = JS_GetRuntime(mainContext);
+  boundInterpreter = PyInterpreterState_GetID(PyInterpreterState_Main());
+}
+
+bool ThreadContext::ensure() {
+  PyThreadState *threadState = PyThreadState_Get();
+  int64_t interpreterId = PyInterpreterState_GetID(PyThreadState_GetInterpreter(threadState));
+  if (GLOBAL_CX) {
+    if (interpreterId == boundInterpreter) {
+      if (currentContext) {
+        currentContext->threadState = threadState; // subinterpreters may run on a new thread state each time
+      }
+      return true;
+    }
+    // SpiderMonkey keeps the JSContext of each thread in thread-local storage, a thread cannot switch between contexts
+    PyErr_SetString(PyExc_RuntimeError, "this thread runs the JavaScript of another Python interpreter, run each subinterpreter using pythonmonkey on threads of its own");
+    return false;
+  }
+  if (!mainRuntime) {
+    PyErr_SetString(PyExc_RuntimeError, "pythonmonkey is not initialized");
+    return false;
+  }
+  ModuleState *state = ModuleState::current();
+  if (!state) {
+    PyErr_SetString(PyExc_RuntimeError, "pythonmonkey is not imported in this interpreter");
+    return false;
+  }
+
+  // a child runtime shares the self-hosted code and the immutable data of the main runtime, which makes it cheaper to create
+  JSContext *cx = JS_NewContext(JS::DefaultHeapMaxBytes, mainRuntime);
+  if (!cx) {
+    PyErr_SetString(SpiderMonkeyError(), "Spidermonkey could not create a JS context for this thread.");
+    return false;
+  }
+  ThreadContext *context = new ThreadContext(cx, threadState);
+  JS_SetContextPrivate(cx, context);
+  GLOBAL_CX = cx;
+  currentContext = context;
+  boundInterpreter = interpreterId;
+
+  context->jobQueue = new JobQueue(cx);
+  if (!initJSContext(cx, context->jobQueue)) {
+    delete context;
+    return false;
+  }
+
+  JS::RootedObject contextGlobal(cx, newContextGlobal(cx));
+  if (!contextGlobal) {
+    delete context;
+    return false;
+  }
+  context->global = new JS::PersistentRootedObject(cx, contextGlobal);
+  context->autoRealm = new JSAutoRealm(cx, contextGlobal);
+
+  JS::RootedObject registry(cx, newFunctionRegistry(cx));
+  if (!registry) {
+    delete context;
+    return false;
+  }
+  jsFunctionRegistry = new JS::PersistentRootedObject(cx, registry);
+
+  if (!state->mainInterpreter) {
+    state->threadContexts.push_back(context); // destroyed with the subinterpreter
+    created.store(true, std::memory_order_relaxed);
+    return true;
+  }
+
+  // The thread state dict is cleared by the ending thread itself, with the GIL held, which destroys the context
+  PyObject *capsule = PyCapsule_New(context, CAPSULE_NAME, destroy);
+  PyObject *threadDict = PyThreadState_GetDict();
+  if (!capsule || !threadDict || PyDict_SetItemString(threadDict, CAPSULE_NAME, capsule) < 0) {
+    Py_XDECREF(capsule);
+    delete context;
+    if (!PyErr_Occurred()) {
+      PyErr_SetString(PyExc_RuntimeError, "pythonmonkey could not attach a JS context to this thread");
+    }
+    return false;
+  }
+  Py_DECREF(capsule);
+
+  created.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void ThreadContext::destroyOnOwnThread(ThreadContext *context) {
+  if (context == currentContext) {
+    delete context;
+  }
+}
+
+void ThreadContext::destroy(PyObject *capsule) {
+  ThreadContext *context = (ThreadContext *)PyCapsule_GetPointer(capsule, CAPSULE_NAME);
+  // A JSContext can only be destroyed on its own thread. Thread states cleared by another thread, as happens to
+  // daemon threads during interpreter finalization, leak their context instead.
+  if (context && context == currentContext && !Py_IsFinalizing()) {
+    delete context;
+  }
+}
+
+ThreadContext::~ThreadContext() {
+  PropertyKeyCache::clear();
+  delete jsFunctionRegistry;
+  jsFunctionRegistry = nullptr;
+  delete autoRealm;
+  delete global;
+  ProxyRoots::destroyContext(cx); // unroots the proxies of this context's values still held by Python, which then raise when used
+  JS_DestroyContext(cx);
+  delete jobQueue;
+  BufferType::releasePendingPyBuffers();
+  GLOBAL_CX = nullptr;
+  currentContext = nullptr;
+  boundInterpreter = -1;
+}
@@ -25,40 +25,11 @@ JSObject *getInternalBindingsByNamespace(JSContext *cx, JSLinearString *namespac
     return createInternalBindingsForNamespace(cx, InternalBinding::utils);
   } else if (JS_LinearStringEqualsLiteral(namespaceStr, "timers")) {
     return createInternalBindingsForNamespace(cx, InternalBinding::timers);
+  } else if (JS_LinearStringEqualsLiteral(namespaceStr, "fs")) {
+    return createInternalBindingsForNamespace(cx, InternalBinding::fs);
+  } else if (JS_LinearStringEqualsLiteral(namespaceStr, "structuredClone")) {
+    return createInternalBindingsForNamespace(cx, InternalBinding::structuredClone);
   } else { // not found
     return nullptr;
   }
 }
-
-/**
- * @brief Implement the `internalBinding(namespace)` function
- */
-static bool internalBindingFn(JSContext *cx, unsigned argc, JS::Value *vp) {
-  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
-
-  // Get the `namespace` argument as string
-  JS::HandleValue namespaceStrArg = args.get(0);
-  JSLinearString *namespaceStr = JS_EnsureLinearString(cx, namespaceStrArg.toString());
-
-  args.rval().setObjectOrNull(getInternalBindingsByNamespace(cx, namespaceStr));
-  return true;
-}
-
-/**
- * @brief Create the JS `internalBinding` function
- */
-JSFunction *createInternalBinding(JSContext *cx) {
-  return JS_NewFunction(cx, internalBindingFn, 1, 0, "internalBinding");
-}
-
-/**
- * @brief Convert the `internalBinding(namespace)` function to a Python function
- */
-PyObject *getInternalBindingPyFn(JSContext *cx) {
-  // Create the JS `internalBinding` function
-  JSObject *jsFn = (JSObject *)createInternalBinding(cx);
-
-  // Convert to a Python function
-  JS::RootedValue jsFnVal(cx, JS::ObjectValue(*jsFn));
-  return pyTypeFactory(cx, jsFnVal);
-}
\ No newline at end of file
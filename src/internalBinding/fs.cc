@@ -0,0 +1,200 @@
+/**
+ * @file fs.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Implement functions in `internalBinding("fs")`, the file system calls made by the CommonJS module loader
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ */
+
+#include "include/internalBinding.hh"
+
+#include <jsapi.h>
+#include <js/String.h>
+#include <js/CharacterEncoding.h>
+
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/**
+ * See function declarations in python/pythonmonkey/builtin_modules/internal-binding.d.ts :
+ *    `declare function internalBinding(namespace: "fs")`
+ */
+
+static constexpr size_t MMAP_THRESHOLD = 64 * 1024; // smaller files are cheaper to read()
+
+// The paths probed while resolving modules, one cache per JSContext as each thread runs a module loader of its own.
+// The modes of existing paths are kept until clearStatCache(). Missing paths are only kept until the outermost require()
+// returns and calls clearMissingPaths(), so that a module created after a failed require() is found by the next one.
+static thread_local std::unordered_map<std::string, double> statCache;
+static thread_local std::unordered_set<std::string> missingPaths;
+
+/**
+ * @brief Convert the path argument to a normalized UTF-8 path, like os.path.normpath does
+ */
+static bool getPath(JSContext *cx, JS::HandleValue pathArg, std::string &path) {
+  JS::RootedString pathStr(cx, JS::ToString(cx, pathArg));
+  if (!pathStr) {
+    return false;
+  }
+  JS::UniqueChars pathChars = JS_EncodeStringToUTF8(cx, pathStr);
+  if (!pathChars) {
+    return false;
+  }
+  path = std::filesystem::path(pathChars.get()).lexically_normal().string();
+  return true;
+}
+
+/**
+ * @brief Throw an Error like Node.js does for a failed system call, with `code` set to the errno name
+ */
+static bool throwSystemError(JSContext *cx, int error, const char *syscall, const std::string &path) {
+  const char *code = error == ENOENT ? "ENOENT" : error == EISDIR ? "EISDIR" : error == EACCES ? "EACCES" : "EIO";
+  JS_ReportErrorUTF8(cx, "%s: %s, %s '%s'", code, strerror(error), syscall, path.c_str());
+
+  JS::RootedValue exception(cx);
+  if (JS_GetPendingException(cx, &exception) && exception.isObject()) {
+    JS::RootedObject exceptionObj(cx, &exception.toObject());
+    JS::RootedString codeStr(cx, JS_NewStringCopyZ(cx, code));
+    if (codeStr) {
+      JS::RootedValue codeVal(cx, JS::StringValue(codeStr));
+      JS_SetProperty(cx, exceptionObj, "code", codeVal);
+    }
+  }
+  return false;
+}
+
+static bool statMode(JSContext *cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  std::string path;
+  if (!getPath(cx, args.get(0), path)) {
+    return false;
+  }
+
+  auto cached = statCache.find(path);
+  if (cached != statCache.end()) {
+    args.rval().setNumber(cached->second);
+    return true;
+  }
+  if (missingPaths.count(path)) {
+    args.rval().setNumber(-1);
+    return true;
+  }
+
+  struct stat sb;
+  if (stat(path.c_str(), &sb) != 0) {
+    missingPaths.insert(std::move(path));
+    args.rval().setNumber(-1);
+    return true;
+  }
+  double mode = (double)sb.st_mode;
+  statCache.emplace(std::move(path), mode);
+  args.rval().setNumber(mode);
+  return true;
+}
+
+static bool clearStatCache(JSContext *cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  statCache.clear();
+  missingPaths.clear();
+  args.rval().setUndefined();
+  return true;
+}
+
+static bool clearMissingPaths(JSContext *cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  missingPaths.clear();
+  args.rval().setUndefined();
+  return true;
+}
+
+static bool readFileUtf8(JSContext *cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+  std::string path;
+  if (!getPath(cx, args.get(0), path)) {
+    return false;
+  }
+
+  JSString *contents = nullptr;
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return throwSystemError(cx, errno, "open", path);
+  }
+  struct stat sb;
+  int error = fstat(fd, &sb) != 0 ? errno : S_ISDIR(sb.st_mode) ? EISDIR : 0;
+  if (error) {
+    close(fd);
+    return throwSystemError(cx, error, "read", path);
+  }
+
+  size_t size = sb.st_size;
+  if (size >= MMAP_THRESHOLD) { // decode straight from the page cache, without a copy of the file in between
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+      close(fd);
+      contents = JS_NewStringCopyUTF8N(cx, JS::UTF8Chars((const char *)mapping, size));
+      munmap(mapping, size);
+      if (!contents) {
+        return false;
+      }
+      args.rval().setString(contents);
+      return true;
+    }
+  }
+
+  std::string buffer(size, '\0');
+  size_t read = 0;
+  while (read < size) {
+    ssize_t count = ::read(fd, buffer.data() + read, size - read);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      break; // the file shrank, or failed
+    }
+    read += count;
+  }
+  close(fd);
+  buffer.resize(read);
+#else
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return throwSystemError(cx, errno, "open", path);
+  }
+  std::string buffer;
+  char chunk[64 * 1024];
+  size_t count;
+  while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    buffer.append(chunk, count);
+  }
+  fclose(file);
+#endif
+
+  contents = JS_NewStringCopyUTF8N(cx, JS::UTF8Chars(buffer.data(), buffer.size()));
+  if (!contents) {
+    return false;
+  }
+  args.rval().setString(contents);
+  return true;
+}
+
+JSFunctionSpec InternalBinding::fs[] = {
+  JS_FN("statMode", statMode, /* nargs */ 1, 0),
+  JS_FN("clearStatCache", clearStatCache, 0, 0),
+  JS_FN("clearMissingPaths", clearMissingPaths, 0, 0),
+  JS_FN("readFileUtf8", readFileUtf8, 1, 0),
+  JS_FS_END
+};
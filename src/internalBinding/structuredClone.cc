@@ -0,0 +1,87 @@
+/**
+ * @file structuredClone.cc
+ * @author Philippe Laporte (philippe@distributive.network)
+ * @brief Implement functions in `internalBinding("structuredClone")`, the message serialization of workers
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026 Distributive Corp.
+ */
+
+#include "include/internalBinding.hh"
+#include "include/AutoGIL.hh"
+#include "include/jsTypeFactory.hh"
+#include "include/pyTypeFactory.hh"
+
+#include <jsapi.h>
+#include <js/StructuredClone.h>
+
+#include <Python.h>
+
+/**
+ * See function declarations in python/pythonmonkey/builtin_modules/internal-binding.d.ts :
+ *    `declare function internalBinding(namespace: "structuredClone")`
+ */
+
+static const char MESSAGE_NAME[] = "pythonmonkey.StructuredClone";
+
+/**
+ * @brief SharedArrayBuffers are shared rather than copied, between the JSContexts of the process
+ */
+static JS::CloneDataPolicy clonePolicy() {
+  JS::CloneDataPolicy policy;
+  policy.allowSharedMemoryObjects();
+  return policy;
+}
+
+/**
+ * @brief Destructor of the capsule holding a serialized message, frees the contents of ArrayBuffers transferred to it but never read
+ */
+static void destroyMessage(PyObject *message) {
+  delete (JSAutoStructuredCloneBuffer *)PyCapsule_GetPointer(message, MESSAGE_NAME);
+}
+
+static bool serialize(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+  // The SameProcess scope lets the message be read by the JSContext of any thread, and lets ArrayBuffers be transferred
+  JSAutoStructuredCloneBuffer *buffer = new JSAutoStructuredCloneBuffer(JS::StructuredCloneScope::SameProcess, nullptr, nullptr);
+  if (!buffer->write(cx, args.get(0), args.get(1), clonePolicy())) {
+    delete buffer;
+    return false;
+  }
+
+  PyObject *message = PyCapsule_New(buffer, MESSAGE_NAME, destroyMessage);
+  if (!message) {
+    delete buffer;
+    return false;
+  }
+  args.rval().set(jsTypeFactory(cx, message));
+  Py_DECREF(message);
+  return true;
+}
+
+static bool deserialize(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+  PyObject *message = pyTypeFactory(cx, args.get(0));
+  if (!message || !PyCapsule_IsValid(message, MESSAGE_NAME)) {
+    Py_XDECREF(message);
+    PyErr_Clear();
+    JS_ReportErrorASCII(cx, "deserialize expects a message returned by serialize");
+    return false;
+  }
+
+  // Transferred ArrayBuffers are moved out of the message by the first read, each message is delivered to a single receiver
+  JSAutoStructuredCloneBuffer *buffer = (JSAutoStructuredCloneBuffer *)PyCapsule_GetPointer(message, MESSAGE_NAME);
+  bool read = buffer->read(cx, args.rval(), clonePolicy());
+  Py_DECREF(message);
+  return read;
+}
+
+JSFunctionSpec InternalBinding::structuredClone[] = {
+  JS_FN("serialize", serialize, /* nargs */ 2, 0),
+  JS_FN("deserialize", deserialize, 1, 0),
+  JS_FS_END
+};
@@ -11,6 +11,7 @@
 #include "include/jsTypeFactory.hh"
 #include "include/PyEventLoop.hh"
 #include "include/setSpiderMonkeyException.hh"
+#include "include/AutoGIL.hh"
 
 #include <jsapi.h>
 #include <js/Array.h>
@@ -23,6 +24,7 @@ using AsyncHandle = PyEventLoop::AsyncHandle;
  */
 
 static bool enqueueWithDelay(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   if (PyErr_Occurred() && PyErr_ExceptionMatches(PyExc_SystemExit)) {
      // quit, exit or sys.exit was called (and raised SystemExit)
      return false;
@@ -53,6 +55,7 @@ static bool enqueueWithDelay(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool cancelByTimeoutId(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   double timeoutID = args.get(0).toNumber();
 
@@ -70,6 +73,7 @@ static bool cancelByTimeoutId(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool timerHasRef(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   double timeoutID = args.get(0).toNumber();
 
@@ -82,6 +86,7 @@ static bool timerHasRef(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool timerAddRef(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   double timeoutID = args.get(0).toNumber();
 
@@ -96,6 +101,7 @@ static bool timerAddRef(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool timerRemoveRef(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   double timeoutID = args.get(0).toNumber();
 
@@ -110,6 +116,7 @@ static bool timerRemoveRef(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool getDebugInfo(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
   double timeoutID = args.get(0).toNumber();
 
@@ -123,6 +130,7 @@ static bool getDebugInfo(JSContext *cx, unsigned argc, JS::Value *vp) {
 }
 
 static bool getAllRefedTimersDebugInfo(JSContext *cx, unsigned argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
 
   JS::RootedVector<JS::Value> results(cx);
@@ -27,6 +27,8 @@
 #include "include/ExceptionType.hh"
 #include "include/BufferType.hh"
 #include "include/setSpiderMonkeyException.hh"
+#include "include/ThreadContext.hh"
+#include "include/AutoGIL.hh"
 
 #include <jsapi.h>
 #include <jsfriendapi.h>
@@ -35,7 +37,6 @@
 #include <js/Array.h>
 
 #include <Python.h>
-#include <datetime.h>
 #include "include/pyshim.hh"
 
 #include <unordered_map>
@@ -50,7 +51,7 @@ static PyObjectProxyHandler pyObjectProxyHandler;
 static PyListProxyHandler pyListProxyHandler;
 static PyIterableProxyHandler pyIterableProxyHandler;
 
-std::unordered_map<PyObject *, size_t> externalStringObjToRefCountMap; // a map of python string objects to the number of JSExternalStrings that depend on it, used when finalizing JSExternalStrings
+thread_local std::unordered_map<PyObject *, size_t> externalStringObjToRefCountMap; // a map of python string objects to the number of JSExternalStrings that depend on it, used when finalizing JSExternalStrings on the thread of their JSContext
 
 PyObject *PythonExternalString::getPyString(const char16_t *chars)
 {
@@ -70,6 +71,7 @@ PyObject *PythonExternalString::getPyString(const JS::Latin1Char *chars)
 
 void PythonExternalString::finalize(char16_t *chars) const
 {
+  AutoAcquireGIL acquireGIL;
   // We cannot call Py_DECREF here when shutting down as the thread state is gone.
   // Then, when shutting down, there is only on reference left, and we don't need
   // to free the object since the entire process memory is being released.
@@ -133,8 +135,6 @@ size_t UCS4ToUTF16(const uint32_t *chars, size_t length, uint16_t **outStr) {
 }
 
 JS::Value jsTypeFactory(JSContext *cx, PyObject *object) {
-  if (!PyDateTimeAPI) { PyDateTime_IMPORT; } // for PyDateTime_Check
-
   JS::RootedValue returnType(cx);
 
   if (PyBool_Check(object)) {
@@ -154,8 +154,16 @@ JS::Value jsTypeFactory(JSContext *cx, PyObject *object) {
   else if (PyFloat_Check(object)) {
     returnType.setNumber(PyFloat_AsDouble(object));
   }
-  else if (PyObject_TypeCheck(object, &JSStringProxyType)) {
-    returnType.setString(((JSStringProxy *)object)->jsString->toString());
+  else if (PyObject_TypeCheck(object, JSStringProxyType())) {
+    if (ThreadContext::owns(((JSStringProxy *)object)->jsString->toString())) {
+      returnType.setString(((JSStringProxy *)object)->jsString->toString());
+    } else { // a string of another thread's context, whose characters belong to that context, is copied
+      PyObject *copy = PyUnicode_FromObject(object);
+      if (copy) {
+        returnType.set(jsTypeFactory(cx, copy));
+        Py_DECREF(copy);
+      }
+    }
   }
   else if (PyUnicode_Check(object)) {
     switch (PyUnicode_KIND(object)) {
@@ -206,7 +214,7 @@ JS::Value jsTypeFactory(JSContext *cx, PyObject *object) {
     registerArgs[0].setObject(*jsFuncObject);
     registerArgs[1].setPrivate(object);
     JS::RootedValue ignoredOutVal(GLOBAL_CX);
-    JS::RootedObject registry(GLOBAL_CX, jsFunctionRegistry);
+    JS::RootedObject registry(GLOBAL_CX, *jsFunctionRegistry);
     if (!JS_CallFunctionName(GLOBAL_CX, registry, "register", registerArgs, &ignoredOutVal)) {
       setSpiderMonkeyException(GLOBAL_CX);
       return returnType;
@@ -221,18 +229,25 @@ JS::Value jsTypeFactory(JSContext *cx, PyObject *object) {
       returnType.setUndefined();
     }
   }
-  else if (PyDateTime_Check(object)) {
+  else if (DateType::isPyDateTime(object)) {
     JSObject *dateObj = DateType::toJsDate(cx, object);
     returnType.setObject(*dateObj);
   }
   else if (PyObject_CheckBuffer(object)) {
-    JSObject *typedArray = BufferType::toJsTypedArray(cx, object); // may return null
-    returnType.setObjectOrNull(typedArray);
-  }
-  else if (PyObject_TypeCheck(object, &JSObjectProxyType)) {
-    returnType.setObject(**((JSObjectProxy *)object)->jsObject);
+    JSObject *typedArray = BufferType::toJsTypedArray(cx, object);
+    if (typedArray) {
+      returnType.setObject(*typedArray);
+    } // otherwise a Python exception is set, and undefined is returned like for the other failed conversions
+  }
+  else if (PyObject_TypeCheck(object, JSObjectProxyType())) {
+    if (ThreadContext::checkOwner(**((JSObjectProxy *)object)->jsObject)) {
+      returnType.setObject(**((JSObjectProxy *)object)->jsObject);
+    }
   }
-  else if (PyObject_TypeCheck(object, &JSMethodProxyType)) {
+  else if (PyObject_TypeCheck(object, JSMethodProxyType())) {
+    if (!ThreadContext::checkOwner(**((JSMethodProxy *)object)->jsFunc)) {
+      return returnType;
+    }
     JS::RootedObject func(cx, *((JSMethodProxy *)object)->jsFunc);
     PyObject *self = ((JSMethodProxy *)object)->self;
 
@@ -249,7 +264,7 @@ JS::Value jsTypeFactory(JSContext *cx, PyObject *object) {
     registerArgs[0].set(boundFunction);
     registerArgs[1].setPrivate(object);
     JS::RootedValue ignoredOutVal(GLOBAL_CX);
-    JS::RootedObject registry(GLOBAL_CX, jsFunctionRegistry);
+    JS::RootedObject registry(GLOBAL_CX, *jsFunctionRegistry);
     if (!JS_CallFunctionName(GLOBAL_CX, registry, "register", registerArgs, &ignoredOutVal)) {
       setSpiderMonkeyException(GLOBAL_CX);
       return returnType;
@@ -257,11 +272,15 @@ JS::Value jsTypeFactory(JSContext *cx, PyObject *object) {
 
     Py_INCREF(object);
   }
-  else if (PyObject_TypeCheck(object, &JSFunctionProxyType)) {
-    returnType.setObject(**((JSFunctionProxy *)object)->jsFunc);
+  else if (PyObject_TypeCheck(object, JSFunctionProxyType())) {
+    if (ThreadContext::checkOwner(**((JSFunctionProxy *)object)->jsFunc)) {
+      returnType.setObject(**((JSFunctionProxy *)object)->jsFunc);
+    }
   }
-  else if (PyObject_TypeCheck(object, &JSArrayProxyType)) {
-    returnType.setObject(**((JSArrayProxy *)object)->jsArray);
+  else if (PyObject_TypeCheck(object, JSArrayProxyType())) {
+    if (ThreadContext::checkOwner(**((JSArrayProxy *)object)->jsArray)) {
+      returnType.setObject(**((JSArrayProxy *)object)->jsArray);
+    }
   }
   else if (PyDict_Check(object) || PyList_Check(object)) {
     JS::RootedValue v(cx);
@@ -350,6 +369,7 @@ bool setPyException(JSContext *cx) {
 }
 
 bool callPyFunc(JSContext *cx, unsigned int argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs callargs = JS::CallArgsFromVp(argc, vp);
 
   // get the python function from the 0th reserved slot
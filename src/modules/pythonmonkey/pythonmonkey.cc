@@ -11,25 +11,45 @@
 #include "include/modules/pythonmonkey/pythonmonkey.hh"
 
 #include "include/setSpiderMonkeyException.hh"
+#include "include/BufferType.hh"
 #include "include/JSFunctionProxy.hh"
 #include "include/JSMethodProxy.hh"
 #include "include/JSArrayIterProxy.hh"
 #include "include/JSArrayProxy.hh"
+#include "include/JSArrayBufferProxy.hh"
 #include "include/JSObjectIterProxy.hh"
 #include "include/JSObjectKeysProxy.hh"
 #include "include/JSObjectValuesProxy.hh"
 #include "include/JSObjectItemsProxy.hh"
 #include "include/JSObjectProxy.hh"
 #include "include/JSStringProxy.hh"
+#include "include/GCParameters.hh"
+#include "include/GCScheduler.hh"
+#include "include/CycleCollector.hh"
+#include "include/ProxyRoots.hh"
+#include "include/JSScriptProxy.hh"
+#include "include/JSRealmProxy.hh"
+#include "include/ModuleLoader.hh"
+#include "include/ModuleState.hh"
+#include "include/ThreadContext.hh"
+#include "include/AutoGIL.hh"
+#include "include/OffThreadCompileTask.hh"
+#include "include/HelperThreads.hh"
 #include "include/pyTypeFactory.hh"
+#include "include/jsTypeFactory.hh"
+#include "include/PropertyKeyCache.hh"
+#include "include/ScriptCache.hh"
+#include "include/StencilCache.hh"
 #include "include/PyEventLoop.hh"
 #include "include/internalBinding.hh"
+#include "include/StructuredClone.hh"
 
 #include <jsapi.h>
 #include <jsfriendapi.h>
 #include <js/friend/ErrorMessages.h>
 #include <js/friend/DOMProxy.h>
 #include <js/CompilationAndEvaluation.h>
+#include <js/BuildId.h>
 #include <js/ContextOptions.h>
 #include <js/Class.h>
 #include <js/Date.h>
@@ -40,14 +60,16 @@
 #include <js/Symbol.h>
 
 #include <Python.h>
-#include <datetime.h>
 #include "include/pyshim.hh"
 
+#include <atomic>
+#include <chrono>
+#include <string>
 #include <unordered_map>
 #include <vector>
 #include <cassert>
 
-JS::PersistentRootedObject jsFunctionRegistry;
+thread_local JS::PersistentRootedObject *jsFunctionRegistry = nullptr;
 
 /**
  * @brief During a GC, string buffers may have moved, so we need to re-point our JSStringProxies
@@ -59,8 +81,9 @@ void updateCharBufferPointers() {
   }
 
   JS::AutoCheckCannotGC nogc;
+  std::lock_guard<std::mutex> lock(jsStringProxiesMutex);
   for (const JSStringProxy *jsStringProxy: jsStringProxies) {
-    JSLinearString *str = JS_ASSERT_STRING_IS_LINEAR(jsStringProxy->jsString->toString());
+    JSLinearString *str = JS_ASSERT_STRING_IS_LINEAR(jsStringProxy->jsString->unbarrieredGet());
     void *updatedCharBufPtr; // pointer to the moved char buffer after a GC
     if (JS::LinearStringHasLatin1Chars(str)) {
       updatedCharBufPtr = (void *)JS::GetLatin1LinearStringChars(nogc, str);
@@ -72,44 +95,45 @@ void updateCharBufferPointers() {
 }
 
 void pythonmonkeyGCCallback(JSContext *cx, JSGCStatus status, JS::GCReason reason, void *data) {
+  AutoAcquireGIL acquireGIL;
   if (status == JSGCStatus::JSGC_END) {
-    JS::ClearKeptObjects(GLOBAL_CX);
-    while (JOB_QUEUE->runFinalizationRegistryCallbacks(GLOBAL_CX));
+    JobQueue *jobQueue = (JobQueue *)data; // the job queue of `cx`
+    JS::ClearKeptObjects(cx);
+    GCScheduler::onGCEnd(cx);
+    while (jobQueue->runFinalizationRegistryCallbacks(cx));
+    BufferType::releasePendingPyBuffers();
     updateCharBufferPointers();
   }
 }
 
 void nurseryCollectionCallback(JSContext *cx, JS::GCNurseryProgress progress, JS::GCReason reason, void *data) {
+  AutoAcquireGIL acquireGIL;
   if (progress == JS::GCNurseryProgress::GC_NURSERY_COLLECTION_END) {
     updateCharBufferPointers();
   }
 }
 
 bool functionRegistryCallback(JSContext *cx, unsigned int argc, JS::Value *vp) {
+  AutoAcquireGIL acquireGIL;
   JS::CallArgs callargs = JS::CallArgsFromVp(argc, vp);
   Py_DECREF((PyObject *)callargs[0].toPrivate());
   return true;
 }
 
-static void cleanupFinalizationRegistry(JSFunction *callback, JSObject *global [[maybe_unused]], void *user_data [[maybe_unused]]) {
-  JOB_QUEUE->queueFinalizationRegistryCallback(callback);
+static void cleanupFinalizationRegistry(JSFunction *callback, JSObject *global [[maybe_unused]], void *user_data) {
+  ((JobQueue *)user_data)->queueFinalizationRegistryCallback(callback);
 }
 
-static PyObject *PythonMonkey_Null;
-static PyObject *PythonMonkey_BigInt;
-
 PyObject *getPythonMonkeyNull() {
-  if (!PythonMonkey_Null) {
-    PythonMonkey_Null = PyObject_GetAttrString(PyState_FindModule(&pythonmonkey), "null");
-  }
-  return PythonMonkey_Null;
+  return (PyObject *)ModuleState::current()->NullType;
 }
 
 PyObject *getPythonMonkeyBigInt() {
-  if (!PythonMonkey_BigInt) {
-    PythonMonkey_BigInt = PyObject_GetAttrString(PyState_FindModule(&pythonmonkey), "bigint");
-  }
-  return PythonMonkey_BigInt;
+  return (PyObject *)ModuleState::current()->BigIntType;
+}
+
+PyObject *SpiderMonkeyError() {
+  return ModuleState::current()->SpiderMonkeyError;
 }
 
 
@@ -117,203 +141,363 @@ typedef struct {
   PyObject_HEAD
 } NullObject;
 
-static PyTypeObject NullType = {
-  .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-  .tp_name = "pythonmonkey.null",
-  .tp_basicsize = sizeof(NullObject),
-  .tp_flags = Py_TPFLAGS_DEFAULT,
-  .tp_doc = PyDoc_STR("Javascript null object")
-};
-
-static PyTypeObject BigIntType = {
-  .tp_name = PyLong_Type.tp_name,
-  .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_LONG_SUBCLASS,
-  .tp_doc = PyDoc_STR("Javascript BigInt object"),
-  .tp_base = &PyLong_Type
-};
-
-PyTypeObject JSObjectProxyType = {
-  .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-  .tp_name = PyDict_Type.tp_name,
-  .tp_basicsize = sizeof(JSObjectProxy),
-  .tp_itemsize = 0,
-  .tp_dealloc = (destructor)JSObjectProxyMethodDefinitions::JSObjectProxy_dealloc,
-  .tp_repr = (reprfunc)JSObjectProxyMethodDefinitions::JSObjectProxy_repr,
-  .tp_as_number = &JSObjectProxy_number_methods,
-  .tp_as_sequence = &JSObjectProxy_sequence_methods,
-  .tp_as_mapping = &JSObjectProxy_mapping_methods,
-  .tp_getattro = (getattrofunc)JSObjectProxyMethodDefinitions::JSObjectProxy_get,
-  .tp_setattro = (setattrofunc)JSObjectProxyMethodDefinitions::JSObjectProxy_assign,
-  .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DICT_SUBCLASS | Py_TPFLAGS_HAVE_GC,
-  .tp_doc = PyDoc_STR("Javascript Object proxy dict"),
-  .tp_traverse = (traverseproc)JSObjectProxyMethodDefinitions::JSObjectProxy_traverse,
-  .tp_clear = (inquiry)JSObjectProxyMethodDefinitions::JSObjectProxy_clear,
-  .tp_richcompare = (richcmpfunc)JSObjectProxyMethodDefinitions::JSObjectProxy_richcompare,
-  .tp_iter = (getiterfunc)JSObjectProxyMethodDefinitions::JSObjectProxy_iter,
-  .tp_iternext = (iternextfunc)JSObjectProxyMethodDefinitions::JSObjectProxy_iter_next,
-  .tp_methods = JSObjectProxy_methods,
-  .tp_base = &PyDict_Type
-};
-
-PyTypeObject JSStringProxyType = {
-  .tp_name = PyUnicode_Type.tp_name,
-  .tp_basicsize = sizeof(JSStringProxy),
-  .tp_dealloc = (destructor)JSStringProxyMethodDefinitions::JSStringProxy_dealloc,
-  .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_UNICODE_SUBCLASS,
-  .tp_doc = PyDoc_STR("Javascript String proxy"),
-  .tp_methods = JSStringProxy_methods,
-  .tp_base = &PyUnicode_Type
-};
-
-PyTypeObject JSFunctionProxyType = {
-  .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-  .tp_name = "pythonmonkey.JSFunctionProxy",
-  .tp_basicsize = sizeof(JSFunctionProxy),
-  .tp_dealloc = (destructor)JSFunctionProxyMethodDefinitions::JSFunctionProxy_dealloc,
-  .tp_call = JSFunctionProxyMethodDefinitions::JSFunctionProxy_call,
-  .tp_flags = Py_TPFLAGS_DEFAULT,
-  .tp_doc = PyDoc_STR("Javascript Function proxy object"),
-  .tp_new = JSFunctionProxyMethodDefinitions::JSFunctionProxy_new
-};
-
-PyTypeObject JSMethodProxyType = {
-  .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-  .tp_name = "pythonmonkey.JSMethodProxy",
-  .tp_basicsize = sizeof(JSMethodProxy),
-  .tp_dealloc = (destructor)JSMethodProxyMethodDefinitions::JSMethodProxy_dealloc,
-  .tp_call = JSMethodProxyMethodDefinitions::JSMethodProxy_call,
-  .tp_flags = Py_TPFLAGS_DEFAULT,
-  .tp_doc = PyDoc_STR("Javascript Method proxy object"),
-  .tp_new = JSMethodProxyMethodDefinitions::JSMethodProxy_new
-};
-
-PyTypeObject JSArrayProxyType = {
-  .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-  .tp_name = PyList_Type.tp_name,
-  .tp_basicsize = sizeof(JSArrayProxy),
-  .tp_itemsize = 0,
-  .tp_dealloc = (destructor)JSArrayProxyMethodDefinitions::JSArrayProxy_dealloc,
-  .tp_repr = (reprfunc)JSArrayProxyMethodDefinitions::JSArrayProxy_repr,
-  .tp_as_sequence = &JSArrayProxy_sequence_methods,
-  .tp_as_mapping = &JSArrayProxy_mapping_methods,
-  .tp_getattro = (getattrofunc)JSArrayProxyMethodDefinitions::JSArrayProxy_get,
-  .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_LIST_SUBCLASS | Py_TPFLAGS_HAVE_GC,
-  .tp_doc = PyDoc_STR("Javascript Array proxy list"),
-  .tp_traverse = (traverseproc)JSArrayProxyMethodDefinitions::JSArrayProxy_traverse,
-  .tp_clear = (inquiry)JSArrayProxyMethodDefinitions::JSArrayProxy_clear,
-  .tp_richcompare = (richcmpfunc)JSArrayProxyMethodDefinitions::JSArrayProxy_richcompare,
-  .tp_iter = (getiterfunc)JSArrayProxyMethodDefinitions::JSArrayProxy_iter,
-  .tp_methods = JSArrayProxy_methods,
-  .tp_base = &PyList_Type
-};
-
-PyTypeObject JSArrayIterProxyType = {
-  .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-  .tp_name = PyListIter_Type.tp_name,
-  .tp_basicsize = sizeof(JSArrayIterProxy),
-  .tp_itemsize = 0,
-  .tp_dealloc = (destructor)JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_dealloc,
-  .tp_getattro = PyObject_GenericGetAttr,
-  .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
-  .tp_doc = PyDoc_STR("Javascript Array proxy iterator"),
-  .tp_traverse =  (traverseproc)JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_traverse,
-  .tp_clear = (inquiry)JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_clear,
-  .tp_iter = (getiterfunc)JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_iter,
-  .tp_iternext = (iternextfunc)JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_next,
-  .tp_methods = JSArrayIterProxy_methods,
-  .tp_base = &PyListIter_Type
-};
-
-PyTypeObject JSObjectIterProxyType = {
-  .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-  .tp_name = PyDictIterKey_Type.tp_name,
-  .tp_basicsize = sizeof(JSObjectIterProxy),
-  .tp_itemsize = 0,
-  .tp_dealloc = (destructor)JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_dealloc,
-  .tp_getattro = PyObject_GenericGetAttr,
-  .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
-  .tp_doc = PyDoc_STR("Javascript Object proxy key iterator"),
-  .tp_traverse =  (traverseproc)JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_traverse,
-  .tp_clear = (inquiry)JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_clear,
-  .tp_iter = (getiterfunc)JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_iter,
-  .tp_iternext = (iternextfunc)JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_nextkey,
-  .tp_methods = JSObjectIterProxy_methods,
-  .tp_base = &PyDictIterKey_Type
-};
-
-PyTypeObject JSObjectKeysProxyType = {
-  .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-  .tp_name = PyDictKeys_Type.tp_name,
-  .tp_basicsize = sizeof(JSObjectKeysProxy),
-  .tp_itemsize = 0,
-  .tp_dealloc = (destructor)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_dealloc,
-  .tp_repr = (reprfunc)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_repr,
-  .tp_as_number = &JSObjectKeysProxy_number_methods,
-  .tp_as_sequence = &JSObjectKeysProxy_sequence_methods,
-  .tp_getattro = PyObject_GenericGetAttr,
-  .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
-  .tp_doc = PyDoc_STR("Javascript Object Keys proxy"),
-  .tp_traverse =  (traverseproc)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_traverse,
-  .tp_clear = (inquiry)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_clear,
-  .tp_richcompare = (richcmpfunc)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_richcompare,
-  .tp_iter = (getiterfunc)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_iter,
-  .tp_methods = JSObjectKeysProxy_methods,
-  .tp_getset = JSObjectKeysProxy_getset,
-  .tp_base = &PyDictKeys_Type
-};
-
-PyTypeObject JSObjectValuesProxyType = {
-  .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-  .tp_name = PyDictValues_Type.tp_name,
-  .tp_basicsize = sizeof(JSObjectValuesProxy),
-  .tp_itemsize = 0,
-  .tp_dealloc = (destructor)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_dealloc,
-  .tp_repr = (reprfunc)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_repr,
-  .tp_as_sequence = &JSObjectValuesProxy_sequence_methods,
-  .tp_getattro = PyObject_GenericGetAttr,
-  .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
-  .tp_doc = PyDoc_STR("Javascript Object Values proxy"),
-  .tp_traverse =  (traverseproc)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_traverse,
-  .tp_clear = (inquiry)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_clear,
-  .tp_iter = (getiterfunc)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_iter,
-  .tp_methods = JSObjectValuesProxy_methods,
-  .tp_getset = JSObjectValuesProxy_getset,
-  .tp_base = &PyDictValues_Type
-};
-
-PyTypeObject JSObjectItemsProxyType = {
-  .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-  .tp_name = PyDictKeys_Type.tp_name,
-  .tp_basicsize = sizeof(JSObjectItemsProxy),
-  .tp_itemsize = 0,
-  .tp_dealloc = (destructor)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_dealloc,
-  .tp_repr = (reprfunc)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_repr,
-  // .tp_as_number = defaults are fine
-  .tp_as_sequence = &JSObjectItemsProxy_sequence_methods,
-  .tp_getattro = PyObject_GenericGetAttr,
-  .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
-  .tp_doc = PyDoc_STR("Javascript Object Items proxy"),
-  .tp_traverse =  (traverseproc)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_traverse,
-  .tp_clear = (inquiry)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_clear,
-  // .tp_richcompare = TODO tuple support
-  .tp_iter = (getiterfunc)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_iter,
-  .tp_methods = JSObjectItemsProxy_methods,
-  .tp_getset = JSObjectItemsProxy_getset,
-  .tp_base = &PyDictKeys_Type
+static PyType_Slot NullType_slots[] = {
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript null object")},
+  {0, NULL}
 };
 
-static void cleanup() {
-  // Clean up the PythonMonkey module
-  Py_XDECREF(PythonMonkey_Null);
-  Py_XDECREF(PythonMonkey_BigInt);
+static PyType_Spec NullType_spec = {
+  .name = "pythonmonkey.null",
+  .basicsize = sizeof(NullObject),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_DISALLOW_INSTANTIATION,
+  .slots = NullType_slots
+};
+
+static PyType_Slot BigIntType_slots[] = {
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript BigInt object")},
+  {0, NULL}
+};
+
+static PyType_Spec BigIntType_spec = {
+  .name = PyLong_Type.tp_name,
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_LONG_SUBCLASS | Py_TPFLAGS_IMMUTABLETYPE,
+  .slots = BigIntType_slots
+};
+
+static PyType_Slot JSObjectProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_dealloc},
+  {Py_tp_repr, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_repr},
+  {Py_nb_or, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_or},
+  {Py_nb_inplace_or, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_ior},
+  {Py_sq_contains, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_contains},
+  {Py_mp_length, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_length},
+  {Py_mp_subscript, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_get_subscript},
+  {Py_mp_ass_subscript, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_assign},
+  {Py_tp_getattro, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_get},
+  {Py_tp_setattro, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_assign},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript Object proxy dict")},
+  {Py_tp_traverse, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_traverse},
+  {Py_tp_clear, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_clear},
+  {Py_tp_richcompare, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_richcompare},
+  {Py_tp_iter, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_iter},
+  {Py_tp_iternext, (void *)JSObjectProxyMethodDefinitions::JSObjectProxy_iter_next},
+  {Py_tp_methods, JSObjectProxy_methods},
+  {0, NULL}
+};
+
+static PyType_Spec JSObjectProxyType_spec = {
+  .name = PyDict_Type.tp_name,
+  .basicsize = sizeof(JSObjectProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_DICT_SUBCLASS | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_IMMUTABLETYPE,
+  .slots = JSObjectProxyType_slots
+};
+
+static PyType_Slot JSStringProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSStringProxyMethodDefinitions::JSStringProxy_dealloc},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript String proxy")},
+  {Py_tp_methods, JSStringProxy_methods},
+  {0, NULL}
+};
+
+static PyType_Spec JSStringProxyType_spec = {
+  .name = PyUnicode_Type.tp_name,
+  .basicsize = sizeof(JSStringProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_UNICODE_SUBCLASS | Py_TPFLAGS_IMMUTABLETYPE,
+  .slots = JSStringProxyType_slots
+};
+
+static PyType_Slot JSFunctionProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSFunctionProxyMethodDefinitions::JSFunctionProxy_dealloc},
+  {Py_tp_call, (void *)JSFunctionProxyMethodDefinitions::JSFunctionProxy_call},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript Function proxy object")},
+  {Py_tp_new, (void *)JSFunctionProxyMethodDefinitions::JSFunctionProxy_new},
+  {Py_tp_traverse, (void *)JSFunctionProxyMethodDefinitions::JSFunctionProxy_traverse},
+  {Py_tp_clear, (void *)JSFunctionProxyMethodDefinitions::JSFunctionProxy_clear},
+  {0, NULL}
+};
+
+static PyType_Spec JSFunctionProxyType_spec = {
+  .name = "pythonmonkey.JSFunctionProxy",
+  .basicsize = sizeof(JSFunctionProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_IMMUTABLETYPE,
+  .slots = JSFunctionProxyType_slots
+};
+
+static PyType_Slot JSMethodProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSMethodProxyMethodDefinitions::JSMethodProxy_dealloc},
+  {Py_tp_call, (void *)JSMethodProxyMethodDefinitions::JSMethodProxy_call},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript Method proxy object")},
+  {Py_tp_new, (void *)JSMethodProxyMethodDefinitions::JSMethodProxy_new},
+  {0, NULL}
+};
+
+static PyType_Spec JSMethodProxyType_spec = {
+  .name = "pythonmonkey.JSMethodProxy",
+  .basicsize = sizeof(JSMethodProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE,
+  .slots = JSMethodProxyType_slots
+};
+
+static PyType_Slot JSArrayProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_dealloc},
+  {Py_tp_repr, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_repr},
+  {Py_sq_length, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_length},
+  {Py_sq_concat, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_concat},
+  {Py_sq_repeat, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_repeat},
+  {Py_sq_contains, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_contains},
+  {Py_sq_inplace_concat, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_inplace_concat},
+  {Py_sq_inplace_repeat, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_inplace_repeat},
+  {Py_mp_length, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_length},
+  {Py_mp_subscript, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_get_subscript},
+  {Py_mp_ass_subscript, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_assign_key},
+  {Py_tp_getattro, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_get},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript Array proxy list")},
+  {Py_tp_traverse, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_traverse},
+  {Py_tp_clear, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_clear},
+  {Py_tp_richcompare, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_richcompare},
+  {Py_tp_iter, (void *)JSArrayProxyMethodDefinitions::JSArrayProxy_iter},
+  {Py_tp_methods, JSArrayProxy_methods},
+  {0, NULL}
+};
+
+static PyType_Spec JSArrayProxyType_spec = {
+  .name = PyList_Type.tp_name,
+  .basicsize = sizeof(JSArrayProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_LIST_SUBCLASS | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_IMMUTABLETYPE,
+  .slots = JSArrayProxyType_slots
+};
 
+static PyType_Slot JSArrayBufferProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_dealloc},
+#if PY_VERSION_HEX >= 0x03090000 // the buffer slots are set by createTypes on Python 3.8
+  {Py_bf_getbuffer, (void *)JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_getbuffer},
+  {Py_bf_releasebuffer, (void *)JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_releasebuffer},
+#endif
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript ArrayBuffer or TypedArray exporting its memory through the buffer protocol")},
+  {0, NULL}
+};
+
+static PyType_Spec JSArrayBufferProxyType_spec = {
+  .name = "pythonmonkey.JSArrayBufferProxy",
+  .basicsize = sizeof(JSArrayBufferProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_DISALLOW_INSTANTIATION,
+  .slots = JSArrayBufferProxyType_slots
+};
+
+static PyType_Slot JSScriptProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSScriptProxyMethodDefinitions::JSScriptProxy_dealloc},
+  {Py_tp_call, (void *)JSScriptProxyMethodDefinitions::JSScriptProxy_call},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript compiled script")},
+  {0, NULL}
+};
+
+static PyType_Spec JSScriptProxyType_spec = {
+  .name = "pythonmonkey.JSScriptProxy",
+  .basicsize = sizeof(JSScriptProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_DISALLOW_INSTANTIATION,
+  .slots = JSScriptProxyType_slots
+};
+
+static PyType_Slot JSRealmProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSRealmProxyMethodDefinitions::JSRealmProxy_dealloc},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript realm, with its own global object and standard classes")},
+  {Py_tp_methods, JSRealmProxy_methods},
+  {Py_tp_getset, JSRealmProxy_getset},
+  {Py_tp_new, (void *)JSRealmProxyMethodDefinitions::JSRealmProxy_new},
+  {0, NULL}
+};
+
+static PyType_Spec JSRealmProxyType_spec = {
+  .name = "pythonmonkey.Realm",
+  .basicsize = sizeof(JSRealmProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE,
+  .slots = JSRealmProxyType_slots
+};
+
+// The iterator and view proxies below cannot subclass the iterator and view types of list and dict, which are final.
+// They get their number methods and comparisons from the dict views instead, and are registered as collections.abc views by __init__.py.
+
+static PyType_Slot JSArrayIterProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_dealloc},
+  {Py_tp_getattro, (void *)PyObject_GenericGetAttr},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript Array proxy iterator")},
+  {Py_tp_traverse, (void *)JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_traverse},
+  {Py_tp_clear, (void *)JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_clear},
+  {Py_tp_iter, (void *)JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_iter},
+  {Py_tp_iternext, (void *)JSArrayIterProxyMethodDefinitions::JSArrayIterProxy_next},
+  {Py_tp_methods, JSArrayIterProxy_methods},
+  {0, NULL}
+};
+
+static PyType_Spec JSArrayIterProxyType_spec = {
+  .name = PyListIter_Type.tp_name,
+  .basicsize = sizeof(JSArrayIterProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_DISALLOW_INSTANTIATION,
+  .slots = JSArrayIterProxyType_slots
+};
+
+static PyType_Slot JSObjectIterProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_dealloc},
+  {Py_tp_getattro, (void *)PyObject_GenericGetAttr},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript Object proxy key iterator")},
+  {Py_tp_traverse, (void *)JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_traverse},
+  {Py_tp_clear, (void *)JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_clear},
+  {Py_tp_iter, (void *)JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_iter},
+  {Py_tp_iternext, (void *)JSObjectIterProxyMethodDefinitions::JSObjectIterProxy_nextkey},
+  {Py_tp_methods, JSObjectIterProxy_methods},
+  {0, NULL}
+};
+
+static PyType_Spec JSObjectIterProxyType_spec = {
+  .name = PyDictIterKey_Type.tp_name,
+  .basicsize = sizeof(JSObjectIterProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_DISALLOW_INSTANTIATION,
+  .slots = JSObjectIterProxyType_slots
+};
+
+static PyType_Slot JSObjectKeysProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_dealloc},
+  {Py_tp_repr, (void *)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_repr},
+  {Py_nb_subtract, (void *)PyDictKeys_Type.tp_as_number->nb_subtract},
+  {Py_nb_and, (void *)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_intersect},
+  {Py_nb_xor, (void *)PyDictKeys_Type.tp_as_number->nb_xor},
+  {Py_nb_or, (void *)PyDictKeys_Type.tp_as_number->nb_or},
+  {Py_sq_length, (void *)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_length},
+  {Py_sq_contains, (void *)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_contains},
+  {Py_tp_getattro, (void *)PyObject_GenericGetAttr},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript Object Keys proxy")},
+  {Py_tp_traverse, (void *)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_traverse},
+  {Py_tp_clear, (void *)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_clear},
+  {Py_tp_richcompare, (void *)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_richcompare},
+  {Py_tp_iter, (void *)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_iter},
+  {Py_tp_methods, JSObjectKeysProxy_methods},
+  {Py_tp_getset, JSObjectKeysProxy_getset},
+  {0, NULL}
+};
+
+static PyType_Spec JSObjectKeysProxyType_spec = {
+  .name = PyDictKeys_Type.tp_name,
+  .basicsize = sizeof(JSObjectKeysProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_DISALLOW_INSTANTIATION,
+  .slots = JSObjectKeysProxyType_slots
+};
+
+static PyType_Slot JSObjectValuesProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_dealloc},
+  {Py_tp_repr, (void *)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_repr},
+  {Py_sq_length, (void *)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_length},
+  {Py_sq_contains, (void *)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_contains},
+  {Py_tp_getattro, (void *)PyObject_GenericGetAttr},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript Object Values proxy")},
+  {Py_tp_traverse, (void *)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_traverse},
+  {Py_tp_clear, (void *)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_clear},
+  {Py_tp_iter, (void *)JSObjectValuesProxyMethodDefinitions::JSObjectValuesProxy_iter},
+  {Py_tp_methods, JSObjectValuesProxy_methods},
+  {Py_tp_getset, JSObjectValuesProxy_getset},
+  {0, NULL}
+};
+
+static PyType_Spec JSObjectValuesProxyType_spec = {
+  .name = PyDictValues_Type.tp_name,
+  .basicsize = sizeof(JSObjectValuesProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_DISALLOW_INSTANTIATION,
+  .slots = JSObjectValuesProxyType_slots
+};
+
+static PyType_Slot JSObjectItemsProxyType_slots[] = {
+  {Py_tp_dealloc, (void *)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_dealloc},
+  {Py_tp_repr, (void *)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_repr},
+  {Py_nb_subtract, (void *)PyDictKeys_Type.tp_as_number->nb_subtract},
+  {Py_nb_and, (void *)JSObjectKeysProxyMethodDefinitions::JSObjectKeysProxy_intersect},
+  {Py_nb_xor, (void *)PyDictKeys_Type.tp_as_number->nb_xor},
+  {Py_nb_or, (void *)PyDictKeys_Type.tp_as_number->nb_or},
+  {Py_sq_length, (void *)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_length},
+  // {Py_sq_contains, TODO tuple support},
+  {Py_tp_getattro, (void *)PyObject_GenericGetAttr},
+  {Py_tp_doc, (void *)PyDoc_STR("Javascript Object Items proxy")},
+  {Py_tp_traverse, (void *)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_traverse},
+  {Py_tp_clear, (void *)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_clear},
+  {Py_tp_richcompare, (void *)PyDictKeys_Type.tp_richcompare}, // TODO tuple support
+  {Py_tp_iter, (void *)JSObjectItemsProxyMethodDefinitions::JSObjectItemsProxy_iter},
+  {Py_tp_methods, JSObjectItemsProxy_methods},
+  {Py_tp_getset, JSObjectItemsProxy_getset},
+  {0, NULL}
+};
+
+static PyType_Spec JSObjectItemsProxyType_spec = {
+  .name = PyDictKeys_Type.tp_name,
+  .basicsize = sizeof(JSObjectItemsProxy),
+  .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_DISALLOW_INSTANTIATION,
+  .slots = JSObjectItemsProxyType_slots
+};
+
+/**
+ * @brief Create a heap type from its spec
+ *
+ * @param base - the base type, or nullptr for object
+ * @return the new type, or nullptr with an exception set
+ */
+static PyTypeObject *newType(PyType_Spec *spec, PyTypeObject *base) {
+  PyObject *bases = base ? PyTuple_Pack(1, (PyObject *)base) : NULL;
+  if (base && !bases) {
+    return nullptr;
+  }
+  PyTypeObject *type = (PyTypeObject *)PyType_FromSpecWithBases(spec, bases);
+  Py_XDECREF(bases);
+#if PY_VERSION_HEX < 0x030a0000 // Py_TPFLAGS_DISALLOW_INSTANTIATION is not available
+  if (type && !base && type->tp_new == PyBaseObject_Type.tp_new) {
+    type->tp_new = NULL;
+  }
+#endif
+  return type;
+}
+
+/**
+ * @brief Create the types of the module state of an interpreter
+ *
+ * @return false with an exception set if a type could not be created
+ */
+static bool createTypes(ModuleState *state) {
+  if (!(state->NullType = newType(&NullType_spec, nullptr)) ||
+      !(state->BigIntType = newType(&BigIntType_spec, &PyLong_Type)) ||
+      !(state->JSObjectProxyType = newType(&JSObjectProxyType_spec, &PyDict_Type)) ||
+      !(state->JSStringProxyType = newType(&JSStringProxyType_spec, &PyUnicode_Type)) ||
+      !(state->JSFunctionProxyType = newType(&JSFunctionProxyType_spec, nullptr)) ||
+      !(state->JSMethodProxyType = newType(&JSMethodProxyType_spec, nullptr)) ||
+      !(state->JSArrayProxyType = newType(&JSArrayProxyType_spec, &PyList_Type)) ||
+      !(state->JSArrayBufferProxyType = newType(&JSArrayBufferProxyType_spec, nullptr)) ||
+      !(state->JSScriptProxyType = newType(&JSScriptProxyType_spec, nullptr)) ||
+      !(state->JSRealmProxyType = newType(&JSRealmProxyType_spec, nullptr)) ||
+      !(state->JSArrayIterProxyType = newType(&JSArrayIterProxyType_spec, nullptr)) ||
+      !(state->JSObjectIterProxyType = newType(&JSObjectIterProxyType_spec, nullptr)) ||
+      !(state->JSObjectKeysProxyType = newType(&JSObjectKeysProxyType_spec, nullptr)) ||
+      !(state->JSObjectValuesProxyType = newType(&JSObjectValuesProxyType_spec, nullptr)) ||
+      !(state->JSObjectItemsProxyType = newType(&JSObjectItemsProxyType_spec, nullptr))) {
+    return false;
+  }
+#if PY_VERSION_HEX < 0x03090000 // Py_bf_getbuffer and Py_bf_releasebuffer are not available
+  state->JSArrayBufferProxyType->tp_as_buffer->bf_getbuffer = (getbufferproc)JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_getbuffer;
+  state->JSArrayBufferProxyType->tp_as_buffer->bf_releasebuffer = (releasebufferproc)JSArrayBufferProxyMethodDefinitions::JSArrayBufferProxy_releasebuffer;
+#endif
+  return true;
+}
+
+static void cleanup() {
   // Clean up SpiderMonkey
+  PropertyKeyCache::clear();
+  ScriptCache::clear();
+  delete jsFunctionRegistry;
+  jsFunctionRegistry = nullptr;
   delete autoRealm;
   delete global;
   if (GLOBAL_CX) {
+    ProxyRoots::destroyContext(GLOBAL_CX);
     JS_DestroyContext(GLOBAL_CX);
     GLOBAL_CX = nullptr;
   }
+  if (!Py_IsFinalizing()) {
+    BufferType::releasePendingPyBuffers();
+  }
   delete JOB_QUEUE;
   JS_ShutDown();
 }
@@ -321,14 +505,65 @@ static void cleanup(PyObject *) {
   cleanup();
 }
 
-static PyObject *collect(PyObject *self, PyObject *args) {
-  JS_GC(GLOBAL_CX);
+static PyObject *collect(PyObject *self, PyObject *args, PyObject *kwargs) {
+  static const char *keywords[] = {"kind", "budget_ms", NULL};
+  const char *kindName = "full";
+  long long budgetMs = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|s$L:collect", (char **)keywords, &kindName, &budgetMs)) {
+    return NULL;
+  }
+  GCScheduler::Kind kind;
+  if (!GCScheduler::parseKind(kindName, &kind)) {
+    return NULL;
+  }
+  if (budgetMs < 0) {
+    PyErr_SetString(PyExc_ValueError, "budget_ms must not be negative");
+    return NULL;
+  }
+  if (!GLOBAL_CX) { // this thread has not used JavaScript yet
+    Py_RETURN_TRUE;
+  }
+  bool finished = GCScheduler::collect(GLOBAL_CX, kind, budgetMs);
+  BufferType::releasePendingPyBuffers();
+  return PyBool_FromLong(finished);
+}
+
+static PyObject *setIdleGC(PyObject *Py_UNUSED(self), PyObject *args, PyObject *kwargs) {
+  return GCScheduler::configure(args, kwargs);
+}
+
+static PyObject *gcInfo(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(_)) {
+  return GCScheduler::info();
+}
+
+static PyObject *setCycleCollection(PyObject *Py_UNUSED(self), PyObject *enabled) {
+  return CycleCollector::configure(enabled);
+}
+
+static PyObject *beforeFork(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(_)) {
+  HelperThreads::beforeFork();
   Py_RETURN_NONE;
 }
 
+static PyObject *afterFork(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(_)) {
+  HelperThreads::afterFork();
+  Py_RETURN_NONE;
+}
+
+static PyObject *setGCParams(PyObject *Py_UNUSED(self), PyObject *args, PyObject *kwargs) {
+  return GCParameters::set(args, kwargs);
+}
+
+static PyObject *getGCParams(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(_)) {
+  if (!ThreadContext::ensure()) {
+    return NULL;
+  }
+  return GCParameters::get(GLOBAL_CX);
+}
+
 static bool getEvalOption(PyObject *evalOptions, const char *optionName, const char **s_p) {
   PyObject *value;
-  if (PyObject_TypeCheck(evalOptions, &JSObjectProxyType)) {
+  if (PyObject_TypeCheck(evalOptions, JSObjectProxyType())) {
     value = PyMapping_GetItemString(evalOptions, optionName);
   } else {
     value = PyDict_GetItemString(evalOptions, optionName);
@@ -341,7 +576,7 @@ static bool getEvalOption(PyObject *evalOptions, const char *optionName, const c
 
 static bool getEvalOption(PyObject *evalOptions, const char *optionName, unsigned long *l_p) {
   PyObject *value;
-  if (PyObject_TypeCheck(evalOptions, &JSObjectProxyType)) {
+  if (PyObject_TypeCheck(evalOptions, JSObjectProxyType())) {
     value = PyMapping_GetItemString(evalOptions, optionName);
     if (value && value != Py_None) {
       *l_p = (unsigned long)PyFloat_AsDouble(value);
@@ -357,7 +592,7 @@ static bool getEvalOption(PyObject *evalOptions, const char *optionName, unsigne
 
 static bool getEvalOption(PyObject *evalOptions, const char *optionName, bool *b_p) {
   PyObject *value;
-  if (PyObject_TypeCheck(evalOptions, &JSObjectProxyType)) {
+  if (PyObject_TypeCheck(evalOptions, JSObjectProxyType())) {
     value = PyMapping_GetItemString(evalOptions, optionName);
   } else {
     value = PyDict_GetItemString(evalOptions, optionName);
@@ -369,106 +604,121 @@ static bool getEvalOption(PyObject *evalOptions, const char *optionName, bool *b
 }
 
 /**
- * Implement the pythonmonkey.eval function. From Python-land, that function has the following API:
+ * @brief Resolve the options of pythonmonkey.eval and pythonmonkey.compile, which roughly correspond to the jsapi CompileOptions
+ */
+static void getScriptOptions(PyObject *evalOptions, ScriptOptions &scriptOptions) {
+  const char *s;
+  unsigned long l;
+  bool b;
+
+  if (getEvalOption(evalOptions, "filename", &s)) scriptOptions.filename = s;
+  if (getEvalOption(evalOptions, "lineno", &l)) scriptOptions.lineno = l;
+  if (getEvalOption(evalOptions, "column", &l)) scriptOptions.column = l;
+  if (getEvalOption(evalOptions, "mutedErrors", &b)) scriptOptions.mutedErrors = b;
+  if (getEvalOption(evalOptions, "noScriptRval", &b)) scriptOptions.noScriptRval = b;
+  if (getEvalOption(evalOptions, "selfHosting", &b)) scriptOptions.selfHosting = b;
+  if (getEvalOption(evalOptions, "strict", &b)) scriptOptions.strict = b;
+  if (getEvalOption(evalOptions, "module", &b)) scriptOptions.module = b;
+
+  if (getEvalOption(evalOptions, "fromPythonFrame", &b) && b) {
+#if PY_VERSION_HEX >= 0x03090000
+    PyFrameObject *frame = PyEval_GetFrame();
+    if (frame && !getEvalOption(evalOptions, "lineno", &l)) {
+      scriptOptions.lineno = PyFrame_GetLineNumber(frame);
+    } /* lineno */
+#endif
+#if 0 && (PY_VERSION_HEX >= 0x030a0000) && (PY_VERSION_HEX < 0x030c0000)
+    PyObject *filename = PyDict_GetItemString(frame->f_builtins, "__file__");
+#elif (PY_VERSION_HEX >= 0x030c0000)
+    PyObject *filename = PyDict_GetItemString(PyFrame_GetGlobals(frame), "__file__");
+#else
+    PyObject *filename = NULL;
+#endif
+    if (!getEvalOption(evalOptions, "filename", &s)) {
+      if (filename && PyUnicode_Check(filename)) {
+        PyObject *filenameStr = PyUnicode_FromObject(filename); // needs a strict Python str object (not a subtype)
+        scriptOptions.filename = PyUnicode_AsUTF8(filenameStr);
+        Py_DECREF(filenameStr);
+      }
+    } /* filename */
+  } /* fromPythonFrame */
+}
+
+/**
+ * @brief Parse the arguments shared by pythonmonkey.eval and pythonmonkey.compile:
  * argument 0 - unicode string of JS code or open file containing JS code in UTF-8
- * argument 1 - a Dict of options which roughly correspond to the jsapi CompileOptions. A novel option,
- *              fromPythonFrame, sets the filename and line offset according to the pm.eval call in the
- *              Python source code. This allows us to embed non-trivial JS inside Python source files
- *              and still get stack dumps which point to the source code.
+ * argument 1 - a Dict of options, see getScriptOptions
+ *
+ * @param fname - name of the calling function, for error messages
+ * @param code - out-param, the code string, or NULL if the code is in a file
+ * @param file - out-param, the open file stream to be closed by the caller, or NULL if the code is a string
+ * @return false if the arguments are invalid and an exception has been raised
  */
-static PyObject *eval(PyObject *self, PyObject *args) {
+static bool getScriptArguments(const char *fname, PyObject *args, PyObject **code, FILE **file, ScriptOptions &scriptOptions) {
   size_t argc = PyTuple_GET_SIZE(args);
   if (argc > 2 || argc == 0) {
-    PyErr_SetString(PyExc_TypeError, "pythonmonkey.eval accepts one or two arguments");
-    return NULL;
+    PyErr_Format(PyExc_TypeError, "pythonmonkey.%s accepts one or two arguments", fname);
+    return false;
   }
 
-  PyObject *code = NULL;
-  FILE *file = NULL;
+  *code = NULL;
+  *file = NULL;
   PyObject *arg0 = PyTuple_GetItem(args, 0);
   PyObject *arg1 = argc == 2 ? PyTuple_GetItem(args, 1) : NULL;
 
+  PyObject *evalOptions = argc == 2 ? arg1 : NULL;
+  if (evalOptions && !PyDict_Check(evalOptions)) {
+    PyErr_Format(PyExc_TypeError, "pythonmonkey.%s expects a dict as its second argument", fname);
+    return false;
+  }
+
   if (PyUnicode_Check(arg0)) {
-    code = arg0;
+    *code = arg0;
   } else if (1 /*PyFile_Check(arg0)*/) {
     /* First argument is an open file. Open a stream with a dup of the underlying fd (so we can fclose
      * the stream later). Future: seek to current Python file position IFF the fd is for a real file.
      */
     int fd = PyObject_AsFileDescriptor(arg0);
     int fd2 = fd == -1 ? -1 : dup(fd);
-    file = fd2 == -1 ? NULL : fdopen(fd, "rb");
-    if (!file) {
+    *file = fd2 == -1 ? NULL : fdopen(fd, "rb");
+    if (!*file) {
       PyErr_SetString(PyExc_TypeError, "error opening file stream");
-      return NULL;
+      return false;
     }
   } else {
-    PyErr_SetString(PyExc_TypeError, "pythonmonkey.eval expects either a string or an open file as its first argument");
-    return NULL;
+    PyErr_Format(PyExc_TypeError, "pythonmonkey.%s expects either a string or an open file as its first argument", fname);
+    return false;
   }
 
-  PyObject *evalOptions = argc == 2 ? arg1 : NULL;
-  if (evalOptions && !PyDict_Check(evalOptions)) {
-    PyErr_SetString(PyExc_TypeError, "pythonmonkey.eval expects a dict as its second argument");
-    if (file)
-      fclose(file);
-    return NULL;
+  if (evalOptions) {
+    getScriptOptions(evalOptions, scriptOptions);
   }
+  return true;
+}
 
-  // initialize JS context
-  JSAutoRealm ar(GLOBAL_CX, *global);
+/**
+ * @brief Compile a script from a code string or a file, then close the file, without going through the ScriptCache
+ *
+ * @param isRunOnce - the script will be executed only once, which allows SpiderMonkey to optimize it for that
+ * @return JSScript* - the compiled script, or nullptr if compilation failed and an exception has been raised
+ */
+static JSScript *compileScript(PyObject *code, FILE *file, const ScriptOptions &scriptOptions, bool isRunOnce) {
   JS::CompileOptions options (GLOBAL_CX);
-  options.setFileAndLine("evaluate", 1)
-  .setIsRunOnce(true)
-  .setNoScriptRval(false)
-  .setIntroductionType("pythonmonkey eval");
-
-  if (evalOptions) {
-    const char *s;
-    unsigned long l;
-    bool b;
-
-    if (getEvalOption(evalOptions, "filename", &s)) options.setFile(s);
-    if (getEvalOption(evalOptions, "lineno", &l)) options.setLine(l);
-    if (getEvalOption(evalOptions, "column", &l)) options.setColumn(JS::ColumnNumberOneOrigin(l));
-    if (getEvalOption(evalOptions, "mutedErrors", &b)) options.setMutedErrors(b);
-    if (getEvalOption(evalOptions, "noScriptRval", &b)) options.setNoScriptRval(b);
-    if (getEvalOption(evalOptions, "selfHosting", &b)) options.setSelfHostingMode(b);
-    if (getEvalOption(evalOptions, "strict", &b)) if (b) options.setForceStrictMode();
-    if (getEvalOption(evalOptions, "module", &b)) if (b) options.setModule();
-
-    if (getEvalOption(evalOptions, "fromPythonFrame", &b) && b) {
-#if PY_VERSION_HEX >= 0x03090000
-      PyFrameObject *frame = PyEval_GetFrame();
-      if (frame && !getEvalOption(evalOptions, "lineno", &l)) {
-        options.setLine(PyFrame_GetLineNumber(frame));
-      } /* lineno */
-#endif
-#if 0 && (PY_VERSION_HEX >= 0x030a0000) && (PY_VERSION_HEX < 0x030c0000)
-      PyObject *filename = PyDict_GetItemString(frame->f_builtins, "__file__");
-#elif (PY_VERSION_HEX >= 0x030c0000)
-      PyObject *filename = PyDict_GetItemString(PyFrame_GetGlobals(frame), "__file__");
-#else
-      PyObject *filename = NULL;
-#endif
-      if (!getEvalOption(evalOptions, "filename", &s)) {
-        if (filename && PyUnicode_Check(filename)) {
-          PyObject *filenameStr = PyUnicode_FromObject(filename); // needs a strict Python str object (not a subtype)
-          options.setFile(PyUnicode_AsUTF8(filenameStr));
-        }
-      } /* filename */
-    } /* fromPythonFrame */
-  } /* eval options */
+  options.setIntroductionType("pythonmonkey eval");
+  scriptOptions.apply(options);
+  options.setIsRunOnce(isRunOnce);
 
-  // compile the code to execute
-  JS::RootedScript script(GLOBAL_CX);
-  JS::Rooted<JS::Value> rval(GLOBAL_CX);
+  JSScript *script;
   if (code) {
     JS::SourceText<mozilla::Utf8Unit> source;
     Py_ssize_t codeLength;
     const char *codeChars = PyUnicode_AsUTF8AndSize(code, &codeLength);
+    if (!codeChars) {
+      return nullptr;
+    }
     if (!source.init(GLOBAL_CX, codeChars, codeLength, JS::SourceOwnership::Borrowed)) {
       setSpiderMonkeyException(GLOBAL_CX);
-      return NULL;
+      return nullptr;
     }
     script = JS::Compile(GLOBAL_CX, options, source);
   } else {
@@ -479,31 +729,548 @@ static PyObject *eval(PyObject *self, PyObject *args) {
 
   if (!script) {
     setSpiderMonkeyException(GLOBAL_CX);
+  }
+  return script;
+}
+
+/**
+ * @brief Compile a code string through the ScriptCache if it is cacheable, or directly otherwise
+ *
+ * @return JSScript* - the compiled script, or nullptr if compilation failed and an exception has been raised
+ */
+static JSScript *getScript(PyObject *code, FILE *file, const ScriptOptions &scriptOptions, bool isRunOnce) {
+  if (!code || scriptOptions.module || ThreadContext::current()) { // the cache roots its scripts in the main context
+    return compileScript(code, file, scriptOptions, isRunOnce);
+  }
+
+  // Code from JS (e.g. CommonJS modules loaded through vm.runInContext) arrives as a JSStringProxy, whose chars may move during a GC.
+  // The cache keeps an exact str copy instead.
+  PyObject *exactCode = PyUnicode_FromObject(code);
+  if (!exactCode) {
+    return nullptr;
+  }
+  JSScript *script = ScriptCache::getOrCompile(GLOBAL_CX, exactCode, scriptOptions);
+  Py_DECREF(exactCode);
+  if (!script && !PyErr_Occurred()) {
+    setSpiderMonkeyException(GLOBAL_CX);
+  }
+  return script;
+}
+
+/**
+ * @brief Make sure the current thread has a JSContext, see ThreadContext::ensure
+ *
+ * @return JSObject* - the global object of the JSContext of the current thread, or nullptr with an exception set
+ */
+static JSObject *currentGlobal() {
+  if (!ThreadContext::ensure()) {
+    return nullptr;
+  }
+  ThreadContext *context = ThreadContext::current();
+  return context ? context->getGlobal() : (JSObject *)*global;
+}
+
+/**
+ * @brief Evaluate a code string or a file as an ES module through the ModuleLoader, then close the file
+ *
+ * @return PyObject* - the namespace of the module, or NULL with an exception set
+ */
+static PyObject *evalModule(PyObject *code, FILE *file, const ScriptOptions &scriptOptions) {
+  std::string source;
+  if (code) {
+    Py_ssize_t codeLength;
+    const char *codeChars = PyUnicode_AsUTF8AndSize(code, &codeLength);
+    if (!codeChars) {
+      return NULL;
+    }
+    source.assign(codeChars, codeLength);
+  } else {
+    char buffer[64 * 1024];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      source.append(buffer, read);
+    }
+    fclose(file);
+  }
+
+  JS::RootedObject moduleNamespace(GLOBAL_CX, ModuleLoader::evaluate(GLOBAL_CX, source, scriptOptions));
+  if (!moduleNamespace) {
+    setSpiderMonkeyException(GLOBAL_CX);
     return NULL;
   }
+  JS::RootedValue moduleNamespaceValue(GLOBAL_CX, JS::ObjectValue(*moduleNamespace));
+  return pyTypeFactory(GLOBAL_CX, moduleNamespaceValue);
+}
 
-  // execute the compiled code; last expr goes to rval
-  if (!JS_ExecuteScript(GLOBAL_CX, script, &rval)) {
+/**
+ * Implement the pythonmonkey.eval function. From Python-land, that function has the following API:
+ * argument 0 - unicode string of JS code or open file containing JS code in UTF-8, or a script compiled by pythonmonkey.compile
+ * argument 1 - a Dict of options which roughly correspond to the jsapi CompileOptions. A novel option,
+ *              fromPythonFrame, sets the filename and line offset according to the pm.eval call in the
+ *              Python source code. This allows us to embed non-trivial JS inside Python source files
+ *              and still get stack dumps which point to the source code.
+ * Code strings are compiled through the ScriptCache, so evaluating the same code with the same options again skips compilation.
+ * With the `module` option, the code is evaluated as an ES module and its namespace is returned.
+ */
+static PyObject *eval(PyObject *self, PyObject *args) {
+  JSObject *evalGlobal = currentGlobal();
+  if (!evalGlobal) {
+    return NULL;
+  }
+  JS::RootedObject rootedGlobal(GLOBAL_CX, evalGlobal);
+  return evalInGlobal(rootedGlobal, "eval", args);
+}
+
+PyObject *evalInGlobal(JS::HandleObject evalGlobal, const char *fname, PyObject *args) {
+  GCScheduler::schedule();
+
+  // initialize JS context
+  JSAutoRealm ar(GLOBAL_CX, evalGlobal);
+
+  if (PyTuple_GET_SIZE(args) == 1 && PyObject_TypeCheck(PyTuple_GET_ITEM(args, 0), JSScriptProxyType())) {
+    if (!JSScriptProxyMethodDefinitions::checkOwner((JSScriptProxy *)PyTuple_GET_ITEM(args, 0))) {
+      return NULL;
+    }
+    JS::RootedScript script(GLOBAL_CX, *((JSScriptProxy *)PyTuple_GET_ITEM(args, 0))->jsScript);
+    return JSScriptProxyMethodDefinitions::execute(GLOBAL_CX, script);
+  }
+
+  PyObject *code;
+  FILE *file;
+  ScriptOptions scriptOptions;
+  if (!getScriptArguments(fname, args, &code, &file, scriptOptions)) {
+    return NULL;
+  }
+
+  if (scriptOptions.module) {
+    return evalModule(code, file, scriptOptions);
+  }
+
+  // compile the code to execute
+  JS::RootedScript script(GLOBAL_CX, getScript(code, file, scriptOptions, true));
+  if (!script) {
+    return NULL;
+  }
+
+  return JSScriptProxyMethodDefinitions::execute(GLOBAL_CX, script);
+}
+
+/**
+ * Implement the pythonmonkey.compile function, which takes the same arguments as pythonmonkey.eval,
+ * and returns a JSScriptProxy that executes the compiled code each time it is called.
+ */
+static PyObject *compile(PyObject *self, PyObject *args) {
+  PyObject *code;
+  FILE *file;
+  ScriptOptions scriptOptions;
+  if (!getScriptArguments("compile", args, &code, &file, scriptOptions)) {
+    return NULL;
+  }
+  if (scriptOptions.module) {
+    if (file) fclose(file);
+    PyErr_SetString(PyExc_ValueError, "pythonmonkey.compile does not compile modules, evaluate them with pythonmonkey.eval");
+    return NULL;
+  }
+
+  JSObject *compileGlobal = currentGlobal();
+  if (!compileGlobal) {
+    if (file) fclose(file);
+    return NULL;
+  }
+  JSAutoRealm ar(GLOBAL_CX, compileGlobal);
+  JS::RootedScript script(GLOBAL_CX, getScript(code, file, scriptOptions, false));
+  if (!script) {
+    return NULL;
+  }
+
+  return JSScriptProxyMethodDefinitions::JSScriptProxy_new(GLOBAL_CX, script);
+}
+
+/**
+ * Implement the pythonmonkey.eval_async function, which takes the same arguments as pythonmonkey.eval
+ * and returns an asyncio.Future of its result. The code is compiled on a helper thread by an OffThreadCompileTask,
+ * so that the event-loop keeps running meanwhile, and executed on the event-loop thread once compiled.
+ */
+static PyObject *evalAsync(PyObject *self, PyObject *args) {
+  PyEventLoop loop = PyEventLoop::getRunningLoop();
+  if (!loop.initialized()) {
+    return NULL;
+  }
+  if (loop._loop != PyEventLoop::getMainLoop()._loop || ThreadContext::current()) { // compiled scripts are dispatched to the main thread's event-loop
+    PyErr_SetString(PyExc_RuntimeError, "pythonmonkey.eval_async must be awaited on the event-loop of the main thread");
+    return NULL;
+  }
+
+  PyObject *code;
+  FILE *file;
+  ScriptOptions scriptOptions;
+  if (!getScriptArguments("eval_async", args, &code, &file, scriptOptions)) {
+    return NULL;
+  }
+  if (scriptOptions.module) {
+    if (file) fclose(file);
+    PyErr_SetString(PyExc_ValueError, "pythonmonkey.eval_async does not evaluate modules, use pythonmonkey.eval or import()");
+    return NULL;
+  }
+
+  std::string source;
+  if (code) {
+    Py_ssize_t codeLength;
+    const char *codeChars = PyUnicode_AsUTF8AndSize(code, &codeLength);
+    if (!codeChars) {
+      return NULL;
+    }
+    source.assign(codeChars, codeLength);
+  }
+
+  JSAutoRealm ar(GLOBAL_CX, *global);
+  JS::CompileOptions options(GLOBAL_CX);
+  options.setIntroductionType("pythonmonkey eval");
+  scriptOptions.apply(options);
+  options.setIsRunOnce(true);
+
+  PyEventLoop::Future future = loop.createFuture();
+  PyObject *futureObject = future.getFutureObject();
+  if (!OffThreadCompileTask::start(GLOBAL_CX, options, std::move(source), file, std::move(future))) {
+    Py_DECREF(futureObject);
+    return NULL;
+  }
+  return futureObject;
+}
+
+/**
+ * Implement the pythonmonkey.compile_function function. From Python-land, that function has the following API:
+ * argument 0 - the name of the function, or None for an anonymous function
+ * argument 1 - a sequence of parameter names
+ * argument 2 - unicode string of the body of the function
+ * argument 3 - an optional Dict of options, as for pythonmonkey.eval
+ * The function is compiled in the global scope through the ScriptCache, and a new function sharing its script is returned as a JSFunctionProxy.
+ */
+static PyObject *compileFunction(PyObject *self, PyObject *args) {
+  const char *name;
+  PyObject *params;
+  PyObject *body;
+  PyObject *evalOptions = NULL;
+  if (!PyArg_ParseTuple(args, "zOU|O!:compile_function", &name, &params, &body, &PyDict_Type, &evalOptions)) {
+    return NULL;
+  }
+
+  PyObject *paramsSeq = PySequence_Fast(params, "pythonmonkey.compile_function expects a sequence of parameter names as its second argument");
+  if (!paramsSeq) {
+    return NULL;
+  }
+  std::vector<std::string> paramNames;
+  for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(paramsSeq); i++) {
+    PyObject *param = PySequence_Fast_GET_ITEM(paramsSeq, i);
+    const char *paramName = PyUnicode_Check(param) ? PyUnicode_AsUTF8(param) : NULL;
+    if (!paramName) {
+      if (!PyErr_Occurred()) {
+        PyErr_SetString(PyExc_TypeError, "pythonmonkey.compile_function expects parameter names to be strings");
+      }
+      Py_DECREF(paramsSeq);
+      return NULL;
+    }
+    paramNames.push_back(paramName);
+  }
+  Py_DECREF(paramsSeq);
+
+  ScriptOptions scriptOptions;
+  if (evalOptions) {
+    getScriptOptions(evalOptions, scriptOptions);
+  }
+
+  PyObject *exactBody = PyUnicode_FromObject(body);
+  if (!exactBody) {
+    return NULL;
+  }
+  JSObject *compileGlobal = currentGlobal();
+  if (!compileGlobal) {
+    Py_DECREF(exactBody);
+    return NULL;
+  }
+  JSAutoRealm ar(GLOBAL_CX, compileGlobal);
+  JS::RootedObject function(GLOBAL_CX, ScriptCache::getOrCompileFunction(GLOBAL_CX, name, paramNames, exactBody, scriptOptions));
+  Py_DECREF(exactBody);
+  if (!function) {
+    if (!PyErr_Occurred()) {
+      setSpiderMonkeyException(GLOBAL_CX);
+    }
+    return NULL;
+  }
+
+  JS::RootedValue functionValue(GLOBAL_CX, JS::ObjectValue(*function));
+  return pyTypeFactory(GLOBAL_CX, functionValue);
+}
+
+/**
+ * @brief The ScriptCache and the StencilCache serve the main context, which subinterpreters, possibly running
+ * without the GIL of the main interpreter, must leave alone. Configuring or clearing them from a subinterpreter does nothing.
+ *
+ * @return whether the caches are reachable from the current interpreter, otherwise raising RuntimeError if `raise`
+ */
+static bool reachesCaches(bool raise) {
+  if (ModuleState::current()->mainInterpreter) {
+    return true;
+  }
+  if (raise) {
+    PyErr_SetString(PyExc_RuntimeError, "the script caches belong to the main interpreter");
+  }
+  return false;
+}
+
+static PyObject *evalCacheInfo(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(_)) {
+  if (!reachesCaches(true)) {
+    return NULL;
+  }
+  return ScriptCache::info();
+}
+
+static PyObject *evalCacheClear(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(_)) {
+  if (reachesCaches(false)) {
+    ScriptCache::clear();
+  }
+  Py_RETURN_NONE;
+}
+
+/**
+ * @brief Implement `pythonmonkey.internalBinding(namespace)`, creating the bindings in the JSContext of the current thread
+ */
+static PyObject *internalBinding(PyObject *self, PyObject *args) {
+  PyObject *namespaceName;
+  if (!PyArg_ParseTuple(args, "U:internalBinding", &namespaceName)) {
+    return NULL;
+  }
+  JSObject *bindingGlobal = currentGlobal();
+  if (!bindingGlobal) {
+    return NULL;
+  }
+  JSAutoRealm ar(GLOBAL_CX, bindingGlobal);
+  JS::RootedValue namespaceValue(GLOBAL_CX, jsTypeFactory(GLOBAL_CX, namespaceName));
+  JSLinearString *namespaceStr = JS_EnsureLinearString(GLOBAL_CX, namespaceValue.toString());
+  if (!namespaceStr) {
     setSpiderMonkeyException(GLOBAL_CX);
     return NULL;
   }
+  JS::RootedValue bindings(GLOBAL_CX, JS::ObjectOrNullValue(getInternalBindingsByNamespace(GLOBAL_CX, namespaceStr)));
+  return pyTypeFactory(GLOBAL_CX, bindings);
+}
 
-  // translate to the proper python type
-  PyObject *returnValue = pyTypeFactory(GLOBAL_CX, rval);
-  if (PyErr_Occurred()) {
+static PyObject *serialize(PyObject *Py_UNUSED(self), PyObject *value) {
+  JSObject *serializeGlobal = currentGlobal();
+  if (!serializeGlobal) {
     return NULL;
   }
+  JSAutoRealm ar(GLOBAL_CX, serializeGlobal);
+  JS::RootedValue jsValue(GLOBAL_CX, jsTypeFactory(GLOBAL_CX, value));
+  return StructuredClone::serialize(GLOBAL_CX, jsValue);
+}
 
-  if (returnValue) {
-    return returnValue;
+static PyObject *deserialize(PyObject *Py_UNUSED(self), PyObject *data) {
+  JSObject *deserializeGlobal = currentGlobal();
+  if (!deserializeGlobal) {
+    return NULL;
+  }
+  JSAutoRealm ar(GLOBAL_CX, deserializeGlobal);
+  JS::RootedValue jsValue(GLOBAL_CX);
+  if (!StructuredClone::deserialize(GLOBAL_CX, data, &jsValue)) {
+    return NULL;
+  }
+  return pyTypeFactory(GLOBAL_CX, jsValue);
+}
+
+static PyObject *setReleaseGIL(PyObject *Py_UNUSED(self), PyObject *args, PyObject *kwargs) {
+  static const char *keywords[] = {"", "thread", NULL};
+  int enabled;
+  int thread = false;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "p|$p:set_release_gil", (char **)keywords, &enabled, &thread)) {
+    return NULL;
   }
-  else {
+  if (thread) {
+    AutoReleaseGIL::enabledOnThread = enabled;
+  } else {
+    AutoReleaseGIL::enabled.store(enabled, std::memory_order_relaxed);
+  }
+  Py_RETURN_NONE;
+}
+
+static PyObject *stencilCacheConfigure(PyObject *Py_UNUSED(self), PyObject *args) {
+  const char *directory;
+  Py_ssize_t maxBytes = 256 * 1024 * 1024;
+  if (!PyArg_ParseTuple(args, "z|n:stencil_cache_configure", &directory, &maxBytes)) {
+    return NULL;
+  }
+  if (maxBytes < 0) {
+    PyErr_SetString(PyExc_ValueError, "the size limit of the stencil cache must not be negative");
+    return NULL;
+  }
+  if (!reachesCaches(false)) {
     Py_RETURN_NONE;
   }
+  if (!StencilCache::configure(directory, (size_t)maxBytes)) {
+    return NULL;
+  }
+  ScriptCache::clear(); // scripts compiled from now on go through the stencil cache
+  Py_RETURN_NONE;
+}
+
+static PyObject *stencilCacheInfo(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(_)) {
+  if (!reachesCaches(true)) {
+    return NULL;
+  }
+  return StencilCache::info();
+}
+
+/**
+ * @brief Identify the build for XDR-encoded stencils, so that stencils from another build are rejected when decoded.
+ * The format of stencils depends on SpiderMonkey rather than on PythonMonkey, so the id is made of both versions
+ * and of the build configuration, and is the same for reproducible builds of the same sources.
+ */
+static bool getBuildId(JS::BuildIdCharVector *buildId) {
+  std::string id = "pythonmonkey " PYTHONMONKEY_VERSION " ";
+  id += JS_GetImplementationVersion();
+  id += " " BUILD_TYPE " ";
+  id += std::to_string(sizeof(void *) * 8);
+  return buildId->append(id.data(), id.size());
+}
+
+static JSClass globalClass = {"global", JSCLASS_GLOBAL_FLAGS_WITH_SLOTS(1) /* ModuleLoader::MODULE_MAP_SLOT */, &JS::DefaultGlobalClassOps};
+
+static JS::RealmOptions globalRealmOptions() {
+  JS::RealmCreationOptions creationOptions = JS::RealmCreationOptions();
+  creationOptions.setSharedMemoryAndAtomicsEnabled(true); // SharedArrayBuffer and Atomics, to share memory with Python threads
+  JS::RealmBehaviors behaviours = JS::RealmBehaviors();
+  return JS::RealmOptions(creationOptions, behaviours);
+}
+
+/**
+ * @brief Define the globals PythonMonkey adds to the standard library of every global object
+ * @return the global, or nullptr with a Python exception set
+ */
+static JSObject *initGlobal(JSContext *cx, JS::HandleObject newGlobal) {
+  if (!newGlobal) {
+    return nullptr;
+  }
+  JSAutoRealm ar(cx, newGlobal);
+  if (!StructuredClone::defineGlobal(cx, newGlobal)) {
+    setSpiderMonkeyException(cx);
+    return nullptr;
+  }
+  return newGlobal;
+}
+
+JSObject *newRealmGlobal(JSContext *cx) {
+  JSObject *contextGlobal = currentGlobal();
+  if (!contextGlobal) {
+    return nullptr;
+  }
+  JS::RealmOptions options = globalRealmOptions();
+  options.creationOptions().setExistingCompartment(contextGlobal); // objects pass between realms without cross-compartment wrappers
+  JS::RootedObject newGlobal(cx, JS_NewGlobalObject(cx, &globalClass, nullptr, JS::FireOnNewGlobalHook, options));
+  return initGlobal(cx, newGlobal);
+}
+
+JSObject *newContextGlobal(JSContext *cx) {
+  JS::RootedObject newGlobal(cx, JS_NewGlobalObject(cx, &globalClass, nullptr, JS::FireOnNewGlobalHook, globalRealmOptions()));
+  if (!newGlobal) {
+    PyErr_SetString(SpiderMonkeyError(), "Spidermonkey could not create a global object.");
+    return nullptr;
+  }
+  return initGlobal(cx, newGlobal);
+}
+
+bool initJSContext(JSContext *cx, JobQueue *jobQueue) {
+  JS::ContextOptionsRef(cx)
+  .setWasm(true)
+  .setAsmJS(true)
+  .setAsyncStack(true)
+  .setSourcePragmas(true);
+
+  if (!jobQueue->init(cx)) {
+    PyErr_SetString(SpiderMonkeyError(), "Spidermonkey could not create the event-loop.");
+    return false;
+  }
+  ModuleLoader::init(cx);
+
+  if (!JS::InitSelfHostedCode(cx)) {
+    PyErr_SetString(SpiderMonkeyError(), "Spidermonkey could not initialize self-hosted code.");
+    return false;
+  }
+
+  JS_SetGCParameter(cx, JSGC_MAX_BYTES, (uint32_t)-1);
+  GCScheduler::initContext(cx);
+  ProxyRoots::initContext(cx);
+  JS::SetOutOfMemoryCallback(cx, GCParameters::onOutOfMemory, nullptr);
+
+  JS_SetGCCallback(cx, pythonmonkeyGCCallback, jobQueue);
+  JS::AddGCNurseryCollectionCallback(cx, nurseryCollectionCallback, NULL);
+  JS::SetHostCleanupFinalizationRegistryCallback(cx, cleanupFinalizationRegistry, jobQueue);
+  return true;
+}
+
+JSObject *newFunctionRegistry(JSContext *cx) {
+  JS::RootedObject contextGlobal(cx, JS::CurrentGlobalOrNull(cx));
+  JS::RootedValue FinalizationRegistry(cx);
+  JS::RootedObject registryObject(cx);
+
+  JS_GetProperty(cx, contextGlobal, "FinalizationRegistry", &FinalizationRegistry);
+  JS::Rooted<JS::ValueArray<1>> args(cx);
+  JSFunction *registryCallback = JS_NewFunction(cx, functionRegistryCallback, 1, 0, NULL);
+  JS::RootedObject registryCallbackObject(cx, JS_GetFunctionObject(registryCallback));
+  args[0].setObject(*registryCallbackObject);
+  if (!JS::Construct(cx, FinalizationRegistry, args, &registryObject)) {
+    setSpiderMonkeyException(cx);
+    return nullptr;
+  }
+  return registryObject;
+}
+
+/**
+ * @brief Getter of globalThis.debuggerGlobal. The debugger global is only created on first use,
+ * after which the getter replaces itself with a data property holding it.
+ */
+static bool getDebuggerGlobal(JSContext *cx, unsigned argc, JS::Value *vp) {
+  JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+  JS::RootedObject debuggerGlobal(cx, JS_NewGlobalObject(cx, &globalClass, nullptr, JS::FireOnNewGlobalHook, globalRealmOptions()));
+  if (!debuggerGlobal) {
+    return false;
+  }
+  {
+    JSAutoRealm r(cx, debuggerGlobal);
+    if (!JS_DefineDebuggerObject(cx, debuggerGlobal)) {
+      return false;
+    }
+  }
+
+  JS::RootedValue debuggerGlobalValue(cx, JS::ObjectValue(*debuggerGlobal));
+  JS::RootedObject thisGlobal(cx, JS::CurrentGlobalOrNull(cx));
+  if (!JS_WrapValue(cx, &debuggerGlobalValue) ||
+      !JS_DefineProperty(cx, thisGlobal, "debuggerGlobal", debuggerGlobalValue, JSPROP_READONLY | JSPROP_PERMANENT)) {
+    return false;
+  }
+  args.rval().set(debuggerGlobalValue);
+  return true;
+}
+
+/**
+ * @brief Record the time spent in a bootstrap phase, and start timing the next one
+ *
+ * @param bootstrapTimings - phase name => seconds, exposed as pythonmonkey.bootstrap_timings
+ * @param phase - name of the phase that just ended
+ * @param start - when the phase started, reset to now
+ */
+static void recordBootstrapPhase(PyObject *bootstrapTimings, const char *phase, std::chrono::steady_clock::time_point &start) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  PyObject *seconds = PyFloat_FromDouble(std::chrono::duration<double>(now - start).count());
+  if (!seconds || PyDict_SetItemString(bootstrapTimings, phase, seconds) < 0) {
+    PyErr_Clear(); // timings are informative only
+  }
+  Py_XDECREF(seconds);
+  start = now;
 }
 
 static PyObject *waitForEventLoop(PyObject *Py_UNUSED(self), PyObject *Py_UNUSED(_)) {
-  PyObject *waiter = PyEventLoop::_locker->_queueIsEmpty; // instance of asyncio.Event
+  PyObject *waiter = PyEventLoop::getLocker()->_queueIsEmpty; // instance of asyncio.Event
 
   // Making sure it's attached to the current event-loop
   PyEventLoop loop = PyEventLoop::getRunningLoop();
@@ -528,7 +1295,12 @@ static PyObject *isCompilableUnit(PyObject *self, PyObject *args) {
   Py_ssize_t bufferLength;
   const char *bufferUtf8 = PyUnicode_AsUTF8AndSize(item, &bufferLength);
 
-  if (JS_Utf8BufferIsCompilableUnit(GLOBAL_CX, *global, bufferUtf8, bufferLength)) {
+  JSObject *compileGlobal = currentGlobal();
+  if (!compileGlobal) {
+    return NULL;
+  }
+  JS::RootedObject rootedGlobal(GLOBAL_CX, compileGlobal);
+  if (JS_Utf8BufferIsCompilableUnit(GLOBAL_CX, rootedGlobal, bufferUtf8, bufferLength)) {
     Py_RETURN_TRUE;
   } else {
     Py_RETURN_FALSE;
@@ -537,87 +1309,72 @@ static PyObject *isCompilableUnit(PyObject *self, PyObject *args) {
 
 PyMethodDef PythonMonkeyMethods[] = {
   {"eval", eval, METH_VARARGS, "Javascript evaluator in Python"},
+  {"compile", compile, METH_VARARGS, "Compile Javascript code into a script that can be executed many times"},
+  {"eval_async", evalAsync, METH_VARARGS, "Javascript evaluator in Python, compiling on a helper thread and returning an awaitable of the result"},
+  {"compile_function", compileFunction, METH_VARARGS, "Compile a Javascript function from its name, parameter names and body"},
+  {"eval_cache_info", evalCacheInfo, METH_NOARGS, "Statistics of the cache of scripts compiled by eval and compile"},
+  {"eval_cache_clear", evalCacheClear, METH_NOARGS, "Empty the cache of scripts compiled by eval and compile"},
+  {"stencil_cache_configure", stencilCacheConfigure, METH_VARARGS, "Set the directory and size limit of the on-disk cache of compiled scripts"},
+  {"stencil_cache_info", stencilCacheInfo, METH_NOARGS, "Configuration and statistics of the on-disk cache of compiled scripts"},
+  {"internalBinding", internalBinding, METH_VARARGS, "Get the C++-implemented functions of a namespace, see internal-binding.d.ts"},
+  {"serialize", serialize, METH_O, "Serialize a value into bytes with the structured clone algorithm"},
+  {"deserialize", deserialize, METH_O, "Create a copy of the value serialized into bytes by serialize"},
+  {"set_release_gil", (PyCFunction)setReleaseGIL, METH_VARARGS | METH_KEYWORDS, "Set whether the GIL is released while Javascript runs, letting other Python threads run meanwhile"},
   {"wait", waitForEventLoop, METH_NOARGS, "The event-loop shield. Blocks until all asynchronous jobs finish."},
   {"stop", closeAllPending, METH_NOARGS, "Cancel all pending event-loop jobs."},
   {"isCompilableUnit", isCompilableUnit, METH_VARARGS, "Hint if a string might be compilable Javascript"},
-  {"collect", collect, METH_VARARGS, "Calls the Spidermonkey garbage collector"},
+  {"collect", (PyCFunction)collect, METH_VARARGS | METH_KEYWORDS, "Calls the Spidermonkey garbage collector, running a full, minor, incremental or shrinking collection"},
+  {"set_idle_gc", (PyCFunction)setIdleGC, METH_VARARGS | METH_KEYWORDS, "Set whether incremental garbage collection runs while the asyncio event-loop is idle, and its time budget"},
+  {"set_gc_params", (PyCFunction)setGCParams, METH_VARARGS | METH_KEYWORDS, "Set parameters of the garbage collector of every JS context, such as the heap limit and the nursery size"},
+  {"get_gc_params", getGCParams, METH_NOARGS, "The parameters of the garbage collector in effect for the JS context of the current thread"},
+  {"set_cycle_collection", setCycleCollection, METH_O, "Set whether full Python garbage collections also collect the reference cycles going through JavaScript objects"},
+  {"gc_info", gcInfo, METH_NOARGS, "Settings and statistics of idle garbage collection, and the state of the heap of the current thread"},
+  {"_before_fork", beforeFork, METH_NOARGS, "Wait for the helper threads of SpiderMonkey to finish their tasks and stop them, called before os.fork()"},
+  {"_after_fork", afterFork, METH_NOARGS, "Start the helper threads stopped by _before_fork again, called after os.fork() in the parent and the child"},
   {NULL, NULL, 0, NULL}
 };
 
-struct PyModuleDef pythonmonkey =
-{
-  PyModuleDef_HEAD_INIT,
-  "pythonmonkey",                                   /* name of module */
-  "A module for python to JS interoperability",   /* module documentation, may be NULL */
-  -1,                                           /* size of per-interpreter state of the module, or -1 if the module keeps state in global variables. */
-  PythonMonkeyMethods
-};
-
-PyObject *SpiderMonkeyError = NULL;
-
-PyMODINIT_FUNC PyInit_pythonmonkey(void)
-{
-  if (!PyDateTimeAPI) { PyDateTime_IMPORT; }
-
-  SpiderMonkeyError = PyErr_NewException("pythonmonkey.SpiderMonkeyError", NULL, NULL);
+/**
+ * @brief Initialize SpiderMonkey and the JSContext of the main thread, once per process, when the main interpreter imports pythonmonkey
+ *
+ * @param bootstrapTimings - phase name => seconds, see recordBootstrapPhase
+ * @return false with an exception set if initialization failed
+ */
+static bool initRuntime(PyObject *bootstrapTimings, std::chrono::steady_clock::time_point &phaseStart) {
   if (!JS_Init()) {
-    PyErr_SetString(SpiderMonkeyError, "Spidermonkey could not be initialized.");
-    return NULL;
+    PyErr_SetString(SpiderMonkeyError(), "Spidermonkey could not be initialized.");
+    return false;
   }
+  JS::SetProcessBuildIdOp(getBuildId);
+  HelperThreads::init();
+  recordBootstrapPhase(bootstrapTimings, "init", phaseStart);
 
   GLOBAL_CX = JS_NewContext(JS::DefaultHeapMaxBytes);
   if (!GLOBAL_CX) {
-    PyErr_SetString(SpiderMonkeyError, "Spidermonkey could not create a JS context.");
-    return NULL;
+    PyErr_SetString(SpiderMonkeyError(), "Spidermonkey could not create a JS context.");
+    return false;
   }
 
-  JS::ContextOptionsRef(GLOBAL_CX)
-  .setWasm(true)
-  .setAsmJS(true)
-  .setAsyncStack(true)
-  .setSourcePragmas(true);
-
   JOB_QUEUE = new JobQueue(GLOBAL_CX);
-  if (!JOB_QUEUE->init(GLOBAL_CX)) {
-    PyErr_SetString(SpiderMonkeyError, "Spidermonkey could not create the event-loop.");
-    return NULL;
+  if (!initJSContext(GLOBAL_CX, JOB_QUEUE)) {
+    return false;
   }
+  ThreadContext::init(GLOBAL_CX);
+  recordBootstrapPhase(bootstrapTimings, "context", phaseStart);
 
-  if (!JS::InitSelfHostedCode(GLOBAL_CX)) {
-    PyErr_SetString(SpiderMonkeyError, "Spidermonkey could not initialize self-hosted code.");
-    return NULL;
+  global = new JS::RootedObject(GLOBAL_CX, newContextGlobal(GLOBAL_CX));
+  if (!*global) {
+    return false;
   }
 
-  JS_SetGCParameter(GLOBAL_CX, JSGC_MAX_BYTES, (uint32_t)-1);
-
-  JS_SetGCCallback(GLOBAL_CX, pythonmonkeyGCCallback, NULL);
-  JS::AddGCNurseryCollectionCallback(GLOBAL_CX, nurseryCollectionCallback, NULL);
-
-  JS::RealmCreationOptions creationOptions = JS::RealmCreationOptions();
-  JS::RealmBehaviors behaviours = JS::RealmBehaviors();
-  JS::RealmOptions options = JS::RealmOptions(creationOptions, behaviours);
-  static JSClass globalClass = {"global", JSCLASS_GLOBAL_FLAGS, &JS::DefaultGlobalClassOps};
-  global = new JS::RootedObject(GLOBAL_CX, JS_NewGlobalObject(GLOBAL_CX, &globalClass, nullptr, JS::FireOnNewGlobalHook, options));
-  if (!global) {
-    PyErr_SetString(SpiderMonkeyError, "Spidermonkey could not create a global object.");
-    return NULL;
-  }
+  autoRealm = new JSAutoRealm(GLOBAL_CX, *global);
 
-  JS::RootedObject debuggerGlobal(GLOBAL_CX, JS_NewGlobalObject(GLOBAL_CX, &globalClass, nullptr, JS::FireOnNewGlobalHook, options));
-  {
-    JSAutoRealm r(GLOBAL_CX, debuggerGlobal);
-    JS_DefineDebuggerObject(GLOBAL_CX, debuggerGlobal);
-  }
-  {
-    JSAutoRealm r(GLOBAL_CX, *global);
-    JS::Rooted<JS::PropertyDescriptor> desc(GLOBAL_CX, JS::PropertyDescriptor::Data(
-      JS::ObjectValue(*debuggerGlobal)
-    ));
-    JS_WrapPropertyDescriptor(GLOBAL_CX, &desc);
-    JS_DefineUCProperty(GLOBAL_CX, *global, u"debuggerGlobal", 14, desc);
+  // the debugger global costs a whole realm, only create it when pmdb or user code asks for it
+  if (!JS_DefineProperty(GLOBAL_CX, *global, "debuggerGlobal", getDebuggerGlobal, nullptr, 0)) {
+    PyErr_SetString(SpiderMonkeyError(), "Spidermonkey could not define the debugger global.");
+    return false;
   }
-
-  autoRealm = new JSAutoRealm(GLOBAL_CX, *global);
+  recordBootstrapPhase(bootstrapTimings, "global", phaseStart);
 
   // XXX: SpiderMonkey bug???
   // In https://hg.mozilla.org/releases/mozilla-esr102/file/3b574e1/js/src/jit/CacheIR.cpp#l317, trying to use the callback returned by `js::GetDOMProxyShadowsCheck()` even it's unset (nullptr)
@@ -627,161 +1384,158 @@ PyMODINIT_FUNC PyInit_pythonmonkey(void)
       return JS::DOMProxyShadowsResult::ShadowCheckFailed;
     }, nullptr);
 
-  if (PyType_Ready(&NullType) < 0)
-    return NULL;
-  if (PyType_Ready(&BigIntType) < 0)
-    return NULL;
-  if (PyType_Ready(&JSObjectProxyType) < 0)
-    return NULL;
-  if (PyType_Ready(&JSStringProxyType) < 0)
-    return NULL;
-  if (PyType_Ready(&JSFunctionProxyType) < 0)
-    return NULL;
-  if (PyType_Ready(&JSMethodProxyType) < 0)
-    return NULL;
-  if (PyType_Ready(&JSArrayProxyType) < 0)
-    return NULL;
-  if (PyType_Ready(&JSArrayIterProxyType) < 0)
-    return NULL;
-  if (PyType_Ready(&JSObjectIterProxyType) < 0)
-    return NULL;
-  if (PyType_Ready(&JSObjectKeysProxyType) < 0)
-    return NULL;
-  if (PyType_Ready(&JSObjectValuesProxyType) < 0)
-    return NULL;
-  if (PyType_Ready(&JSObjectItemsProxyType) < 0)
-    return NULL;
-
-  PyObject *pyModule = PyModule_Create(&pythonmonkey);
-  if (pyModule == NULL)
-    return NULL;
-
-  // Clean up SpiderMonkey when the PythonMonkey module gets destroyed (module.___cleanup is GCed)
-  // The `cleanup` function will be called automatically when this PyCapsule gets GCed
-  // We cannot use `Py_AtExit(cleanup);` because the GIL is unavailable after Python finalization, no more Python APIs can be called.
-  PyObject *autoDestructor = PyCapsule_New(&pythonmonkey, NULL, cleanup);
-  if (PyModule_AddObject(pyModule, "___cleanup", autoDestructor) < 0) {
-    Py_DECREF(autoDestructor);
-    Py_DECREF(pyModule);
-    return NULL;
+  // initialize FinalizationRegistry of JSFunctions to Python Functions
+  JS::RootedObject registryObject(GLOBAL_CX, newFunctionRegistry(GLOBAL_CX));
+  if (!registryObject) {
+    return false;
   }
+  jsFunctionRegistry = new JS::PersistentRootedObject(GLOBAL_CX, registryObject);
+  return true;
+}
 
-  Py_INCREF(&NullType);
-  if (PyModule_AddObject(pyModule, "null", (PyObject *)&NullType) < 0) {
-    Py_DECREF(&NullType);
-    Py_DECREF(pyModule);
-    return NULL;
+/**
+ * @brief Add an object to the module, stealing a reference to it
+ */
+static bool addObject(PyObject *pyModule, const char *name, PyObject *object) {
+  if (PyModule_AddObject(pyModule, name, object) < 0) {
+    Py_DECREF(object);
+    return false;
   }
+  return true;
+}
 
-  Py_INCREF(&BigIntType);
-  if (PyModule_AddObject(pyModule, "bigint", (PyObject *)&BigIntType) < 0) {
-    Py_DECREF(&BigIntType);
-    Py_DECREF(pyModule);
-    return NULL;
-  }
+/**
+ * @brief Add a type of the module state to the module
+ */
+static bool addType(PyObject *pyModule, const char *name, PyTypeObject *type) {
+  Py_INCREF(type);
+  return addObject(pyModule, name, (PyObject *)type);
+}
 
-  Py_INCREF(&JSObjectProxyType);
-  if (PyModule_AddObject(pyModule, "JSObjectProxy", (PyObject *)&JSObjectProxyType) < 0) {
-    Py_DECREF(&JSObjectProxyType);
-    Py_DECREF(pyModule);
-    return NULL;
-  }
+/**
+ * @brief The exec slot of the module, run once by each interpreter importing pythonmonkey.
+ * The main interpreter must import it first, as it initializes SpiderMonkey and owns the main JSContext.
+ */
+static int execPythonMonkey(PyObject *pyModule) {
+  static std::atomic<bool> runtimeInitialized = false; // read by subinterpreters, which may run alongside the main one with their own GIL
 
-  Py_INCREF(&JSStringProxyType);
-  if (PyModule_AddObject(pyModule, "JSStringProxy", (PyObject *)&JSStringProxyType) < 0) {
-    Py_DECREF(&JSStringProxyType);
-    Py_DECREF(pyModule);
-    return NULL;
+  std::chrono::steady_clock::time_point phaseStart = std::chrono::steady_clock::now();
+  PyObject *bootstrapTimings = PyDict_New(); // the Python part of the bootstrap adds its own phases to the same dict
+  if (!bootstrapTimings || !addObject(pyModule, "bootstrap_timings", bootstrapTimings)) {
+    return -1;
   }
 
-  Py_INCREF(&JSArrayProxyType);
-  if (PyModule_AddObject(pyModule, "JSArrayProxy", (PyObject *)&JSArrayProxyType) < 0) {
-    Py_DECREF(&JSArrayProxyType);
-    Py_DECREF(pyModule);
-    return NULL;
+  ModuleState *state = ModuleState::create();
+  if (!state) {
+    return -1;
   }
+  *(ModuleState **)PyModule_GetState(pyModule) = state;
 
-  Py_INCREF(&JSFunctionProxyType);
-  if (PyModule_AddObject(pyModule, "JSFunctionProxy", (PyObject *)&JSFunctionProxyType) < 0) {
-    Py_DECREF(&JSFunctionProxyType);
-    Py_DECREF(pyModule);
-    return NULL;
+  state->SpiderMonkeyError = PyErr_NewException("pythonmonkey.SpiderMonkeyError", NULL, NULL);
+  if (!state->SpiderMonkeyError || !createTypes(state)) {
+    return -1;
   }
 
-  Py_INCREF(&JSArrayIterProxyType);
-  if (PyModule_AddObject(pyModule, "JSArrayIterProxy", (PyObject *)&JSArrayIterProxyType) < 0) {
-    Py_DECREF(&JSArrayIterProxyType);
-    Py_DECREF(pyModule);
-    return NULL;
-  }
+  // Initialize event-loop shield
+  state->locker = new PyEventLoop::Lock();
 
-  Py_INCREF(&JSMethodProxyType);
-  if (PyModule_AddObject(pyModule, "JSMethodProxy", (PyObject *)&JSMethodProxyType) < 0) {
-    Py_DECREF(&JSMethodProxyType);
-    Py_DECREF(pyModule);
-    return NULL;
+  if (state->mainInterpreter && !runtimeInitialized) {
+    if (!initRuntime(bootstrapTimings, phaseStart)) {
+      return -1;
+    }
+    runtimeInitialized = true;
+
+    // Clean up SpiderMonkey when the PythonMonkey module gets destroyed (module.___cleanup is GCed)
+    // The `cleanup` function will be called automatically when this PyCapsule gets GCed
+    // We cannot use `Py_AtExit(cleanup);` because the GIL is unavailable after Python finalization, no more Python APIs can be called.
+    PyObject *autoDestructor = PyCapsule_New(&pythonmonkey, NULL, cleanup);
+    if (!autoDestructor || !addObject(pyModule, "___cleanup", autoDestructor)) {
+      return -1;
+    }
+  } else if (!runtimeInitialized) {
+    PyErr_SetString(PyExc_ImportError, "pythonmonkey must be imported by the main interpreter before any subinterpreter");
+    return -1;
   }
 
-  Py_INCREF(&JSObjectIterProxyType);
-  if (PyModule_AddObject(pyModule, "JSObjectIterProxy", (PyObject *)&JSObjectIterProxyType) < 0) {
-    Py_DECREF(&JSObjectIterProxyType);
-    Py_DECREF(pyModule);
-    return NULL;
+  // gc.callbacks is per interpreter
+  if (!CycleCollector::install()) {
+    return -1;
   }
 
-  Py_INCREF(&JSObjectKeysProxyType);
-  if (PyModule_AddObject(pyModule, "JSObjectKeysProxy", (PyObject *)&JSObjectKeysProxyType) < 0) {
-    Py_DECREF(&JSObjectKeysProxyType);
-    Py_DECREF(pyModule);
-    return NULL;
+  Py_INCREF(state->SpiderMonkeyError);
+  if (!addType(pyModule, "null", state->NullType) ||
+      !addType(pyModule, "bigint", state->BigIntType) ||
+      !addType(pyModule, "JSObjectProxy", state->JSObjectProxyType) ||
+      !addType(pyModule, "JSStringProxy", state->JSStringProxyType) ||
+      !addType(pyModule, "JSArrayProxy", state->JSArrayProxyType) ||
+      !addType(pyModule, "JSArrayBufferProxy", state->JSArrayBufferProxyType) ||
+      !addType(pyModule, "JSFunctionProxy", state->JSFunctionProxyType) ||
+      !addType(pyModule, "JSScriptProxy", state->JSScriptProxyType) ||
+      !addType(pyModule, "Realm", state->JSRealmProxyType) ||
+      !addType(pyModule, "JSArrayIterProxy", state->JSArrayIterProxyType) ||
+      !addType(pyModule, "JSMethodProxy", state->JSMethodProxyType) ||
+      !addType(pyModule, "JSObjectIterProxy", state->JSObjectIterProxyType) ||
+      !addType(pyModule, "JSObjectKeysProxy", state->JSObjectKeysProxyType) ||
+      !addType(pyModule, "JSObjectValuesProxy", state->JSObjectValuesProxyType) ||
+      !addType(pyModule, "JSObjectItemsProxy", state->JSObjectItemsProxyType) ||
+      !addObject(pyModule, "SpiderMonkeyError", state->SpiderMonkeyError)) {
+    return -1;
   }
+  recordBootstrapPhase(bootstrapTimings, "module", phaseStart);
+  return 0;
+}
 
-  Py_INCREF(&JSObjectValuesProxyType);
-  if (PyModule_AddObject(pyModule, "JSObjectValuesProxy", (PyObject *)&JSObjectValuesProxyType) < 0) {
-    Py_DECREF(&JSObjectValuesProxyType);
-    Py_DECREF(pyModule);
-    return NULL;
-  }
+/**
+ * @return the module state held by a pythonmonkey module object, or nullptr if its exec slot failed early
+ */
+static ModuleState *getModuleState(PyObject *pyModule) {
+  ModuleState **statePointer = (ModuleState **)PyModule_GetState(pyModule);
+  return statePointer ? *statePointer : nullptr;
+}
 
-  Py_INCREF(&JSObjectItemsProxyType);
-  if (PyModule_AddObject(pyModule, "JSObjectItemsProxy", (PyObject *)&JSObjectItemsProxyType) < 0) {
-    Py_DECREF(&JSObjectItemsProxyType);
-    Py_DECREF(pyModule);
-    return NULL;
-  }
+static int traversePythonMonkey(PyObject *pyModule, visitproc visit, void *arg) {
+  ModuleState *state = getModuleState(pyModule);
+  return state ? state->traverse(visit, arg) : 0;
+}
 
-  if (PyModule_AddObject(pyModule, "SpiderMonkeyError", SpiderMonkeyError) < 0) {
-    Py_DECREF(pyModule);
-    return NULL;
+static int clearPythonMonkey(PyObject *pyModule) {
+  ModuleState *state = getModuleState(pyModule);
+  if (state) {
+    state->clear();
   }
+  return 0;
+}
 
-  // Initialize event-loop shield
-  PyEventLoop::_locker = new PyEventLoop::Lock();
-
-  PyObject *internalBindingPy = getInternalBindingPyFn(GLOBAL_CX);
-  if (PyModule_AddObject(pyModule, "internalBinding", internalBindingPy) < 0) {
-    Py_DECREF(internalBindingPy);
-    Py_DECREF(pyModule);
-    return NULL;
+static void freePythonMonkey(void *pyModule) {
+  ModuleState *state = getModuleState((PyObject *)pyModule);
+  if (state) {
+    ModuleState::destroy(state);
+    *(ModuleState **)PyModule_GetState((PyObject *)pyModule) = nullptr;
   }
+}
 
-  // initialize FinalizationRegistry of JSFunctions to Python Functions
-  JS::RootedValue FinalizationRegistry(GLOBAL_CX);
-  JS::RootedObject registryObject(GLOBAL_CX);
-
-  JS_GetProperty(GLOBAL_CX, *global, "FinalizationRegistry", &FinalizationRegistry);
-  JS::Rooted<JS::ValueArray<1>> args(GLOBAL_CX);
-  JSFunction *registryCallback = JS_NewFunction(GLOBAL_CX, functionRegistryCallback, 1, 0, NULL);
-  JS::RootedObject registryCallbackObject(GLOBAL_CX, JS_GetFunctionObject(registryCallback));
-  args[0].setObject(*registryCallbackObject);
-  if (!JS::Construct(GLOBAL_CX, FinalizationRegistry, args, &registryObject)) {
-    setSpiderMonkeyException(GLOBAL_CX);
-    return NULL;
-  }
-  jsFunctionRegistry.init(GLOBAL_CX);
-  jsFunctionRegistry.set(registryObject);
+static PyModuleDef_Slot PythonMonkeySlots[] = {
+  {Py_mod_exec, (void *)execPythonMonkey},
+#if PY_VERSION_HEX >= 0x030c0000 // Python 3.12 or higher
+  {Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED},
+#endif
+  {0, NULL}
+};
 
-  JS::SetHostCleanupFinalizationRegistryCallback(GLOBAL_CX, cleanupFinalizationRegistry, NULL);
+struct PyModuleDef pythonmonkey =
+{
+  PyModuleDef_HEAD_INIT,
+  "pythonmonkey",                                   /* name of module */
+  "A module for python to JS interoperability",   /* module documentation, may be NULL */
+  sizeof(ModuleState *),                        /* size of per-module state, a pointer to the ModuleState of the interpreter */
+  PythonMonkeyMethods,
+  PythonMonkeySlots,
+  traversePythonMonkey,
+  clearPythonMonkey,
+  freePythonMonkey
+};
 
-  return pyModule;
-}
\ No newline at end of file
+PyMODINIT_FUNC PyInit_pythonmonkey(void)
+{
+  return PyModuleDef_Init(&pythonmonkey);
+}
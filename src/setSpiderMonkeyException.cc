@@ -12,6 +12,7 @@
 #include "include/setSpiderMonkeyException.hh"
 #include "include/StrType.hh"
 #include "include/DictType.hh"
+#include "include/GCParameters.hh"
 
 #include <jsapi.h>
 #include <Python.h>
@@ -75,16 +76,19 @@ PyObject *getExceptionString(JSContext *cx, const JS::ExceptionStack &exceptionS
 }
 
 void setSpiderMonkeyException(JSContext *cx) {
+  if (GCParameters::raiseOutOfMemory(cx)) { // MemoryError, reporting the "out of memory" exception would need memory
+    return;
+  }
   if (PyErr_Occurred()) { // Check if a Python exception has already been set, otherwise `PyErr_SetString` would overwrite the exception set
     return;
   }
   if (!JS_IsExceptionPending(cx)) {
-    PyErr_SetString(SpiderMonkeyError, "Spidermonkey failed, but spidermonkey did not set an exception.");
+    PyErr_SetString(SpiderMonkeyError(), "Spidermonkey failed, but spidermonkey did not set an exception.");
     return;
   }
   JS::ExceptionStack exceptionStack(cx);
   if (!JS::GetPendingExceptionStack(cx, &exceptionStack)) {
-    PyErr_SetString(SpiderMonkeyError, "Spidermonkey set an exception, but was unable to retrieve it.");
+    PyErr_SetString(SpiderMonkeyError(), "Spidermonkey set an exception, but was unable to retrieve it.");
     return;
   }
 
@@ -108,7 +112,7 @@ void setSpiderMonkeyException(JSContext *cx) {
   // `PyErr_SetString` uses `PyErr_SetObject` with `PyUnicode_FromString` under the hood
   //    see https://github.com/python/cpython/blob/3.9/Python/errors.c#L234-L236
   PyObject *errStr = getExceptionString(cx, exceptionStack, printStack);
-  PyObject *errObj = PyObject_CallFunction(SpiderMonkeyError, "O", errStr); // errObj = SpiderMonkeyError(errStr)
+  PyObject *errObj = PyObject_CallFunction(SpiderMonkeyError(), "O", errStr); // errObj = SpiderMonkeyError(errStr)
   Py_XDECREF(errStr);
   // Preserve the original JS value as the `jsError` attribute for lossless back conversion
   PyObject *originalJsErrCapsule = DictType::getPyObject(cx, exn);
@@ -116,6 +120,6 @@ void setSpiderMonkeyException(JSContext *cx) {
   Py_XDECREF(originalJsErrCapsule);
   // `PyErr_SetObject` can accept either an already created Exception instance or the containing exception value as the second argument
   //  see https://github.com/python/cpython/blob/v3.9.16/Python/errors.c#L134-L150
-  PyErr_SetObject(SpiderMonkeyError, errObj);
+  PyErr_SetObject(SpiderMonkeyError(), errObj);
   Py_XDECREF(errObj);
 }
@@ -0,0 +1,27 @@
+# @file     bench_bytes_scan.py - Benchmark scanning Python bytes from JS, byte by byte
+#           Usage: python3 tests/benchmarks/bench_bytes_scan.py [number of megabytes]
+# @author   Philippe Laporte <philippe@distributive.network>
+# @date     October 2026
+# @copyright Copyright (c) 2026 Distributive Corp.
+
+import sys
+import timeit
+import pythonmonkey as pm
+
+megabytes = int(sys.argv[1]) if len(sys.argv) > 1 else 64
+repeat = 5
+
+data = bytes(range(256)) * (megabytes * 4096)
+
+countNewlines = pm.eval("""(bytes) => {
+  let n = 0;
+  for (let i = 0; i < bytes.length; i++)
+    if (bytes[i] === 10) n++;
+  return n;
+}""")
+passThrough = pm.eval("(bytes) => bytes.length")
+
+assert countNewlines(data) == megabytes * 4096  # warm up
+for name, fn in [('conversion', passThrough), ('scan', countNewlines)]:
+  seconds = min(timeit.repeat(lambda: fn(data), number=1, repeat=repeat))
+  print(f'{name:12} {megabytes} MB: {seconds * 1000:9.2f} ms')
@@ -0,0 +1,23 @@
+# @file     bench_dict_keys.py - Benchmark key enumeration of Python dicts proxied to JS
+#           Usage: python3 tests/benchmarks/bench_dict_keys.py [number of keys]
+# @author   Philippe Laporte <philippe@distributive.network>
+# @date     October 2026
+# @copyright Copyright (c) 2026 Distributive Corp.
+
+import sys
+import timeit
+import pythonmonkey as pm
+
+numberOfKeys = int(sys.argv[1]) if len(sys.argv) > 1 else 100_000
+repeat = 10
+
+d = {f'key{i}': i for i in range(numberOfKeys)}
+
+objectKeys = pm.eval("(obj) => { Object.keys(obj); }")
+jsonStringify = pm.eval("(obj) => { JSON.stringify(obj); }")
+forIn = pm.eval("(obj) => { let n = 0; for (const k in obj) n++; return n; }")
+
+for name, fn in [('Object.keys', objectKeys), ('JSON.stringify', jsonStringify), ('for...in', forIn)]:
+  fn(d)  # warm up
+  seconds = min(timeit.repeat(lambda: fn(d), number=1, repeat=repeat))
+  print(f'{name:16} {numberOfKeys} keys: {seconds * 1000:9.2f} ms')
@@ -0,0 +1,53 @@
+# @file     bench_process_pool.py - Benchmark the throughput of CPU-bound JavaScript calls in a ProcessPool of 1 to N processes
+#           Usage: python3 tests/benchmarks/bench_process_pool.py [max number of processes] [calls per process]
+# @author   Philippe Laporte <philippe@distributive.network>
+# @date     October 2026
+# @copyright Copyright (c) 2026 Distributive Corp.
+
+import asyncio
+import os
+import sys
+import tempfile
+import time
+import pythonmonkey as pm
+
+maxProcesses = int(sys.argv[1]) if len(sys.argv) > 1 else (os.cpu_count() or 4)
+callsPerProcess = int(sys.argv[2]) if len(sys.argv) > 2 else 50
+module = os.path.join(tempfile.gettempdir(), 'bench-pool.js')  # workers spawned where fork() is missing import this script too
+
+
+def writeModule():
+  with open(module, 'w') as file:
+    file.write("""
+      exports.work = function work(seed) {
+        let sum = 0;
+        for (let i = 0; i < 2000000; i++)
+          sum = (sum + i * seed) % 1000003;
+        return sum;
+      };
+    """)
+
+
+async def run(numberOfProcesses):
+  start = time.perf_counter()
+  with pm.ProcessPool(numberOfProcesses, preload=[module]) as pool:
+    # one call per worker, each one being busy until it returns, so that every worker has started before timing
+    await asyncio.gather(*[pool.call(module, 'work', 0) for i in range(numberOfProcesses)])
+    started = time.perf_counter()
+    await asyncio.gather(*[pool.call(module, 'work', i) for i in range(numberOfProcesses * callsPerProcess)])
+    end = time.perf_counter()
+  return started - start, end - started
+
+
+async def main():
+  baseline = None
+  for numberOfProcesses in range(1, maxProcesses + 1):
+    startup, seconds = await run(numberOfProcesses)
+    throughput = numberOfProcesses * callsPerProcess / seconds
+    baseline = baseline or throughput
+    print(f'{numberOfProcesses:3} processes {throughput:10.1f} calls/s {throughput / baseline:6.2f}x'
+          f' (pool started in {startup * 1000:.1f}ms)')
+
+if __name__ == '__main__':
+  writeModule()
+  asyncio.run(main())
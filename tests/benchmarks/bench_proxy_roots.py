@@ -0,0 +1,41 @@
+# @file     bench_proxy_roots.py - Benchmark creating and dropping Python proxies of JS objects, arrays, functions and strings
+#           Usage: python3 tests/benchmarks/bench_proxy_roots.py [number of proxies]
+# @author   Philippe Laporte <philippe@distributive.network>
+# @date     October 2026
+# @copyright Copyright (c) 2026 Distributive Corp.
+
+import sys
+import timeit
+import pythonmonkey as pm
+
+count = int(sys.argv[1]) if len(sys.argv) > 1 else 10_000_000
+repeat = 3
+
+makers = [
+  ('object', pm.eval("() => ({})")),
+  ('array', pm.eval("() => []")),
+  ('function', pm.eval("() => () => 1")),
+  ('string', pm.eval("() => 'a string that is not interned'.slice(1)")),
+]
+
+
+def createAndDrop(make):
+  for _ in range(count):
+    make()
+
+
+def createAllThenDrop(make):
+  proxies = [make() for _ in range(count // 10)]
+  del proxies
+
+
+for name, make in makers:
+  make()  # warm up
+  seconds = min(timeit.repeat(lambda: createAndDrop(make), number=1, repeat=repeat))
+  print(f'{name:10} create/drop  {count}: {seconds:8.2f} s, {seconds / count * 1e9:7.1f} ns per proxy')
+  seconds = min(timeit.repeat(lambda: createAllThenDrop(make), number=1, repeat=repeat))
+  print(f'{name:10} batch create {count // 10}: {seconds:8.2f} s, {seconds / (count // 10) * 1e9:7.1f} ns per proxy')
+
+pm.collect()
+info = pm.gc_info()
+print(f"roots {info['proxy_roots']}, slots {info['proxy_root_slots']}")
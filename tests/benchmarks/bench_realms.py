@@ -0,0 +1,40 @@
+# @file     bench_realms.py - Benchmark the cost of creating, using and dropping pythonmonkey.Realm objects
+#           Usage: python3 tests/benchmarks/bench_realms.py [number of realms]
+# @author   Philippe Laporte <philippe@distributive.network>
+# @date     October 2026
+# @copyright Copyright (c) 2026 Distributive Corp.
+
+import sys
+import timeit
+import pythonmonkey as pm
+
+numberOfRealms = int(sys.argv[1]) if len(sys.argv) > 1 else 10_000
+repeat = 5
+
+code = "[1, 2, 3].map(x => x * 2).join(',')"
+
+
+def create():
+  pm.Realm()
+
+
+def createAndEval():
+  with pm.Realm() as realm:
+    realm.eval(code)
+
+
+def createEvalAndCollect():
+  createAndEval()
+  pm.collect()
+
+
+for name, fn, number in [
+  ('create', create, numberOfRealms),
+  ('create + eval', createAndEval, numberOfRealms),
+  ('create + eval + GC', createEvalAndCollect, max(numberOfRealms // 100, 1)),
+  ('eval in main realm', lambda: pm.eval(code), numberOfRealms),
+]:
+  fn()  # warm up
+  seconds = min(timeit.repeat(fn, number=number, repeat=repeat))
+  print(f'{name:20} {seconds / number * 1_000_000:9.2f} us per iteration')
+pm.collect()
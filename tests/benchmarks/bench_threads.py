@@ -0,0 +1,45 @@
+# @file     bench_threads.py - Benchmark the throughput of JavaScript evaluated from 1 to N Python threads
+#           Usage: python3 tests/benchmarks/bench_threads.py [max number of threads] [evaluations per thread]
+# @author   Philippe Laporte <philippe@distributive.network>
+# @date     October 2026
+# @copyright Copyright (c) 2026 Distributive Corp.
+
+import os
+import sys
+import threading
+import time
+import pythonmonkey as pm
+
+maxThreads = int(sys.argv[1]) if len(sys.argv) > 1 else (os.cpu_count() or 4)
+evaluations = int(sys.argv[2]) if len(sys.argv) > 2 else 200
+
+code = "let sum = 0; for (let i = 0; i < 100000; i++) sum += i % 7; sum"
+
+
+def work():
+  script = pm.compile(code)  # compiled in the context of this thread
+  for i in range(evaluations):
+    script()
+
+
+def run(numberOfThreads):
+  threads = [threading.Thread(target=work) for i in range(numberOfThreads)]
+  start = time.perf_counter()
+  for thread in threads:
+    thread.start()
+  for thread in threads:
+    thread.join()
+  return time.perf_counter() - start
+
+
+run(1)  # warm up
+for releaseGIL in (False, True):
+  pm.set_release_gil(releaseGIL)
+  print(f'GIL {"released" if releaseGIL else "held"} while JavaScript runs')
+  baseline = None
+  for numberOfThreads in range(1, maxThreads + 1):
+    seconds = run(numberOfThreads)
+    throughput = numberOfThreads * evaluations / seconds
+    baseline = baseline or throughput
+    print(f'{numberOfThreads:3} threads {throughput:12.1f} evaluations/s {throughput / baseline:6.2f}x')
+pm.set_release_gil(False)
@@ -0,0 +1,84 @@
+import os
+import subprocess
+import sys
+import pytest
+import pythonmonkey as pm
+
+
+def test_bootstrap_timings():
+  for phase in ['init', 'context', 'global', 'module', 'helpers', 'require', 'console', 'XMLHttpRequest']:
+    assert phase in pm.bootstrap_timings
+    assert pm.bootstrap_timings[phase] >= 0.0
+
+
+@pytest.mark.skipif(bool(os.environ.get('PYTHONMONKEY_STENCIL_CACHE')), reason="caching all scripts")
+def test_bootstrap_cache_is_disabled_after_import():
+  assert pm.stencil_cache_info()['directory'] is None
+
+
+def importInSubprocess(overrides):
+  env = {name: value for name, value in os.environ.items() if not name.startswith('PYTHONMONKEY_')}
+  env.update(overrides)
+  subprocess.run([sys.executable, '-c', 'import pythonmonkey'], env=env, check=True, timeout=300)
+
+
+def test_bootstrap_cache_is_per_user_by_default(tmp_path):
+  importInSubprocess({'XDG_CACHE_HOME': str(tmp_path), 'LOCALAPPDATA': str(tmp_path)})
+  assert os.listdir(tmp_path / 'pythonmonkey' / 'bootstrap')
+
+
+def test_bootstrap_cache_can_be_disabled(tmp_path):
+  importInSubprocess({'XDG_CACHE_HOME': str(tmp_path), 'LOCALAPPDATA': str(tmp_path), 'PYTHONMONKEY_BOOTSTRAP_CACHE': ''})
+  assert not os.path.exists(tmp_path / 'pythonmonkey')
+
+
+def test_lazy_timers():
+  assert "function" == pm.eval("typeof setTimeout")
+  assert "value" in pm.eval("Object.getOwnPropertyDescriptor(globalThis, 'setInterval')")
+  assert 'timers' in pm.bootstrap_timings
+
+
+def test_lazy_timers_can_be_replaced():
+  original = pm.eval("clearImmediate")
+  pm.eval("globalThis.clearImmediate = () => 'replaced'")
+  try:
+    assert 'replaced' == pm.eval("clearImmediate()")
+  finally:
+    pm.eval("(original) => { globalThis.clearImmediate = original; }")(original)
+
+
+def test_lazy_debugger_global():
+  debuggerGlobal = pm.eval("debuggerGlobal")
+  assert "function" == pm.eval("(g) => typeof g.Debugger")(debuggerGlobal)
+  assert pm.eval("debuggerGlobal === debuggerGlobal")
+  assert "value" in pm.eval("Object.getOwnPropertyDescriptor(globalThis, 'debuggerGlobal')")
+
+
+def test_lazy_inspect():
+  assert "{ a: 1 }" == pm.bootstrap.inspect(pm.eval("({ a: 1 })"))
+
+
+def test_lazy_globals_survive_a_failed_load():
+  attempts = []
+
+  def requireModule():
+    attempts.append(True)
+    if len(attempts) == 1:
+      raise ImportError("not yet")
+    pm.eval("globalThis.lazyTestGlobal = 'loaded'")
+
+  pm._lazyGlobals(['lazyTestGlobal'], requireModule)
+  try:
+    with pytest.raises(Exception, match="not yet"):
+      pm.eval("lazyTestGlobal")
+    assert "get" in pm.eval("Object.getOwnPropertyDescriptor(globalThis, 'lazyTestGlobal')")
+    assert 'loaded' == pm.eval("lazyTestGlobal")
+    assert 2 == len(attempts)
+  finally:
+    pm.eval("delete globalThis.lazyTestGlobal")
+
+
+def test_debugger_global_export():
+  from pythonmonkey import debuggerGlobal
+  assert pm.eval("(g) => g === debuggerGlobal")(debuggerGlobal)
+  assert "function" == pm.eval("(g) => typeof g.Debugger")(pm.debuggerGlobal)
@@ -6,13 +6,14 @@ import array
 import struct
 from io import StringIO
 import sys
+import mmap
 
 
 def test_py_buffer_to_js_typed_array():
   # JS TypedArray/ArrayBuffer should coerce to Python memoryview type
   def assert_js_to_py_memoryview(buf: memoryview):
     assert type(buf) is memoryview
-    assert None is buf.obj  # https://docs.python.org/3.9/c-api/buffer.html#c.Py_buffer.obj
+    assert type(buf.obj) is pm.JSArrayBufferProxy  # https://docs.python.org/3.9/c-api/buffer.html#c.Py_buffer.obj
     assert 2 * 4 == buf.nbytes  # 2 elements * sizeof(int32_t)
     assert "02000000ffffffff" == buf.hex()  # native (little) endian
   buf1 = pm.eval("new Int32Array([2,-1])")
@@ -191,24 +192,203 @@ def test_py_buffer_to_js_typed_array():
   # TODO (Tom Tang): once a JS ArrayBuffer is transferred to a worker
   # thread, it should be invalidated in Python-land as well
 
-  # TODO (Tom Tang): error for detached ArrayBuffer, or should it be considered as empty?
+  # multidimensional arrays are flattened, their layout is exposed as `shape` and `strides` (in elements)
+  numpy_2d_array = numpy.array([[1, 2, 3], [4, 5, 6]], dtype=numpy.int32, order="C")
+  assert [2.0, 3.0] == pm.eval("(typedArray) => typedArray.shape")(numpy_2d_array)
+  assert [3.0, 1.0] == pm.eval("(typedArray) => typedArray.strides")(numpy_2d_array)
+  assert "1,2,3,4,5,6" == pm.eval("(typedArray) => typedArray.toString()")(numpy_2d_array)
+
+  # Fortran order (column major) is shared as well, in memory order
+  fortran_order_arr = numpy.array([[1, 2, 3], [4, 5, 6]], dtype=numpy.int32, order="F")
+  assert [2.0, 3.0] == pm.eval("(typedArray) => typedArray.shape")(fortran_order_arr)
+  assert [1.0, 2.0] == pm.eval("(typedArray) => typedArray.strides")(fortran_order_arr)
+  assert "1,4,2,5,3,6" == pm.eval("(typedArray) => typedArray.toString()")(fortran_order_arr)
+
+
+def test_py_buffer_nd_shares_memory():
+  arr = numpy.zeros((2, 3), dtype=numpy.float64)
+  pm.eval("(typedArray) => { typedArray[typedArray.strides[0] * 1 + typedArray.strides[1] * 2] = 7; }")(arr)
+  assert 7 == arr[1, 2]
+  arr = numpy.zeros((2, 3), dtype=numpy.float64, order="F")
+  pm.eval("(typedArray) => { typedArray[typedArray.strides[0] * 1 + typedArray.strides[1] * 2] = 7; }")(arr)
+  assert 7 == arr[1, 2]
+
+
+def test_py_buffer_offset_view_shares_memory():
+  arr = numpy.arange(8, dtype=numpy.int32)
+  view = arr[3:6]
+  assert "3,4,5" == pm.eval("(typedArray) => typedArray.toString()")(view)
+  pm.eval("(typedArray) => { typedArray[0] = 42; }")(view)
+  assert 42 == arr[3]
+  matrix = numpy.arange(12, dtype=numpy.int16).reshape(3, 4)
+  pm.eval("(typedArray) => { typedArray[0] = -1; }")(matrix[1:])
+  assert -1 == matrix[1, 0]
+
+
+def test_py_buffer_non_contiguous_is_copied():
+  arr = numpy.arange(8, dtype=numpy.int32)
+  assert "0,2,4,6" == pm.eval("(typedArray) => typedArray.toString()")(arr[::2])
+  assert "7,6,5,4,3,2,1,0" == pm.eval("(typedArray) => typedArray.toString()")(arr[::-1])
+  pm.eval("(typedArray) => { typedArray[0] = 42; }")(arr[::2])
+  assert 0 == arr[0]  # a copy
+
+  # copies are in C order
+  matrix = numpy.arange(12, dtype=numpy.int32).reshape(3, 4)[:, 1:3]
+  assert [3.0, 2.0] == pm.eval("(typedArray) => typedArray.shape")(matrix)
+  assert [2.0, 1.0] == pm.eval("(typedArray) => typedArray.strides")(matrix)
+  assert "1,2,5,6,9,10" == pm.eval("(typedArray) => typedArray.toString()")(matrix)
+
+
+def test_py_buffer_misaligned_is_copied():
+  raw = bytearray(13)
+  view = memoryview(raw)[1:].cast("i")
+  view[0] = 5
+  assert 5 == pm.eval("(typedArray) => typedArray[0]")(view)
+  assert pm.eval("(typedArray) => typedArray instanceof Int32Array")(view)
+
+
+def test_py_buffer_unsupported_format_raises():
+  import ctypes
+  structs = (ctypes.c_int32 * 2)()  # format '<i', which no TypedArray type matches
+  with pytest.raises(TypeError, match="Invalid Python buffer type"):
+    pm.eval("(typedArray) => typedArray")(structs)
+  assert pm.eval("(typedArray) => typedArray instanceof Uint8Array")(bytearray(structs))
+
+
+def test_py_buffer_1d_has_no_layout():
+  assert pm.eval("(typedArray) => !('shape' in typedArray) && !('strides' in typedArray)")(bytearray(4))
+
+
+def test_js_buffer_outlives_js_references():
+  buf = pm.eval("(() => { const arr = new Float64Array(4); arr[3] = 1.5; return arr; })()")
+  for i in range(4):  # the TypedArray is only referenced from Python now
+    gc.collect(), pm.collect()
+  assert [0.0, 0.0, 0.0, 1.5] == buf.tolist()
+  copy = memoryview(buf.obj)  # a new export from the same JS TypedArray
+  buf.release()
+  gc.collect(), pm.collect()
+  assert 1.5 == copy[3]
+
+
+def test_js_buffer_small_typed_array_data_does_not_move():
+  # small TypedArrays keep their data inline, which would move with the object during a compacting GC
+  bufs = [pm.eval(f"new Uint8Array([{i}, {i + 1}])") for i in range(100)]
+  pm.eval("for (let i = 0; i < 1000; i++) new Array(100).fill({});")
+  gc.collect(), pm.collect()
+  assert [[i, i + 1] for i in range(100)] == [buf.tolist() for buf in bufs]
+
+
+def test_js_buffer_cannot_be_detached_while_exported():
+  holder = pm.eval("({ arrayBuffer: new ArrayBuffer(8) })")
+  transfer = pm.eval("(holder) => { holder.arrayBuffer.transfer(); }")
+  buf = holder['arrayBuffer']
+  with pytest.raises(pm.SpiderMonkeyError):
+    transfer(holder)
+  assert 8 == buf.nbytes
+  buf.release()
+  transfer(holder)  # no more exports, the length is no longer pinned
+
+
+def test_js_buffer_detached():
+  with pytest.raises(BufferError, match="the JS ArrayBuffer has been detached"):
+    pm.eval("(() => { const arrayBuffer = new ArrayBuffer(8); arrayBuffer.transfer(); return arrayBuffer; })()")
+
+
+
+def test_js_shared_array_buffer():
+  holder = pm.eval("({ sab: new SharedArrayBuffer(8) })")
+  buf = holder['sab']
+  assert type(buf.obj) is pm.JSArrayBufferProxy
+  assert "B" == buf.format
+  assert 8 == buf.nbytes
+  buf[0] = 7
+  assert 7 == pm.eval("(holder) => new Uint8Array(holder.sab)[0]")(holder)
+  pm.eval("(holder) => { Atomics.add(new Int32Array(holder.sab), 1, 5); }")(holder)
+  assert 5 == buf.cast("i")[1]
+  # the memoryview goes back to JS as the same SharedArrayBuffer
+  assert pm.eval("(holder, sab) => holder.sab === sab")(holder, buf)
+
+
+def test_js_typed_array_on_shared_memory():
+  buf = pm.eval("(() => { const arr = new Int32Array(new SharedArrayBuffer(8)); Atomics.store(arr, 1, -3); return arr; })()")
+  assert "i" == buf.format
+  assert [0, -3] == buf.tolist()
+  assert pm.eval("(arr) => arr.buffer instanceof SharedArrayBuffer")(buf)
+
+
+def test_js_data_view():
+  holder = pm.eval("({ dataView: new DataView(new Uint8Array([1, 2, 3, 4]).buffer, 1, 2) })")
+  buf = holder['dataView']
+  assert type(buf) is memoryview
+  assert "B" == buf.format
+  assert [2, 3] == buf.tolist()
+  buf[1] = 0xff
+  assert 0xff == pm.eval("(holder) => holder.dataView.getUint8(1)")(holder)
+  assert pm.eval("(holder, dataView) => holder.dataView === dataView")(holder, buf)
+  # only part of the DataView, the bytes are shared through a new Uint8Array
+  assert pm.eval("(dataView) => dataView instanceof Uint8Array && dataView[0] === 0xff")(buf[1:])
 
-  # buffer should be in C order (row major)
-  # 1-D array is always considered C-contiguous because it doesn't matter if it's row or column major in 1-D
-  fortran_order_arr = numpy.array([[1, 2], [3, 4]], order="F")
-  with pytest.raises(ValueError, match="ndarray is not C-contiguous"):
-    pm.eval("(typedArray) => {}")(fortran_order_arr)
 
-  # disallow multidimensional array
-  numpy_2d_array = numpy.array([[1, 2], [3, 4]], order="C")
-  with pytest.raises(BufferError, match="multidimensional arrays are not allowed"):
-    pm.eval("(typedArray) => {}")(numpy_2d_array)
+def test_py_bytearray_resizable_after_js_gc():
+  arr = bytearray(8)
+  pm.eval("(arr) => { new DataView(arr.buffer).setUint8(0, 1); }")(arr)
+  for i in range(2):
+    gc.collect(), pm.collect()
+  arr.extend(b"resized")  # no JS ArrayBuffer exports the bytearray anymore
+  assert 1 == arr[0]
 
 
+def test_py_mmap_closable_after_js_gc():
+  mm = mmap.mmap(-1, 16)
+  pm.eval("(arr) => { arr[0] = 42; }")(mm)
+  assert 42 == mm[0]
+  for i in range(2):
+    gc.collect(), pm.collect()
+  mm.close()  # no JS ArrayBuffer exports the mmap anymore
 
-def test_bytes_proxy_write():
-  with pytest.raises(TypeError, match="'bytes' object has only read-only attributes"):
-    pm.eval('(bytes) => bytes[0] = 5')(bytes("hello world", "ascii"))
+
+def test_bytes_write():
+  # JS gets a private copy of immutable buffers, writes never reach the Python bytes
+  b = bytes("hello world", "ascii")
+  assert 5 == pm.eval('(bytes) => { bytes[0] = 5; return bytes[0]; }')(b)
+  assert b == b"hello world"
+
+
+def test_bytes_modified_round_trip():
+  b = bytes("hello world", "ascii")
+  modified = pm.eval('(bytes) => { bytes[0] = 72; return bytes; }')(b)
+  assert modified is not b
+  assert bytes(modified) == b"Hello world"
+  assert b == b"hello world"
+
+
+def test_bytes_subarray_round_trip():
+  b = pm.eval('(bytes) => bytes.subarray(6)')(bytes("hello world", "ascii"))
+  assert bytes(b) == b"world"
+
+
+def test_bytes_native_typed_array():
+  assert pm.eval('(bytes) => ArrayBuffer.isView(bytes) && Object.getPrototypeOf(bytes) === Uint8Array.prototype')(b"abc")
+  assert "abc" == pm.eval('(bytes) => String.fromCharCode(...bytes)')(b"abc")
+  assert 3 == pm.eval('(bytes) => bytes.subarray(1).reduce((a, b) => a + b - 97, 0)')(b"abc")
+
+
+def test_readonly_buffer_keeps_subtype():
+  arr = numpy.array([1.5, -2.5], dtype=numpy.float64)
+  arr.flags.writeable = False
+  assert pm.eval('(arr) => arr instanceof Float64Array && arr[1] === -2.5')(arr)
+  assert pm.eval('(arr) => arr')(arr) is arr
+
+
+def test_readonly_buffer_changed_by_python():
+  base = numpy.array([1.5, -2.5], dtype=numpy.float64)
+  arr = base.view()
+  arr.flags.writeable = False
+  keep = pm.eval('(arr) => { globalThis.keptReadonlyArray = arr; return () => globalThis.keptReadonlyArray; }')(arr)
+  base[0] = 7.5  # the JS copy no longer matches
+  assert keep() is not arr
+  assert keep()[0] == 1.5
+  pm.eval('delete globalThis.keptReadonlyArray')
 
 
 def test_bytes_get_index_python():
@@ -221,6 +401,15 @@ def test_bytes_get_index_js():
   assert b == 101.0  
 
 
+def test_bytes_get_index_out_of_bounds_js():
+  assert pm.eval('(bytes) => bytes[11] === undefined && bytes[1e9] === undefined')(bytes("hello world", "ascii"))
+
+
+def test_bytes_round_trip_is_the_same_object():
+  b = bytes("hello world", "ascii")
+  assert pm.eval('(bytes) => bytes')(b) is b
+
+
 def test_bytes_bytes_per_element():
   b = pm.eval('(bytes) => bytes.BYTES_PER_ELEMENT')(bytes("hello world", "ascii"))
   assert b == 1.0  
@@ -260,8 +449,9 @@ def test_constructor_creates_typedarray():
 
 
 def test_bytes_valueOf():
-  a = pm.eval('(bytes) => bytes.valueOf()')(bytes("hello world", "ascii"))
-  assert a == "104,101,108,108,111,32,119,111,114,108,100"   
+  b = bytes("hello world", "ascii")
+  a = pm.eval('(bytes) => bytes.valueOf()')(b)
+  assert a is b
 
 
 def test_bytes_toString():
@@ -273,7 +463,8 @@ def test_bytes_console():
   temp_out = StringIO()
   sys.stdout = temp_out
   pm.eval('console.log')(bytes("hello world", "ascii"))
-  assert temp_out.getvalue().__contains__('104,101,108,108,111,32,119,111,114,108,100')
+  assert temp_out.getvalue().__contains__('Uint8Array(11)')
+  assert temp_out.getvalue().__contains__('104')
 
 
 # iterator symbol property
@@ -379,3 +379,29 @@ def test___class__attribute():
 def test___none__attribute():
   a = pm.eval("({'0': 1, '1': 2})")
   assert a[2] is None
+
+# key enumeration
+
+
+def test_object_keys_many_keys():
+  d = {f'key{i}': i for i in range(1000)}
+  keys = pm.eval("(obj) => Object.keys(obj)")(d)
+  assert keys == list(d.keys())
+  # enumerating again goes through the cached key ids
+  assert pm.eval("(obj) => Object.keys(obj)")(d) == list(d.keys())
+
+
+def test_object_keys_non_latin1_keys():
+  d = {'a': 1, 'é': 2, 'λ': 3, '🐍': 4}
+  assert pm.eval("(obj) => Object.keys(obj)")(d) == ['a', 'é', 'λ', '🐍']
+  assert pm.eval("(obj) => obj['λ'] + obj['🐍']")(d) == 7.0
+
+
+def test_for_in_dict():
+  d = {'a': 1, 'b': 2, 'c': 3}
+  assert pm.eval("(obj) => { let keys = []; for (let k in obj) keys.push(k); return keys; }")(d) == ['a', 'b', 'c']
+
+
+def test_json_stringify_dict():
+  d = {'a': 1, 'b': 'two', 'c': {'d': 3}}
+  assert pm.eval("(obj) => JSON.stringify(obj)")(d) == '{"a":1,"b":"two","c":{"d":3}}'
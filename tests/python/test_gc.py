@@ -0,0 +1,244 @@
+import asyncio
+import gc
+import subprocess
+import sys
+import weakref
+import pytest
+import pythonmonkey as pm
+
+
+@pytest.fixture
+def idle_gc():
+  yield
+  pm.set_idle_gc(False, slice_budget_ms=5, delay=0.1, threshold=1024 * 1024)
+
+
+def test_collect_kinds():
+  pm.eval("globalThis.gcGarbage = Array.from({ length: 10000 }, (_, i) => ({ i }))")
+  pm.eval("delete globalThis.gcGarbage")
+  assert pm.collect() is True
+  assert pm.collect("full") is True
+  assert pm.collect("minor") in (True, False)
+  assert pm.collect("shrinking") is True
+  assert pm.collect(kind="full") is True
+
+
+def test_collect_incremental_finishes():
+  pm.eval("globalThis.gcGarbage = Array.from({ length: 100000 }, (_, i) => ({ i }))")
+  pm.eval("delete globalThis.gcGarbage")
+  for _ in range(100000):
+    if pm.collect("incremental", budget_ms=1):
+      break
+  assert pm.gc_info()['in_progress'] is False
+
+
+def test_collect_invalid_kind():
+  with pytest.raises(ValueError, match="unknown kind of collection"):
+    pm.collect("major")
+  with pytest.raises(ValueError):
+    pm.collect("incremental", budget_ms=-1)
+
+
+def test_set_idle_gc_validates(idle_gc):
+  with pytest.raises(ValueError):
+    pm.set_idle_gc(True, slice_budget_ms=0)
+  with pytest.raises(ValueError):
+    pm.set_idle_gc(True, delay=-1)
+  with pytest.raises(ValueError):
+    pm.set_idle_gc(True, threshold=-1)
+
+
+def test_gc_info(idle_gc):
+  pm.set_idle_gc(True, slice_budget_ms=3, delay=0.25, threshold=4096)
+  info = pm.gc_info()
+  assert info['idle'] is True
+  assert info['slice_budget_ms'] == 3
+  assert info['delay'] == 0.25
+  assert info['threshold'] == 4096
+  assert info['heap_bytes'] > 0
+  pm.set_idle_gc(False)
+  info = pm.gc_info()
+  assert info['idle'] is False
+  assert info['slice_budget_ms'] == 3  # settings not passed are kept
+
+
+def test_idle_gc_collects_while_the_loop_is_idle(idle_gc):
+  pm.set_idle_gc(True, slice_budget_ms=2, delay=0.01, threshold=0)
+  before = pm.gc_info()['idle_slices']
+
+  async def main():
+    for _ in range(5):
+      pm.eval("Array.from({ length: 50000 }, (_, i) => ({ i })).length")
+      await asyncio.sleep(0.1)
+
+  asyncio.run(main())
+  assert pm.gc_info()['idle_slices'] > before
+
+
+def test_idle_gc_disabled_runs_no_slices(idle_gc):
+  pm.set_idle_gc(False)
+  before = pm.gc_info()['idle_slices']
+
+  async def main():
+    pm.eval("Array.from({ length: 50000 }, (_, i) => ({ i })).length")
+    await asyncio.sleep(0.1)
+
+  asyncio.run(main())
+  assert pm.gc_info()['idle_slices'] == before
+
+
+def test_gc_params_round_trip():
+  params = pm.get_gc_params()
+  assert params['max_bytes'] is None  # unlimited by default
+  for name in ('min_nursery_bytes', 'max_nursery_bytes', 'slice_time_budget_ms', 'marking_threads',
+               'helper_thread_ratio', 'max_helper_threads'):
+    assert isinstance(params[name], int)
+  for name in ('incremental', 'per_zone', 'compacting', 'parallel_marking'):
+    assert isinstance(params[name], bool)
+
+  try:
+    pm.set_gc_params(max_bytes=1024 * 1024 * 1024, compacting=False, slice_time_budget_ms=7)
+    params = pm.get_gc_params()
+    assert params['max_bytes'] == 1024 * 1024 * 1024
+    assert params['compacting'] is False
+    assert params['slice_time_budget_ms'] == 7
+    pm.set_idle_gc(True, slice_budget_ms=3)
+    assert pm.get_gc_params()['slice_time_budget_ms'] == 7  # set explicitly, it wins over idle collection
+  finally:
+    pm.set_gc_params(max_bytes=None, compacting=None, slice_time_budget_ms=None)
+    pm.set_idle_gc(False, slice_budget_ms=5)
+  params = pm.get_gc_params()
+  assert params['max_bytes'] is None
+  assert params['compacting'] is True
+  assert params['incremental'] is True
+  assert params['slice_time_budget_ms'] == 0  # unlimited without idle collection
+
+
+def test_gc_params_validation():
+  with pytest.raises(TypeError, match="unexpected keyword argument 'heap'"):
+    pm.set_gc_params(heap=1)
+  with pytest.raises(TypeError):
+    pm.set_gc_params(1)
+  with pytest.raises(TypeError):
+    pm.set_gc_params(max_nursery_bytes="big")
+  with pytest.raises(ValueError):
+    pm.set_gc_params(max_bytes=-1)
+  with pytest.raises(ValueError):
+    pm.set_gc_params(max_bytes=2 ** 32)
+
+
+def test_out_of_memory_raises_memory_error():
+  # in a process of its own, so that the heap limit does not affect other tests
+  script = """if True:
+    import pythonmonkey as pm
+    pm.set_gc_params(max_bytes=pm.gc_info()['heap_bytes'] + 32 * 1024 * 1024)
+    try:
+      pm.eval("const objs = []; while (true) objs.push({ i: objs.length, s: 'x' + objs.length })")
+    except MemoryError:
+      print('MemoryError')
+    pm.set_gc_params(max_bytes=None)
+    pm.collect()
+    print(pm.eval('1 + 1'), pm.gc_info()['out_of_memory'] > 0)
+  """
+  result = subprocess.run([sys.executable, '-c', script], capture_output=True, text=True, timeout=300)
+  assert result.returncode == 0, result.stderr
+  assert result.stdout.split() == ['MemoryError', '2.0', 'True']
+
+
+class Holder:
+  pass
+
+
+def test_cycle_through_js_closure_is_collected():
+  holder = Holder()
+  holder.closure = pm.eval("(captured) => () => captured")(holder)
+  assert holder.closure() is holder
+  ref = weakref.ref(holder)
+  del holder
+  pm.collect()  # the cycle collection uses the gray bits of the last full JS collection
+  gc.collect()
+  assert ref() is None
+  assert pm.gc_info()['cycle_edges'] > 0
+
+
+def test_cycle_through_js_object_is_collected():
+  holder = Holder()
+  holder.obj = pm.eval("(captured) => ({ captured })")(holder)
+  holder.arr = pm.eval("(captured) => [captured]")(holder)
+  ref = weakref.ref(holder)
+  del holder
+  pm.collect()
+  gc.collect()
+  assert ref() is None
+
+
+def test_cycle_reachable_from_js_is_kept():
+  holder = Holder()
+  holder.closure = pm.eval("(captured) => globalThis.gcKeptClosure = () => captured")(holder)
+  ref = weakref.ref(holder)
+  del holder
+  pm.collect()
+  gc.collect()
+  assert ref() is not None
+  assert pm.eval("globalThis.gcKeptClosure")() is ref()
+  pm.eval("delete globalThis.gcKeptClosure")
+  pm.collect()
+  gc.collect()
+  assert ref() is None
+
+
+def test_set_cycle_collection():
+  try:
+    pm.set_cycle_collection(False)
+    assert pm.gc_info()['cycle_collection'] is False
+    holder = Holder()
+    holder.closure = pm.eval("(captured) => () => captured")(holder)
+    ref = weakref.ref(holder)
+    del holder
+    pm.collect()
+    gc.collect()
+    assert ref() is not None  # not collected while disabled
+  finally:
+    pm.set_cycle_collection(True)
+  assert pm.gc_info()['cycle_collection'] is True
+  gc.collect()
+  assert ref() is None
+
+
+def test_cycle_collection_reuses_the_last_js_collection():
+  holder = Holder()
+  holder.closure = pm.eval("(captured) => () => captured")(holder)
+  ref = weakref.ref(holder)
+  del holder
+  pm.collect()
+  forcedGCs = pm.gc_info()['cycle_forced_gcs']
+  gc.collect()
+  assert ref() is None
+  gc.collect()
+  assert pm.gc_info()['cycle_forced_gcs'] == forcedGCs
+
+
+def test_proxy_root_slots_are_reused():
+  makeProxies = pm.eval("() => [{}, [], () => 1, 'a string held by a proxy'.repeat(2)]")
+  proxies = [makeProxies() for _ in range(5000)]
+  info = pm.gc_info()
+  assert info['proxy_roots'] >= 20000
+  assert info['proxy_root_slots'] >= info['proxy_roots']
+  slots = info['proxy_root_slots']
+  del proxies
+  proxies = [makeProxies() for _ in range(5000)]
+  assert pm.gc_info()['proxy_root_slots'] <= slots
+  del proxies
+  assert pm.gc_info()['proxy_roots'] < 20000
+
+
+def test_recycled_proxies_are_reinitialized():
+  makeProxies = pm.eval("(n) => [{ n }, [n], () => n, 'string number ' + n]")
+  for n in range(1000):
+    obj, arr, fn, string = makeProxies(n)
+    assert isinstance(obj, dict) and obj['n'] == n and len(obj) == 1
+    assert isinstance(arr, list) and arr == [n]
+    assert fn() == n
+    assert isinstance(string, str) and string == f'string number {n}'
+    assert gc.is_tracked(obj) and gc.is_tracked(arr) and gc.is_tracked(fn)
+    del obj, arr, fn, string
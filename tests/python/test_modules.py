@@ -0,0 +1,86 @@
+import asyncio
+import json
+import pytest
+import pythonmonkey as pm
+
+
+def evalModule(path):
+  return pm.eval(path.read_text(), {'module': True, 'filename': str(path)})
+
+
+def test_module_namespace(tmp_path):
+  main = tmp_path / "main.mjs"
+  main.write_text("export const answer = 42; export default 'main';")
+  ns = evalModule(main)
+  assert 42.0 == ns.answer
+  assert 'main' == ns.default
+
+
+def test_static_imports_across_files(tmp_path):
+  (tmp_path / "lib").mkdir()
+  (tmp_path / "lib" / "math.mjs").write_text("export function add(a, b) { return a + b; }")
+  (tmp_path / "lib" / "index.js").write_text("export { add } from '../lib/math.mjs'; export const name = 'lib';")
+  main = tmp_path / "main.mjs"
+  main.write_text("import { add, name } from './lib'; export const result = name + add(1, 2);")
+  assert 'lib3' == evalModule(main).result
+
+
+def test_package_in_node_modules(tmp_path):
+  pkg = tmp_path / "node_modules" / "esm-pkg"
+  (pkg / "src").mkdir(parents=True)
+  (pkg / "package.json").write_text(json.dumps({'name': 'esm-pkg', 'main': 'cjs.js', 'module': 'src/entry.mjs'}))
+  (pkg / "src" / "entry.mjs").write_text("export const kind = 'esm';")
+  (tmp_path / "app").mkdir()
+  main = tmp_path / "app" / "main.mjs"
+  main.write_text("import { kind } from 'esm-pkg'; export { kind };")
+  assert 'esm' == evalModule(main).kind
+
+
+def test_shared_module_evaluated_once(tmp_path):
+  (tmp_path / "shared.mjs").write_text("globalThis.sharedEvaluations = (globalThis.sharedEvaluations || 0) + 1; export const obj = {};")
+  (tmp_path / "a.mjs").write_text("export { obj } from './shared.mjs';")
+  (tmp_path / "b.mjs").write_text("export { obj } from './shared.mjs';")
+  main = tmp_path / "main.mjs"
+  main.write_text("import { obj as a } from './a.mjs'; import { obj as b } from './b.mjs'; export const same = a === b;")
+  assert evalModule(main).same
+  evalModule(main)
+  assert 1.0 == pm.eval("globalThis.sharedEvaluations")
+
+
+def test_dynamic_import(tmp_path):
+  lib = tmp_path / "dynamic.mjs"
+  lib.write_text("export const value = 'imported';")
+
+  async def main():
+    ns = await pm.eval(f"import({json.dumps(str(lib))})")
+    return ns.value
+  assert 'imported' == asyncio.run(main())
+
+
+def test_import_meta(tmp_path):
+  main = tmp_path / "meta.mjs"
+  main.write_text("export const { url, filename, dirname } = import.meta;")
+  ns = evalModule(main)
+  assert ns.url.startswith("file://") and ns.url.endswith("/meta.mjs")
+  assert ns.filename == str(main)
+  assert ns.dirname == str(tmp_path)
+
+
+def test_missing_module(tmp_path):
+  main = tmp_path / "main.mjs"
+  main.write_text("import './does-not-exist.mjs';")
+  with pytest.raises(pm.SpiderMonkeyError, match="Cannot find module"):
+    evalModule(main)
+
+
+def test_syntax_error_in_dependency(tmp_path):
+  (tmp_path / "broken.mjs").write_text("export const = ;")
+  main = tmp_path / "main.mjs"
+  main.write_text("import './broken.mjs';")
+  with pytest.raises(pm.SpiderMonkeyError, match="SyntaxError"):
+    evalModule(main)
+
+
+def test_compile_rejects_modules():
+  with pytest.raises(ValueError):
+    pm.compile("export const a = 1;", {'module': True})
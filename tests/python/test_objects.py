@@ -1,5 +1,7 @@
 import pythonmonkey as pm
+import gc
 import sys
+import weakref
 
 
 def test_eval_pyobjects():
@@ -73,6 +75,103 @@ def test_eval_pyobjects_proxy_keys():
   assert pm.eval("(obj) => { return Object.keys(obj)[0]; }")(o) == 'a'
 
 
+def test_eval_pyobjects_proxy_keys_match_dir():
+  class Base:
+    x = 1
+
+    def method(self):
+      pass
+
+  class MyClass(Base):
+    def __init__(self):
+      self.b = 2
+      self.a = 1
+      self.__private = 3
+
+  keys = pm.eval("(obj) => Object.keys(obj)")
+  o1 = MyClass()
+  o2 = MyClass()
+  o2.c = 4
+  expected = [name for name in dir(o1) if not name.startswith('__')]
+  assert keys(o1) == expected
+  assert keys(o1) == expected  # class attributes now come from the per-type cache
+  assert keys(o2) == sorted(expected + ['c'])
+
+
+def test_eval_pyobjects_proxy_keys_after_class_modified():
+  class MyClass:
+    pass
+
+  keys = pm.eval("(obj) => Object.keys(obj)")
+  o = MyClass()
+  assert keys(o) == []
+  MyClass.added = 1
+  assert keys(o) == ['added']
+  del MyClass.added
+  assert keys(o) == []
+
+
+def test_eval_pyobjects_proxy_keys_after_base_class_modified():
+  class Base:
+    pass
+
+  class MyClass(Base):
+    pass
+
+  keys = pm.eval("(obj) => Object.keys(obj)")
+  o = MyClass()
+  assert keys(o) == []
+  Base.added = 1
+  assert keys(o) == ['added']
+  Base.removed = 2
+  del Base.removed
+  assert keys(o) == ['added']
+
+
+def test_eval_pyobjects_proxy_keys_do_not_keep_classes_alive():
+  class MyClass:
+    x = 1
+
+  keys = pm.eval("(obj) => Object.keys(obj)")
+  o = MyClass()
+  assert keys(o) == ['x']
+  ref = weakref.ref(MyClass)
+  del o, MyClass
+  pm.collect()
+  gc.collect()
+  assert ref() is None
+
+
+def test_eval_pyobjects_proxy_keys_with_many_classes():
+  class Hot:
+    pass
+
+  keys = pm.eval("(obj) => Object.keys(obj)")
+  hot = Hot()
+  for i in range(300):  # more classes than the cache holds, the least recently used ones being dropped
+    cold = type(f'Cold{i}', (), {f'attr{i}': i})()
+    assert keys(cold) == [f'attr{i}']
+    assert keys(hot) == []
+  Hot.added = 1
+  assert keys(hot) == ['added']
+
+
+def test_eval_pyobjects_proxy_keys_slots_and_custom_dir():
+  class Slotted:
+    __slots__ = ['a']
+
+    def __init__(self):
+      self.a = 1
+
+  class CustomDir:
+    def __dir__(self):
+      return ['z', '__hidden', 'y']
+
+  keys = pm.eval("(obj) => Object.keys(obj)")
+  assert keys(Slotted()) == ['a']
+  assert keys(CustomDir()) == ['y', 'z']
+
+
 def test_eval_pyobjects_proxy_delete():
   class MyClass:
     def __init__(self):
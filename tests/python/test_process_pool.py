@@ -0,0 +1,133 @@
+import asyncio
+import multiprocessing
+import os
+import warnings
+import pytest
+import pythonmonkey as pm
+
+
+@pytest.fixture
+def module(tmp_path):
+  path = tmp_path / "pool-module.js"
+  path.write_text("""
+    exports.square = (x) => x * x;
+    exports.pid = () => python.eval('__import__("os").getpid()');
+    exports.loadedAt = Date.now();
+    exports.stamp = () => exports.loadedAt;
+    exports.dates = (date) => ({ later: new Date(date.getTime() + 1000), bytes: new Uint8Array([1, 2, 3]) });
+    exports.later = async (x) => { await null; return x + 1; };
+    exports.fail = () => { throw new Error('pool failure'); };
+    exports.exit = () => python.eval('__import__("os")._exit(3)');
+  """)
+  return str(path)
+
+
+def test_pool_calls(module):
+  async def async_fn():
+    with pm.ProcessPool(2, preload=[module]) as pool:
+      return await asyncio.gather(*[pool.call(module, 'square', i) for i in range(10)])
+  assert [float(i * i) for i in range(10)] == asyncio.run(async_fn())
+
+
+def test_pool_runs_in_other_processes(module):
+  async def async_fn():
+    with pm.ProcessPool(2, preload=[module]) as pool:
+      return await asyncio.gather(*[pool.call(module, 'pid') for i in range(4)])
+  pids = asyncio.run(async_fn())
+  assert os.getpid() not in pids
+
+
+def test_pool_preloads_once_per_worker(module):
+  async def async_fn():
+    with pm.ProcessPool(2, preload=[module]) as pool:
+      return await asyncio.gather(*[pool.call(module, 'stamp') for i in range(8)])
+  assert len(set(asyncio.run(async_fn()))) <= 2
+
+
+@pytest.mark.skipif('fork' not in multiprocessing.get_all_start_methods(), reason="workers are spawned")
+def test_pool_forks_after_preloading(module):
+  async def async_fn():
+    with pm.ProcessPool(2, preload=[module]) as pool:
+      stamps = await asyncio.gather(*[pool.call(module, 'stamp') for i in range(8)])
+      return stamps, pm.require(module).loadedAt
+  stamps, loadedAt = asyncio.run(async_fn())
+  assert set(stamps) == {loadedAt}  # loaded once, by the pool
+
+
+@pytest.mark.skipif('fork' not in multiprocessing.get_all_start_methods(), reason="workers are spawned")
+def test_pool_forks_with_helper_threads_stopped(module):
+  # keep SpiderMonkey's helper threads busy with JIT compilation and garbage collection before forking
+  pm.eval("(() => { let sum = 0; for (let i = 0; i < 1e6; i++) sum += [i].length; return sum; })()")
+  pm.collect('incremental', budget_ms=1)  # leaves a collection in progress
+
+  async def async_fn():
+    with pm.ProcessPool(1, preload=[module]) as pool:
+      return await pool.call(module, 'square', 4)
+  with warnings.catch_warnings():
+    warnings.simplefilter('error', DeprecationWarning)  # raised by os.fork() in a process running threads
+    assert 16.0 == asyncio.run(async_fn())
+
+
+def test_pool_structured_clone_payloads(module):
+  async def async_fn():
+    with pm.ProcessPool(1, preload=[module]) as pool:
+      result = await pool.call(module, 'dates', pm.eval("new Date(0)"))
+    return pm.eval("(r) => r.later.getTime() === 1000 && r.bytes instanceof Uint8Array && r.bytes[2] === 3")(result)
+  assert asyncio.run(async_fn()) is True
+
+
+def test_pool_async_export(module):
+  async def async_fn():
+    with pm.ProcessPool(1, preload=[module]) as pool:
+      return await pool.call(module, 'later', 1)
+  assert 2.0 == asyncio.run(async_fn())
+
+
+def test_pool_error(module):
+  async def async_fn():
+    with pm.ProcessPool(1, preload=[module]) as pool:
+      with pytest.raises(pm.SpiderMonkeyError, match="pool failure"):
+        await pool.call(module, 'fail')
+      return await pool.call(module, 'square', 3)  # the worker survives
+  assert 9.0 == asyncio.run(async_fn())
+
+
+def test_pool_closed(module):
+  async def async_fn():
+    pool = pm.ProcessPool(1)
+    pool.close()
+    with pytest.raises(RuntimeError, match="closed"):
+      pool.call(module, 'square', 1)
+  asyncio.run(async_fn())
+
+
+def test_pool_terminate_rejects_running_calls(module):
+  async def async_fn():
+    pool = pm.ProcessPool(1, preload=[module])
+    call = pool.call(module, 'square', 2)
+    pool.terminate()
+    with pytest.raises((RuntimeError, asyncio.CancelledError)):
+      await call
+  asyncio.run(async_fn())
+
+
+def test_pool_worker_exit_rejects_its_calls(module):
+  async def async_fn():
+    with pm.ProcessPool(1, preload=[module]) as pool:
+      call = pool.call(module, 'exit')
+      queued = pool.call(module, 'square', 2)
+      with pytest.raises(RuntimeError, match="exited with code 3"):
+        await call
+      with pytest.raises(RuntimeError, match="exited"):
+        await queued
+  asyncio.run(async_fn())
+
+
+def test_pool_preload_failure_rejects_calls(tmp_path):
+  missing = str(tmp_path / "missing-module.js")
+
+  async def async_fn():
+    with pm.ProcessPool(1, preload=[missing]) as pool:
+      with pytest.raises(Exception, match="missing-module"):
+        await pool.call(missing, 'anything')
+  asyncio.run(async_fn())
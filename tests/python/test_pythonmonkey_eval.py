@@ -450,4 +450,249 @@ def test_iterable_attribute_console_printing():
   assert hasattr(sys.stdin, '__iter__') == True
   obj['stdin'].isTTY = sys.stdin.isatty()
   pm.eval('''(function iife(obj){console.log(obj['stdin'].isTTY);})''')(obj)
-  assert temp_out.getvalue() == "\x1b[33mfalse\x1b[39m\n" 
\ No newline at end of file
+  assert temp_out.getvalue() == "\x1b[33mfalse\x1b[39m\n" 
+
+def test_compile_runs_many_times():
+  pm.eval("globalThis.compileCounter = 0")
+  script = pm.compile("++compileCounter")
+  assert type(script) is pm.JSScriptProxy
+  assert 1 == script()
+  assert 2 == script()
+  assert 3 == pm.eval(script)
+
+
+def test_compile_errors():
+  with pytest.raises(pm.SpiderMonkeyError, match="SyntaxError"):
+    pm.compile("let let = ;")
+  script = pm.compile("throw new RangeError('from compiled script')")
+  with pytest.raises(pm.SpiderMonkeyError, match="from compiled script"):
+    script()
+  with pytest.raises(TypeError):
+    pm.compile("1")(1)
+
+
+def test_compile_options():
+  script = pm.compile("new Error().stack", {'filename': 'compiled.js', 'lineno': 42})
+  assert "compiled.js:42" in script()
+
+
+def test_eval_cache_hits():
+  pm.eval_cache_clear()
+  code = "Math.random() < 2"
+  assert pm.eval(code)
+  assert {'hits': 0, 'misses': 1, 'currsize': 1}.items() <= pm.eval_cache_info().items()
+  for i in range(3):
+    assert pm.eval("Math.random() < " + "2")  # equal, but different str objects
+  assert {'hits': 3, 'misses': 1, 'currsize': 1}.items() <= pm.eval_cache_info().items()
+  pm.compile(code)
+  assert 4 == pm.eval_cache_info()['hits']
+
+
+def test_eval_cache_keyed_by_options():
+  pm.eval_cache_clear()
+  code = "new Error().stack"
+  assert "one.js" in pm.eval(code, {'filename': 'one.js'})
+  assert "two.js" in pm.eval(code, {'filename': 'two.js'})
+  assert "one.js" in pm.eval(code, {'filename': 'one.js'})
+  assert {'hits': 1, 'misses': 2}.items() <= pm.eval_cache_info().items()
+
+
+def test_eval_cache_lru_eviction():
+  pm.eval_cache_clear()
+  maxsize = pm.eval_cache_info()['maxsize']
+  for i in range(maxsize + 10):
+    assert i == pm.eval(f"{i}")
+  info = pm.eval_cache_info()
+  assert maxsize == info['currsize']
+  assert 0 == pm.eval("0")  # evicted
+  assert maxsize + 11 == pm.eval_cache_info()['misses']
+  pm.eval_cache_clear()
+  assert {'hits': 0, 'misses': 0, 'currsize': 0}.items() <= pm.eval_cache_info().items()
+
+
+def test_eval_cache_scripts_rerun():
+  pm.eval("globalThis.evalCacheCounter = 0")
+  for i in range(5):
+    pm.eval("evalCacheCounter++")
+  assert 5 == pm.eval("evalCacheCounter")
+
+
+def test_stencil_cache(tmp_path):
+  directory = tmp_path / "stencils"
+  pm.stencil_cache_configure(str(directory))
+  try:
+    info = pm.stencil_cache_info()
+    assert str(directory) == info['directory']
+    code = "(function stencilCached(a) { return a * 6; })"
+    assert 42 == pm.eval(code)(7)
+    assert info['writes'] + 1 == pm.stencil_cache_info()['writes']
+    assert 1 == len(list(directory.glob("*.stencil")))
+    pm.eval_cache_clear()  # the next eval misses in memory, and decodes the stencil
+    hits = pm.stencil_cache_info()['hits']
+    fn = pm.eval(code)
+    assert hits + 1 == pm.stencil_cache_info()['hits']
+    assert 42 == fn(7)
+    assert "return a * 6" in pm.eval("(fn) => fn.toString()")(fn)
+  finally:
+    pm.stencil_cache_configure(None)
+    pm.eval_cache_clear()
+
+
+def test_stencil_cache_replaces_corrupt_files(tmp_path):
+  pm.stencil_cache_configure(str(tmp_path))
+  try:
+    code = "'stencil' + 'corrupted'"
+    writes = pm.stencil_cache_info()['writes']
+    assert "stencilcorrupted" == pm.eval(code)
+    for file in tmp_path.glob("*.stencil"):
+      file.write_bytes(b"not a stencil")
+    pm.eval_cache_clear()
+    assert "stencilcorrupted" == pm.eval(code)
+    assert writes + 2 == pm.stencil_cache_info()['writes']
+  finally:
+    pm.stencil_cache_configure(None)
+    pm.eval_cache_clear()
+
+
+def test_stencil_cache_size_limit(tmp_path):
+  pm.stencil_cache_configure(str(tmp_path), 1)
+  try:
+    writes = pm.stencil_cache_info()['writes']
+    for i in range(3):
+      assert i == pm.eval(f"{i} /* size limit */")
+    assert writes + 3 == pm.stencil_cache_info()['writes']
+    assert [] == list(tmp_path.glob("*.stencil"))  # every stencil is larger than the limit
+  finally:
+    pm.stencil_cache_configure(None)
+    pm.eval_cache_clear()
+
+
+def test_compile_function():
+  add = pm.compile_function("add", ["a", "b"], "return a + b;")
+  assert isinstance(add, pm.JSFunctionProxy)
+  assert 3.0 == add(1, 2)
+  assert "add" == pm.eval("(fn) => fn.name")(add)
+  assert 2 == pm.eval("(fn) => fn.length")(add)
+
+
+def test_compile_function_anonymous():
+  fn = pm.compile_function(None, [], "return 'anonymous';")
+  assert "anonymous" == fn()
+  assert "anonymous" == pm.eval("(fn) => fn.name")(fn)
+
+
+def test_compile_function_is_cached():
+  pm.eval_cache_clear()
+  first = pm.compile_function("cached", ["x"], "return x * 2;")
+  second = pm.compile_function("cached", ["x"], "return x * 2;")
+  assert 1 == pm.eval_cache_info()['hits']
+  assert 4 == second(2)
+  other = pm.compile_function("cached", ["y"], "return x * 2;")
+  assert 1 == pm.eval_cache_info()['hits']
+
+
+def test_compile_function_returns_a_new_function_each_call():
+  first = pm.compile_function("perCaller", [], "return this;")
+  second = pm.compile_function("perCaller", [], "return this;")
+  assert not pm.eval("(a, b) => a === b")(first, second)
+  pm.eval("(fn) => { fn.state = 'first'; }")(first)
+  assert pm.eval("(fn) => fn.state === undefined")(second)
+
+
+def test_compile_function_param_names_do_not_collide():
+  pm.eval_cache_clear()
+  joined = pm.compile_function("collide", ["a,b"], "return typeof b;")
+  split = pm.compile_function("collide", ["a", "b"], "return typeof b;")
+  assert 0 == pm.eval_cache_info()['hits']
+  assert 2 == pm.eval("(fn) => fn.length")(split)
+  assert "undefined" == split(1)
+  assert "number" == split(1, 2)
+  assert not pm.eval("(a, b) => a === b")(joined, split)
+
+
+def test_compile_function_global_scope():
+  pm.eval("globalThis.compileFunctionGlobal = 7")
+  fn = pm.compile_function("readGlobal", [], "return compileFunctionGlobal;")
+  assert 7 == fn()
+  assert "undefined" == pm.eval("typeof readGlobal")  # compiling doesn't define the function in the global scope
+
+
+def test_compile_function_strict():
+  fn = pm.compile_function("strictThis", [], "return this;", {'strict': True})
+  assert pm.eval("(fn) => fn.call(undefined) === undefined")(fn)
+
+
+def test_compile_function_syntax_error():
+  with pytest.raises(pm.SpiderMonkeyError, match="SyntaxError"):
+    pm.compile_function("broken", ["a"], "return a +;")
+
+
+def test_compile_function_bad_params():
+  with pytest.raises(TypeError):
+    pm.compile_function("badParams", [1], "return 1;")
+  with pytest.raises(TypeError):
+    pm.compile_function("badParams", 1, "return 1;")
+
+
+def test_eval_async():
+  async def async_fn():
+    return await pm.eval_async("1 + 2")
+  assert 3.0 == asyncio.run(async_fn())
+
+
+def test_eval_async_options():
+  async def async_fn():
+    return await pm.eval_async("new Error().stack", {'filename': 'evalAsync.js', 'lineno': 7})
+  assert "evalAsync.js:7" in asyncio.run(async_fn())
+
+
+def test_eval_async_file(tmp_path):
+  script = tmp_path / "script.js"
+  script.write_text("const evalAsyncFile = 'from a file'; evalAsyncFile")
+
+  async def async_fn():
+    with open(script) as file:
+      return await pm.eval_async(file)
+  assert "from a file" == asyncio.run(async_fn())
+
+
+def test_eval_async_errors():
+  async def syntax_error():
+    await pm.eval_async("1 +")
+
+  async def runtime_error():
+    await pm.eval_async("throw new RangeError('evalAsync')")
+
+  with pytest.raises(pm.SpiderMonkeyError, match="SyntaxError"):
+    asyncio.run(syntax_error())
+  with pytest.raises(pm.SpiderMonkeyError, match="RangeError: evalAsync"):
+    asyncio.run(runtime_error())
+
+
+def test_eval_async_queues_more_calls_than_helper_threads():
+  async def async_fn():
+    return await asyncio.gather(*(pm.eval_async(f"{i} * 2") for i in range(64)))
+  assert [i * 2.0 for i in range(64)] == asyncio.run(async_fn())
+
+
+def test_eval_async_keeps_event_loop_running():
+  code = "".join(f"function f{i}(a) {{ return a + {i}; }}\n" for i in range(50_000)) + "f49999(1)"
+  ticks = 0
+
+  async def ticker(compiled):
+    nonlocal ticks
+    while not compiled.done():
+      ticks += 1
+      await asyncio.sleep(0)
+
+  async def async_fn():
+    compiled = asyncio.ensure_future(pm.eval_async(code))
+    await ticker(compiled)
+    return await compiled
+  assert 50_000.0 == asyncio.run(async_fn())
+  assert ticks > 0
+
+
+def test_eval_async_requires_a_running_loop():
+  with pytest.raises(RuntimeError):
+    pm.eval_async("1")
@@ -0,0 +1,76 @@
+import pytest
+import pythonmonkey as pm
+
+
+def test_realm_has_its_own_global():
+  realm = pm.Realm()
+  realm.eval("globalThis.realmOnly = 1")
+  assert 1.0 == realm.globalThis.realmOnly
+  assert pm.eval("typeof globalThis.realmOnly") == 'undefined'
+
+
+def test_realm_has_its_own_builtins():
+  realm = pm.Realm()
+  realm.eval("Array.prototype.polluted = true")
+  assert realm.eval("[].polluted")
+  assert not pm.eval("[].polluted")
+  assert not pm.eval("(arr) => arr instanceof Array")(realm.eval("[]"))
+
+
+def test_realm_has_only_standard_globals():
+  realm = pm.Realm()
+  assert 'undefined' == realm.eval("typeof console")
+  assert 'function' == realm.eval("typeof Promise")
+
+
+def test_values_pass_between_realms():
+  first = pm.Realm()
+  second = pm.Realm()
+  obj = first.eval("({ count: 1 })")
+  second.globalThis.shared = obj
+  second.eval("shared.count++")
+  assert 2.0 == first.eval("(obj) => obj.count")(obj)
+  increment = first.eval("(x) => x + 1")
+  assert 3.0 == second.eval("(fn) => fn(2)")(increment)
+
+
+def test_realm_python_values():
+  realm = pm.Realm()
+  realm.globalThis.data = {'a': [1, 2]}
+  assert 2.0 == realm.eval("data.a.length")
+
+
+def test_realm_eval_options():
+  realm = pm.Realm()
+  with pytest.raises(pm.SpiderMonkeyError, match="realm-file.js"):
+    realm.eval("throw new Error('boom')", {'filename': 'realm-file.js'})
+
+
+def test_realm_eval_cached_script():
+  script = pm.compile("typeof realmMarker")
+  realm = pm.Realm()
+  realm.globalThis.realmMarker = 1
+  assert 'number' == realm.eval(script)
+  assert 'undefined' == script()
+  assert 'number' == realm.eval("typeof realmMarker")
+
+
+def test_realm_module_map(tmp_path):
+  (tmp_path / "counter.mjs").write_text("globalThis.loads = (globalThis.loads || 0) + 1; export const loads = globalThis.loads;")
+  main = tmp_path / "main.mjs"
+  main.write_text("import { loads } from './counter.mjs'; export { loads };")
+  for i in range(2):
+    realm = pm.Realm()
+    assert 1.0 == realm.eval(main.read_text(), {'module': True, 'filename': str(main)}).loads
+
+
+def test_closed_realm():
+  with pm.Realm() as realm:
+    realm.eval("1")
+  with pytest.raises(ValueError):
+    realm.eval("1")
+
+
+def test_realm_takes_no_arguments():
+  with pytest.raises(TypeError):
+    pm.Realm(1)
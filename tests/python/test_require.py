@@ -0,0 +1,76 @@
+import pytest
+import pythonmonkey as pm
+
+
+def test_require_from_node_modules(tmp_path):
+  pkg = tmp_path / "node_modules" / "deep-pkg"
+  pkg.mkdir(parents=True)
+  (pkg / "package.json").write_text('{"name": "deep-pkg", "main": "lib/main.js"}')
+  (pkg / "lib").mkdir()
+  (pkg / "lib" / "main.js").write_text("exports.name = require('./name');")
+  (pkg / "lib" / "name.js").write_text("module.exports = 'deep';")
+  (tmp_path / "a" / "b" / "c").mkdir(parents=True)
+  require = pm.createRequire(str(tmp_path / "a" / "b" / "c" / "main.py"))
+  assert 'deep' == require('deep-pkg').name
+
+
+def test_require_finds_module_created_after_a_failed_require(tmp_path):
+  require = pm.createRequire(str(tmp_path / "main.py"))
+  with pytest.raises(pm.SpiderMonkeyError):
+    require('./later')
+  (tmp_path / "later.js").write_text("module.exports = 'found';")
+  assert 'found' == require('./later')
+
+
+def test_require_memoizes_resolution(tmp_path):
+  (tmp_path / "memoized.js").write_text("module.exports = { loaded: true };")
+  require = pm.createRequire(str(tmp_path / "main.py"))
+  exports = require('./memoized')
+  (tmp_path / "memoized.js").unlink()
+  pm.internalBinding('fs').clearStatCache()
+  assert pm.eval("(a, b) => a === b")(exports, require('./memoized'))  # not resolved again
+
+
+def test_fs_binding_missing_path_until_cleared(tmp_path):
+  fs = pm.internalBinding('fs')
+  created = tmp_path / "created.js"
+  assert -1 == fs.statMode(str(created))
+  created.write_text("x")
+  assert -1 == fs.statMode(str(created))  # cached
+  fs.clearMissingPaths()
+  assert fs.statMode(str(created)) != -1
+
+
+def test_fs_binding_stat_mode_of_removed_file_until_cleared(tmp_path):
+  fs = pm.internalBinding('fs')
+  removed = tmp_path / "removed.js"
+  removed.write_text("x")
+  assert fs.statMode(str(removed)) != -1
+  removed.unlink()
+  assert fs.statMode(str(removed)) != -1  # cached
+  fs.clearStatCache()
+  assert -1 == fs.statMode(str(removed))
+
+
+def test_fs_binding_stat_mode(tmp_path):
+  fs = pm.internalBinding('fs')
+  assert -1 == fs.statMode(str(tmp_path / "missing"))
+  assert fs.statMode(str(tmp_path)) & 0o40000
+  (tmp_path / "file.txt").write_text("x")
+  assert not fs.statMode(str(tmp_path / "." / "file.txt")) & 0o40000
+
+
+def test_fs_binding_read_file(tmp_path):
+  fs = pm.internalBinding('fs')
+  small = tmp_path / "small.js"
+  small.write_text("// é\n", encoding="utf-8")
+  assert "// é\n" == fs.readFileUtf8(str(small))
+  large = tmp_path / "large.js"  # memory-mapped
+  contents = "/* ü */\n" * 100000
+  large.write_text(contents, encoding="utf-8")
+  assert contents == fs.readFileUtf8(str(large))
+
+
+def test_fs_binding_read_missing_file(tmp_path):
+  readFile = pm.eval("(fs, filename) => { try { fs.readFileUtf8(filename); } catch (error) { return error.code; } }")
+  assert 'ENOENT' == readFile(pm.internalBinding('fs'), str(tmp_path / "missing.js"))
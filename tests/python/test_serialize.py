@@ -0,0 +1,110 @@
+import pickle
+import threading
+import pytest
+import pythonmonkey as pm
+
+
+def test_serialize_returns_bytes():
+  assert type(pm.serialize({'a': 1})) is bytes
+
+
+def test_round_trip_plain_values():
+  assert 'hello' == pm.deserialize(pm.serialize('hello'))
+  assert 1.5 == pm.deserialize(pm.serialize(1.5))
+  assert [1.0, 'two', True] == pm.deserialize(pm.serialize([1, 'two', True]))
+
+
+def test_round_trip_keeps_what_json_loses():
+  value = pm.eval("""({
+    when: new Date(0),
+    bytes: new Float64Array([0.5, 1.5]),
+    map: new Map([[1, 'a']]),
+    set: new Set(['x']),
+    big: 12345678901234567890n,
+  })""")
+  copy = pm.deserialize(pm.serialize(value))
+  check = pm.eval("""(copy) =>
+    copy.when instanceof Date && copy.when.getTime() === 0
+    && copy.bytes instanceof Float64Array && copy.bytes[1] === 1.5
+    && copy.map.get(1) === 'a' && copy.set.has('x')
+    && copy.big === 12345678901234567890n""")
+  assert check(copy) is True
+
+
+def test_round_trip_keeps_cycles():
+  value = pm.eval("{ const o = { name: 'cycle' }; o.self = o; o }")
+  copy = pm.deserialize(pm.serialize(value))
+  assert pm.eval("(copy) => copy.self === copy && copy.name === 'cycle'")(copy) is True
+
+
+def test_deserialize_accepts_buffers():
+  data = pm.serialize([1, 2])
+  assert [1.0, 2.0] == pm.deserialize(bytearray(data))
+  assert [1.0, 2.0] == pm.deserialize(memoryview(data))
+
+
+def test_typed_array_contents_are_copied():
+  value = pm.eval("({ bytes: new Uint8Array(1024 * 1024).fill(7) })")
+  data = pm.serialize(value)
+  assert 1024 * 1024 <= len(data) < 1024 * 1024 + 256  # written inline, once
+  pm.eval("(value) => { value.bytes.fill(8) }")(value)
+  source = bytearray(data)
+  copy = pm.deserialize(source)
+  source[:] = bytes(len(source))
+  assert pm.eval("(copy) => copy.bytes.length === 1024 * 1024 && copy.bytes.every((byte) => byte === 7)")(copy) is True
+
+
+def test_deserialize_in_another_thread():
+  data = pm.serialize(pm.eval("({ a: [1, 2, 3] })"))
+  results = []
+  thread = threading.Thread(target=lambda: results.append(pm.eval("(o) => o.a.length")(pm.deserialize(data))))
+  thread.start()
+  thread.join()
+  assert [3.0] == results
+
+
+def test_serialize_function_raises():
+  with pytest.raises(pm.SpiderMonkeyError):
+    pm.serialize(pm.eval("() => 1"))
+
+
+def test_deserialize_garbage_raises():
+  with pytest.raises(pm.SpiderMonkeyError):
+    pm.deserialize(b'not a structured clone')
+  with pytest.raises(TypeError):
+    pm.deserialize('not bytes')
+
+
+def test_pickle_object_proxy():
+  obj = pm.eval("({ a: 1, nested: { when: new Date(0) } })")
+  copy = pickle.loads(pickle.dumps(obj))
+  assert 1.0 == copy['a']
+  assert pm.eval("(copy) => copy.nested.when.getTime()")(copy) == 0.0
+
+
+def test_pickle_array_proxy():
+  arr = pm.eval("[1, [2, 3], 'four']")
+  copy = pickle.loads(pickle.dumps(arr))
+  assert [1.0, [2.0, 3.0], 'four'] == copy
+  assert pm.eval("(a, b) => a !== b")(arr, copy) is True
+
+
+def test_structured_clone_global():
+  assert pm.eval("""{
+    const original = { list: [1, 2], when: new Date(1) };
+    const copy = structuredClone(original);
+    copy !== original && copy.list[1] === 2 && copy.when.getTime() === 1;
+  }""") is True
+
+
+def test_structured_clone_transfer():
+  assert pm.eval("""{
+    const buffer = new Uint8Array([1, 2, 3]).buffer;
+    const copy = structuredClone(buffer, { transfer: [buffer] });
+    buffer.byteLength === 0 && copy.byteLength === 3;
+  }""") is True
+
+
+def test_structured_clone_in_realm():
+  with pm.Realm() as realm:
+    assert 2.0 == realm.eval("structuredClone({ a: 2 }).a")
@@ -0,0 +1,98 @@
+import sys
+import threading
+import pytest
+import pythonmonkey as pm
+
+try:
+  import _interpreters as interpreters  # Python 3.13+
+except ImportError:
+  try:
+    import _xxsubinterpreters as interpreters
+  except ImportError:
+    interpreters = None
+
+pytestmark = pytest.mark.skipif(interpreters is None or sys.version_info < (3, 12),
+                                reason="subinterpreters need Python 3.12+")
+
+
+def new_interpreter():
+  # aiohttp, used by XMLHttpRequest, is not importable by isolated subinterpreters
+  try:
+    return interpreters.create('legacy')  # Python 3.13+
+  except TypeError:
+    return interpreters.create(isolated=False)
+
+
+def run_string(interp, code):
+  """Run code in a subinterpreter, returning the message of its uncaught exception if any"""
+  try:
+    error = interpreters.run_string(interp, code)  # Python 3.13+ returns the exception
+  except Exception as e:
+    error = e
+  if error is None:
+    return None
+  return getattr(error, 'formatted', None) or str(error)
+
+
+def run_in_subinterpreter(code):
+  """Run code in a new subinterpreter, on a thread of its own"""
+  result = {}
+
+  def target():
+    interp = new_interpreter()
+    try:
+      result['error'] = run_string(interp, code)
+    finally:
+      interpreters.destroy(interp)
+  thread = threading.Thread(target=target)
+  thread.start()
+  thread.join()
+  return result.get('error')
+
+
+def test_eval_in_subinterpreter():
+  assert run_in_subinterpreter("""if True:
+    import pythonmonkey as pm
+    assert pm.eval('1 + 2') == 3
+    obj = pm.eval('({ a: [1, 2], s: "sub" })')
+    assert isinstance(obj, pm.JSObjectProxy)
+    assert obj['a'][1] == 2
+    assert obj['s'] == 'sub'
+    assert list(obj.keys()) == ['a', 's']
+  """) is None
+
+
+def test_subinterpreter_has_its_own_types():
+  assert run_in_subinterpreter("""if True:
+    import pythonmonkey as pm
+    try:
+      pm.eval("throw new Error('from the subinterpreter')")
+    except pm.SpiderMonkeyError as e:
+      assert 'from the subinterpreter' in str(e)
+    else:
+      raise AssertionError('no SpiderMonkeyError')
+    assert pm.eval('null') is pm.null
+  """) is None
+  # the main interpreter keeps working with its own types
+  assert isinstance(pm.eval('({})'), pm.JSObjectProxy)
+  with pytest.raises(pm.SpiderMonkeyError, match="main"):
+    pm.eval("throw new Error('main')")
+
+
+def test_subinterpreters_one_after_the_other_on_a_thread():
+  code = """if True:
+    import pythonmonkey as pm
+    assert pm.eval('[1, 2, 3].length') == 3
+  """
+  assert run_in_subinterpreter(code) is None
+  assert run_in_subinterpreter(code) is None
+
+
+def test_subinterpreter_on_a_thread_running_another_interpreter():
+  interp = new_interpreter()
+  try:
+    error = run_string(interp, "import pythonmonkey")  # this thread runs the JavaScript of the main interpreter
+  finally:
+    interpreters.destroy(interp)
+  assert error is not None
+  assert "threads of its own" in error
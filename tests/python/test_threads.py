@@ -0,0 +1,265 @@
+import sys
+import threading
+import pytest
+import pythonmonkey as pm
+
+
+def runInThread(fn):
+  results = {}
+
+  def target():
+    try:
+      results['value'] = fn()
+    except BaseException as error:
+      results['error'] = error
+  thread = threading.Thread(target=target)
+  thread.start()
+  thread.join()
+  if 'error' in results:
+    raise results['error']
+  return results['value']
+
+
+def test_eval_in_thread():
+  assert 6.0 == runInThread(lambda: pm.eval("[1, 2, 3].reduce((a, b) => a + b)"))
+
+
+def test_string_from_thread_is_a_python_string():
+  result = runInThread(lambda: pm.eval("'thread' + '-' + 'string'"))
+  assert type(result) is str
+  assert 'thread-string' == result
+
+
+def test_thread_has_its_own_global():
+  pm.eval("globalThis.mainOnly = 1")
+
+  def work():
+    first = pm.eval("typeof globalThis.mainOnly")
+    pm.eval("globalThis.threadOnly = 2")
+    return first, pm.eval("globalThis.threadOnly")
+  assert ('undefined', 2.0) == runInThread(work)
+  assert 'undefined' == pm.eval("typeof globalThis.threadOnly")
+
+
+def test_thread_keeps_its_context():
+  def work():
+    pm.eval("globalThis.calls = 0")
+    for i in range(10):
+      pm.eval("calls++")
+    return pm.eval("calls")
+  assert 10.0 == runInThread(work)
+
+
+def test_python_values_pass_between_threads():
+  data = {'a': [1, 2]}
+  assert 2.0 == runInThread(lambda: pm.eval("(data) => data.a.length")(data))
+
+
+def test_dict_keys_in_thread_and_main_thread():
+  record = {'alpha': 1, 'beta': 2, 'gamma': 3}
+  keysOf = "(record) => Object.keys(record).join()"
+  assert 'alpha,beta,gamma' == pm.eval(keysOf)(record)
+  assert 'alpha,beta,gamma' == runInThread(lambda: pm.eval(keysOf)(record))
+  assert 'alpha,beta,gamma' == pm.eval(keysOf)(record)
+
+
+def test_main_proxy_in_thread_raises():
+  obj = pm.eval("({ a: 1 })")
+  fn = pm.eval("() => 1")
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(lambda: obj['a'])
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(fn)
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(lambda: pm.eval("(x) => x")(obj))
+
+
+def test_thread_proxy_on_main_thread_raises():
+  obj = runInThread(lambda: pm.eval("({ a: 1 })"))
+  with pytest.raises(RuntimeError):
+    obj['a']
+
+
+@pytest.mark.parametrize("use", [
+  lambda obj: obj.get('a'),
+  lambda obj: obj.setdefault('b', 2),
+  lambda obj: obj.pop('a'),
+  lambda obj: obj.update({'b': 2}),
+  lambda obj: obj == {'a': 1},
+  lambda obj: obj.copy(),
+  lambda obj: obj.clear(),
+  lambda obj: obj.keys(),
+  lambda obj: obj.values(),
+  lambda obj: obj.items(),
+])
+def test_main_object_methods_in_thread_raise(use):
+  obj = pm.eval("({ a: 1 })")
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(lambda: use(obj))
+  assert 1.0 == obj['a']
+
+
+@pytest.mark.skipif(sys.version_info < (3, 9), reason="| is not implemented for dicts in 3.8 or less")
+def test_main_object_operators_in_thread_raise():
+  obj = pm.eval("({ a: 1 })")
+
+  def update():
+    nonlocal obj
+    obj |= {'b': 2}
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(lambda: obj | {'b': 2})
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(lambda: {'b': 2} | obj)
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(update)
+  assert 'b' not in obj
+
+
+@pytest.mark.parametrize("view", ['keys', 'values', 'items'])
+def test_main_object_views_in_thread_raise(view):
+  obj = pm.eval("({ a: 1 })")
+  items = getattr(obj, view)()
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(lambda: list(items))
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(lambda: list(reversed(items)))
+  iterator = iter(items)
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(lambda: next(iterator))
+
+
+@pytest.mark.parametrize("use", [
+  lambda arr: arr.append(4),
+  lambda arr: arr.extend([4]),
+  lambda arr: arr.insert(0, 4),
+  lambda arr: arr.pop(),
+  lambda arr: arr.remove(1),
+  lambda arr: arr.index(1),
+  lambda arr: arr.count(1),
+  lambda arr: arr.reverse(),
+  lambda arr: arr.sort(),
+  lambda arr: arr.clear(),
+  lambda arr: arr.copy(),
+  lambda arr: arr + [4],
+  lambda arr: arr * 2,
+  lambda arr: arr == [1, 2, 3],
+  lambda arr: list(reversed(arr)),
+])
+def test_main_array_methods_in_thread_raise(use):
+  arr = pm.eval("[1, 2, 3]")
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(lambda: use(arr))
+  assert [1.0, 2.0, 3.0] == arr
+
+
+def test_main_array_inplace_operators_in_thread_raise():
+  arr = pm.eval("[1, 2, 3]")
+
+  def concat():
+    nonlocal arr
+    arr += [4]
+
+  def repeat():
+    nonlocal arr
+    arr *= 2
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(concat)
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(repeat)
+  assert [1.0, 2.0, 3.0] == arr
+
+
+def test_main_array_iterator_in_thread_raises():
+  iterator = iter(pm.eval("[1, 2, 3]"))
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(lambda: next(iterator))
+
+
+def test_main_buffer_in_thread_raises():
+  buffer = pm.eval("new Uint8Array([1, 2, 3])")
+  with pytest.raises(BufferError, match="another thread"):
+    runInThread(lambda: memoryview(buffer.obj))
+  assert [1, 2, 3] == list(buffer)
+
+
+def test_compile_in_thread():
+  def work():
+    script = pm.compile("1 + 1")
+    return script() + pm.compile_function(None, ['x'], "return x * 2")(2)
+  assert 6.0 == runInThread(work)
+
+
+def test_main_script_in_thread_raises():
+  script = pm.compile("1")
+  with pytest.raises(RuntimeError, match="another thread"):
+    runInThread(script)
+
+
+def test_many_threads():
+  results = []
+
+  def work(i):
+    results.append(pm.eval(f"({i}) * 2"))
+  threads = [threading.Thread(target=work, args=(i,)) for i in range(8)]
+  for thread in threads:
+    thread.start()
+  for thread in threads:
+    thread.join()
+  assert sorted(results) == [i * 2.0 for i in range(8)]
+
+
+@pytest.fixture
+def releaseGIL():
+  pm.set_release_gil(True)
+  yield
+  pm.set_release_gil(False)
+
+
+def test_release_gil_lets_python_threads_run(releaseGIL):
+  ticks = []
+  done = threading.Event()
+
+  def ticker():
+    while not done.is_set():
+      ticks.append(1)
+      done.wait(0.001)
+  thread = threading.Thread(target=ticker)
+  thread.start()
+  try:
+    pm.eval("{ const end = Date.now() + 200; while (Date.now() < end); }")
+  finally:
+    done.set()
+    thread.join()
+  assert len(ticks) > 10
+
+
+def test_release_gil_callbacks_into_python(releaseGIL):
+  data = {'items': [3, 1, 2]}
+  result = pm.eval("(data, fn) => data.items.map(fn).sort()")(data, lambda x: x * 2)
+  assert [2.0, 4.0, 6.0] == result
+  assert 'abc' == pm.eval("'a' + 'bc'")
+
+
+def test_release_gil_in_threads(releaseGIL):
+  results = []
+
+  def work():
+    results.append(pm.eval("let sum = 0; for (let i = 0; i < 100000; i++) sum += 1; sum"))
+  threads = [threading.Thread(target=work) for i in range(4)]
+  for thread in threads:
+    thread.start()
+  for thread in threads:
+    thread.join()
+  assert [100000.0] * 4 == results
+
+
+def test_release_gil_takes_a_bool():
+  with pytest.raises(TypeError):
+    pm.set_release_gil()
+
+
+def test_release_gil_on_thread():
+  def work():
+    pm.set_release_gil(True, thread=True)
+    return pm.eval("let sum = 0; for (let i = 0; i < 1000; i++) sum += 1; sum")
+  assert 1000.0 == runInThread(work)
@@ -0,0 +1,116 @@
+import asyncio
+import os
+import tempfile
+import pytest
+import pythonmonkey as pm
+
+
+def test_worker_echo():
+  async def async_fn():
+    worker = pm.Worker("onmessage = (event) => postMessage({ echo: event.data, self: self === globalThis })")
+    received = asyncio.get_running_loop().create_future()
+    worker.onmessage = received.set_result
+    worker.post_message({'a': [1, 2]})
+    data = await received
+    worker.terminate()
+    await worker.exited
+    return data
+  data = asyncio.run(async_fn())
+  assert [1.0, 2.0] == data['echo']['a']
+  assert data['self'] is True
+
+
+def test_worker_completion_resolves_to_the_result():
+  async def async_fn():
+    worker = pm.Worker("onmessage = (event) => event.data * 2")
+    results = [await worker.post_message(i) for i in range(3)]
+    worker.terminate()
+    await worker.exited
+    return results
+  assert [0.0, 2.0, 4.0] == asyncio.run(async_fn())
+
+
+def test_worker_async_completion():
+  async def async_fn():
+    worker = pm.Worker("onmessage = async (event) => { await null; return event.data + '!' }")
+    result = await worker.post_message('done')
+    worker.terminate()
+    return result
+  assert 'done!' == asyncio.run(async_fn())
+
+
+def test_worker_does_not_share_the_global():
+  async def async_fn():
+    pm.eval("globalThis.parentOnly = 1")
+    worker = pm.Worker("onmessage = () => typeof parentOnly")
+    result = await worker.post_message(None)
+    worker.terminate()
+    return result
+  assert 'undefined' == asyncio.run(async_fn())
+
+
+def test_worker_transfer_array_buffer():
+  async def async_fn():
+    worker = pm.Worker("onmessage = (event) => new Uint8Array(event.data).reduce((a, b) => a + b)")
+    buffer = pm.eval("new Uint8Array([1, 2, 3]).buffer")
+    result = await worker.post_message(buffer, [buffer])
+    worker.terminate()
+    return result, pm.eval("(buffer) => buffer.byteLength")(buffer)
+  assert (6.0, 0.0) == asyncio.run(async_fn())
+
+
+def test_worker_error_rejects_the_completion():
+  async def async_fn():
+    worker = pm.Worker("onmessage = () => { throw new Error('worker failure') }")
+    errors = []
+    worker.onerror = errors.append
+    with pytest.raises(pm.SpiderMonkeyError, match="worker failure"):
+      await worker.post_message(1)
+    worker.terminate()
+    await worker.exited
+    return errors
+  assert 1 == len(asyncio.run(async_fn()))
+
+
+def test_worker_close():
+  async def async_fn():
+    worker = pm.Worker("onmessage = () => close()")
+    await worker.post_message(None)
+    await worker.exited
+    with pytest.raises(RuntimeError, match="exited"):
+      await worker.post_message(None)
+  asyncio.run(async_fn())
+
+
+def test_worker_script_error_exits():
+  async def async_fn():
+    worker = pm.Worker("throw new Error('bad script')")
+    errors = []
+    worker.onerror = errors.append
+    await worker.exited
+    return errors
+  errors = asyncio.run(async_fn())
+  assert 1 == len(errors)
+  assert 'bad script' in str(errors[0])
+
+
+def test_js_worker_global():
+  with tempfile.NamedTemporaryFile('w', suffix='.js', delete=False) as script:
+    script.write("onmessage = (event) => postMessage(event.data.map((x) => x * x))")
+  try:
+    async def async_fn():
+      received = asyncio.get_running_loop().create_future()
+      pm.eval("""(filename, done) => {
+        const worker = new Worker(filename);
+        worker.onmessage = (event) => { worker.terminate(); done(event instanceof MessageEvent ? event.data : null); };
+        worker.postMessage([1, 2, 3]);
+      }""")(script.name, received.set_result)
+      return await received
+    assert [1.0, 4.0, 9.0] == asyncio.run(async_fn())
+  finally:
+    os.unlink(script.name)
+
+
+def test_worker_requires_an_event_loop():
+  with pytest.raises(RuntimeError):
+    pm.Worker("1")